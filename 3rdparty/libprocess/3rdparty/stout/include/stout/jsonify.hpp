@@ -304,6 +304,40 @@ private:
 };
 
 
+// The raw writer. `append` is used to write out JSON that has been
+// serialized before (e.g., to cache the serialization of an object)
+// as is. The appended JSON must form a single valid JSON value.
+// If `append` is not called at all, `null` is printed.
+class RawWriter
+{
+public:
+  RawWriter(std::ostream* stream) : stream_(stream), empty_(true) {}
+
+  RawWriter(const RawWriter&) = delete;
+  RawWriter(RawWriter&&) = delete;
+
+  ~RawWriter()
+  {
+    if (empty_) {
+      *stream_ << "null";
+    }
+  }
+
+  RawWriter& operator=(const RawWriter&) = delete;
+  RawWriter& operator=(RawWriter&&) = delete;
+
+  void append(const std::string& value)
+  {
+    *stream_ << value;
+    empty_ = false;
+  }
+
+private:
+  std::ostream* stream_;
+  bool empty_;
+};
+
+
 // The array writer. `element(value)` is used to write a new element.
 // If `element` is not called at all, `[]` is printed.
 class ArrayWriter
@@ -574,6 +608,10 @@ public:
         writer_.object_writer.~ObjectWriter();
         break;
       }
+      case RAW_WRITER: {
+        writer_.raw_writer.~RawWriter();
+        break;
+      }
     }
   }
 
@@ -612,6 +650,13 @@ public:
     return &writer_.object_writer;
   }
 
+  operator RawWriter*() &&
+  {
+    new (&writer_.raw_writer) RawWriter(stream_);
+    type_ = RAW_WRITER;
+    return &writer_.raw_writer;
+  }
+
 private:
   enum Type
   {
@@ -619,7 +664,8 @@ private:
     NUMBER_WRITER,
     STRING_WRITER,
     ARRAY_WRITER,
-    OBJECT_WRITER
+    OBJECT_WRITER,
+    RAW_WRITER
   };
 
   union Writer
@@ -631,6 +677,7 @@ private:
     StringWriter string_writer;
     ArrayWriter array_writer;
     ObjectWriter object_writer;
+    RawWriter raw_writer;
   };
 
   std::ostream* stream_;
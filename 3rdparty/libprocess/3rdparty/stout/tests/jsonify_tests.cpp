@@ -162,3 +162,47 @@ TEST(JsonifyTest, Dictionary)
 
   EXPECT_EQ(expected, string(jsonify(names)));
 }
+
+
+namespace store {
+
+// An object whose serialization is cached.
+struct Cached
+{
+  string json;
+};
+
+
+// `json` overload for `Cached`.
+void json(JSON::RawWriter* writer, const Cached& cached)
+{
+  writer->append(cached.json);
+}
+
+} // namespace store {
+
+
+// Tests that JSON serialized before is written out as is.
+TEST(JsonifyTest, Raw)
+{
+  store::Cached name{string(jsonify(store::Name{"michael", "park"}))};
+  EXPECT_EQ(
+      "{\"first_name\":\"michael\",\"last_name\":\"park\"}",
+      string(jsonify(name)));
+
+  vector<store::Cached> names = {name, name};
+  EXPECT_EQ(
+      "[{\"first_name\":\"michael\",\"last_name\":\"park\"},"
+      "{\"first_name\":\"michael\",\"last_name\":\"park\"}]",
+      string(jsonify(names)));
+
+  auto object = [&name](JSON::ObjectWriter* writer) {
+    writer->field("name", name);
+  };
+
+  EXPECT_EQ(
+      "{\"name\":{\"first_name\":\"michael\",\"last_name\":\"park\"}}",
+      string(jsonify(object)));
+
+  EXPECT_EQ("null", string(jsonify([](JSON::RawWriter*) {})));
+}
@@ -53,11 +53,11 @@ set(PROCESS_DEPENDENCIES
   ${HTTP_PARSER_TARGET}
   )
 
-if (NOT ENABLE_LIBEVENT)
-  set(PROCESS_DEPENDENCIES ${PROCESS_DEPENDENCIES} ${LIBEV_TARGET})
-elseif (ENABLE_LIBEVENT)
+if (ENABLE_LIBEVENT)
   set(PROCESS_DEPENDENCIES ${PROCESS_DEPENDENCIES} ${LIBEVENT_TARGET})
-endif (NOT ENABLE_LIBEVENT)
+elseif (NOT ENABLE_EPOLL)
+  set(PROCESS_DEPENDENCIES ${PROCESS_DEPENDENCIES} ${LIBEV_TARGET})
+endif (ENABLE_LIBEVENT)
 
 if (WIN32)
   set(PROCESS_DEPENDENCIES
@@ -76,11 +76,11 @@ set(PROCESS_INCLUDE_DIRS
   ${HTTP_PARSER_INCLUDE_DIR}
   )
 
-if (NOT ENABLE_LIBEVENT)
-  set(PROCESS_INCLUDE_DIRS ${PROCESS_INCLUDE_DIRS} ${LIBEV_INCLUDE_DIR})
-elseif (ENABLE_LIBEVENT)
+if (ENABLE_LIBEVENT)
   set(PROCESS_INCLUDE_DIRS ${PROCESS_INCLUDE_DIRS} ${LIBEVENT_INCLUDE_DIR})
-endif (NOT ENABLE_LIBEVENT)
+elseif (NOT ENABLE_EPOLL)
+  set(PROCESS_INCLUDE_DIRS ${PROCESS_INCLUDE_DIRS} ${LIBEV_INCLUDE_DIR})
+endif (ENABLE_LIBEVENT)
 
 if (HAS_GPERFTOOLS)
   set(PROCESS_INCLUDE_DIRS ${PROCESS_INCLUDE_DIRS} ${GPERFTOOLS_INCLUDE_DIR})
@@ -103,11 +103,11 @@ set(PROCESS_LIB_DIRS
   ${HTTP_PARSER_LIB_DIR}
   )
 
-if (NOT ENABLE_LIBEVENT)
-  set(PROCESS_LIB_DIRS ${PROCESS_LIB_DIRS} ${LIBEV_LIB_DIR})
-elseif (ENABLE_LIBEVENT)
+if (ENABLE_LIBEVENT)
   set(PROCESS_LIB_DIRS ${PROCESS_LIB_DIRS} ${LIBEVENT_LIB_DIR})
-endif (NOT ENABLE_LIBEVENT)
+elseif (NOT ENABLE_EPOLL)
+  set(PROCESS_LIB_DIRS ${PROCESS_LIB_DIRS} ${LIBEV_LIB_DIR})
+endif (ENABLE_LIBEVENT)
 
 if (WIN32)
   set(PROCESS_LIB_DIRS
@@ -127,11 +127,11 @@ set(PROCESS_LIBS
   ${HTTP_PARSER_LFLAG}
   )
 
-if (NOT ENABLE_LIBEVENT)
-  set(PROCESS_LIBS ${PROCESS_LIBS} ${LIBEV_LFLAG})
-elseif (ENABLE_LIBEVENT)
+if (ENABLE_LIBEVENT)
   set(PROCESS_LIBS ${PROCESS_LIBS} ${LIBEVENT_LFLAG})
-endif (NOT ENABLE_LIBEVENT)
+elseif (NOT ENABLE_EPOLL)
+  set(PROCESS_LIBS ${PROCESS_LIBS} ${LIBEV_LFLAG})
+endif (ENABLE_LIBEVENT)
 
 if (NOT WIN32)
   find_package(ZLIB REQUIRED)
@@ -155,8 +155,10 @@ private:
 
   AsyncExecutor()
   {
-    process = new AsyncExecutorProcess();
-    spawn(process, true); // Automatically GC.
+    // NOTE: We only keep the PID since the process might already have
+    // been terminated and deleted (e.g., during 'process::finalize')
+    // by the time we dispatch to it.
+    pid = spawn(new AsyncExecutorProcess(), true); // Automatically GC.
   }
 
   virtual ~AsyncExecutor() {}
@@ -174,7 +176,7 @@ private:
     typename result_of<F()>::type(AsyncExecutorProcess::*method)(const F&, typename boost::disable_if<boost::is_void<typename result_of<F()>::type> >::type*) = // NOLINT(whitespace/line_length)
       &AsyncExecutorProcess::execute<F>;
 
-    return dispatch(process, method, f, (void*) NULL);
+    return dispatch(pid, method, f, (void*) NULL);
   }
 
   template <typename F>
@@ -186,7 +188,7 @@ private:
     Nothing(AsyncExecutorProcess::*method)(const F&, typename boost::enable_if<boost::is_void<typename result_of<F()>::type> >::type*) = // NOLINT(whitespace/line_length)
       &AsyncExecutorProcess::execute<F>;
 
-    return dispatch(process, method, f, (void*) NULL);
+    return dispatch(pid, method, f, (void*) NULL);
   }
 
 #define TEMPLATE(Z, N, DATA)                                            \
@@ -200,7 +202,7 @@ private:
     typename result_of<F(ENUM_PARAMS(N, A))>::type(AsyncExecutorProcess::*method)(const F&, ENUM_PARAMS(N, A), typename boost::disable_if<boost::is_void<typename result_of<F(ENUM_PARAMS(N, A))>::type> >::type*) = /* NOLINT(whitespace/line_length) */ \
       &AsyncExecutorProcess::execute<F, ENUM_PARAMS(N, A)>;             \
                                                                         \
-    return dispatch(process, method, f, ENUM_PARAMS(N, a), (void*) NULL); \
+    return dispatch(pid, method, f, ENUM_PARAMS(N, a), (void*) NULL);   \
   }                                                                     \
                                                                         \
   template <typename F, ENUM_PARAMS(N, typename A)>                     \
@@ -213,13 +215,13 @@ private:
     Nothing(AsyncExecutorProcess::*method)(const F&, ENUM_PARAMS(N, A), typename boost::enable_if<boost::is_void<typename result_of<F(ENUM_PARAMS(N, A))>::type> >::type*) = /* NOLINT(whitespace/line_length) */ \
       &AsyncExecutorProcess::execute<F, ENUM_PARAMS(N, A)>;             \
                                                                         \
-    return dispatch(process, method, f, ENUM_PARAMS(N, a), (void*) NULL); \
+    return dispatch(pid, method, f, ENUM_PARAMS(N, a), (void*) NULL);   \
   }
 
   REPEAT_FROM_TO(1, 11, TEMPLATE, _) // Args A0 -> A9.
 #undef TEMPLATE
 
-  AsyncExecutorProcess* process;
+  PID<AsyncExecutorProcess> pid;
 };
 
 
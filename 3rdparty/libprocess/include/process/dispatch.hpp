@@ -16,6 +16,7 @@
 #include <functional>
 #include <memory> // TODO(benh): Replace shared_ptr with unique_ptr.
 #include <string>
+#include <utility>
 
 #include <process/process.hpp>
 
@@ -58,12 +59,13 @@ namespace internal {
 // this routine does not expect anything in particular about the
 // specified function (second argument). The semantics are simple: the
 // function gets applied/invoked with the process as its first
-// argument. Currently we wrap the function in a shared_ptr but this
-// will probably change in the future to unique_ptr (or a variant).
+// argument. The function is moved into the dispatch event (see
+// 'DispatchFunction'), so small functions are never heap allocated.
 void dispatch(
     const UPID& pid,
-    const std::shared_ptr<std::function<void(ProcessBase*)>>& f,
-    const Option<const std::type_info*>& functionType = None());
+    DispatchFunction&& f,
+    const Option<const std::type_info*>& functionType = None(),
+    const Option<MethodId>& method = None());
 
 } // namespace internal {
 
@@ -79,16 +81,15 @@ void dispatch(
 template <typename T>
 void dispatch(const PID<T>& pid, void (T::*method)())
 {
-  std::shared_ptr<std::function<void(ProcessBase*)>> f(
-      new std::function<void(ProcessBase*)>(
-          [=](ProcessBase* process) {
-            assert(process != NULL);
-            T* t = dynamic_cast<T*>(process);
-            assert(t != NULL);
-            (t->*method)();
-          }));
-
-  internal::dispatch(pid, f, &typeid(method));
+  DispatchFunction f(
+      [=](ProcessBase* process) {
+        assert(process != NULL);
+        T* t = dynamic_cast<T*>(process);
+        assert(t != NULL);
+        (t->*method)();
+      });
+
+  internal::dispatch(pid, std::move(f), &typeid(method), MethodId(method));
 }
 
 template <typename T>
@@ -115,16 +116,16 @@ void dispatch(const Process<T>* process, void (T::*method)())
       void (T::*method)(ENUM_PARAMS(N, P)),                             \
       ENUM_BINARY_PARAMS(N, A, a))                                      \
   {                                                                     \
-    std::shared_ptr<std::function<void(ProcessBase*)>> f(               \
-        new std::function<void(ProcessBase*)>(                          \
-            [=](ProcessBase* process) {                                 \
-              assert(process != NULL);                                  \
-              T* t = dynamic_cast<T*>(process);                         \
-              assert(t != NULL);                                        \
-              (t->*method)(ENUM_PARAMS(N, a));                          \
-            }));                                                        \
+    DispatchFunction f(                                                 \
+        [=](ProcessBase* process) {                                     \
+          assert(process != NULL);                                      \
+          T* t = dynamic_cast<T*>(process);                             \
+          assert(t != NULL);                                            \
+          (t->*method)(ENUM_PARAMS(N, a));                              \
+        });                                                             \
                                                                         \
-    internal::dispatch(pid, f, &typeid(method));                        \
+    internal::dispatch(                                                 \
+        pid, std::move(f), &typeid(method), MethodId(method));          \
   }                                                                     \
                                                                         \
   template <typename T,                                                 \
@@ -160,16 +161,15 @@ Future<R> dispatch(const PID<T>& pid, Future<R> (T::*method)())
 {
   std::shared_ptr<Promise<R>> promise(new Promise<R>());
 
-  std::shared_ptr<std::function<void(ProcessBase*)>> f(
-      new std::function<void(ProcessBase*)>(
-          [=](ProcessBase* process) {
-            assert(process != NULL);
-            T* t = dynamic_cast<T*>(process);
-            assert(t != NULL);
-            promise->associate((t->*method)());
-          }));
+  DispatchFunction f(
+      [=](ProcessBase* process) {
+        assert(process != NULL);
+        T* t = dynamic_cast<T*>(process);
+        assert(t != NULL);
+        promise->associate((t->*method)());
+      });
 
-  internal::dispatch(pid, f, &typeid(method));
+  internal::dispatch(pid, std::move(f), &typeid(method), MethodId(method));
 
   return promise->future();
 }
@@ -198,16 +198,16 @@ Future<R> dispatch(const Process<T>* process, Future<R> (T::*method)())
   {                                                                     \
     std::shared_ptr<Promise<R>> promise(new Promise<R>());              \
                                                                         \
-    std::shared_ptr<std::function<void(ProcessBase*)>> f(               \
-        new std::function<void(ProcessBase*)>(                          \
-            [=](ProcessBase* process) {                                 \
-              assert(process != NULL);                                  \
-              T* t = dynamic_cast<T*>(process);                         \
-              assert(t != NULL);                                        \
-              promise->associate((t->*method)(ENUM_PARAMS(N, a)));      \
-            }));                                                        \
+    DispatchFunction f(                                                 \
+        [=](ProcessBase* process) {                                     \
+          assert(process != NULL);                                      \
+          T* t = dynamic_cast<T*>(process);                             \
+          assert(t != NULL);                                            \
+          promise->associate((t->*method)(ENUM_PARAMS(N, a)));          \
+        });                                                             \
                                                                         \
-    internal::dispatch(pid, f, &typeid(method));                        \
+    internal::dispatch(                                                 \
+        pid, std::move(f), &typeid(method), MethodId(method));          \
                                                                         \
     return promise->future();                                           \
   }                                                                     \
@@ -247,16 +247,15 @@ Future<R> dispatch(const PID<T>& pid, R (T::*method)())
 {
   std::shared_ptr<Promise<R>> promise(new Promise<R>());
 
-  std::shared_ptr<std::function<void(ProcessBase*)>> f(
-      new std::function<void(ProcessBase*)>(
-          [=](ProcessBase* process) {
-            assert(process != NULL);
-            T* t = dynamic_cast<T*>(process);
-            assert(t != NULL);
-            promise->set((t->*method)());
-          }));
+  DispatchFunction f(
+      [=](ProcessBase* process) {
+        assert(process != NULL);
+        T* t = dynamic_cast<T*>(process);
+        assert(t != NULL);
+        promise->set((t->*method)());
+      });
 
-  internal::dispatch(pid, f, &typeid(method));
+  internal::dispatch(pid, std::move(f), &typeid(method), MethodId(method));
 
   return promise->future();
 }
@@ -285,16 +284,16 @@ Future<R> dispatch(const Process<T>* process, R (T::*method)())
   {                                                                     \
     std::shared_ptr<Promise<R>> promise(new Promise<R>());              \
                                                                         \
-    std::shared_ptr<std::function<void(ProcessBase*)>> f(               \
-        new std::function<void(ProcessBase*)>(                          \
-            [=](ProcessBase* process) {                                 \
-              assert(process != NULL);                                  \
-              T* t = dynamic_cast<T*>(process);                         \
-              assert(t != NULL);                                        \
-              promise->set((t->*method)(ENUM_PARAMS(N, a)));            \
-            }));                                                        \
+    DispatchFunction f(                                                 \
+        [=](ProcessBase* process) {                                     \
+          assert(process != NULL);                                      \
+          T* t = dynamic_cast<T*>(process);                             \
+          assert(t != NULL);                                            \
+          promise->set((t->*method)(ENUM_PARAMS(N, a)));                \
+        });                                                             \
                                                                         \
-    internal::dispatch(pid, f, &typeid(method));                        \
+    internal::dispatch(                                                 \
+        pid, std::move(f), &typeid(method), MethodId(method));          \
                                                                         \
     return promise->future();                                           \
   }                                                                     \
@@ -329,13 +328,12 @@ Future<R> dispatch(const Process<T>* process, R (T::*method)())
 
 inline void dispatch(const UPID& pid, const std::function<void()>& f)
 {
-  std::shared_ptr<std::function<void(ProcessBase*)>> f_(
-      new std::function<void(ProcessBase*)>(
-          [=](ProcessBase*) {
-            f();
-          }));
+  DispatchFunction f_(
+      [=](ProcessBase*) {
+        f();
+      });
 
-  internal::dispatch(pid, f_);
+  internal::dispatch(pid, std::move(f_));
 }
 
 
@@ -344,13 +342,12 @@ Future<R> dispatch(const UPID& pid, const std::function<Future<R>()>& f)
 {
   std::shared_ptr<Promise<R>> promise(new Promise<R>());
 
-  std::shared_ptr<std::function<void(ProcessBase*)>> f_(
-      new std::function<void(ProcessBase*)>(
-          [=](ProcessBase*) {
-            promise->associate(f());
-          }));
+  DispatchFunction f_(
+      [=](ProcessBase*) {
+        promise->associate(f());
+      });
 
-  internal::dispatch(pid, f_);
+  internal::dispatch(pid, std::move(f_));
 
   return promise->future();
 }
@@ -361,13 +358,12 @@ Future<R> dispatch(const UPID& pid, const std::function<R()>& f)
 {
   std::shared_ptr<Promise<R>> promise(new Promise<R>());
 
-  std::shared_ptr<std::function<void(ProcessBase*)>> f_(
-      new std::function<void(ProcessBase*)>(
-          [=](ProcessBase*) {
-            promise->set(f());
-          }));
+  DispatchFunction f_(
+      [=](ProcessBase*) {
+        promise->set(f());
+      });
 
-  internal::dispatch(pid, f_);
+  internal::dispatch(pid, std::move(f_));
 
   return promise->future();
 }
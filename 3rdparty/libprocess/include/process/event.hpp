@@ -13,7 +13,15 @@
 #ifndef __PROCESS_EVENT_HPP__
 #define __PROCESS_EVENT_HPP__
 
+#include <stddef.h>
+#include <string.h>
+
+#include <chrono>
 #include <memory> // TODO(benh): Replace shared_ptr with unique_ptr.
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
 
 #include <process/future.hpp>
 #include <process/http.hpp>
@@ -26,6 +34,7 @@
 namespace process {
 
 // Forward declarations.
+class EventQueue;
 class ProcessBase;
 struct MessageEvent;
 struct DispatchEvent;
@@ -49,6 +58,17 @@ struct Event
 {
   virtual ~Event() {}
 
+  // Events are allocated from per-thread pools rather than directly
+  // from the heap since every dispatch, message and HTTP request
+  // results in at least one event.
+  static void* operator new(size_t size);
+  static void operator delete(void* event, size_t size);
+
+  // Class specific allocation functions hide the global placement
+  // forms, which are still needed (e.g., by 'Option').
+  static void* operator new(size_t, void* place) { return place; }
+  static void operator delete(void*, void*) {}
+
   virtual void visit(EventVisitor* visitor) const = 0;
 
   template <typename T>
@@ -81,6 +101,19 @@ struct Event
     }
     return *result;
   }
+
+  // The time (of the monotonic clock) at which the event was enqueued
+  // for a process that timestamps its events (see
+  // `ProcessBase::timestampEvents`), so that the process can tell how
+  // long the event has been queued. Left at the epoch otherwise.
+  std::chrono::steady_clock::time_point enqueued;
+
+private:
+  friend class EventQueue;
+
+  // Intrusive link used while the event is queued for the receiving
+  // process, so that enqueueing an event never allocates.
+  Event* next = NULL;
 };
 
 
@@ -90,7 +123,8 @@ struct MessageEvent : Event
     : message(_message) {}
 
   MessageEvent(const MessageEvent& that)
-    : message(that.message == NULL ? NULL : new Message(*that.message)) {}
+    : Event(that),
+      message(that.message == NULL ? NULL : new Message(*that.message)) {}
 
   virtual ~MessageEvent()
   {
@@ -145,15 +179,174 @@ private:
 };
 
 
+// A move-only, type-erased function invoked with the process that a
+// dispatch is delivered to. Unlike 'std::function' this stores any
+// function object of up to 'CAPACITY' bytes inline, so that a
+// dispatch (whose function captures the method pointer and its
+// arguments) does not need a heap allocation beyond the event itself.
+class DispatchFunction
+{
+public:
+  static const size_t CAPACITY = 128;
+
+  template <typename F>
+  explicit DispatchFunction(F&& f)
+  {
+    typedef typename std::decay<F>::type T;
+
+    static_assert(
+        std::is_move_constructible<T>::value,
+        "Dispatched functions must be move constructible");
+
+    ops = &Ops<T>::ops;
+
+    if (Ops<T>::INLINE) {
+      new (&storage) T(std::forward<F>(f));
+    } else {
+      heap = new T(std::forward<F>(f));
+    }
+  }
+
+  DispatchFunction(DispatchFunction&& that)
+    : ops(that.ops)
+  {
+    ops->move(&that, this);
+  }
+
+  ~DispatchFunction()
+  {
+    ops->destroy(this);
+  }
+
+  void operator()(ProcessBase* process) const
+  {
+    ops->invoke(this, process);
+  }
+
+private:
+  // Not copyable, not assignable.
+  DispatchFunction(const DispatchFunction&);
+  DispatchFunction& operator=(const DispatchFunction&);
+
+  typedef std::aligned_storage<CAPACITY>::type Storage;
+
+  struct Operations
+  {
+    void (*invoke)(const DispatchFunction*, ProcessBase*);
+    void (*move)(DispatchFunction*, DispatchFunction*);
+    void (*destroy)(DispatchFunction*);
+  };
+
+  template <typename T>
+  struct Ops
+  {
+    static const bool INLINE =
+      sizeof(T) <= CAPACITY && alignof(T) <= alignof(Storage);
+
+    static T* get(DispatchFunction* function)
+    {
+      return INLINE
+        ? reinterpret_cast<T*>(&function->storage)
+        : static_cast<T*>(function->heap);
+    }
+
+    static void invoke(const DispatchFunction* function, ProcessBase* process)
+    {
+      (*get(const_cast<DispatchFunction*>(function)))(process);
+    }
+
+    static void move(DispatchFunction* from, DispatchFunction* to)
+    {
+      if (INLINE) {
+        new (&to->storage) T(std::move(*get(from)));
+      } else {
+        // Steal the heap allocated function, leaving 'from' to
+        // destroy nothing.
+        to->heap = from->heap;
+        from->heap = NULL;
+      }
+    }
+
+    static void destroy(DispatchFunction* function)
+    {
+      if (INLINE) {
+        get(function)->~T();
+      } else {
+        delete get(function);
+      }
+    }
+
+    static const Operations ops;
+  };
+
+  const Operations* ops;
+
+  union
+  {
+    Storage storage;
+    void* heap;
+  };
+};
+
+
+template <typename T>
+const DispatchFunction::Operations DispatchFunction::Ops<T>::ops = {
+  &DispatchFunction::Ops<T>::invoke,
+  &DispatchFunction::Ops<T>::move,
+  &DispatchFunction::Ops<T>::destroy
+};
+
+
+// Identifies the method that a dispatch invokes by the bytes of the
+// pointer to it (the type of the pointer only identifies the signature
+// of the method, which many methods of a process may share). The bytes
+// are kept inline so that a dispatch does not allocate for them.
+class MethodId
+{
+public:
+  template <typename Method>
+  explicit MethodId(Method method)
+  {
+    static_assert(
+        sizeof(Method) <= sizeof(bytes),
+        "Pointer to method does not fit in 'MethodId'");
+
+    memset(bytes, 0, sizeof(bytes));
+    memcpy(bytes, &method, sizeof(method));
+  }
+
+  bool operator==(const MethodId& that) const
+  {
+    return memcmp(bytes, that.bytes, sizeof(bytes)) == 0;
+  }
+
+  bool operator!=(const MethodId& that) const
+  {
+    return !(*this == that);
+  }
+
+  // Returns the bytes as a string, e.g., to key a map by the method.
+  std::string str() const
+  {
+    return std::string(bytes, sizeof(bytes));
+  }
+
+private:
+  char bytes[4 * sizeof(void*)];
+};
+
+
 struct DispatchEvent : Event
 {
   DispatchEvent(
       const UPID& _pid,
-      const std::shared_ptr<lambda::function<void(ProcessBase*)>>& _f,
-      const Option<const std::type_info*>& _functionType)
+      DispatchFunction&& _f,
+      const Option<const std::type_info*>& _functionType,
+      const Option<MethodId>& _method = None())
     : pid(_pid),
-      f(_f),
-      functionType(_functionType)
+      f(std::move(_f)),
+      functionType(_functionType),
+      method(_method)
   {}
 
   virtual void visit(EventVisitor* visitor) const
@@ -165,10 +358,14 @@ struct DispatchEvent : Event
   const UPID pid;
 
   // Function to get invoked as a result of this dispatch event.
-  const std::shared_ptr<lambda::function<void(ProcessBase*)>> f;
+  const DispatchFunction f;
 
   const Option<const std::type_info*> functionType;
 
+  // Method getting invoked as a result of this dispatch event, if the
+  // dispatch was of a method (rather than of an arbitrary function).
+  const Option<MethodId> method;
+
 private:
   // Not copyable, not assignable.
   DispatchEvent(const DispatchEvent&);
@@ -22,6 +22,7 @@
 #include <memory>
 #include <queue>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <boost/functional/hash.hpp>
@@ -49,6 +50,8 @@ namespace process {
 template <typename T>
 class Future;
 
+class RateLimiter;
+
 namespace network {
 class Socket;
 } // namespace network {
@@ -223,45 +226,6 @@ typedef hashmap<std::string,
                 CaseInsensitiveEqual> Headers;
 
 
-struct Request
-{
-  std::string method;
-
-  // TODO(benh): Add major/minor version.
-
-  // For client requests, the URL should be a URI.
-  // For server requests, the URL may be a URI or a relative reference.
-  URL url;
-
-  Headers headers;
-
-  // TODO(bmahler): Add a 'query' field which contains both
-  // the URL query and the parsed form data from the body.
-
-  std::string body;
-
-  // TODO(bmahler): Ensure this is consistent with the 'Connection'
-  // header; perhaps make this a function that checks the header.
-  bool keepAlive;
-
-  // For server requests, this contains the address of the client.
-  // Note that this may correspond to a proxy or load balancer address.
-  network::Address client;
-
-  /**
-   * Returns whether the encoding is considered acceptable in the
-   * response. See RFC 2616 section 14.3 for details.
-   */
-  bool acceptsEncoding(const std::string& encoding) const;
-
-  /**
-   * Returns whether the media type is considered acceptable in the
-   * response. See RFC 2616, section 14.1 for the details.
-   */
-  bool acceptsMediaType(const std::string& mediaType) const;
-};
-
-
 // Represents an asynchronous in-memory unbuffered Pipe, currently
 // used for streaming HTTP responses via chunked encoding. Note that
 // being an in-memory pipe means that this cannot be used across OS
@@ -313,6 +277,12 @@ public:
     // is closed.
     Future<std::string> read();
 
+    // Performs a series of asynchronous reads, until EOF is reached.
+    // Returns the concatenated result of the reads.
+    // Returns Failure if the writer failed, or the read-end
+    // is closed.
+    Future<std::string> readAll();
+
     // Closing the read-end of the pipe before the write-end closes
     // or fails will notify the writer that the reader is no longer
     // interested. Returns false if the read-end was already closed.
@@ -359,6 +329,12 @@ public:
     // was unable to continue reading!
     Future<Nothing> readerClosed() const;
 
+    // Returns Nothing once no more than 'size' bytes written to the
+    // pipe remain unread, or once either end of the pipe is closed
+    // (or failed). This lets writers apply backpressure, e.g., by not
+    // reading more data from a socket until the reader has caught up.
+    Future<Nothing> drained(size_t size = 0) const;
+
     // Comparison operators useful for checking connection equality.
     bool operator==(const Writer& other) const { return data == other.data; }
     bool operator!=(const Writer& other) const { return !(*this == other); }
@@ -390,7 +366,12 @@ private:
   {
     Data()
       : readEnd(Reader::OPEN),
-        writeEnd(Writer::OPEN) {}
+        writeEnd(Writer::OPEN),
+        unread(0) {}
+
+    // Returns (and removes) the drains that are satisfied.
+    // NOTE: The 'lock' must be held.
+    std::vector<Owned<Promise<Nothing>>> drained();
 
     // Rather than use a process to serialize access to the pipe's
     // internal data we use a 'std::atomic_flag'.
@@ -406,6 +387,13 @@ private:
     // empty strings as they serve as a signal for end-of-file.
     std::queue<std::string> writes;
 
+    // Total size of the unread 'writes'.
+    size_t unread;
+
+    // Represents writers waiting for the unread writes to drain to
+    // (at most) the specified size.
+    std::vector<std::pair<size_t, Owned<Promise<Nothing>>>> drains;
+
     // Signals when the read-end is closed before the write-end.
     Promise<Nothing> readerClosure;
 
@@ -417,14 +405,73 @@ private:
 };
 
 
+struct Request
+{
+  Request() : keepAlive(false), type(BODY) {}
+
+  std::string method;
+
+  // TODO(benh): Add major/minor version.
+
+  // For client requests, the URL should be a URI.
+  // For server requests, the URL may be a URI or a relative reference.
+  URL url;
+
+  Headers headers;
+
+  // TODO(bmahler): Add a 'query' field which contains both
+  // the URL query and the parsed form data from the body.
+
+  // TODO(bmahler): Ensure this is consistent with the 'Connection'
+  // header; perhaps make this a function that checks the header.
+  bool keepAlive;
+
+  // For server requests, the body is either buffered into 'body'
+  // (BODY) or, for routes that have requested streaming (see
+  // 'ProcessBase::RouteOptions'), delivered through 'reader' while
+  // it is being received (PIPE). Client requests only support BODY.
+  //
+  // PIPE: The reader must be read until end-of-file (or closed) for
+  // the connection to make progress, since no more data is received
+  // from the socket while too much of the body remains unread. The
+  // reader is closed once the response is ready, unless it is a PIPE
+  // response.
+  enum
+  {
+    BODY,
+    PIPE
+  } type;
+
+  std::string body;
+  Option<Pipe::Reader> reader;
+
+  // For server requests, this contains the address of the client.
+  // Note that this may correspond to a proxy or load balancer address.
+  network::Address client;
+
+  /**
+   * Returns whether the encoding is considered acceptable in the
+   * response. See RFC 2616 section 14.3 for details.
+   */
+  bool acceptsEncoding(const std::string& encoding) const;
+
+  /**
+   * Returns whether the media type is considered acceptable in the
+   * response. See RFC 2616, section 14.1 for the details.
+   */
+  bool acceptsMediaType(const std::string& mediaType) const;
+};
+
+
 struct Response
 {
   Response()
-    : type(NONE)
+    : type(NONE),
+      offset(0)
   {}
 
   Response(uint16_t _code)
-    : type(NONE), code(_code)
+    : type(NONE), offset(0), code(_code)
   {
     status = Status::string(code);
   }
@@ -434,6 +481,7 @@ struct Response
       uint16_t _code)
     : type(BODY),
       body(_body),
+      offset(0),
       code(_code)
   {
     headers["Content-Length"] = stringify(body.size());
@@ -454,7 +502,8 @@ struct Response
   // already specified.
   //
   // PATH: Attempts to perform a 'sendfile' operation on the file
-  // found at 'path'.
+  // found at 'path' (or the part of it given by 'offset' and
+  // 'length' below).
   //
   // PIPE: Splices data from the Pipe 'reader' using a "chunked"
   // 'Transfer-Encoding'. The writer uses a Pipe::Writer to
@@ -478,6 +527,20 @@ struct Response
   std::string path;
   Option<Pipe::Reader> reader;
 
+  // PATH only: sends at most 'length' bytes (by default up to the end
+  // of the file) starting at 'offset', both clamped to the size of the
+  // file at the time it is sent. For '206 Partial Content' responses
+  // the 'Content-Range' header is filled in. If the whole file is
+  // requested, a (single) range in the 'Range' header of the request
+  // is honored.
+  //
+  // If set, a permit of the 'limiter' is acquired for every byte
+  // before it is sent, which limits the bandwidth used by all the
+  // responses sharing the limiter.
+  size_t offset;
+  Option<size_t> length;
+  std::shared_ptr<RateLimiter> limiter;
+
   uint16_t code;
 };
 
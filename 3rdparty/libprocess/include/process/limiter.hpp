@@ -50,6 +50,12 @@ public:
   // Discarding this future cancels this acquisition.
   virtual Future<Nothing> acquire();
 
+  // Acquires several permits at once, e.g., one per byte to limit the
+  // bandwidth of a transfer. The permits are granted together, and
+  // the next acquisition has to wait for as long as it takes to
+  // accumulate all of them.
+  virtual Future<Nothing> acquire(size_t permits);
+
 private:
   // Not copyable, not assignable.
   RateLimiter(const RateLimiter&);
@@ -84,14 +90,16 @@ public:
       delete promise;
     }
     promises.clear();
+    counts.clear();
   }
 
-  Future<Nothing> acquire()
+  Future<Nothing> acquire(size_t permits)
   {
     if (!promises.empty()) {
       // Need to wait for others to get permits first.
       Promise<Nothing>* promise = new Promise<Nothing>();
       promises.push_back(promise);
+      counts.push_back(permits);
       return promise->future()
         .onDiscard(defer(self(), &Self::discard, promise->future()));
     }
@@ -100,13 +108,14 @@ public:
       // Need to wait a bit longer, but first one in the queue.
       Promise<Nothing>* promise = new Promise<Nothing>();
       promises.push_back(promise);
+      counts.push_back(permits);
       delay(timeout.remaining(), self(), &Self::_acquire);
       return promise->future()
         .onDiscard(defer(self(), &Self::discard, promise->future()));
     }
 
     // No need to wait!
-    timeout = Seconds(1) / permitsPerSecond;
+    timeout = Seconds(1) * (permits / permitsPerSecond);
     return Nothing();
   }
 
@@ -123,11 +132,13 @@ private:
     // whose future is not discarded.
     while (!promises.empty()) {
       Promise<Nothing>* promise = promises.front();
+      size_t permits = counts.front();
       promises.pop_front();
+      counts.pop_front();
       if (!promise->future().isDiscarded()) {
         promise->set(Nothing());
         delete promise;
-        timeout = Seconds(1) / permitsPerSecond;
+        timeout = Seconds(1) * (permits / permitsPerSecond);
         break;
       } else {
         delete promise;
@@ -154,6 +165,9 @@ private:
   Timeout timeout;
 
   std::deque<Promise<Nothing>*> promises;
+
+  // The number of permits requested by each of the 'promises'.
+  std::deque<size_t> counts;
 };
 
 
@@ -181,7 +195,13 @@ inline RateLimiter::~RateLimiter()
 
 inline Future<Nothing> RateLimiter::acquire()
 {
-  return dispatch(process, &RateLimiterProcess::acquire);
+  return acquire(1);
+}
+
+
+inline Future<Nothing> RateLimiter::acquire(size_t permits)
+{
+  return dispatch(process, &RateLimiterProcess::acquire, permits);
 }
 
 } // namespace process {
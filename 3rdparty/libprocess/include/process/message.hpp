@@ -13,6 +13,8 @@
 #ifndef __PROCESS_MESSAGE_HPP__
 #define __PROCESS_MESSAGE_HPP__
 
+#include <stddef.h>
+
 #include <string>
 
 #include <process/pid.hpp>
@@ -21,6 +23,16 @@ namespace process {
 
 struct Message
 {
+  // Messages are allocated from the same per-thread pools as events
+  // (see 'Event::operator new').
+  static void* operator new(size_t size);
+  static void operator delete(void* message, size_t size);
+
+  // Class specific allocation functions hide the global placement
+  // forms, which are still needed (e.g., by 'Option').
+  static void* operator new(size_t, void* place) { return place; }
+  static void operator delete(void*, void*) {}
+
   std::string name;
   UPID from;
   UPID to;
@@ -0,0 +1,88 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __PROCESS_METRICS_PUSH_GAUGE_HPP__
+#define __PROCESS_METRICS_PUSH_GAUGE_HPP__
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include <process/metrics/metric.hpp>
+
+namespace process {
+namespace metrics {
+
+// A Metric that represents an instantaneous value which is published
+// by its owner whenever it changes. Unlike a 'Gauge', whose value is
+// pulled from (i.e., dispatched to) the owning process, the value of
+// a PushGauge is readily available, so snapshots never wait behind a
+// busy owner. Updates are lock-free and may be done from any thread.
+class PushGauge : public Metric
+{
+public:
+  // 'name' is the unique name for the instance of PushGauge being
+  // constructed. It will be the key exposed in the JSON endpoint.
+  explicit PushGauge(const std::string& name)
+    : Metric(name, None()),
+      data(new Data()) {}
+
+  virtual ~PushGauge() {}
+
+  virtual Future<double> value() const
+  {
+    return data->value.load();
+  }
+
+  PushGauge& operator=(double v)
+  {
+    data->value.store(v);
+    return *this;
+  }
+
+  PushGauge& operator++()
+  {
+    return *this += 1;
+  }
+
+  PushGauge& operator--()
+  {
+    return *this -= 1;
+  }
+
+  PushGauge& operator+=(double v)
+  {
+    double current = data->value.load();
+    while (!data->value.compare_exchange_weak(current, current + v)) {}
+    return *this;
+  }
+
+  PushGauge& operator-=(double v)
+  {
+    return *this += -v;
+  }
+
+private:
+  struct Data
+  {
+    Data() : value(0) {}
+
+    std::atomic<double> value;
+  };
+
+  std::shared_ptr<Data> data;
+};
+
+} // namespace metrics {
+} // namespace process {
+
+#endif // __PROCESS_METRICS_PUSH_GAUGE_HPP__
@@ -87,6 +87,19 @@ public:
     return t;
   }
 
+  // Records an event that was timed by the caller, e.g., with a
+  // `Stopwatch`.
+  void record(const Duration& duration)
+  {
+    const double value = T(duration).value();
+
+    synchronized (data->lock) {
+      data->lastValue = value;
+    }
+
+    push(value);
+  }
+
   // Time an asynchronous event.
   template <typename U>
   Future<U> time(const Future<U>& future)
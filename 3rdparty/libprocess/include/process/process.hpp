@@ -15,6 +15,7 @@
 
 #include <stdint.h>
 
+#include <atomic>
 #include <map>
 #include <queue>
 #include <vector>
@@ -38,7 +39,8 @@
 
 namespace process {
 
-// Forward declaration.
+// Forward declarations.
+class EventQueue;
 class Sequence;
 
 namespace firewall {
@@ -223,6 +225,22 @@ protected:
   typedef lambda::function<Future<http::Response>(const http::Request&)>
   HttpRequestHandler;
 
+  /**
+   * Options to control the behavior of a route.
+   */
+  struct RouteOptions
+  {
+    RouteOptions() : requestStreaming(false) {}
+
+    /**
+     * Whether the request body should be streamed to the handler
+     * through `http::Request::reader` (i.e., the request is of type
+     * `http::Request::PIPE`) rather than being buffered into
+     * `http::Request::body` before the handler is invoked.
+     */
+    bool requestStreaming;
+  };
+
   /**
    * Sets up a handler for HTTP requests with the specified name.
    *
@@ -232,7 +250,8 @@ protected:
   void route(
       const std::string& name,
       const Option<std::string>& help,
-      const HttpRequestHandler& handler);
+      const HttpRequestHandler& handler,
+      const RouteOptions& options = RouteOptions());
 
   /**
    * @copydoc process::ProcessBase::route
@@ -241,14 +260,15 @@ protected:
   void route(
       const std::string& name,
       const Option<std::string>& help,
-      Future<http::Response> (T::*method)(const http::Request&))
+      Future<http::Response> (T::*method)(const http::Request&),
+      const RouteOptions& options = RouteOptions())
   {
     // Note that we use dynamic_cast here so a process can use
     // multiple inheritance if it sees so fit (e.g., to implement
     // multiple callback interfaces).
     HttpRequestHandler handler =
       lambda::bind(method, dynamic_cast<T*>(this), lambda::_1);
-    route(name, help, handler);
+    route(name, help, handler, options);
   }
 
   /**
@@ -275,7 +295,8 @@ protected:
       const std::string& name,
       const std::string& realm,
       const Option<std::string>& help,
-      const AuthenticatedHttpRequestHandler& handler);
+      const AuthenticatedHttpRequestHandler& handler,
+      const RouteOptions& options = RouteOptions());
 
   /**
    * @copydoc process::ProcessBase::route
@@ -287,14 +308,15 @@ protected:
       const Option<std::string>& help,
       Future<http::Response> (T::*method)(
           const http::Request&,
-          const Option<std::string>&))
+          const Option<std::string>&),
+      const RouteOptions& options = RouteOptions())
   {
     // Note that we use dynamic_cast here so a process can use
     // multiple inheritance if it sees so fit (e.g., to implement
     // multiple callback interfaces).
     AuthenticatedHttpRequestHandler handler =
       lambda::bind(method, dynamic_cast<T*>(this), lambda::_1, lambda::_2);
-    route(name, realm, help, handler);
+    route(name, realm, help, handler, options);
   }
 
   /**
@@ -324,6 +346,17 @@ protected:
     assets[name] = asset;
   }
 
+  /**
+   * Makes libprocess timestamp the events enqueued for this process
+   * (see `Event::enqueued`), e.g., to tell how long they were queued.
+   * This reads the monotonic clock for every event, which only the
+   * processes that ask for it pay for.
+   */
+  void timestampEvents(bool enabled)
+  {
+    timestamped.store(enabled, std::memory_order_relaxed);
+  }
+
   /**
    * Returns the number of events of the given type currently on the event
    * queue.
@@ -334,6 +367,7 @@ protected:
     size_t count = 0U;
 
     synchronized (mutex) {
+      drain();
       count = std::count_if(events.begin(), events.end(), isEventType<T>);
     }
 
@@ -347,7 +381,7 @@ private:
   friend void* schedule(void*);
 
   // Process states.
-  enum
+  enum State
   {
     BOTTOM,
     READY,
@@ -355,7 +389,11 @@ private:
     BLOCKED,
     TERMINATING,
     TERMINATED
-  } state;
+  };
+
+  // NOTE: Atomic since producers move a process from BLOCKED to
+  // READY without acquiring 'mutex' (see 'EventQueue').
+  std::atomic<State> state;
 
   template <typename T>
   static bool isEventType(const Event* event)
@@ -363,13 +401,22 @@ private:
     return event->is<T>();
   }
 
-  // Mutex protecting internals.
-  // TODO(benh): Consider replacing with a spinlock, on multi-core systems.
+  // Mutex protecting 'events'. Only contended when events are
+  // injected or inspected (e.g., 'eventCount'), since producers push
+  // onto the lock-free 'inbox' instead.
   std::recursive_mutex mutex;
 
   // Enqueue the specified message, request, or function call.
   void enqueue(Event* event, bool inject = false);
 
+  // Whether to timestamp the enqueued events, see 'timestampEvents'.
+  // NOTE: Atomic since it is read by the producers of the events.
+  std::atomic_bool timestamped;
+
+  // Moves any events pushed onto 'inbox' to the back of 'events',
+  // requires lock()ed access!
+  void drain();
+
   // Delegates for messages.
   std::map<std::string, UPID> delegates;
 
@@ -393,6 +440,8 @@ private:
 
     Option<std::string> realm;
     Option<AuthenticatedHttpRequestHandler> authenticatedHandler;
+
+    RouteOptions options;
   };
 
   // Handlers for messages and HTTP requests.
@@ -416,12 +465,21 @@ private:
   // Static assets(s) to provide.
   std::map<std::string, Asset> assets;
 
+  // Events that have been received but not yet drained into
+  // 'events'. Producers push onto this without acquiring 'mutex'.
+  EventQueue* inbox;
+
   // Queue of received events, requires lock()ed access!
   std::deque<Event*> events;
 
   // Active references.
   std::atomic_long refs;
 
+  // Index of the processing thread that most recently ran this
+  // process (or -1 if it has never run). Used to enqueue the process
+  // back onto that thread's run queue to keep its state cache-warm.
+  std::atomic_long worker;
+
   // Process PID.
   UPID pid;
 };
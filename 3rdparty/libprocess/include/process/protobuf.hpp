@@ -25,6 +25,7 @@
 #include <process/dispatch.hpp>
 #include <process/process.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/lambda.hpp>
 
@@ -92,7 +93,12 @@ template <typename T>
 class ProtobufProcess : public process::Process<T>
 {
 public:
-  virtual ~ProtobufProcess() {}
+  virtual ~ProtobufProcess()
+  {
+    foreachvalue (google::protobuf::Message* message, messages) {
+      delete message;
+    }
+  }
 
 protected:
   virtual void visit(const process::MessageEvent& event)
@@ -107,6 +113,15 @@ protected:
     }
   }
 
+  // Returns whether a handler is installed for the messages with the
+  // given name. Message names are chosen by the senders, so a process
+  // can use this to only keep state (e.g., metrics) for the names of
+  // the messages that it handles.
+  bool installed(const std::string& name) const
+  {
+    return protobufHandlers.contains(name);
+  }
+
   void send(const process::UPID& to,
             const google::protobuf::Message& message)
   {
@@ -131,13 +146,13 @@ protected:
   template <typename M>
   void install(void (T::*method)(const process::UPID&, const M&))
   {
-    google::protobuf::Message* m = new M();
+    M* m = new M();
     T* t = static_cast<T*>(this);
     protobufHandlers[m->GetTypeName()] =
       lambda::bind(&handlerM<M>,
-                   t, method,
+                   t, method, m,
                    lambda::_1, lambda::_2);
-    delete m;
+    reuse(m);
   }
 
   template <typename M>
@@ -158,13 +173,13 @@ protected:
       void (T::*method)(const process::UPID&, P1C),
       P1 (M::*param1)() const)
   {
-    google::protobuf::Message* m = new M();
+    M* m = new M();
     T* t = static_cast<T*>(this);
     protobufHandlers[m->GetTypeName()] =
       lambda::bind(&handler1<M, P1, P1C>,
-                   t, method, param1,
+                   t, method, param1, m,
                    lambda::_1, lambda::_2);
-    delete m;
+    reuse(m);
   }
 
   template <typename M,
@@ -175,13 +190,13 @@ protected:
       P1 (M::*p1)() const,
       P2 (M::*p2)() const)
   {
-    google::protobuf::Message* m = new M();
+    M* m = new M();
     T* t = static_cast<T*>(this);
     protobufHandlers[m->GetTypeName()] =
       lambda::bind(&handler2<M, P1, P1C, P2, P2C>,
-                   t, method, p1, p2,
+                   t, method, p1, p2, m,
                    lambda::_1, lambda::_2);
-    delete m;
+    reuse(m);
   }
 
   template <typename M,
@@ -194,13 +209,13 @@ protected:
       P2 (M::*p2)() const,
       P3 (M::*p3)() const)
   {
-    google::protobuf::Message* m = new M();
+    M* m = new M();
     T* t = static_cast<T*>(this);
     protobufHandlers[m->GetTypeName()] =
       lambda::bind(&handler3<M, P1, P1C, P2, P2C, P3, P3C>,
-                   t, method, p1, p2, p3,
+                   t, method, p1, p2, p3, m,
                    lambda::_1, lambda::_2);
-    delete m;
+    reuse(m);
   }
 
   template <typename M,
@@ -215,13 +230,13 @@ protected:
       P3 (M::*p3)() const,
       P4 (M::*p4)() const)
   {
-    google::protobuf::Message* m = new M();
+    M* m = new M();
     T* t = static_cast<T*>(this);
     protobufHandlers[m->GetTypeName()] =
       lambda::bind(&handler4<M, P1, P1C, P2, P2C, P3, P3C, P4, P4C>,
-                   t, method, p1, p2, p3, p4,
+                   t, method, p1, p2, p3, p4, m,
                    lambda::_1, lambda::_2);
-    delete m;
+    reuse(m);
   }
 
   template <typename M,
@@ -238,13 +253,13 @@ protected:
       P4 (M::*p4)() const,
       P5 (M::*p5)() const)
   {
-    google::protobuf::Message* m = new M();
+    M* m = new M();
     T* t = static_cast<T*>(this);
     protobufHandlers[m->GetTypeName()] =
       lambda::bind(&handler5<M, P1, P1C, P2, P2C, P3, P3C, P4, P4C, P5, P5C>,
-                   t, method, p1, p2, p3, p4, p5,
+                   t, method, p1, p2, p3, p4, p5, m,
                    lambda::_1, lambda::_2);
-    delete m;
+    reuse(m);
   }
 
   template <typename M,
@@ -263,27 +278,27 @@ protected:
       P5 (M::*p5)() const,
       P6 (M::*p6)() const)
   {
-    google::protobuf::Message* m = new M();
+    M* m = new M();
     T* t = static_cast<T*>(this);
     protobufHandlers[m->GetTypeName()] =
       lambda::bind(&handler6<M, P1, P1C, P2, P2C, P3, P3C,
                                 P4, P4C, P5, P5C, P6, P6C>,
-                   t, method, p1, p2, p3, p4, p5, p6,
+                   t, method, p1, p2, p3, p4, p5, p6, m,
                    lambda::_1, lambda::_2);
-    delete m;
+    reuse(m);
   }
 
   // Installs that do not take the sender.
   template <typename M>
   void install(void (T::*method)(const M&))
   {
-    google::protobuf::Message* m = new M();
+    M* m = new M();
     T* t = static_cast<T*>(this);
     protobufHandlers[m->GetTypeName()] =
       lambda::bind(&_handlerM<M>,
-                   t, method,
+                   t, method, m,
                    lambda::_1, lambda::_2);
-    delete m;
+    reuse(m);
   }
 
   template <typename M>
@@ -304,13 +319,13 @@ protected:
       void (T::*method)(P1C),
       P1 (M::*param1)() const)
   {
-    google::protobuf::Message* m = new M();
+    M* m = new M();
     T* t = static_cast<T*>(this);
     protobufHandlers[m->GetTypeName()] =
       lambda::bind(&_handler1<M, P1, P1C>,
-                   t, method, param1,
+                   t, method, param1, m,
                    lambda::_1, lambda::_2);
-    delete m;
+    reuse(m);
   }
 
   template <typename M,
@@ -321,13 +336,13 @@ protected:
       P1 (M::*p1)() const,
       P2 (M::*p2)() const)
   {
-    google::protobuf::Message* m = new M();
+    M* m = new M();
     T* t = static_cast<T*>(this);
     protobufHandlers[m->GetTypeName()] =
       lambda::bind(&_handler2<M, P1, P1C, P2, P2C>,
-                   t, method, p1, p2,
+                   t, method, p1, p2, m,
                    lambda::_1, lambda::_2);
-    delete m;
+    reuse(m);
   }
 
   template <typename M,
@@ -340,13 +355,13 @@ protected:
       P2 (M::*p2)() const,
       P3 (M::*p3)() const)
   {
-    google::protobuf::Message* m = new M();
+    M* m = new M();
     T* t = static_cast<T*>(this);
     protobufHandlers[m->GetTypeName()] =
       lambda::bind(&_handler3<M, P1, P1C, P2, P2C, P3, P3C>,
-                   t, method, p1, p2, p3,
+                   t, method, p1, p2, p3, m,
                    lambda::_1, lambda::_2);
-    delete m;
+    reuse(m);
   }
 
   template <typename M,
@@ -361,13 +376,13 @@ protected:
       P3 (M::*p3)() const,
       P4 (M::*p4)() const)
   {
-    google::protobuf::Message* m = new M();
+    M* m = new M();
     T* t = static_cast<T*>(this);
     protobufHandlers[m->GetTypeName()] =
       lambda::bind(&_handler4<M, P1, P1C, P2, P2C, P3, P3C, P4, P4C>,
-                   t, method, p1, p2, p3, p4,
+                   t, method, p1, p2, p3, p4, m,
                    lambda::_1, lambda::_2);
-    delete m;
+    reuse(m);
   }
 
   template <typename M,
@@ -384,13 +399,13 @@ protected:
       P4 (M::*p4)() const,
       P5 (M::*p5)() const)
   {
-    google::protobuf::Message* m = new M();
+    M* m = new M();
     T* t = static_cast<T*>(this);
     protobufHandlers[m->GetTypeName()] =
       lambda::bind(&_handler5<M, P1, P1C, P2, P2C, P3, P3C, P4, P4C, P5, P5C>,
-                   t, method, p1, p2, p3, p4, p5,
+                   t, method, p1, p2, p3, p4, p5, m,
                    lambda::_1, lambda::_2);
-    delete m;
+    reuse(m);
   }
 
   template <typename M,
@@ -409,35 +424,74 @@ protected:
       P5 (M::*p5)() const,
       P6 (M::*p6)() const)
   {
-    google::protobuf::Message* m = new M();
+    M* m = new M();
     T* t = static_cast<T*>(this);
     protobufHandlers[m->GetTypeName()] =
       lambda::bind(&_handler6<M, P1, P1C, P2, P2C, P3, P3C,
                                  P4, P4C, P5, P5C, P6, P6C>,
-                   t, method, p1, p2, p3, p4, p5, p6,
+                   t, method, p1, p2, p3, p4, p5, p6, m,
                    lambda::_1, lambda::_2);
-    delete m;
+    reuse(m);
   }
 
   using process::Process<T>::install;
 
 private:
+  // Keeps 'm' as the message into which all messages of its type get
+  // parsed by the installed handler. Reusing a message (rather than
+  // parsing into a new one every time) lets protobuf reuse the memory
+  // of its fields (strings, repeated and nested messages), which saves
+  // most allocations when a process receives many messages of a type.
+  //
+  // NOTE: A handler (as before, when each message was parsed into a
+  // local) must copy whatever it keeps of its message beyond its own
+  // return, e.g., `defer` and `lambda::bind` copy their arguments,
+  // since the message gets overwritten by the next one of its type.
+  void reuse(google::protobuf::Message* m)
+  {
+    if (messages.contains(m->GetTypeName())) {
+      delete messages[m->GetTypeName()];
+    }
+
+    messages[m->GetTypeName()] = m;
+  }
+
+  // Messages above this size are not kept in their reused message, so
+  // that a rare large message does not pin its memory for the lifetime
+  // of the process.
+  static constexpr size_t MAX_REUSED_MESSAGE_SIZE = 64 * 1024;
+
+  // Clears 'm' once its handler has returned, releasing the memory of
+  // its fields if 'data' was above `MAX_REUSED_MESSAGE_SIZE`.
+  template <typename M>
+  static void release(M* m, const std::string& data)
+  {
+    if (data.size() > MAX_REUSED_MESSAGE_SIZE) {
+      M empty;
+      m->Swap(&empty);
+    } else {
+      m->Clear();
+    }
+  }
+
   // Handlers that take the sender as the first argument.
   template <typename M>
   static void handlerM(
       T* t,
       void (T::*method)(const process::UPID&, const M&),
+      M* m,
       const process::UPID& sender,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
-      (t->*method)(sender, m);
+    m->ParseFromString(data);
+    if (m->IsInitialized()) {
+      (t->*method)(sender, *m);
     } else {
       LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
+                   << m->InitializationErrorString();
     }
+
+    release(m, data);
   }
 
   static void handler0(
@@ -455,17 +509,19 @@ private:
       T* t,
       void (T::*method)(const process::UPID&, P1C),
       P1 (M::*p1)() const,
+      M* m,
       const process::UPID& sender,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
-      (t->*method)(sender, google::protobuf::convert((&m->*p1)()));
+    m->ParseFromString(data);
+    if (m->IsInitialized()) {
+      (t->*method)(sender, google::protobuf::convert((m->*p1)()));
     } else {
       LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
+                   << m->InitializationErrorString();
     }
+
+    release(m, data);
   }
 
   template <typename M,
@@ -476,19 +532,21 @@ private:
       void (T::*method)(const process::UPID&, P1C, P2C),
       P1 (M::*p1)() const,
       P2 (M::*p2)() const,
+      M* m,
       const process::UPID& sender,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
+    m->ParseFromString(data);
+    if (m->IsInitialized()) {
       (t->*method)(sender,
-                   google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()));
+                   google::protobuf::convert((m->*p1)()),
+                   google::protobuf::convert((m->*p2)()));
     } else {
       LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
+                   << m->InitializationErrorString();
     }
+
+    release(m, data);
   }
 
   template <typename M,
@@ -501,20 +559,22 @@ private:
       P1 (M::*p1)() const,
       P2 (M::*p2)() const,
       P3 (M::*p3)() const,
+      M* m,
       const process::UPID& sender,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
+    m->ParseFromString(data);
+    if (m->IsInitialized()) {
       (t->*method)(sender,
-                   google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()),
-                   google::protobuf::convert((&m->*p3)()));
+                   google::protobuf::convert((m->*p1)()),
+                   google::protobuf::convert((m->*p2)()),
+                   google::protobuf::convert((m->*p3)()));
     } else {
       LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
+                   << m->InitializationErrorString();
     }
+
+    release(m, data);
   }
 
   template <typename M,
@@ -529,21 +589,23 @@ private:
       P2 (M::*p2)() const,
       P3 (M::*p3)() const,
       P4 (M::*p4)() const,
+      M* m,
       const process::UPID& sender,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
+    m->ParseFromString(data);
+    if (m->IsInitialized()) {
       (t->*method)(sender,
-                   google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()),
-                   google::protobuf::convert((&m->*p3)()),
-                   google::protobuf::convert((&m->*p4)()));
+                   google::protobuf::convert((m->*p1)()),
+                   google::protobuf::convert((m->*p2)()),
+                   google::protobuf::convert((m->*p3)()),
+                   google::protobuf::convert((m->*p4)()));
     } else {
       LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
+                   << m->InitializationErrorString();
     }
+
+    release(m, data);
   }
 
   template <typename M,
@@ -560,22 +622,24 @@ private:
       P3 (M::*p3)() const,
       P4 (M::*p4)() const,
       P5 (M::*p5)() const,
+      M* m,
       const process::UPID& sender,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
+    m->ParseFromString(data);
+    if (m->IsInitialized()) {
       (t->*method)(sender,
-                   google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()),
-                   google::protobuf::convert((&m->*p3)()),
-                   google::protobuf::convert((&m->*p4)()),
-                   google::protobuf::convert((&m->*p5)()));
+                   google::protobuf::convert((m->*p1)()),
+                   google::protobuf::convert((m->*p2)()),
+                   google::protobuf::convert((m->*p3)()),
+                   google::protobuf::convert((m->*p4)()),
+                   google::protobuf::convert((m->*p5)()));
     } else {
       LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
+                   << m->InitializationErrorString();
     }
+
+    release(m, data);
   }
 
   template <typename M,
@@ -594,23 +658,25 @@ private:
       P4 (M::*p4)() const,
       P5 (M::*p5)() const,
       P6 (M::*p6)() const,
+      M* m,
       const process::UPID& sender,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
+    m->ParseFromString(data);
+    if (m->IsInitialized()) {
       (t->*method)(sender,
-                   google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()),
-                   google::protobuf::convert((&m->*p3)()),
-                   google::protobuf::convert((&m->*p4)()),
-                   google::protobuf::convert((&m->*p5)()),
-                   google::protobuf::convert((&m->*p6)()));
+                   google::protobuf::convert((m->*p1)()),
+                   google::protobuf::convert((m->*p2)()),
+                   google::protobuf::convert((m->*p3)()),
+                   google::protobuf::convert((m->*p4)()),
+                   google::protobuf::convert((m->*p5)()),
+                   google::protobuf::convert((m->*p6)()));
     } else {
       LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
+                   << m->InitializationErrorString();
     }
+
+    release(m, data);
   }
 
 
@@ -619,17 +685,19 @@ private:
   static void _handlerM(
       T* t,
       void (T::*method)(const M&),
+      M* m,
       const process::UPID&,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
-      (t->*method)(m);
+    m->ParseFromString(data);
+    if (m->IsInitialized()) {
+      (t->*method)(*m);
     } else {
       LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
+                   << m->InitializationErrorString();
     }
+
+    release(m, data);
   }
 
   static void _handler0(
@@ -647,17 +715,19 @@ private:
       T* t,
       void (T::*method)(P1C),
       P1 (M::*p1)() const,
+      M* m,
       const process::UPID&,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
-      (t->*method)(google::protobuf::convert((&m->*p1)()));
+    m->ParseFromString(data);
+    if (m->IsInitialized()) {
+      (t->*method)(google::protobuf::convert((m->*p1)()));
     } else {
       LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
+                   << m->InitializationErrorString();
     }
+
+    release(m, data);
   }
 
   template <typename M,
@@ -668,18 +738,20 @@ private:
       void (T::*method)(P1C, P2C),
       P1 (M::*p1)() const,
       P2 (M::*p2)() const,
+      M* m,
       const process::UPID&,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
-      (t->*method)(google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()));
+    m->ParseFromString(data);
+    if (m->IsInitialized()) {
+      (t->*method)(google::protobuf::convert((m->*p1)()),
+                   google::protobuf::convert((m->*p2)()));
     } else {
       LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
+                   << m->InitializationErrorString();
     }
+
+    release(m, data);
   }
 
   template <typename M,
@@ -692,19 +764,21 @@ private:
       P1 (M::*p1)() const,
       P2 (M::*p2)() const,
       P3 (M::*p3)() const,
+      M* m,
       const process::UPID&,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
-      (t->*method)(google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()),
-                   google::protobuf::convert((&m->*p3)()));
+    m->ParseFromString(data);
+    if (m->IsInitialized()) {
+      (t->*method)(google::protobuf::convert((m->*p1)()),
+                   google::protobuf::convert((m->*p2)()),
+                   google::protobuf::convert((m->*p3)()));
     } else {
       LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
+                   << m->InitializationErrorString();
     }
+
+    release(m, data);
   }
 
   template <typename M,
@@ -719,20 +793,22 @@ private:
       P2 (M::*p2)() const,
       P3 (M::*p3)() const,
       P4 (M::*p4)() const,
+      M* m,
       const process::UPID&,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
-      (t->*method)(google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()),
-                   google::protobuf::convert((&m->*p3)()),
-                   google::protobuf::convert((&m->*p4)()));
+    m->ParseFromString(data);
+    if (m->IsInitialized()) {
+      (t->*method)(google::protobuf::convert((m->*p1)()),
+                   google::protobuf::convert((m->*p2)()),
+                   google::protobuf::convert((m->*p3)()),
+                   google::protobuf::convert((m->*p4)()));
     } else {
       LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
+                   << m->InitializationErrorString();
     }
+
+    release(m, data);
   }
 
   template <typename M,
@@ -749,21 +825,23 @@ private:
       P3 (M::*p3)() const,
       P4 (M::*p4)() const,
       P5 (M::*p5)() const,
+      M* m,
       const process::UPID&,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
-      (t->*method)(google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()),
-                   google::protobuf::convert((&m->*p3)()),
-                   google::protobuf::convert((&m->*p4)()),
-                   google::protobuf::convert((&m->*p5)()));
+    m->ParseFromString(data);
+    if (m->IsInitialized()) {
+      (t->*method)(google::protobuf::convert((m->*p1)()),
+                   google::protobuf::convert((m->*p2)()),
+                   google::protobuf::convert((m->*p3)()),
+                   google::protobuf::convert((m->*p4)()),
+                   google::protobuf::convert((m->*p5)()));
     } else {
       LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
+                   << m->InitializationErrorString();
     }
+
+    release(m, data);
   }
 
   template <typename M,
@@ -782,28 +860,33 @@ private:
       P4 (M::*p4)() const,
       P5 (M::*p5)() const,
       P6 (M::*p6)() const,
+      M* m,
       const process::UPID&,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
-      (t->*method)(google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()),
-                   google::protobuf::convert((&m->*p3)()),
-                   google::protobuf::convert((&m->*p4)()),
-                   google::protobuf::convert((&m->*p5)()),
-                   google::protobuf::convert((&m->*p6)()));
+    m->ParseFromString(data);
+    if (m->IsInitialized()) {
+      (t->*method)(google::protobuf::convert((m->*p1)()),
+                   google::protobuf::convert((m->*p2)()),
+                   google::protobuf::convert((m->*p3)()),
+                   google::protobuf::convert((m->*p4)()),
+                   google::protobuf::convert((m->*p5)()),
+                   google::protobuf::convert((m->*p6)()));
     } else {
       LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
+                   << m->InitializationErrorString();
     }
+
+    release(m, data);
   }
 
   typedef lambda::function<
       void(const process::UPID&, const std::string&)> handler;
   hashmap<std::string, handler> protobufHandlers;
 
+  // Messages reused by the handlers, keyed by type name.
+  hashmap<std::string, google::protobuf::Message*> messages;
+
   // Sender of "current" message, inaccessible by subclasses.
   // This is only used for reply().
   process::UPID from;
@@ -15,6 +15,7 @@
 
 #ifndef __WINDOWS__
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/wait.h>
 #endif // __WINDOWS__
 
@@ -143,6 +144,19 @@ public:
     virtual Future<size_t> send(const char* data, size_t size) = 0;
     virtual Future<size_t> sendfile(int fd, off_t offset, size_t size) = 0;
 
+    /**
+     * Sends the data of the specified buffers, in order, with a single
+     * scatter/gather write where the implementation supports it. Like
+     * `send`, this may send less data than requested and returns the
+     * number of bytes sent. The buffers (and the array describing
+     * them) must remain valid until the returned future is ready.
+     *
+     * The default implementation only sends the first buffer, hence
+     * implementations that can send several buffers at once (e.g., by
+     * copying them into a single write) should override it.
+     */
+    virtual Future<size_t> sendv(const struct iovec* iov, int iovcnt);
+
     /**
      * An overload of `recv`, which receives data based on the specified
      * 'size' parameter.
@@ -288,6 +302,11 @@ public:
     return impl->sendfile(fd, offset, size);
   }
 
+  Future<size_t> sendv(const struct iovec* iov, int iovcnt) const
+  {
+    return impl->sendv(iov, iovcnt);
+  }
+
   Future<std::string> recv(const Option<ssize_t>& size = None())
   {
     return impl->recv(size);
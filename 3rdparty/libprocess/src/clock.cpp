@@ -31,6 +31,7 @@
 #include <stout/unreachable.hpp>
 
 #include "event_loop.hpp"
+#include "timer_wheel.hpp"
 
 using std::list;
 using std::map;
@@ -39,10 +40,10 @@ using std::set;
 
 namespace process {
 
-// We store the timers in a map of lists indexed by the timeout of the
-// timer so that we can have two timers that have the same timeout. We
-// exploit that the map is SORTED!
-static map<Time, list<Timer>>* timers = new map<Time, list<Timer>>();
+// We store the timers in a hierarchical timing wheel so that creating,
+// canceling and expiring a timer is constant time regardless of the
+// number of pending timers (see 'TimerWheel').
+static TimerWheel* timers = new TimerWheel();
 static recursive_mutex* timers_mutex = new recursive_mutex();
 
 
@@ -83,26 +84,23 @@ set<Time>* ticks = new set<Time>();
 // so that it's clear from the callsite that the use of 'timers' is
 // within a 'synchronized' block.
 //
-// TODO(benh): Create a generic 'Timers' abstraction which hides this
-// and more away (i.e., all manipulations of 'timers' below).
-Option<Time> next(const map<Time, list<Timer>>& timers)
+// NOTE: The time returned by the timing wheel might be before the
+// timeout of the next timer (see 'TimerWheel::next'), in which case
+// the 'tick' only cascades timers and schedules another 'tick'.
+Option<Time> next(const TimerWheel& timers)
 {
-  if (!timers.empty()) {
-    Time first = timers.begin()->first;
-
-    // If the clock is paused and no timers are expired, the
-    // timers cannot fire until the clock is advanced, so we
-    // return None() here. Note that we pass NULL to ensure
-    // that this looks at the global clock, since this can be
-    // called from a Process context through Clock::timer.
-    if (Clock::paused() && first > Clock::now(NULL)) {
-      return None();
-    }
-
-    return first;
+  const Option<Time> first = timers.next();
+
+  // If the clock is paused and no timers are expired, the
+  // timers cannot fire until the clock is advanced, so we
+  // return None() here. Note that we pass NULL to ensure
+  // that this looks at the global clock, since this can be
+  // called from a Process context through Clock::timer.
+  if (first.isSome() && Clock::paused() && first.get() > Clock::now(NULL)) {
+    return None();
   }
 
-  return None();
+  return first;
 }
 
 
@@ -116,7 +114,7 @@ void tick(const Time& time);
 // a 'synchronized' block.
 // TODO(bmahler): Consider taking an optional 'now' to avoid
 // excessive syscalls via Clock::now(NULL).
-void scheduleTick(const map<Time, list<Timer>>& timers, set<Time>* ticks)
+void scheduleTick(const TimerWheel& timers, set<Time>* ticks)
 {
   // Determine when the next 'tick' should fire.
   const Option<Time> next = clock::next(timers);
@@ -151,12 +149,10 @@ void tick(const Time& time)
 
     VLOG(3) << "Handling timers up to " << now;
 
-    foreachkey (const Time& timeout, *timers) {
-      if (timeout > now) {
-        break;
-      }
+    timers->expire(now, &timedout);
 
-      VLOG(3) << "Have timeout(s) at " << timeout;
+    if (!timedout.empty()) {
+      VLOG(3) << "Have " << timedout.size() << " timeout(s)";
 
       // Need to toggle 'settling' so that we don't prematurely say
       // we're settled until after the timers are executed below,
@@ -164,15 +160,10 @@ void tick(const Time& time)
       if (clock::paused) {
         clock::settling = true;
       }
-
-      timedout.splice(timedout.end(), (*timers)[timeout]);
     }
 
-    // Now erase the range of timers that timed out.
-    timers->erase(timers->begin(), timers->upper_bound(now));
-
     // Okay, so the timeout for the next timer should not have fired.
-    CHECK(timers->empty() || (timers->begin()->first > now));
+    CHECK(timers->next().isNone() || timers->next().get() > now);
 
     // Remove this tick from the scheduled 'ticks', it may have
     // been removed already if the clock was paused / manipulated
@@ -190,8 +181,8 @@ void tick(const Time& time)
   // executing expired timers.
   synchronized (timers_mutex) {
     if (clock::paused &&
-        (timers->size() == 0 ||
-         timers->begin()->first > *clock::current)) {
+        (timers->next().isNone() ||
+         timers->next().get() > *clock::current)) {
       VLOG(3) << "Clock has settled";
       clock::settling = false;
     }
@@ -219,7 +210,7 @@ void Clock::finalize()
     // This, along with the `timers_mutex`, is all that is required to clean
     // up any pending timers.  Timers are triggered via "ticks".  However,
     // we do not need to clear `ticks` because a "tick" with an empty `timers`
-    // map will effectively be a no-op.
+    // wheel will effectively be a no-op.
     timers->clear();
   }
 }
@@ -264,57 +255,44 @@ Timer Clock::timer(
     const Duration& duration,
     const lambda::function<void()>& thunk)
 {
-  // Start at 1 since Timer() instances use id 0.
-  static std::atomic<uint64_t> id(1);
-
   // Assumes Clock::now() does Clock::now(__process__).
   Timeout timeout = Timeout::in(duration);
 
   UPID pid = __process__ != NULL ? __process__->self() : UPID();
 
-  Timer timer(id.fetch_add(1), timeout, pid, thunk);
-
-  VLOG(3) << "Created a timer for " << pid << " in " << stringify(duration)
-          << " in the future (" << timeout.time() << ")";
+  Timer timer;
 
   // Add the timer.
   synchronized (timers_mutex) {
-    if (timers->size() == 0 ||
-        timer.timeout().time() < timers->begin()->first) {
-      // Need to interrupt the loop to update/set timer repeat.
-      (*timers)[timer.timeout().time()].push_back(timer);
+    if (timers->empty()) {
+      timers->reset(Clock::now(NULL));
+    }
 
-      // Schedule another "tick" if necessary.
+    const Option<Time> first = timers->next();
+
+    timer = timers->insert(timeout, pid, thunk);
+
+    if (first.isNone() || timeout.time() < first.get()) {
+      // Need to interrupt the loop to update/set timer repeat.
       clock::scheduleTick(*timers, clock::ticks);
-    } else {
-      // Timer repeat is adequate, just add the timeout.
-      CHECK(timers->size() >= 1);
-      (*timers)[timer.timeout().time()].push_back(timer);
     }
   }
 
+  VLOG(3) << "Created a timer for " << pid << " in " << stringify(duration)
+          << " in the future (" << timeout.time() << ")";
+
   return timer;
 }
 
 
 bool Clock::cancel(const Timer& timer)
 {
-  bool canceled = false;
   synchronized (timers_mutex) {
-    // Check if the timeout is still pending, and if so, erase it. In
-    // addition, erase an empty list if we just removed the last
-    // timeout.
-    Time time = timer.timeout().time();
-    if (timers->count(time) > 0) {
-      canceled = true;
-      (*timers)[time].remove(timer);
-      if ((*timers)[time].empty()) {
-        timers->erase(time);
-      }
-    }
+    // Erase the timer if it is still pending.
+    return timers->erase(timer);
   }
 
-  return canceled;
+  UNREACHABLE();
 }
 
 
@@ -458,8 +436,8 @@ bool Clock::settled()
     if (clock::settling) {
       VLOG(3) << "Clock still not settled";
       return false;
-    } else if (timers->size() == 0 ||
-               timers->begin()->first > *clock::current) {
+    } else if (timers->next().isNone() ||
+               timers->next().get() > *clock::current) {
       VLOG(3) << "Clock is settled";
       return true;
     }
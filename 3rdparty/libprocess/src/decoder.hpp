@@ -13,6 +13,8 @@
 #ifndef __DECODER_HPP__
 #define __DECODER_HPP__
 
+#include <limits.h>
+
 #include <http_parser.h>
 
 #include <glog/logging.h>
@@ -22,11 +24,15 @@
 #include <vector>
 
 #include <process/http.hpp>
+#include <process/message.hpp>
+#include <process/pid.hpp>
+#include <process/process.hpp>
 #include <process/socket.hpp>
 
 #include <stout/foreach.hpp>
 #include <stout/gzip.hpp>
 #include <stout/option.hpp>
+#include <stout/strings.hpp>
 #include <stout/try.hpp>
 
 
@@ -35,13 +41,90 @@
 
 namespace process {
 
+// Returns the libprocess message sent as 'request' (see
+// 'MessageEncoder'), without its body, or NULL if the request is not
+// a (well formed) libprocess message.
+inline Message* parse(const http::Request& request)
+{
+  // TODO(benh): Do better error handling (to deal with a malformed
+  // libprocess message, malicious or otherwise).
+
+  // First try and determine 'from'.
+  Option<UPID> from = None();
+
+  Option<std::string> libprocessFrom = request.headers.get("Libprocess-From");
+
+  if (libprocessFrom.isSome()) {
+    from = UPID(strings::trim(libprocessFrom.get()));
+  } else {
+    // Try and get 'from' from the User-Agent.
+    const std::string agent = request.headers.get("User-Agent").getOrElse("");
+    const std::string identifier = "libprocess/";
+    size_t index = agent.find(identifier);
+    if (index != std::string::npos) {
+      from = UPID(agent.substr(index + identifier.size(), agent.size()));
+    }
+  }
+
+  if (from.isNone()) {
+    return NULL;
+  }
+
+  // Now determine 'to'.
+  size_t index = request.url.path.find('/', 1);
+  index = index != std::string::npos ? index - 1 : std::string::npos;
+
+  // Decode possible percent-encoded 'to'.
+  Try<std::string> decode = http::decode(request.url.path.substr(1, index));
+
+  if (decode.isError()) {
+    VLOG(2) << "Failed to decode URL path: " << decode.error();
+    return NULL;
+  }
+
+  const UPID to(decode.get(), process::address());
+
+  // And now determine 'name'.
+  index = index != std::string::npos ? index + 2: request.url.path.size();
+  const std::string name = request.url.path.substr(index);
+
+  VLOG(2) << "Parsed message name '" << name
+          << "' for " << to << " from " << from.get();
+
+  Message* message = new Message();
+  message->name = name;
+  message->from = from.get();
+  message->to = to;
+
+  return message;
+}
+
+
+// Returns true if 'request' was sent by libprocess (see
+// 'ProcessManager::handle').
+inline bool libprocess(const http::Request& request)
+{
+  return
+    (request.method == "POST" &&
+     request.headers.contains("User-Agent") &&
+     request.headers.at("User-Agent").find("libprocess/") == 0) ||
+    (request.method == "POST" &&
+     request.headers.contains("Libprocess-From"));
+}
+
+
+// Maximum number of bytes of the body of a streamed request that may
+// remain unread before the decoder stops receiving (see 'drained').
+const size_t STREAMING_BUFFER_SIZE = 256 * 1024;
+
+
 // TODO(benh): Make DataDecoder abstract and make RequestDecoder a
 // concrete subclass.
 class DataDecoder
 {
 public:
   explicit DataDecoder(const network::Socket& _s)
-    : s(_s), failure(false), request(NULL)
+    : s(_s), failure(false), request(NULL), message(NULL), messages(NULL)
   {
     settings.on_message_begin = &DataDecoder::on_message_begin;
 
@@ -65,10 +148,36 @@ public:
     parser.data = this;
   }
 
-  std::deque<http::Request*> decode(const char* data, size_t length)
+  ~DataDecoder()
   {
+    // Let the reader of a partially received streamed request know
+    // that the rest of the body will never arrive.
+    if (writer.isSome()) {
+      writer->fail("Connection closed before the request body completed");
+    }
+  }
+
+  // Decodes as much of the data as possible into HTTP requests. If
+  // 'messages' is not NULL, libprocess messages that don't expect a
+  // response (i.e., those sent by 'MessageEncoder') are instead decoded
+  // straight into messages and appended to 'messages', which skips
+  // building (and copying the body out of) an 'http::Request'.
+  //
+  // Requests with a body (other than libprocess messages or compressed
+  // requests) are returned as soon as their headers are decoded, the
+  // body is then written to the request's 'reader' as it is decoded
+  // (see 'http::Request::PIPE').
+  std::deque<http::Request*> decode(
+      const char* data,
+      size_t length,
+      std::deque<Message*>* messages = NULL)
+  {
+    this->messages = messages;
+
     size_t parsed = http_parser_execute(&parser, &settings, data, length);
 
+    this->messages = NULL;
+
     if (parsed != length) {
       // TODO(bmahler): joyent/http-parser exposes error reasons.
       failure = true;
@@ -88,6 +197,18 @@ public:
     return failure;
   }
 
+  // Returns a future that is ready once it's fine to receive more
+  // data, i.e., once the reader of the request being streamed (if
+  // any) has caught up with the decoded body.
+  Future<Nothing> drained() const
+  {
+    if (writer.isNone()) {
+      return Nothing();
+    }
+
+    return writer->drained(STREAMING_BUFFER_SIZE);
+  }
+
   network::Socket socket() const
   {
     return s;
@@ -233,14 +354,70 @@ private:
 
     decoder->request->keepAlive = http_should_keep_alive(&decoder->parser);
 
+    // Libprocess peers identify themselves via the User-Agent, in which
+    // case they don't expect a response (see 'ProcessManager::handle').
+    if (decoder->messages != NULL &&
+        decoder->request->method == "POST" &&
+        decoder->request->headers.get("User-Agent").getOrElse("").find(
+            "libprocess/") == 0 &&
+        !decoder->request->headers.contains("Content-Encoding")) {
+      CHECK(decoder->message == NULL);
+      decoder->message = parse(*decoder->request);
+    }
+
+    if (decoder->message != NULL) {
+      return 0;
+    }
+
+    // Parse the query key/values.
+    Try<hashmap<std::string, std::string>> decoded =
+      http::query::decode(decoder->query);
+
+    if (decoded.isError()) {
+      return 1;
+    }
+
+    decoder->request->url.query = decoded.get();
+
+    // Stream the body, if there is one, unless the request has to be
+    // buffered anyway (i.e., it needs to be decompressed or parsed
+    // into a libprocess message).
+    const bool body = (decoder->parser.flags & F_CHUNKED) ||
+      (decoder->parser.content_length > 0 &&
+       decoder->parser.content_length != ULLONG_MAX);
+
+    if (body &&
+        !libprocess(*decoder->request) &&
+        !decoder->request->headers.contains("Content-Encoding")) {
+      http::Pipe pipe;
+
+      decoder->request->type = http::Request::PIPE;
+      decoder->request->reader = pipe.reader();
+
+      decoder->writer = pipe.writer();
+
+      decoder->requests.push_back(decoder->request);
+      decoder->request = NULL;
+    }
+
     return 0;
   }
 
   static int on_body(http_parser* p, const char* data, size_t length)
   {
     DataDecoder* decoder = (DataDecoder*) p->data;
-    CHECK_NOTNULL(decoder->request);
-    decoder->request->body.append(data, length);
+
+    if (decoder->writer.isSome()) {
+      // NOTE: The write fails once the reader is closed, in which
+      // case we keep decoding and drop the rest of the body.
+      decoder->writer->write(std::string(data, length));
+    } else if (decoder->message != NULL) {
+      decoder->message->body.append(data, length);
+    } else {
+      CHECK_NOTNULL(decoder->request);
+      decoder->request->body.append(data, length);
+    }
+
     return 0;
   }
 
@@ -248,18 +425,26 @@ private:
   {
     DataDecoder* decoder = (DataDecoder*) p->data;
 
-    // Parse the query key/values.
-    Try<hashmap<std::string, std::string>> decoded =
-      http::query::decode(decoder->query);
+    if (decoder->writer.isSome()) {
+      // The request has already been returned by 'decode'.
+      decoder->writer->close();
+      decoder->writer = None();
+      return 0;
+    }
 
-    if (decoded.isError()) {
-      return 1;
+    if (decoder->message != NULL) {
+      CHECK_NOTNULL(decoder->messages);
+
+      decoder->messages->push_back(decoder->message);
+      decoder->message = NULL;
+
+      delete decoder->request;
+      decoder->request = NULL;
+      return 0;
     }
 
     CHECK_NOTNULL(decoder->request);
 
-    decoder->request->url.query = decoded.get();
-
     Option<std::string> encoding =
       decoder->request->headers.get("Content-Encoding");
 
@@ -297,7 +482,16 @@ private:
 
   http::Request* request;
 
+  // The message being decoded instead of 'request', if any.
+  Message* message;
+
   std::deque<http::Request*> requests;
+
+  // Where to append decoded messages during 'decode', if anywhere.
+  std::deque<Message*>* messages;
+
+  // The write end of the body of the request being streamed, if any.
+  Option<http::Pipe::Writer> writer;
 };
 
 
@@ -13,11 +13,16 @@
 #ifndef __ENCODER_HPP__
 #define __ENCODER_HPP__
 
+#include <limits.h>
 #include <stdint.h>
 #include <time.h>
 
+#include <sys/uio.h>
+
 #include <map>
+#include <memory>
 #include <sstream>
+#include <vector>
 
 #include <process/http.hpp>
 #include <process/process.hpp>
@@ -33,6 +38,13 @@ namespace process {
 
 const uint32_t GZIP_MINIMUM_BODY_LENGTH = 1024;
 
+// Terminates the (single) chunk of a non-empty message body.
+const char MESSAGE_BODY_TRAILER[] = "\r\n0\r\n\r\n";
+
+// Bytes of a file sent at once if the bandwidth is limited, which
+// bounds how far a single send can exceed the limit.
+const size_t FILE_CHUNK_SIZE = 64 * 1024;
+
 // Forward declarations.
 class Encoder;
 
@@ -43,7 +55,8 @@ public:
   enum Kind
   {
     DATA,
-    FILE
+    FILE,
+    IOVEC
   };
 
   explicit Encoder(const network::Socket& _s) : s(_s) {}
@@ -104,11 +117,129 @@ private:
 };
 
 
-class MessageEncoder : public DataEncoder
+// Encodes data as a sequence of buffers that are sent, in order, with
+// a single scatter/gather write rather than first being copied into a
+// contiguous buffer. The buffers are not owned by the encoder, so
+// subclasses must keep the data alive for the life of the encoder.
+class IovecEncoder : public Encoder
+{
+public:
+  explicit IovecEncoder(const network::Socket& s)
+    : Encoder(s), size(0), index(0) {}
+
+  virtual ~IovecEncoder() {}
+
+  virtual Kind kind() const
+  {
+    return Encoder::IOVEC;
+  }
+
+  // Returns the buffers holding the remaining data (at most 'IOV_MAX'
+  // of them) and marks their data as sent. The returned array remains
+  // valid until the next call to 'next' or 'backup'.
+  virtual const struct iovec* next(int* count, size_t* length)
+  {
+    pending.clear();
+
+    *length = 0;
+
+    size_t offset = 0;
+    foreach (const struct iovec& buffer, buffers) {
+      if (pending.size() == static_cast<size_t>(IOV_MAX)) {
+        break;
+      }
+
+      if (offset + buffer.iov_len > index) {
+        // Skip the part of the buffer that has already been sent.
+        const size_t skip = index > offset ? index - offset : 0;
+
+        struct iovec remainder;
+        remainder.iov_base = static_cast<char*>(buffer.iov_base) + skip;
+        remainder.iov_len = buffer.iov_len - skip;
+
+        pending.push_back(remainder);
+        *length += remainder.iov_len;
+      }
+
+      offset += buffer.iov_len;
+    }
+
+    index += *length;
+    *count = pending.size();
+
+    return pending.data();
+  }
+
+  virtual void backup(size_t length)
+  {
+    if (index >= length) {
+      index -= length;
+    }
+  }
+
+  virtual size_t remaining() const
+  {
+    return size - index;
+  }
+
+  // Returns the number of buffers.
+  size_t count() const
+  {
+    return buffers.size();
+  }
+
+protected:
+  void append(const char* data, size_t length)
+  {
+    if (length > 0) {
+      struct iovec buffer;
+      buffer.iov_base = const_cast<char*>(data);
+      buffer.iov_len = length;
+
+      buffers.push_back(buffer);
+      size += length;
+    }
+  }
+
+  // Appends the buffers of another encoder which has not sent any
+  // data yet.
+  void append(const IovecEncoder& encoder)
+  {
+    CHECK_EQ(0u, encoder.index);
+
+    foreach (const struct iovec& buffer, encoder.buffers) {
+      append(static_cast<const char*>(buffer.iov_base), buffer.iov_len);
+    }
+  }
+
+private:
+  std::vector<struct iovec> buffers;
+  std::vector<struct iovec> pending;
+  size_t size;
+  size_t index;
+};
+
+
+// Encodes a message as an HTTP POST request whose body is sent
+// directly from the message (i.e., without copying it) along with the
+// separately encoded header and chunk framing.
+class MessageEncoder : public IovecEncoder
 {
 public:
   MessageEncoder(const network::Socket& s, Message* _message)
-    : DataEncoder(s, encode(_message)), message(_message) {}
+    : IovecEncoder(s), message(_message)
+  {
+    if (message != NULL) {
+      header = encodeHeader(message);
+
+      append(header.data(), header.size());
+
+      if (message->body.size() > 0) {
+        append(message->body.data(), message->body.size());
+        append(MESSAGE_BODY_TRAILER, sizeof(MESSAGE_BODY_TRAILER) - 1);
+      }
+    }
+  }
 
   virtual ~MessageEncoder()
   {
@@ -119,42 +250,82 @@ public:
 
   static std::string encode(Message* message)
   {
-    std::ostringstream out;
+    std::string data;
 
     if (message != NULL) {
-      out << "POST ";
-      // Nothing keeps the 'id' component of a PID from being an empty
-      // string which would create a malformed path that has two
-      // '//' unless we check for it explicitly.
-      // TODO(benh): Make the 'id' part of a PID optional so when it's
-      // missing it's clear that we're simply addressing an ip:port.
-      if (message->to.id != "") {
-        out << "/" << message->to.id;
-      }
-
-      out << "/" << message->name << " HTTP/1.1\r\n"
-          << "User-Agent: libprocess/" << message->from << "\r\n"
-          << "Libprocess-From: " << message->from << "\r\n"
-          << "Connection: Keep-Alive\r\n"
-          << "Host: \r\n";
+      data = encodeHeader(message);
 
       if (message->body.size() > 0) {
-        out << "Transfer-Encoding: chunked\r\n\r\n"
-            << std::hex << message->body.size() << "\r\n";
-        out.write(message->body.data(), message->body.size());
-        out << "\r\n"
-            << "0\r\n"
-            << "\r\n";
-      } else {
-        out << "\r\n";
+        data.append(message->body);
+        data.append(MESSAGE_BODY_TRAILER, sizeof(MESSAGE_BODY_TRAILER) - 1);
       }
     }
 
-    return out.str();
+    return data;
   }
 
 private:
+  // Returns the request line and headers of the message, including the
+  // size of the body's chunk if the body is non-empty.
+  static std::string encodeHeader(Message* message)
+  {
+    std::ostringstream out;
+
+    out << "POST ";
+    // Nothing keeps the 'id' component of a PID from being an empty
+    // string which would create a malformed path that has two
+    // '//' unless we check for it explicitly.
+    // TODO(benh): Make the 'id' part of a PID optional so when it's
+    // missing it's clear that we're simply addressing an ip:port.
+    if (message->to.id != "") {
+      out << "/" << message->to.id;
+    }
+
+    out << "/" << message->name << " HTTP/1.1\r\n"
+        << "User-Agent: libprocess/" << message->from << "\r\n"
+        << "Libprocess-From: " << message->from << "\r\n"
+        << "Connection: Keep-Alive\r\n"
+        << "Host: \r\n";
+
+    if (message->body.size() > 0) {
+      out << "Transfer-Encoding: chunked\r\n\r\n"
+          << std::hex << message->body.size() << "\r\n";
+    } else {
+      out << "\r\n";
+    }
+
+    return out.str();
+  }
+
   Message* message;
+  std::string header;
+};
+
+
+// Sends the data of several encoders with a single scatter/gather
+// write, e.g., all of the messages queued for a socket. Takes
+// ownership of the encoders.
+class BatchEncoder : public IovecEncoder
+{
+public:
+  explicit BatchEncoder(const network::Socket& s) : IovecEncoder(s) {}
+
+  virtual ~BatchEncoder()
+  {
+    foreach (IovecEncoder* encoder, encoders) {
+      delete encoder;
+    }
+  }
+
+  // Appends the data of an encoder which has not sent any data yet.
+  void add(IovecEncoder* encoder)
+  {
+    append(*encoder);
+    encoders.push_back(encoder);
+  }
+
+private:
+  std::vector<IovecEncoder*> encoders;
 };
 
 
@@ -250,8 +421,20 @@ public:
 class FileEncoder : public Encoder
 {
 public:
-  FileEncoder(const network::Socket& s, int _fd, size_t _size)
-    : Encoder(s), fd(_fd), size(_size), index(0) {}
+  // Sends 'size' bytes of the file starting at 'offset', acquiring a
+  // permit of 'limiter' (if any) once for every byte.
+  FileEncoder(
+      const network::Socket& s,
+      int _fd,
+      size_t offset,
+      size_t _size,
+      const std::shared_ptr<RateLimiter>& _limiter)
+    : Encoder(s),
+      limiter(_limiter),
+      permits(0),
+      fd(_fd),
+      size(offset + _size),
+      index(offset) {}
 
   virtual ~FileEncoder()
   {
@@ -267,8 +450,13 @@ public:
   {
     off_t temp = index;
     index = size;
+
+    if (limiter && size - temp > FILE_CHUNK_SIZE) {
+      index = temp + FILE_CHUNK_SIZE;
+    }
+
     *offset = temp;
-    *length = size - temp;
+    *length = index - temp;
     return fd;
   }
 
@@ -284,6 +472,15 @@ public:
     return size - index;
   }
 
+  // Shared by all responses with the same bandwidth limit.
+  const std::shared_ptr<RateLimiter> limiter;
+
+  // Number of bytes at the start of the next chunk that permits have
+  // already been acquired for, i.e., the part of the previous chunk
+  // that was not sent. These are carried over rather than acquired
+  // again, so every byte is charged once.
+  size_t permits;
+
 private:
   int fd;
   size_t size;
@@ -0,0 +1,606 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <errno.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include <process/io.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/lambda.hpp>
+#include <stout/numify.hpp>
+#include <stout/option.hpp>
+#include <stout/os.hpp>
+#include <stout/synchronized.hpp>
+#include <stout/thread_local.hpp>
+#include <stout/try.hpp>
+
+#include "epoll.hpp"
+#include "event_loop.hpp"
+#ifdef HAVE_LINUX_IO_URING_H
+#include "io_uring.hpp"
+#endif // HAVE_LINUX_IO_URING_H
+#include "pool.hpp"
+
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace process {
+
+std::vector<Reactor*>* reactors = new std::vector<Reactor*>();
+
+
+// Maximum number of events returned by a single 'epoll_wait'.
+static const int EVENTS = 1024;
+
+// Tags the epoll data of watched file descriptors.
+static const uint64_t WATCH = uint64_t(1) << 63;
+
+
+static uint32_t events(short events)
+{
+  return (events & io::READ ? EPOLLIN : 0) |
+         (events & io::WRITE ? EPOLLOUT : 0);
+}
+
+
+Try<EpollPoller*> EpollPoller::create()
+{
+  int fd = ::epoll_create1(EPOLL_CLOEXEC);
+
+  if (fd < 0) {
+    return ErrnoError("Failed to create epoll instance");
+  }
+
+  return new EpollPoller(fd);
+}
+
+
+EpollPoller::~EpollPoller()
+{
+  ::close(fd);
+}
+
+
+void EpollPoller::add(Poll* poll)
+{
+  Descriptor* descriptor = &descriptors[poll->fd];
+
+  descriptor->polls.push_back(poll);
+
+  arm(poll->fd, descriptor);
+}
+
+
+void EpollPoller::remove(Poll* poll)
+{
+  vector<Poll*>::iterator iterator =
+    std::find(unsupported.begin(), unsupported.end(), poll);
+
+  if (iterator != unsupported.end()) {
+    unsupported.erase(iterator);
+    return;
+  }
+
+  if (!descriptors.contains(poll->fd)) {
+    return;
+  }
+
+  Descriptor* descriptor = &descriptors[poll->fd];
+
+  iterator = std::find(
+      descriptor->polls.begin(),
+      descriptor->polls.end(),
+      poll);
+
+  if (iterator == descriptor->polls.end()) {
+    return;
+  }
+
+  descriptor->polls.erase(iterator);
+
+  if (!descriptor->polls.empty()) {
+    arm(poll->fd, descriptor);
+    return;
+  }
+
+  // Unlike after a completed poll the registration is still armed,
+  // so we remove it. Failures are ignored since the file descriptor
+  // might have been closed already.
+  if (descriptor->registered) {
+    ::epoll_ctl(fd, EPOLL_CTL_DEL, poll->fd, NULL);
+  }
+
+  descriptors.erase(poll->fd);
+}
+
+
+void EpollPoller::watch(int _fd)
+{
+  struct epoll_event event;
+  event.events = EPOLLIN;
+  event.data.u64 = WATCH | uint32_t(_fd);
+
+  PCHECK(::epoll_ctl(fd, EPOLL_CTL_ADD, _fd, &event) == 0)
+    << "Failed to watch file descriptor";
+}
+
+
+void EpollPoller::wait(
+    vector<pair<Poll*, short>>* ready,
+    vector<int>* watched)
+{
+  struct epoll_event events[EVENTS];
+
+  // Don't block if there are polls of unsupported file descriptors.
+  const int timeout = unsupported.empty() ? -1 : 0;
+
+  int count = ::epoll_wait(fd, events, EVENTS, timeout);
+
+  if (count < 0) {
+    PCHECK(errno == EINTR) << "Failed to wait for events";
+    count = 0;
+  }
+
+  foreach (Poll* poll, unsupported) {
+    ready->push_back(std::make_pair(poll, poll->events));
+  }
+
+  unsupported.clear();
+
+  for (int i = 0; i < count; i++) {
+    if (events[i].data.u64 & WATCH) {
+      watched->push_back(int(events[i].data.u64 & UINT32_MAX));
+      continue;
+    }
+
+    const int _fd = events[i].data.fd;
+
+    if (!descriptors.contains(_fd)) {
+      continue;
+    }
+
+    // Errors and hang ups are reported as both readable and writable
+    // so that the subsequent I/O observes them.
+    const uint32_t revents = events[i].events;
+
+    short occurred = 0;
+
+    if (revents & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+      occurred |= io::READ;
+    }
+
+    if (revents & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+      occurred |= io::WRITE;
+    }
+
+    // The registration is now disabled (see 'EPOLLONESHOT'), so we
+    // only need to re-arm it if some polls remain.
+    Descriptor* descriptor = &descriptors[_fd];
+
+    vector<Poll*> remaining;
+
+    foreach (Poll* poll, descriptor->polls) {
+      if (poll->events & occurred) {
+        ready->push_back(std::make_pair(poll, poll->events & occurred));
+      } else {
+        remaining.push_back(poll);
+      }
+    }
+
+    descriptor->polls.swap(remaining);
+
+    if (!descriptor->polls.empty()) {
+      arm(_fd, descriptor);
+    }
+  }
+}
+
+
+void EpollPoller::arm(int _fd, Descriptor* descriptor)
+{
+  struct epoll_event event;
+  event.events = EPOLLONESHOT;
+  event.data.u64 = 0;
+  event.data.fd = _fd;
+
+  foreach (Poll* poll, descriptor->polls) {
+    event.events |= process::events(poll->events);
+  }
+
+  // Since a file descriptor is removed from the epoll instance when
+  // it gets closed, a registration might be stale (i.e., the file
+  // descriptor number has been reused), in which case we add it.
+  if (descriptor->registered &&
+      ::epoll_ctl(fd, EPOLL_CTL_MOD, _fd, &event) == 0) {
+    return;
+  }
+
+  if (::epoll_ctl(fd, EPOLL_CTL_ADD, _fd, &event) == 0 ||
+      (errno == EEXIST && ::epoll_ctl(fd, EPOLL_CTL_MOD, _fd, &event) == 0)) {
+    descriptor->registered = true;
+    return;
+  }
+
+  // The file descriptor can not be polled (e.g., it is a regular file
+  // or it has been closed), so we consider its polls ready and let
+  // the subsequent I/O succeed or fail.
+  if (errno != EPERM) {
+    VLOG(1) << "Failed to poll file descriptor " << _fd
+            << ": " << os::strerror(errno);
+  }
+
+  foreach (Poll* poll, descriptor->polls) {
+    unsupported.push_back(poll);
+  }
+
+  descriptors.erase(_fd);
+}
+
+
+// The reactor of the calling thread, if any.
+static THREAD_LOCAL Reactor* _reactor_ = NULL;
+
+
+// Returns the current time of the monotonic clock in nanoseconds.
+static int64_t monotonic()
+{
+  struct timespec ts;
+  ::clock_gettime(CLOCK_MONOTONIC, &ts);
+  return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
+Reactor* Reactor::current()
+{
+  return _reactor_;
+}
+
+
+Reactor::Reactor(Poller* _poller)
+  : poller(_poller),
+    stopping(false),
+    signaled(false)
+{
+  wakeup = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  PCHECK(wakeup >= 0) << "Failed to create eventfd";
+
+  timer = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  PCHECK(timer >= 0) << "Failed to create timerfd";
+
+  poller->watch(wakeup);
+  poller->watch(timer);
+}
+
+
+Reactor::~Reactor()
+{
+  foreachvalue (Poll* poll, polls) {
+    poll->promise.discard();
+    delete poll;
+  }
+
+  delete poller;
+
+  ::close(wakeup);
+  ::close(timer);
+}
+
+
+void Reactor::loop()
+{
+  _reactor_ = this;
+
+  vector<pair<Poll*, short>> ready;
+  vector<int> watched;
+
+  while (!stopping.load()) {
+    ready.clear();
+    watched.clear();
+
+    poller->wait(&ready, &watched);
+
+    // Remove all ready polls before completing any of them, since
+    // the callbacks might discard one of the others.
+    typedef pair<Poll*, short> Ready;
+
+    foreach (const Ready& poll, ready) {
+      polls.erase(poll.first->id);
+    }
+
+    foreach (const Ready& poll, ready) {
+      poll.first->promise.set(poll.second);
+      delete poll.first;
+    }
+
+    foreach (int fd, watched) {
+      if (fd == timer) {
+        expire();
+      } else if (fd == wakeup) {
+        drain();
+      }
+    }
+  }
+
+  _reactor_ = NULL;
+}
+
+
+void Reactor::stop()
+{
+  stopping.store(true);
+
+  const uint64_t value = 1;
+  ssize_t length = ::write(wakeup, &value, sizeof(value));
+  (void) length; // Can only fail if the counter overflows.
+}
+
+
+void Reactor::run(const lambda::function<void()>& function)
+{
+  if (_reactor_ == this) {
+    function();
+    return;
+  }
+
+  synchronized (mutex) {
+    functions.push_back(function);
+  }
+
+  if (!signaled.exchange(true)) {
+    const uint64_t value = 1;
+    ssize_t length = ::write(wakeup, &value, sizeof(value));
+    (void) length;
+  }
+}
+
+
+void Reactor::poll(Poll* poll)
+{
+  // Don't bother polling if the future has been discarded.
+  if (poll->promise.future().hasDiscard()) {
+    poll->promise.discard();
+    delete poll;
+    return;
+  }
+
+  polls[poll->id] = poll;
+  poller->add(poll);
+}
+
+
+void Reactor::discard(uint64_t id)
+{
+  if (!polls.contains(id)) {
+    return; // Already completed.
+  }
+
+  Poll* poll = polls[id];
+  polls.erase(id);
+
+  poller->remove(poll);
+
+  poll->promise.discard();
+  delete poll;
+}
+
+
+void Reactor::delay(
+    const Duration& duration,
+    const lambda::function<void()>& function)
+{
+  // We always invoke 'function' from the event loop, even if the
+  // duration is negative.
+  const int64_t deadline =
+    monotonic() + std::max(duration.ns(), int64_t(0));
+
+  const bool earliest = timers.empty() || deadline < timers.begin()->first;
+
+  timers.insert(std::make_pair(deadline, function));
+
+  if (earliest) {
+    arm(deadline);
+  }
+}
+
+
+void Reactor::drain()
+{
+  uint64_t value;
+  ssize_t length = ::read(wakeup, &value, sizeof(value));
+  (void) length;
+
+  // Clear the flag before taking the functions so that a function
+  // queued after we took them signals the reactor again.
+  signaled.store(false);
+
+  vector<lambda::function<void()>> run;
+
+  synchronized (mutex) {
+    std::swap(run, functions);
+  }
+
+  // Invoke the functions outside of the mutex, see 'handle_async' in
+  // libev.cpp for why.
+  foreach (const lambda::function<void()>& function, run) {
+    function();
+  }
+}
+
+
+void Reactor::expire()
+{
+  uint64_t expirations;
+  ssize_t length = ::read(timer, &expirations, sizeof(expirations));
+  (void) length;
+
+  const int64_t now = monotonic();
+
+  // NOTE: The invoked functions might add delays.
+  while (!timers.empty() && timers.begin()->first <= now) {
+    lambda::function<void()> function = timers.begin()->second;
+    timers.erase(timers.begin());
+    function();
+  }
+
+  if (!timers.empty()) {
+    arm(timers.begin()->first);
+  }
+}
+
+
+void Reactor::arm(int64_t deadline)
+{
+  struct itimerspec spec;
+  spec.it_interval.tv_sec = 0;
+  spec.it_interval.tv_nsec = 0;
+
+  // A zero 'it_value' disarms the timer, but the monotonic clock is
+  // never zero.
+  spec.it_value.tv_sec = deadline / 1000000000;
+  spec.it_value.tv_nsec = deadline % 1000000000;
+
+  PCHECK(::timerfd_settime(timer, TFD_TIMER_ABSTIME, &spec, NULL) == 0)
+    << "Failed to arm timerfd";
+}
+
+
+// Returns the number of reactors to run. The default aims at one
+// reactor per 8 processing threads, up to 4 reactors.
+static size_t concurrency()
+{
+  Option<string> value = os::getenv("LIBPROCESS_NUM_REACTORS");
+
+  if (value.isSome()) {
+    Try<int> result = numify<int>(value.get().c_str());
+    if (result.isSome() && result.get() > 0) {
+      return result.get();
+    }
+
+    LOG(FATAL) << "LIBPROCESS_NUM_REACTORS=" << value.get()
+               << " is not a positive number";
+  }
+
+  const long cpus = std::max(8L, sysconf(_SC_NPROCESSORS_ONLN));
+
+  return std::max(1L, std::min(4L, cpus / 8));
+}
+
+
+static Poller* poller()
+{
+#ifdef HAVE_LINUX_IO_URING_H
+  Option<string> value = os::getenv("LIBPROCESS_ENABLE_IO_URING");
+
+  if (value.isSome() && (value.get() == "1" || value.get() == "true")) {
+    Try<IoUringPoller*> poller = IoUringPoller::create();
+
+    if (poller.isSome()) {
+      return poller.get();
+    }
+
+    LOG(WARNING) << "Falling back to epoll: " << poller.error();
+  }
+#endif // HAVE_LINUX_IO_URING_H
+
+  Try<EpollPoller*> poller = EpollPoller::create();
+
+  if (poller.isError()) {
+    LOG(FATAL) << poller.error();
+  }
+
+  return poller.get();
+}
+
+
+void EventLoop::initialize()
+{
+  const size_t count = concurrency();
+
+  for (size_t i = 0; i < count; i++) {
+    reactors->push_back(new Reactor(poller()));
+  }
+}
+
+
+void EventLoop::delay(
+    const Duration& duration,
+    const lambda::function<void()>& function)
+{
+  Reactor* reactor = reactors->front();
+
+  reactor->run([=]() {
+    reactor->delay(duration, function);
+  });
+}
+
+
+double EventLoop::time()
+{
+  struct timespec ts;
+  ::clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+void EventLoop::run()
+{
+  // The first reactor runs on the calling thread (i.e., the event
+  // loop thread), the others on threads of their own. Like the event
+  // loop thread they allocate the events of received messages, so
+  // they cache pooled blocks.
+  vector<std::thread*> threads;
+
+  for (size_t i = 1; i < reactors->size(); i++) {
+    Reactor* reactor = (*reactors)[i];
+
+    threads.push_back(new std::thread([reactor]() {
+      pool::cache();
+      reactor->loop();
+    }));
+  }
+
+  reactors->front()->loop();
+
+  foreach (std::thread* thread, threads) {
+    thread->join();
+    delete thread;
+  }
+}
+
+
+void EventLoop::stop()
+{
+  foreach (Reactor* reactor, *reactors) {
+    reactor->stop();
+  }
+}
+
+} // namespace process {
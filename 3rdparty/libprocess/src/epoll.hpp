@@ -0,0 +1,201 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __EPOLL_HPP__
+#define __EPOLL_HPP__
+
+#include <stdint.h>
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <process/future.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/lambda.hpp>
+#include <stout/try.hpp>
+
+namespace process {
+
+// A pending 'io::poll' of a file descriptor. Polls are one-shot: once
+// the file descriptor is ready (or the poll gets discarded) the poll
+// is removed from its poller.
+struct Poll
+{
+  uint64_t id;
+  int fd;
+  short events; // 'io::READ' and/or 'io::WRITE'.
+  Promise<short> promise;
+};
+
+
+// The mechanism a reactor uses to wait for file descriptors. Pollers
+// are only ever used from the thread of their reactor.
+class Poller
+{
+public:
+  virtual ~Poller() {}
+
+  // Starts waiting for 'poll->events' on 'poll->fd'. Multiple polls
+  // may be pending for the same file descriptor.
+  virtual void add(Poll* poll) = 0;
+
+  // Stops waiting for a poll that has not been returned by 'wait'.
+  virtual void remove(Poll* poll) = 0;
+
+  // Persistently waits for 'fd' to become readable, until the poller
+  // is destroyed. Used for the reactor's own file descriptors.
+  virtual void watch(int fd) = 0;
+
+  // Blocks until at least one poll or watched file descriptor is
+  // ready (or a signal interrupts the wait). Ready polls are removed
+  // from the poller and appended to 'ready' along with the events
+  // that occurred, readable watched file descriptors are appended to
+  // 'watched'.
+  virtual void wait(
+      std::vector<std::pair<Poll*, short>>* ready,
+      std::vector<int>* watched) = 0;
+};
+
+
+// Poller based on (one-shot, level-triggered) epoll.
+class EpollPoller : public Poller
+{
+public:
+  static Try<EpollPoller*> create();
+
+  virtual ~EpollPoller();
+
+  virtual void add(Poll* poll);
+  virtual void remove(Poll* poll);
+  virtual void watch(int fd);
+  virtual void wait(
+      std::vector<std::pair<Poll*, short>>* ready,
+      std::vector<int>* watched);
+
+private:
+  // A file descriptor with pending polls. Descriptors are kept after
+  // their last poll completes so that the next poll only has to
+  // re-arm the (disabled) registration.
+  struct Descriptor
+  {
+    Descriptor() : registered(false) {}
+
+    std::vector<Poll*> polls;
+    bool registered;
+  };
+
+  explicit EpollPoller(int _fd) : fd(_fd) {}
+
+  // Registers (or re-arms) 'descriptor' for the union of the events
+  // of its polls.
+  void arm(int fd, Descriptor* descriptor);
+
+  const int fd;
+
+  hashmap<int, Descriptor> descriptors;
+
+  // Polls of file descriptors that epoll does not support (e.g.,
+  // regular files), which are always ready.
+  std::vector<Poll*> unsupported;
+};
+
+
+// A thread running an event loop for the file descriptors sharded to
+// it. Functions can be run in the reactor from any thread, but the
+// remaining operations must be invoked from within the reactor.
+class Reactor
+{
+public:
+  // Returns the reactor of the calling thread, if any.
+  static Reactor* current();
+
+  // Takes ownership of 'poller'.
+  explicit Reactor(Poller* poller);
+  ~Reactor();
+
+  // Runs the event loop until 'stop' is called.
+  void loop();
+
+  // Asynchronously tells the event loop to stop.
+  void stop();
+
+  // Runs 'function' in the reactor, immediately if the calling
+  // thread is the reactor's thread.
+  void run(const lambda::function<void()>& function);
+
+  // Starts polling, the poll gets deleted once it completes.
+  void poll(Poll* poll);
+
+  // Discards the poll with the specified id, if it is still pending.
+  void discard(uint64_t id);
+
+  // Invokes 'function' in the reactor after 'duration'.
+  void delay(
+      const Duration& duration,
+      const lambda::function<void()>& function);
+
+private:
+  Reactor(const Reactor&) = delete;
+  Reactor& operator=(const Reactor&) = delete;
+
+  // Runs the functions queued by other threads.
+  void drain();
+
+  // Invokes all expired timers and re-arms the timer file descriptor.
+  void expire();
+
+  // Sets the timer file descriptor to expire at 'deadline'.
+  void arm(int64_t deadline);
+
+  Poller* poller;
+
+  // An eventfd used to wake up the reactor and a timerfd for delays.
+  int wakeup;
+  int timer;
+
+  std::atomic_bool stopping;
+
+  // Functions queued by other threads. 'signaled' is set while the
+  // reactor is known to be woken up, so only the first function
+  // queued since the reactor last drained the queue writes 'wakeup'.
+  std::mutex mutex;
+  std::vector<lambda::function<void()>> functions;
+  std::atomic_bool signaled;
+
+  // Pending polls, by id.
+  hashmap<uint64_t, Poll*> polls;
+
+  // Pending delays, by deadline (in nanoseconds of the monotonic
+  // clock). Delays with the same deadline run in the order added.
+  std::multimap<int64_t, lambda::function<void()>> timers;
+};
+
+
+// The reactors of the event loop. Every file descriptor is polled by
+// the reactor at index 'fd % reactors->size()', the first reactor
+// also runs the delays of 'EventLoop::delay'.
+extern std::vector<Reactor*>* reactors;
+
+
+inline Reactor* reactor(int fd)
+{
+  return (*reactors)[fd % reactors->size()];
+}
+
+} // namespace process {
+
+#endif // __EPOLL_HPP__
@@ -0,0 +1,67 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include <process/future.hpp>
+#include <process/io.hpp>
+#include <process/process.hpp> // For process::initialize.
+
+#include "epoll.hpp"
+
+namespace process {
+namespace io {
+
+// Ids of polls, unique across all reactors.
+static std::atomic<uint64_t> ids(1);
+
+
+Future<short> poll(int fd, short events)
+{
+  process::initialize();
+
+  // TODO(benh): Check if the file descriptor is non-blocking?
+
+  Reactor* reactor = process::reactor(fd);
+
+  Poll* poll = new Poll();
+  poll->id = ids.fetch_add(1);
+  poll->fd = fd;
+  poll->events = events;
+
+  // Get a copy of the future before handing the poll to the reactor,
+  // which deletes it once the poll completes.
+  Future<short> future = poll->promise.future();
+
+  const uint64_t id = poll->id;
+
+  reactor->run([reactor, poll]() {
+    reactor->poll(poll);
+  });
+
+  // Make sure we stop polling if a discard occurs on our future. Since
+  // the reactor runs functions in order this is never invoked before
+  // the poll has been started, and it is a no-op once the poll has
+  // completed.
+  future.onDiscard([reactor, id]() {
+    reactor->run([reactor, id]() {
+      reactor->discard(id);
+    });
+  });
+
+  return future;
+}
+
+} // namespace io {
+} // namespace process {
@@ -0,0 +1,154 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __EVENT_QUEUE_HPP__
+#define __EVENT_QUEUE_HPP__
+
+#include <stdint.h>
+
+#include <atomic>
+#include <deque>
+
+#include <process/event.hpp>
+
+namespace process {
+
+// Lock-free multiple-producer single-consumer queue of events for a
+// process, built as an intrusive stack (see 'Event::next') that the
+// consumer drains in batches.
+//
+// Besides events, the head of the stack also encodes whether the
+// consumer is blocked (i.e., the process is not on any run queue and
+// needs to be scheduled by whoever enqueues the next event) or whether
+// the queue has been closed (i.e., the process is terminating and any
+// further events must be dropped). Folding these states into the head
+// means a producer learns atomically with its push whether it is
+// responsible for scheduling the process.
+class EventQueue
+{
+public:
+  EventQueue() : head(NULL) {}
+
+  // Pushes an event onto the queue. Returns false if the queue has
+  // been closed, in which case the caller retains ownership of the
+  // event. Otherwise sets 'wakeup' to true if the consumer was
+  // blocked, in which case the caller must schedule the consumer.
+  bool push(Event* event, bool* wakeup)
+  {
+    Event* old = head.load(std::memory_order_relaxed);
+
+    do {
+      if (old == CLOSED()) {
+        return false;
+      }
+
+      event->next = old == BLOCKED() ? NULL : old;
+    } while (!head.compare_exchange_weak(
+        old,
+        event,
+        std::memory_order_acq_rel,
+        std::memory_order_relaxed));
+
+    *wakeup = old == BLOCKED();
+
+    return true;
+  }
+
+  // Appends all events pushed so far to 'events' in the order in
+  // which they were pushed. Callers must serialize calls to 'drain',
+  // 'block' and 'close' (e.g., via 'ProcessBase::mutex') so that
+  // batches are appended in order.
+  void drain(std::deque<Event*>* events)
+  {
+    Event* old = head.load(std::memory_order_relaxed);
+
+    do {
+      if (old == NULL || old == BLOCKED() || old == CLOSED()) {
+        return;
+      }
+    } while (!head.compare_exchange_weak(
+        old,
+        NULL,
+        std::memory_order_acquire,
+        std::memory_order_relaxed));
+
+    append(old, events);
+  }
+
+  // Marks the consumer as blocked if no events have been pushed since
+  // the last 'drain'. Returns false if there are events to drain.
+  bool block()
+  {
+    Event* expected = NULL;
+    return head.compare_exchange_strong(expected, BLOCKED());
+  }
+
+  // Clears a blocked consumer without pushing an event (e.g., when an
+  // event was injected directly on the consumer side). Returns true if
+  // the consumer was blocked, in which case the caller must schedule
+  // the consumer.
+  bool unblock()
+  {
+    Event* expected = BLOCKED();
+    return head.compare_exchange_strong(expected, NULL);
+  }
+
+  // Closes the queue, appending any events that were pushed but not
+  // yet drained to 'events'. Any subsequent 'push' will fail.
+  void close(std::deque<Event*>* events)
+  {
+    Event* old = head.exchange(CLOSED(), std::memory_order_acquire);
+
+    if (old != NULL && old != BLOCKED() && old != CLOSED()) {
+      append(old, events);
+    }
+  }
+
+  // NOTE: This is only a snapshot and may be stale by the time the
+  // caller looks at it.
+  bool empty() const
+  {
+    Event* event = head.load(std::memory_order_relaxed);
+    return event == NULL || event == BLOCKED() || event == CLOSED();
+  }
+
+private:
+  static Event* BLOCKED() { return reinterpret_cast<Event*>(uintptr_t(1)); }
+  static Event* CLOSED() { return reinterpret_cast<Event*>(uintptr_t(2)); }
+
+  // Reverses the (LIFO) stack of events starting at 'event' and
+  // appends it to 'events'.
+  static void append(Event* event, std::deque<Event*>* events)
+  {
+    Event* reversed = NULL;
+
+    while (event != NULL) {
+      Event* next = event->next;
+      event->next = reversed;
+      reversed = event;
+      event = next;
+    }
+
+    while (reversed != NULL) {
+      Event* next = reversed->next;
+      reversed->next = NULL;
+      events->push_back(reversed);
+      reversed = next;
+    }
+  }
+
+  std::atomic<Event*> head;
+};
+
+} // namespace process {
+
+#endif // __EVENT_QUEUE_HPP__
@@ -388,16 +388,39 @@ Pipe::Writer Pipe::writer() const
 }
 
 
+vector<Owned<Promise<Nothing>>> Pipe::Data::drained()
+{
+  vector<Owned<Promise<Nothing>>> satisfied;
+
+  const bool closed = readEnd == Reader::CLOSED || writeEnd != Writer::OPEN;
+
+  for (size_t i = 0; i < drains.size();) {
+    if (closed || unread <= drains[i].first) {
+      satisfied.push_back(drains[i].second);
+      drains[i] = drains.back();
+      drains.pop_back();
+    } else {
+      i++;
+    }
+  }
+
+  return satisfied;
+}
+
+
 Future<string> Pipe::Reader::read()
 {
   Future<string> future;
+  vector<Owned<Promise<Nothing>>> drains;
 
   synchronized (data->lock) {
     if (data->readEnd == Reader::CLOSED) {
       future = Failure("closed");
     } else if (!data->writes.empty()) {
       future = data->writes.front();
+      data->unread -= data->writes.front().size();
       data->writes.pop();
+      drains = data->drained();
     } else if (data->writeEnd == Writer::CLOSED) {
       future = ""; // End-of-file.
     } else if (data->writeEnd == Writer::FAILED) {
@@ -409,15 +432,49 @@ Future<string> Pipe::Reader::read()
     }
   }
 
+  // NOTE: We set the promises outside the critical section to avoid
+  // triggering callbacks that try to reacquire the lock.
+  foreach (const Owned<Promise<Nothing>>& drain, drains) {
+    drain->set(Nothing());
+  }
+
   return future;
 }
 
 
+namespace internal {
+
+Future<string> _readAll(
+    Pipe::Reader reader,
+    const Owned<string>& buffer)
+{
+  return reader.read()
+    .then([reader, buffer](const string& data) mutable -> Future<string> {
+      if (data.empty()) {
+        return *buffer; // EOF.
+      }
+
+      buffer->append(data);
+
+      return _readAll(reader, buffer);
+    });
+}
+
+} // namespace internal {
+
+
+Future<string> Pipe::Reader::readAll()
+{
+  return internal::_readAll(*this, Owned<string>(new string()));
+}
+
+
 bool Pipe::Reader::close()
 {
   bool closed = false;
   bool notify = false;
   queue<Owned<Promise<string>>> reads;
+  vector<Owned<Promise<Nothing>>> drains;
 
   synchronized (data->lock) {
     if (data->readEnd == Reader::OPEN) {
@@ -426,6 +483,8 @@ bool Pipe::Reader::close()
         data->writes.pop();
       }
 
+      data->unread = 0;
+
       // Extract the pending reads so we can fail them.
       std::swap(data->reads, reads);
 
@@ -434,6 +493,8 @@ bool Pipe::Reader::close()
 
       // Notify if write-end is still open!
       notify = data->writeEnd == Writer::OPEN;
+
+      drains = data->drained();
     }
   }
 
@@ -448,6 +509,10 @@ bool Pipe::Reader::close()
     if (notify) {
       data->readerClosure.set(Nothing());
     }
+
+    foreach (const Owned<Promise<Nothing>>& drain, drains) {
+      drain->set(Nothing());
+    }
   }
 
   return closed;
@@ -466,6 +531,7 @@ bool Pipe::Writer::write(const string& s)
       if (!s.empty()) {
         if (data->reads.empty()) {
           data->writes.push(s);
+          data->unread += s.size();
         } else {
           read = data->reads.front();
           data->reads.pop();
@@ -489,6 +555,7 @@ bool Pipe::Writer::close()
 {
   bool closed = false;
   queue<Owned<Promise<string>>> reads;
+  vector<Owned<Promise<Nothing>>> drains;
 
   synchronized (data->lock) {
     if (data->writeEnd == Writer::OPEN) {
@@ -497,6 +564,8 @@ bool Pipe::Writer::close()
 
       data->writeEnd = Writer::CLOSED;
       closed = true;
+
+      drains = data->drained();
     }
   }
 
@@ -507,6 +576,10 @@ bool Pipe::Writer::close()
     reads.pop();
   }
 
+  foreach (const Owned<Promise<Nothing>>& drain, drains) {
+    drain->set(Nothing());
+  }
+
   return closed;
 }
 
@@ -515,6 +588,7 @@ bool Pipe::Writer::fail(const string& message)
 {
   bool failed = false;
   queue<Owned<Promise<string>>> reads;
+  vector<Owned<Promise<Nothing>>> drains;
 
   synchronized (data->lock) {
     if (data->writeEnd == Writer::OPEN) {
@@ -524,6 +598,8 @@ bool Pipe::Writer::fail(const string& message)
       data->writeEnd = Writer::FAILED;
       data->failure = Failure(message);
       failed = true;
+
+      drains = data->drained();
     }
   }
 
@@ -534,6 +610,10 @@ bool Pipe::Writer::fail(const string& message)
     reads.pop();
   }
 
+  foreach (const Owned<Promise<Nothing>>& drain, drains) {
+    drain->set(Nothing());
+  }
+
   return failed;
 }
 
@@ -544,6 +624,24 @@ Future<Nothing> Pipe::Writer::readerClosed() const
 }
 
 
+Future<Nothing> Pipe::Writer::drained(size_t size) const
+{
+  Future<Nothing> future = Nothing();
+
+  synchronized (data->lock) {
+    if (data->readEnd == Reader::OPEN &&
+        data->writeEnd == Writer::OPEN &&
+        data->unread > size) {
+      Owned<Promise<Nothing>> drain(new Promise<Nothing>());
+      data->drains.push_back(std::make_pair(size, drain));
+      future = drain->future();
+    }
+  }
+
+  return future;
+}
+
+
 OK::OK(const JSON::Value& value, const Option<string>& jsonp)
   : Response(Status::OK)
 {
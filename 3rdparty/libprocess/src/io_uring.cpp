@@ -0,0 +1,379 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <linux/io_uring.h>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include <utility>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include <process/io.hpp>
+
+#include <stout/error.hpp>
+#include <stout/try.hpp>
+
+#include "io_uring.hpp"
+
+using std::pair;
+using std::vector;
+
+namespace process {
+
+// Number of entries of the submission ring. Completions of polls only
+// occupy the (larger) completion ring once they are ready.
+static const unsigned ENTRIES = 4096;
+static const unsigned COMPLETIONS = 8 * ENTRIES;
+
+// The 'user_data' of requests whose completion is ignored, and the
+// tag of the 'user_data' of watched file descriptors.
+static const uint64_t IGNORE = 0;
+static const uint64_t WATCH = uint64_t(1) << 63;
+
+
+static int io_uring_setup(unsigned entries, struct io_uring_params* params)
+{
+#ifdef __NR_io_uring_setup
+  return ::syscall(__NR_io_uring_setup, entries, params);
+#else
+  errno = ENOSYS;
+  return -1;
+#endif // __NR_io_uring_setup
+}
+
+
+static int io_uring_enter(
+    int fd,
+    unsigned submit,
+    unsigned wait,
+    unsigned flags)
+{
+#ifdef __NR_io_uring_enter
+  return ::syscall(__NR_io_uring_enter, fd, submit, wait, flags, NULL, 0);
+#else
+  errno = ENOSYS;
+  return -1;
+#endif // __NR_io_uring_enter
+}
+
+
+Try<IoUringPoller*> IoUringPoller::create()
+{
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+
+  params.flags = IORING_SETUP_CQSIZE;
+  params.cq_entries = COMPLETIONS;
+
+  int fd = io_uring_setup(ENTRIES, &params);
+
+  if (fd < 0) {
+    return ErrnoError("Failed to set up io_uring");
+  }
+
+  // Without 'IORING_FEAT_NODROP' completions are dropped when the
+  // completion ring overflows, which would lose polls.
+  if ((params.features & IORING_FEAT_NODROP) == 0) {
+    ::close(fd);
+    return Error("io_uring does not support IORING_FEAT_NODROP");
+  }
+
+  IoUringPoller* poller = new IoUringPoller();
+  poller->fd = fd;
+
+  poller->sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  poller->cqSize =
+    params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  poller->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+  poller->sq = ::mmap(
+      NULL,
+      poller->sqSize,
+      PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE,
+      fd,
+      IORING_OFF_SQ_RING);
+
+  poller->cq = ::mmap(
+      NULL,
+      poller->cqSize,
+      PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE,
+      fd,
+      IORING_OFF_CQ_RING);
+
+  void* sqes = ::mmap(
+      NULL,
+      poller->sqesSize,
+      PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE,
+      fd,
+      IORING_OFF_SQES);
+
+  if (poller->sq == MAP_FAILED ||
+      poller->cq == MAP_FAILED ||
+      sqes == MAP_FAILED) {
+    ErrnoError error("Failed to map io_uring");
+    delete poller;
+    if (sqes != MAP_FAILED) {
+      ::munmap(sqes, params.sq_entries * sizeof(struct io_uring_sqe));
+    }
+    return error;
+  }
+
+  char* sq = static_cast<char*>(poller->sq);
+  char* cq = static_cast<char*>(poller->cq);
+
+  poller->sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+  poller->sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  poller->sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  poller->sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  poller->sqes = static_cast<struct io_uring_sqe*>(sqes);
+
+  poller->cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  poller->cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  poller->cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  poller->cqes =
+    reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+  return poller;
+}
+
+
+IoUringPoller::IoUringPoller()
+  : fd(-1),
+    sq(MAP_FAILED),
+    sqSize(0),
+    sqHead(NULL),
+    sqTail(NULL),
+    sqMask(0),
+    sqArray(NULL),
+    sqes(static_cast<struct io_uring_sqe*>(MAP_FAILED)),
+    sqesSize(0),
+    cq(MAP_FAILED),
+    cqSize(0),
+    cqHead(NULL),
+    cqTail(NULL),
+    cqMask(0),
+    cqes(NULL),
+    queued(0) {}
+
+
+IoUringPoller::~IoUringPoller()
+{
+  if (sqes != MAP_FAILED) {
+    ::munmap(sqes, sqesSize);
+  }
+
+  if (cq != MAP_FAILED) {
+    ::munmap(cq, cqSize);
+  }
+
+  if (sq != MAP_FAILED) {
+    ::munmap(sq, sqSize);
+  }
+
+  if (fd >= 0) {
+    ::close(fd);
+  }
+}
+
+
+void IoUringPoller::add(Poll* poll)
+{
+  polls[poll->id] = poll;
+
+  submit(poll->id, poll->fd, poll->events);
+}
+
+
+void IoUringPoller::remove(Poll* poll)
+{
+  if (!polls.contains(poll->id)) {
+    return;
+  }
+
+  polls.erase(poll->id);
+
+  struct io_uring_sqe sqe;
+  memset(&sqe, 0, sizeof(sqe));
+
+  sqe.opcode = IORING_OP_POLL_REMOVE;
+  sqe.fd = -1;
+  sqe.addr = poll->id;
+  sqe.user_data = IGNORE;
+
+  push(sqe);
+}
+
+
+void IoUringPoller::watch(int _fd)
+{
+  submit(WATCH | uint32_t(_fd), _fd, io::READ);
+}
+
+
+void IoUringPoller::wait(
+    vector<pair<Poll*, short>>* ready,
+    vector<int>* watched)
+{
+  while (!backlog.empty() && !full()) {
+    place(backlog.front());
+    backlog.pop_front();
+  }
+
+  if (!enter(1)) {
+    return;
+  }
+
+  unsigned head = *cqHead;
+  const unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+
+  for (; head != tail; head++) {
+    const struct io_uring_cqe* cqe = &cqes[head & cqMask];
+
+    const uint64_t data = cqe->user_data;
+    const int result = cqe->res;
+
+    if (data == IGNORE) {
+      continue;
+    }
+
+    if (data & WATCH) {
+      const int _fd = int(data & UINT32_MAX);
+
+      watched->push_back(_fd);
+
+      // Poll requests are one-shot, so re-arm the watch. It gets
+      // submitted along with the next wait.
+      submit(data, _fd, io::READ);
+      continue;
+    }
+
+    if (!polls.contains(data)) {
+      continue; // Removed.
+    }
+
+    Poll* poll = polls[data];
+    polls.erase(data);
+
+    // Errors and hang ups are reported as both readable and writable
+    // so that the subsequent I/O observes them. The same goes for a
+    // failed request (e.g., the file descriptor has been closed).
+    short occurred = poll->events;
+
+    if (result >= 0) {
+      occurred = 0;
+
+      if (result & (POLLIN | POLLPRI | POLLERR | POLLHUP)) {
+        occurred |= io::READ;
+      }
+
+      if (result & (POLLOUT | POLLERR | POLLHUP)) {
+        occurred |= io::WRITE;
+      }
+
+      occurred &= poll->events;
+    }
+
+    ready->push_back(std::make_pair(poll, occurred));
+  }
+
+  __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+}
+
+
+void IoUringPoller::submit(uint64_t data, int _fd, short events)
+{
+  struct io_uring_sqe sqe;
+  memset(&sqe, 0, sizeof(sqe));
+
+  sqe.opcode = IORING_OP_POLL_ADD;
+  sqe.fd = _fd;
+  sqe.poll_events =
+    (events & io::READ ? POLLIN : 0) | (events & io::WRITE ? POLLOUT : 0);
+  sqe.user_data = data;
+
+  push(sqe);
+}
+
+
+void IoUringPoller::push(const struct io_uring_sqe& sqe)
+{
+  if (full()) {
+    enter(0);
+  }
+
+  // The kernel might not accept more requests until we reaped the
+  // completions (see 'enter'), so we keep the request until the next
+  // wait.
+  if (!backlog.empty() || full()) {
+    backlog.push_back(sqe);
+    return;
+  }
+
+  place(sqe);
+}
+
+
+void IoUringPoller::place(const struct io_uring_sqe& sqe)
+{
+  const unsigned tail = *sqTail;
+  const unsigned index = tail & sqMask;
+
+  sqes[index] = sqe;
+  sqArray[index] = index;
+
+  __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+
+  queued++;
+}
+
+
+bool IoUringPoller::full() const
+{
+  return *sqTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) > sqMask;
+}
+
+
+bool IoUringPoller::enter(unsigned wait)
+{
+  const unsigned flags = wait > 0 ? IORING_ENTER_GETEVENTS : 0;
+
+  int result = io_uring_enter(fd, queued, wait, flags);
+
+  // Older kernels refuse to submit requests while completions are
+  // overflowing the completion ring, but we can still reap them.
+  if (result < 0 && errno == EBUSY && wait > 0) {
+    result = io_uring_enter(fd, 0, wait, flags);
+  }
+
+  if (result < 0) {
+    PCHECK(errno == EINTR || errno == EBUSY || errno == EAGAIN)
+      << "Failed to enter io_uring";
+    return false;
+  }
+
+  queued -= result;
+
+  return true;
+}
+
+} // namespace process {
@@ -0,0 +1,110 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __IO_URING_HPP__
+#define __IO_URING_HPP__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <linux/io_uring.h>
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include <stout/hashmap.hpp>
+#include <stout/try.hpp>
+
+#include "epoll.hpp"
+
+namespace process {
+
+// Poller based on io_uring poll requests. Compared to epoll, adding
+// and completing a poll does not need a system call of its own: the
+// requests are queued in the submission ring and submitted as part of
+// the next wait.
+//
+// The rings are set up with the raw system calls, so no liburing is
+// required. Creating the poller fails if the kernel does not support
+// io_uring (e.g., older than 5.1, or io_uring has been disabled), in
+// which case callers should fall back to an 'EpollPoller'.
+class IoUringPoller : public Poller
+{
+public:
+  static Try<IoUringPoller*> create();
+
+  virtual ~IoUringPoller();
+
+  virtual void add(Poll* poll);
+  virtual void remove(Poll* poll);
+  virtual void watch(int fd);
+  virtual void wait(
+      std::vector<std::pair<Poll*, short>>* ready,
+      std::vector<int>* watched);
+
+private:
+  IoUringPoller();
+
+  // Queues a poll request for 'fd'.
+  void submit(uint64_t data, int fd, short events);
+
+  // Queues 'sqe', submitting the queued requests first if the
+  // submission ring is full.
+  void push(const struct io_uring_sqe& sqe);
+
+  // Adds 'sqe' to the submission ring, which must not be full.
+  void place(const struct io_uring_sqe& sqe);
+
+  // Returns true if the submission ring is full.
+  bool full() const;
+
+  // Submits the queued requests, waiting for at least 'wait'
+  // completions. Returns false if nothing has been submitted or
+  // reaped (e.g., interrupted by a signal).
+  bool enter(unsigned wait);
+
+  int fd;
+
+  // Submission ring.
+  void* sq;
+  size_t sqSize;
+  unsigned* sqHead;
+  unsigned* sqTail;
+  unsigned sqMask;
+  unsigned* sqArray;
+  struct io_uring_sqe* sqes;
+  size_t sqesSize;
+
+  // Completion ring.
+  void* cq;
+  size_t cqSize;
+  unsigned* cqHead;
+  unsigned* cqTail;
+  unsigned cqMask;
+  struct io_uring_cqe* cqes;
+
+  // Number of requests queued but not yet submitted.
+  unsigned queued;
+
+  // Requests that did not fit into the submission ring.
+  std::deque<struct io_uring_sqe> backlog;
+
+  // Pending polls by id, which is the 'user_data' of their request.
+  // A removed poll may still complete (e.g., with ECANCELED), which
+  // is ignored since it is not found here.
+  hashmap<uint64_t, Poll*> polls;
+};
+
+} // namespace process {
+
+#endif // __IO_URING_HPP__
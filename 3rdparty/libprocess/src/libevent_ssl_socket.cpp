@@ -10,6 +10,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License
 
+#include <vector>
+
 #include <event2/buffer.h>
 #include <event2/bufferevent_ssl.h>
 #include <event2/event.h>
@@ -23,6 +25,7 @@
 #include <process/queue.hpp>
 #include <process/socket.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/net.hpp>
 #include <stout/synchronized.hpp>
 
@@ -734,6 +737,55 @@ Future<size_t> LibeventSSLSocketImpl::send(const char* data, size_t size)
 }
 
 
+Future<size_t> LibeventSSLSocketImpl::sendv(
+    const struct iovec* iov,
+    int iovcnt)
+{
+  CHECK_GT(iovcnt, 0);
+
+  // The buffers are copied into the bufferevent, which encrypts and
+  // writes them out together, hence we send all of them at once
+  // rather than one buffer per round trip.
+  std::vector<struct iovec> buffers(iov, iov + iovcnt);
+
+  size_t size = 0;
+  foreach (const struct iovec& buffer, buffers) {
+    size += buffer.iov_len;
+  }
+
+  // Optimistically construct a 'SendRequest' and future.
+  Owned<SendRequest> request(new SendRequest(size));
+  Future<size_t> future = request->promise.future();
+
+  // See the comments in 'send' about discards, the lock and 'self'.
+  synchronized (lock) {
+    if (send_request.get() != NULL) {
+      return Failure("Socket is already sending");
+    }
+    std::swap(request, send_request);
+  }
+
+  auto self = shared(this);
+
+  run_in_event_loop(
+      [self, buffers]() {
+        CHECK(__in_event_loop__);
+        CHECK(self);
+
+        synchronized (self->lock) {
+          CHECK_NOTNULL(self->send_request.get());
+        }
+
+        foreach (const struct iovec& buffer, buffers) {
+          bufferevent_write(self->bev, buffer.iov_base, buffer.iov_len);
+        }
+      },
+      DISALLOW_SHORT_CIRCUIT);
+
+  return future;
+}
+
+
 Future<size_t> LibeventSSLSocketImpl::sendfile(
     int fd,
     off_t offset,
@@ -43,6 +43,7 @@ public:
   virtual Future<size_t> recv(char* data, size_t size);
   // Send does not currently support discard. See implementation.
   virtual Future<size_t> send(const char* data, size_t size);
+  virtual Future<size_t> sendv(const struct iovec* iov, int iovcnt);
   virtual Future<size_t> sendfile(int fd, off_t offset, size_t size);
   virtual Try<Nothing> listen(int backlog);
   virtual Future<Socket> accept();
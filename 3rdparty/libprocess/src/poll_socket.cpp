@@ -12,6 +12,9 @@
 
 #include <netinet/tcp.h>
 
+#include <sys/socket.h>
+#include <sys/uio.h>
+
 #include <process/io.hpp>
 #include <process/network.hpp>
 #include <process/socket.hpp>
@@ -212,6 +215,49 @@ Future<size_t> socket_send_file(int s, int fd, off_t offset, size_t size)
   }
 }
 
+
+Future<size_t> socket_send_buffers(int s, const struct iovec* iov, int iovcnt)
+{
+  CHECK(iovcnt > 0);
+
+  // We use 'sendmsg' rather than 'writev' so that we can pass
+  // MSG_NOSIGNAL, just like 'socket_send_data'.
+  struct msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_iov = const_cast<struct iovec*>(iov);
+  message.msg_iovlen = iovcnt;
+
+  while (true) {
+    ssize_t length = sendmsg(s, &message, MSG_NOSIGNAL);
+
+    if (length < 0 && (errno == EINTR)) {
+      // Interrupted, try again now.
+      continue;
+    } else if (length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      // Might block, try again later.
+      return io::poll(s, io::WRITE)
+        .then(lambda::bind(&internal::socket_send_buffers, s, iov, iovcnt));
+    } else if (length <= 0) {
+      // Socket error or closed.
+      if (length < 0) {
+        const string error = os::strerror(errno);
+        VLOG(1) << "Socket error while sending: " << error;
+      } else {
+        VLOG(1) << "Socket closed while sending";
+      }
+      if (length == 0) {
+        return length;
+      } else {
+        return Failure(ErrnoError("Socket sendmsg failed"));
+      }
+    } else {
+      CHECK(length > 0);
+
+      return length;
+    }
+  }
+}
+
 } // namespace internal {
 
 
@@ -228,5 +274,12 @@ Future<size_t> PollSocketImpl::sendfile(int fd, off_t offset, size_t size)
     .then(lambda::bind(&internal::socket_send_file, get(), fd, offset, size));
 }
 
+
+Future<size_t> PollSocketImpl::sendv(const struct iovec* iov, int iovcnt)
+{
+  return io::poll(get(), io::WRITE)
+    .then(lambda::bind(&internal::socket_send_buffers, get(), iov, iovcnt));
+}
+
 } // namespace network {
 } // namespace process {
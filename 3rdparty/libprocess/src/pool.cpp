@@ -0,0 +1,231 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include <process/event.hpp>
+#include <process/message.hpp>
+
+#include <stout/synchronized.hpp>
+#include <stout/thread_local.hpp>
+
+#include "pool.hpp"
+
+using std::vector;
+
+namespace process {
+namespace pool {
+
+// Blocks are handed out in multiples of 'ALIGNMENT' bytes, up to
+// 'CLASSES * ALIGNMENT' bytes. Larger requests go to the heap.
+static const size_t ALIGNMENT = 16;
+static const size_t CLASSES = 16;
+
+// Maximum number of blocks a thread caches per size class before it
+// returns 'BATCH' of them to the depot.
+static const size_t CAPACITY = 1024;
+static const size_t BATCH = 256;
+
+// Maximum number of batches the depot keeps per size class. Batches
+// returned beyond that are freed, so that the memory of a burst is
+// released once it has passed.
+static const size_t DEPOT_CAPACITY = 16;
+
+
+struct Block
+{
+  Block* next;
+};
+
+
+struct FreeList
+{
+  Block* head;
+  size_t size;
+};
+
+
+struct Cache
+{
+  FreeList lists[CLASSES];
+};
+
+
+// Batches of 'BATCH' blocks (linked via 'Block::next') for a size
+// class that have been returned by threads with full free lists.
+struct Depot
+{
+  std::mutex mutex;
+  vector<Block*> batches;
+};
+
+
+// NOTE: Intentionally leaked, like other libprocess globals, since
+// blocks may be freed during static destruction.
+static Depot* depots = new Depot[CLASSES];
+
+
+// Per thread cache, or NULL if the thread does not cache blocks.
+static THREAD_LOCAL Cache* _cache_ = NULL;
+
+
+// Number of blocks allocated from the heap, see 'misses'.
+static std::atomic_size_t _misses_(0);
+
+
+// Allocates a block from the heap.
+static void* miss(size_t size)
+{
+  _misses_.fetch_add(1, std::memory_order_relaxed);
+  return ::operator new(size);
+}
+
+
+static size_t index(size_t size)
+{
+  return size == 0 ? 0 : (size - 1) / ALIGNMENT;
+}
+
+
+void* allocate(size_t size)
+{
+  const size_t i = index(size);
+
+  if (i >= CLASSES) {
+    return miss(size);
+  }
+
+  Cache* cache = _cache_;
+
+  if (cache == NULL) {
+    // Allocate the full block so that it can be cached by whichever
+    // thread ends up freeing it.
+    return miss((i + 1) * ALIGNMENT);
+  }
+
+  FreeList* list = &cache->lists[i];
+
+  if (list->head == NULL) {
+    synchronized (depots[i].mutex) {
+      if (!depots[i].batches.empty()) {
+        list->head = depots[i].batches.back();
+        list->size = BATCH;
+        depots[i].batches.pop_back();
+      }
+    }
+
+    if (list->head == NULL) {
+      return miss((i + 1) * ALIGNMENT);
+    }
+  }
+
+  Block* block = list->head;
+  list->head = block->next;
+  list->size--;
+
+  return block;
+}
+
+
+void deallocate(void* pointer, size_t size)
+{
+  const size_t i = index(size);
+
+  Cache* cache = _cache_;
+
+  if (i >= CLASSES || cache == NULL) {
+    ::operator delete(pointer);
+    return;
+  }
+
+  FreeList* list = &cache->lists[i];
+
+  Block* block = static_cast<Block*>(pointer);
+  block->next = list->head;
+  list->head = block;
+  list->size++;
+
+  if (list->size >= CAPACITY) {
+    // Return a batch of blocks to the depot.
+    Block* batch = list->head;
+
+    Block* last = batch;
+    for (size_t j = 1; j < BATCH; j++) {
+      last = last->next;
+    }
+
+    list->head = last->next;
+    list->size -= BATCH;
+    last->next = NULL;
+
+    bool kept = false;
+
+    synchronized (depots[i].mutex) {
+      if (depots[i].batches.size() < DEPOT_CAPACITY) {
+        depots[i].batches.push_back(batch);
+        kept = true;
+      }
+    }
+
+    // Free the batch outside of the critical section.
+    while (!kept && batch != NULL) {
+      Block* next = batch->next;
+      ::operator delete(batch);
+      batch = next;
+    }
+  }
+}
+
+
+void cache()
+{
+  if (_cache_ == NULL) {
+    _cache_ = new Cache();
+  }
+}
+
+
+size_t misses()
+{
+  return _misses_.load(std::memory_order_relaxed);
+}
+
+} // namespace pool {
+
+
+void* Event::operator new(size_t size)
+{
+  return pool::allocate(size);
+}
+
+
+void Event::operator delete(void* event, size_t size)
+{
+  pool::deallocate(event, size);
+}
+
+
+void* Message::operator new(size_t size)
+{
+  return pool::allocate(size);
+}
+
+
+void Message::operator delete(void* message, size_t size)
+{
+  pool::deallocate(message, size);
+}
+
+} // namespace process {
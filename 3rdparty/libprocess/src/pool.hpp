@@ -0,0 +1,55 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __POOL_HPP__
+#define __POOL_HPP__
+
+#include <stddef.h>
+
+namespace process {
+namespace pool {
+
+// Pools of small, fixed size blocks used for objects that libprocess
+// allocates and frees at very high rates (events and messages).
+//
+// Each thread that has called 'cache' keeps a free list per size
+// class. Since objects are commonly allocated on one thread (e.g., the
+// sender of a dispatch) and freed on another (the receiver), a thread
+// whose free list grows too long returns a batch of blocks to a global
+// depot, from which threads with an empty free list take a batch. This
+// way the global lock is acquired at most once per batch of blocks. The
+// depot keeps a bounded number of batches and frees any beyond that,
+// so that the blocks of a burst are returned to the heap.
+//
+// Threads that have not called 'cache' (e.g., threads created outside
+// of libprocess) allocate and free directly from the heap.
+
+// Returns a block of at least 'size' bytes.
+void* allocate(size_t size);
+
+// Returns a block previously returned by 'allocate(size)'.
+void deallocate(void* block, size_t size);
+
+// Enables the per-thread cache for the calling thread. The blocks in
+// the thread's free lists are never returned to the heap, so this
+// should only be called by long-lived threads (e.g., processing
+// threads).
+void cache();
+
+// Returns the number of blocks allocated from the heap rather than
+// from a free list, e.g., to check that a hot path reuses its blocks.
+size_t misses();
+
+} // namespace pool {
+} // namespace process {
+
+#endif // __POOL_HPP__
@@ -37,6 +37,7 @@
 #include <sys/uio.h>
 
 #include <algorithm>
+#include <chrono>
 #include <deque>
 #include <fstream>
 #include <iomanip>
@@ -67,6 +68,7 @@
 #include <process/help.hpp>
 #include <process/id.hpp>
 #include <process/io.hpp>
+#include <process/limiter.hpp>
 #include <process/logging.hpp>
 #include <process/mime.hpp>
 #include <process/owned.hpp>
@@ -90,6 +92,7 @@
 #include <stout/os.hpp>
 #include <stout/os/strerror.hpp>
 #include <stout/path.hpp>
+#include <stout/result.hpp>
 #include <stout/strings.hpp>
 #include <stout/synchronized.hpp>
 #include <stout/thread_local.hpp>
@@ -100,11 +103,14 @@
 #include "decoder.hpp"
 #include "encoder.hpp"
 #include "event_loop.hpp"
+#include "event_queue.hpp"
 #include "gate.hpp"
+#include "pool.hpp"
 #ifdef USE_SSL_SOCKET
 #include "openssl.hpp"
 #endif
 #include "process_reference.hpp"
+#include "run_queue.hpp"
 
 namespace firewall = process::firewall;
 namespace metrics = process::metrics;
@@ -117,6 +123,7 @@ using process::http::Forbidden;
 using process::http::InternalServerError;
 using process::http::NotFound;
 using process::http::OK;
+using process::http::Pipe;
 using process::http::Request;
 using process::http::Response;
 using process::http::ServiceUnavailable;
@@ -399,6 +406,9 @@ public:
       const Socket& socket,
       Request* request);
 
+  // Delivers messages received from a socket (see 'DataDecoder').
+  void handle(const std::deque<Message*>& messages);
+
   bool deliver(
       ProcessBase* receiver,
       Event* event,
@@ -420,7 +430,7 @@ public:
   string absolutePath(const string& path);
 
   void enqueue(ProcessBase* process);
-  ProcessBase* dequeue();
+  ProcessBase* dequeue(long worker);
 
   void settle();
 
@@ -438,11 +448,20 @@ private:
   // Gates for waiting threads (protected by processes_mutex).
   map<ProcessBase*, Gate*> gates;
 
-  // Queue of runnable processes (implemented using list).
-  list<ProcessBase*> runq;
-  std::recursive_mutex runq_mutex;
+  // Queues of runnable processes, one per processing thread. Idle
+  // threads steal from the queues of other threads (see 'dequeue').
+  vector<RunQueue*> runqs;
+
+  // Used to spread processes that have never run (and are enqueued
+  // from a thread that is not a processing thread) across 'runqs'.
+  std::atomic_long next_runq;
 
-  // Number of running processes, to support Clock::settle operation.
+  // Number of processes that are either enqueued on one of 'runqs'
+  // or currently running, to support Clock::settle operation. This
+  // is incremented _before_ a process is pushed onto a run queue and
+  // decremented only after the process has been resumed, so that a
+  // process moving from a run queue to a processing thread is never
+  // observed as neither queued nor running.
   std::atomic_long running;
 
   // Stores the thread handles so that we can join during shutdown.
@@ -496,6 +515,10 @@ THREAD_LOCAL ProcessBase* __process__ = NULL;
 // Per thread executor pointer.
 THREAD_LOCAL Executor* _executor_ = NULL;
 
+// Per thread index of the processing thread (and thus its run queue),
+// or -1 if this is not a processing thread.
+THREAD_LOCAL long __worker__ = -1;
+
 
 namespace http {
 namespace authentication {
@@ -556,72 +579,6 @@ static void transport(Message* message, ProcessBase* sender = NULL)
 }
 
 
-static bool libprocess(Request* request)
-{
-  return
-    (request->method == "POST" &&
-     request->headers.contains("User-Agent") &&
-     request->headers["User-Agent"].find("libprocess/") == 0) ||
-    (request->method == "POST" &&
-     request->headers.contains("Libprocess-From"));
-}
-
-
-static Message* parse(Request* request)
-{
-  // TODO(benh): Do better error handling (to deal with a malformed
-  // libprocess message, malicious or otherwise).
-
-  // First try and determine 'from'.
-  Option<UPID> from = None();
-
-  if (request->headers.contains("Libprocess-From")) {
-    from = UPID(strings::trim(request->headers["Libprocess-From"]));
-  } else {
-    // Try and get 'from' from the User-Agent.
-    const string& agent = request->headers["User-Agent"];
-    const string identifier = "libprocess/";
-    size_t index = agent.find(identifier);
-    if (index != string::npos) {
-      from = UPID(agent.substr(index + identifier.size(), agent.size()));
-    }
-  }
-
-  if (from.isNone()) {
-    return NULL;
-  }
-
-  // Now determine 'to'.
-  size_t index = request->url.path.find('/', 1);
-  index = index != string::npos ? index - 1 : string::npos;
-
-  // Decode possible percent-encoded 'to'.
-  Try<string> decode = http::decode(request->url.path.substr(1, index));
-
-  if (decode.isError()) {
-    VLOG(2) << "Failed to decode URL path: " << decode.get();
-    return NULL;
-  }
-
-  const UPID to(decode.get(), __address__);
-
-  // And now determine 'name'.
-  index = index != string::npos ? index + 2: request->url.path.size();
-  const string name = request->url.path.substr(index);
-
-  VLOG(2) << "Parsed message name '" << name
-          << "' for " << to << " from " << from.get();
-
-  Message* message = new Message();
-  message->name = name;
-  message->from = from.get();
-  message->to = to;
-  message->body = request->body;
-
-  return message;
-}
-
-
 namespace internal {
 
 void decode_recv(
@@ -651,8 +608,15 @@ void decode_recv(
     return;
   }
 
-  // Decode as much of the data as possible into HTTP requests.
-  const deque<Request*> requests = decoder->decode(data, length.get());
+  // Decode as much of the data as possible into HTTP requests and
+  // libprocess messages.
+  deque<Message*> messages;
+  const deque<Request*> requests =
+    decoder->decode(data, length.get(), &messages);
+
+  if (!messages.empty()) {
+    process_manager->handle(messages);
+  }
 
   if (requests.empty() && decoder->failed()) {
      VLOG(1) << "Decoder error while receiving";
@@ -683,6 +647,24 @@ void decode_recv(
     }
   }
 
+  // Don't receive more data until the reader of a streamed request
+  // body has caught up, which bounds the memory used per connection.
+  Future<Nothing> drained = decoder->drained();
+
+  if (!drained.isReady()) {
+    drained.onAny([=]() {
+      socket->recv(data, size)
+        .onAny(lambda::bind(
+            &decode_recv,
+            lambda::_1,
+            data,
+            size,
+            socket,
+            decoder));
+    });
+    return;
+  }
+
   socket->recv(data, size)
     .onAny(lambda::bind(&decode_recv, lambda::_1, data, size, socket, decoder));
 }
@@ -1124,6 +1106,62 @@ void HttpProxy::waited(const Future<Response>& future)
 }
 
 
+// Parses the 'Range' header of a request for a file of 'size' bytes
+// (see RFC 7233) into the offset and length of the range. Returns
+// None if the header is ignored (e.g., it is malformed or asks for
+// multiple ranges, which we do not support) and an Error if the range
+// can not be satisfied.
+static Result<pair<size_t, size_t>> range(const string& header, size_t size)
+{
+  if (!strings::startsWith(header, "bytes=")) {
+    return None();
+  }
+
+  const string spec = strings::trim(header.substr(strlen("bytes=")));
+
+  const size_t dash = spec.find('-');
+  if (dash == string::npos || spec.find(',') != string::npos) {
+    return None();
+  }
+
+  const string first = strings::trim(spec.substr(0, dash));
+  const string last = strings::trim(spec.substr(dash + 1));
+
+  if (first.empty()) {
+    // A suffix range, i.e., the last bytes of the file.
+    Try<size_t> suffix = numify<size_t>(last);
+    if (suffix.isError()) {
+      return None();
+    } else if (suffix.get() == 0 || size == 0) {
+      return Error("Empty suffix range");
+    }
+
+    const size_t length = std::min(suffix.get(), size);
+    return std::make_pair(size - length, length);
+  }
+
+  Try<size_t> start = numify<size_t>(first);
+  if (start.isError()) {
+    return None();
+  } else if (start.get() >= size) {
+    return Error("Range starts beyond the end of the file");
+  }
+
+  size_t end = size - 1;
+
+  if (!last.empty()) {
+    Try<size_t> _end = numify<size_t>(last);
+    if (_end.isError() || _end.get() < start.get()) {
+      return None();
+    }
+
+    end = std::min(_end.get(), end);
+  }
+
+  return std::make_pair(start.get(), end - start.get() + 1);
+}
+
+
 bool HttpProxy::process(const Future<Response>& future, const Request& request)
 {
   if (!future.isReady()) {
@@ -1162,18 +1200,63 @@ bool HttpProxy::process(const Future<Response>& future, const Request& request)
         VLOG(1) << "Returning '404 Not Found' for directory '" << path << "'";
         socket_manager->send(NotFound(), request, socket);
       } else {
+        const size_t size = s.st_size;
+
+        // Honor a range request if the whole file is being sent.
+        Option<string> header = request.headers.get("Range");
+        if (header.isSome() &&
+            response.code == http::Status::OK &&
+            response.offset == 0 &&
+            response.length.isNone()) {
+          Result<pair<size_t, size_t>> requested = range(header.get(), size);
+
+          if (requested.isError()) {
+            VLOG(1) << "Returning '416 Requested range not satisfiable' for"
+                    << " path '" << path << "': " << requested.error();
+
+            os::close(fd);
+
+            Response unsatisfiable(
+                http::Status::REQUESTED_RANGE_NOT_SATISFIABLE);
+            unsatisfiable.headers["Content-Range"] =
+              "bytes */" + stringify(size);
+
+            socket_manager->send(unsatisfiable, request, socket);
+            return true; // All done, can process next request.
+          }
+
+          if (requested.isSome()) {
+            response.code = http::Status::PARTIAL_CONTENT;
+            response.status = http::Status::string(response.code);
+            response.offset = requested.get().first;
+            response.length = requested.get().second;
+          }
+        }
+
+        const size_t offset = std::min(response.offset, size);
+        const size_t length = std::min(
+            response.length.getOrElse(size - offset),
+            size - offset);
+
         // While the user is expected to properly set a 'Content-Type'
         // header, we fill in (or overwrite) 'Content-Length' header.
-        stringstream out;
-        out << s.st_size;
-        response.headers["Content-Length"] = out.str();
+        response.headers["Content-Length"] = stringify(length);
+        response.headers["Accept-Ranges"] = "bytes";
+
+        if (response.code == http::Status::PARTIAL_CONTENT) {
+          response.headers["Content-Range"] = length == 0
+            ? "bytes */" + stringify(size)
+            : "bytes " + stringify(offset) + "-" +
+              stringify(offset + length - 1) + "/" + stringify(size);
+        }
 
-        if (s.st_size == 0) {
+        if (length == 0) {
+          os::close(fd);
           socket_manager->send(response, request, socket);
           return true; // All done, can process next request.
         }
 
-        VLOG(1) << "Sending file at '" << path << "' with length " << s.st_size;
+        VLOG(1) << "Sending file at '" << path << "' with length " << length;
 
         // TODO(benh): Consider a way to have the socket manager turn
         // on TCP_CORK for both sends and then turn it off.
@@ -1183,7 +1266,7 @@ bool HttpProxy::process(const Future<Response>& future, const Request& request)
 
         // Note the file descriptor gets closed by FileEncoder.
         socket_manager->send(
-            new FileEncoder(socket, fd, s.st_size),
+            new FileEncoder(socket, fd, offset, length, response.limiter),
             request.keepAlive);
       }
     }
@@ -1538,10 +1621,54 @@ void send(Encoder* encoder, Socket* socket)
       break;
     }
     case Encoder::FILE: {
+      FileEncoder* file = reinterpret_cast<FileEncoder*>(encoder);
       off_t offset;
       size_t size;
-      int fd = reinterpret_cast<FileEncoder*>(encoder)->next(&offset, &size);
-      socket->sendfile(fd, offset, size)
+      int fd = file->next(&offset, &size);
+
+      Future<size_t> sent;
+
+      if (file->limiter) {
+        // Wait for a permit per byte before sending the next chunk.
+        // The bytes that a partial send left unsent have already been
+        // paid for, so only the rest of the chunk needs permits (see
+        // 'FileEncoder::permits').
+        CHECK_LE(file->permits, size);
+
+        const Socket s = *socket;
+
+        Future<Nothing> acquired = Nothing();
+        if (size > file->permits) {
+          acquired = file->limiter->acquire(size - file->permits);
+        }
+
+        sent = acquired
+          .then([s, fd, offset, size]() {
+            return s.sendfile(fd, offset, size);
+          })
+          .then([file, size](size_t length) {
+            file->permits = size - length;
+            return length;
+          });
+      } else {
+        sent = socket->sendfile(fd, offset, size);
+      }
+
+      sent
+        .onAny(lambda::bind(
+            &internal::_send,
+            lambda::_1,
+            socket,
+            encoder,
+            size));
+      break;
+    }
+    case Encoder::IOVEC: {
+      int count;
+      size_t size;
+      const struct iovec* iov =
+        reinterpret_cast<IovecEncoder*>(encoder)->next(&count, &size);
+      socket->sendv(iov, count)
         .onAny(lambda::bind(
             &internal::_send,
             lambda::_1,
@@ -1832,6 +1959,32 @@ Encoder* SocketManager::next(int s)
         // More messages!
         Encoder* encoder = outgoing[s].front();
         outgoing[s].pop();
+
+        // Coalesce consecutive messages so that they get sent with a
+        // single write, as long as they fit in one.
+        if (encoder->kind() == Encoder::IOVEC &&
+            !outgoing[s].empty() &&
+            outgoing[s].front()->kind() == Encoder::IOVEC) {
+          BatchEncoder* batch = new BatchEncoder(encoder->socket());
+          batch->add(reinterpret_cast<IovecEncoder*>(encoder));
+
+          while (!outgoing[s].empty() &&
+                 outgoing[s].front()->kind() == Encoder::IOVEC) {
+            IovecEncoder* next =
+              reinterpret_cast<IovecEncoder*>(outgoing[s].front());
+
+            const size_t count = batch->count() + next->count();
+            if (count > static_cast<size_t>(IOV_MAX)) {
+              break;
+            }
+
+            batch->add(next);
+            outgoing[s].pop();
+          }
+
+          return batch;
+        }
+
         return encoder;
       } else {
         // No more messages ... erase the outgoing queue.
@@ -2141,6 +2294,7 @@ void SocketManager::swap_implementing_socket(const Socket& from, Socket* to)
 ProcessManager::ProcessManager(const Option<string>& _delegate)
   : delegate(_delegate)
 {
+  next_runq.store(0);
   running.store(0);
 }
 
@@ -2174,6 +2328,10 @@ ProcessManager::~ProcessManager()
     thread->join();
     delete thread;
   }
+
+  foreach (RunQueue* runq, runqs) {
+    delete runq;
+  }
 }
 
 
@@ -2193,18 +2351,33 @@ long ProcessManager::init_threads()
   long cpus = std::max(8L, sysconf(_SC_NPROCESSORS_ONLN));
   threads.reserve(cpus+1);
 
+  // Create a run queue for each processing thread. This must be done
+  // before any thread is started since threads steal from each
+  // other's run queues.
+  runqs.reserve(cpus);
+  for (long i = 0; i < cpus; i++) {
+    runqs.push_back(new RunQueue());
+  }
+
   // Create processing threads.
   for (long i = 0; i < cpus; i++) {
     // Retain the thread handles so that we can join when shutting down.
     threads.emplace_back(
         // We pass a constant reference to `joining` to make it clear that this
         // value is only being tested (read), and not manipulated.
-        new std::thread(std::bind([](const std::atomic_bool& joining) {
+        new std::thread(std::bind([](long worker,
+                                     const std::atomic_bool& joining) {
+          __worker__ = worker;
+
+          // Processing threads allocate and free most events, so let
+          // them cache pooled blocks (see 'pool.hpp').
+          pool::cache();
+
           do {
-            ProcessBase* process = process_manager->dequeue();
+            ProcessBase* process = process_manager->dequeue(worker);
             if (process == NULL) {
               Gate::state_t old = gate->approach();
-              process = process_manager->dequeue();
+              process = process_manager->dequeue(worker);
               if (process == NULL) {
                 if (joining.load()) {
                   break;
@@ -2218,11 +2391,17 @@ long ProcessManager::init_threads()
             process_manager->resume(process);
           } while (true);
         },
+        i,
         std::cref(joining_threads))));
   }
 
-  // Create a thread for the event loop.
-  threads.emplace_back(new std::thread(&EventLoop::run));
+  // Create a thread for the event loop. The event loop thread
+  // allocates the events for all messages received over sockets, so
+  // it also caches pooled blocks.
+  threads.emplace_back(new std::thread([]() {
+    pool::cache();
+    EventLoop::run();
+  }));
 
   return cpus;
 }
@@ -2245,6 +2424,18 @@ ProcessReference ProcessManager::use(const UPID& pid)
 }
 
 
+// Deletes an HTTP request that is not delivered to a process. Drops
+// the body of a streamed request, so that the connection proceeds.
+static void dispose(Request* request)
+{
+  if (request->reader.isSome()) {
+    request->reader->close();
+  }
+
+  delete request;
+}
+
+
 void ProcessManager::handle(
     const Socket& socket,
     Request* request)
@@ -2253,9 +2444,13 @@ void ProcessManager::handle(
 
   // Check if this is a libprocess request (i.e., 'User-Agent:
   // libprocess/id@ip:port') and if so, parse as a message.
-  if (libprocess(request)) {
-    Message* message = parse(request);
+  if (libprocess(*request)) {
+    Message* message = parse(*request);
     if (message != NULL) {
+      // The request is not used for anything but the response (if
+      // any) so we can take its body rather than copy it.
+      message->body.swap(request->body);
+
       // TODO(benh): Use the sender PID when delivering in order to
       // capture happens-before timing relationships for testing.
       bool accepted = deliver(message->to, new MessageEvent(message));
@@ -2306,7 +2501,7 @@ void ProcessManager::handle(
     dispatch(proxy, &HttpProxy::enqueue, BadRequest(), *request);
 
     // Cleanup request.
-    delete request;
+    dispose(request);
     return;
   }
 
@@ -2323,7 +2518,7 @@ void ProcessManager::handle(
     dispatch(proxy, &HttpProxy::enqueue, NotFound(), *request);
 
     // Cleanup request.
-    delete request;
+    dispose(request);
     return;
   }
 
@@ -2376,7 +2571,7 @@ void ProcessManager::handle(
             *request);
 
         // Cleanup request.
-        delete request;
+        dispose(request);
         return;
       }
     }
@@ -2387,6 +2582,20 @@ void ProcessManager::handle(
     // into the HttpEvent created below.
     Promise<Response>* promise(new Promise<Response>());
 
+    // Drop whatever remains of a streamed request body once the
+    // response is ready, unless the response is streamed as well
+    // (the handler might still be reading the request body).
+    if (request->reader.isSome()) {
+      Pipe::Reader reader = request->reader.get();
+
+      promise->future()
+        .onAny([reader](const Future<Response>& response) mutable {
+          if (!response.isReady() || response->type != Response::PIPE) {
+            reader.close();
+          }
+        });
+    }
+
     PID<HttpProxy> proxy = socket_manager->proxy(socket);
 
     // Enqueue the response with the HttpProxy so that it respects the
@@ -2411,7 +2620,34 @@ void ProcessManager::handle(
   dispatch(proxy, &HttpProxy::enqueue, NotFound(), *request);
 
   // Cleanup request.
-  delete request;
+  dispose(request);
+}
+
+
+void ProcessManager::handle(const deque<Message*>& messages)
+{
+  // Messages commonly arrive in batches for the same process (e.g., a
+  // storm of status updates), so we only look up the receiver when it
+  // changes.
+  // TODO(benh): Use the sender PID when delivering in order to
+  // capture happens-before timing relationships for testing.
+  UPID to;
+  ProcessReference receiver;
+
+  foreach (Message* message, messages) {
+    if (message->to != to) {
+      to = message->to;
+      receiver = use(to);
+    }
+
+    if (receiver) {
+      deliver(receiver, new MessageEvent(message));
+    } else {
+      VLOG(1) << "Failed to handle libprocess message to " << to
+              << ": not found";
+      delete message;
+    }
+  }
 }
 
 
@@ -2491,6 +2727,14 @@ void ProcessManager::resume(ProcessBase* process)
 {
   __process__ = process;
 
+  // Remember which processing thread ran this process so that it gets
+  // enqueued back onto this thread's run queue (see 'enqueue'). A
+  // thread donated via 'wait' is not a processing thread, in which
+  // case we keep the previous affinity.
+  if (__worker__ >= 0) {
+    process->worker.store(__worker__, std::memory_order_relaxed);
+  }
+
   VLOG(2) << "Resuming " << process->pid << " at " << Clock::now();
 
   bool terminate = false;
@@ -2508,17 +2752,38 @@ void ProcessManager::resume(ProcessBase* process)
   while (!terminate && !blocked) {
     Event* event = NULL;
 
+    // NOTE: Producers push onto 'process->inbox' without acquiring
+    // 'process->mutex', so the lock here is normally uncontended. We
+    // only drain the inbox once 'process->events' is empty, which
+    // moves every event enqueued so far over in a single batch.
     synchronized (process->mutex) {
-      if (process->events.size() > 0) {
+      if (process->events.empty()) {
+        process->drain();
+      }
+
+      if (!process->events.empty()) {
         event = process->events.front();
         process->events.pop_front();
         process->state = ProcessBase::RUNNING;
       } else {
+        // We must set the state before blocking on the inbox since
+        // the producer that unblocks the inbox will set the state to
+        // READY when it schedules the process.
         process->state = ProcessBase::BLOCKED;
-        blocked = true;
+
+        if (process->inbox->block()) {
+          blocked = true;
+        } else {
+          process->state = ProcessBase::RUNNING;
+        }
       }
     }
 
+    // Events were pushed since we drained the inbox, try again.
+    if (!blocked && event == NULL) {
+      continue;
+    }
+
     if (!blocked) {
       CHECK(event != NULL);
 
@@ -2612,6 +2877,7 @@ void ProcessManager::cleanup(ProcessBase* process)
 
   synchronized (process->mutex) {
     process->state = ProcessBase::TERMINATING;
+    process->inbox->close(&process->events);
     events = process->events;
     process->events.clear();
   }
@@ -2766,24 +3032,22 @@ bool ProcessManager::wait(const UPID& pid)
       // Check if it is runnable in order to donate this thread.
       if (process->state == ProcessBase::BOTTOM ||
           process->state == ProcessBase::READY) {
-        synchronized (runq_mutex) {
-          list<ProcessBase*>::iterator it =
-            find(runq.begin(), runq.end(), process);
-          if (it != runq.end()) {
-            // Found it! Remove it from the run queue since we'll be
-            // donating our thread and also increment 'running' before
-            // leaving this 'runq' protected critical section so that
-            // everyone that is waiting for the processes to settle
-            // continue to wait (otherwise they could see nothing in
-            // 'runq' and 'running' equal to 0 between when we exit
-            // this critical section and increment 'running').
-            runq.erase(it);
-            running.fetch_add(1);
-          } else {
-            // Another thread has resumed the process ...
-            process = NULL;
+        // Look for the process on every run queue since it may have
+        // been enqueued on any of them. Note that we don't need to
+        // touch 'running' here since a process that was removed from
+        // a run queue is still accounted for until it is resumed.
+        bool found = false;
+        foreach (RunQueue* runq, runqs) {
+          if (runq->remove(process)) {
+            found = true;
+            break;
           }
         }
+
+        if (!found) {
+          // Another thread has resumed the process ...
+          process = NULL;
+        }
       } else {
         // Process is not runnable, so no need to donate ...
         process = NULL;
@@ -2869,41 +3133,62 @@ void ProcessManager::enqueue(ProcessBase* process)
     return;
   }
 
-  // TODO(benh): Check and see if this process has it's own thread. If
-  // it does, push it on that threads runq, and wake up that thread if
-  // it's not running. Otherwise, check and see which thread this
-  // process was last running on, and put it on that threads runq.
+  // NOTE: A process is only ever enqueued on the transition into the
+  // READY state (which happens while holding 'process->mutex'), so a
+  // process can never be on more than one run queue at a time.
 
-  synchronized (runq_mutex) {
-    CHECK(find(runq.begin(), runq.end(), process) == runq.end());
-    runq.push_back(process);
+  // Put the process on the run queue of the thread it was last
+  // running on, so that its state is likely still in that thread's
+  // cache. If it has never run, prefer the current processing thread
+  // (e.g., a process spawning another process) and otherwise spread
+  // processes across the run queues.
+  long worker = process->worker.load(std::memory_order_relaxed);
+
+  if (worker < 0) {
+    worker = __worker__ >= 0
+      ? __worker__
+      : next_runq.fetch_add(1) % static_cast<long>(runqs.size());
   }
 
-  // Wake up the processing thread if necessary.
-  gate->open();
+  // Increment 'running' before the process becomes visible on the
+  // run queue in order to support the Clock::settle() operation
+  // (see the comment on 'running').
+  running.fetch_add(1);
+
+  runqs[worker]->push(process);
+
+  // Wake up a processing thread if necessary. Any idle thread will
+  // steal the process if its own thread is busy, so there is no need
+  // to wake up every waiting thread.
+  gate->open(false);
 }
 
 
-ProcessBase* ProcessManager::dequeue()
+ProcessBase* ProcessManager::dequeue(long worker)
 {
-  // TODO(benh): Remove a process from this thread's runq. If there
-  // are no processes to run, and this is not a dedicated thread, then
-  // steal one from another threads runq.
+  CHECK_GE(worker, 0);
+  CHECK_LT(worker, static_cast<long>(runqs.size()));
 
-  ProcessBase* process = NULL;
+  // First try and run a process from this thread's own run queue.
+  ProcessBase* process = runqs[worker]->pop();
 
-  synchronized (runq_mutex) {
-    if (!runq.empty()) {
-      process = runq.front();
-      runq.pop_front();
-      // Increment the running count of processes in order to support
-      // the Clock::settle() operation (this must be done atomically
-      // with removing the process from the runq).
-      running.fetch_add(1);
+  if (process != NULL) {
+    return process;
+  }
+
+  // Otherwise try and steal a process from another thread's run
+  // queue, starting with the next thread so that thieves don't all
+  // gang up on the same queue.
+  const long size = static_cast<long>(runqs.size());
+
+  for (long i = 1; i < size; i++) {
+    process = runqs[(worker + i) % size]->steal();
+    if (process != NULL) {
+      return process;
     }
   }
 
-  return process;
+  return NULL;
 }
 
 
@@ -2927,21 +3212,16 @@ void ProcessManager::settle()
 
     done = true; // Assume to start that we are settled.
 
-    synchronized (runq_mutex) {
-      if (!runq.empty()) {
-        done = false;
-        continue;
-      }
-
-      if (running.load() > 0) {
-        done = false;
-        continue;
-      }
+    // NOTE: 'running' accounts for both enqueued and running
+    // processes so there is no need to inspect the run queues.
+    if (running.load() > 0) {
+      done = false;
+      continue;
+    }
 
-      if (!Clock::settled()) {
-        done = false;
-        continue;
-      }
+    if (!Clock::settled()) {
+      done = false;
+      continue;
     }
   } while (!done);
 }
@@ -3015,6 +3295,8 @@ Future<Response> ProcessManager::__processes__(const Request&)
       } visitor(&events);
 
       synchronized (process->mutex) {
+        process->drain();
+
         foreach (Event* event, process->events) {
           event->visit(&visitor);
         }
@@ -3037,6 +3319,12 @@ ProcessBase::ProcessBase(const string& id)
 
   refs = 0;
 
+  worker = -1;
+
+  timestamped = false;
+
+  inbox = new EventQueue();
+
   pid.id = id != "" ? id : ID::generate();
   pid.address = __address__;
 
@@ -3049,33 +3337,59 @@ ProcessBase::ProcessBase(const string& id)
 }
 
 
-ProcessBase::~ProcessBase() {}
+ProcessBase::~ProcessBase()
+{
+  delete inbox;
+}
 
 
 void ProcessBase::enqueue(Event* event, bool inject)
 {
   CHECK(event != NULL);
 
-  synchronized (mutex) {
-    if (state != TERMINATING && state != TERMINATED) {
-      if (!inject) {
-        events.push_back(event);
-      } else {
-        events.push_front(event);
-      }
+  if (timestamped.load(std::memory_order_relaxed)) {
+    event->enqueued = std::chrono::steady_clock::now();
+  }
 
-      if (state == BLOCKED) {
-        state = READY;
-        process_manager->enqueue(this);
-      }
+  bool wakeup = false;
 
-      CHECK(state == BOTTOM ||
-            state == READY ||
-            state == RUNNING);
-    } else {
+  if (!inject) {
+    // Push onto the lock-free inbox. This fails if the inbox has been
+    // closed because the process is terminating.
+    if (!inbox->push(event, &wakeup)) {
       delete event;
+      return;
+    }
+  } else {
+    // Injected events must go to the front of the queue, so they
+    // bypass the inbox. Holding 'mutex' here serializes us with the
+    // consumer deciding to block (see 'ProcessManager::resume') and
+    // with 'ProcessManager::cleanup'.
+    synchronized (mutex) {
+      if (state == TERMINATING || state == TERMINATED) {
+        delete event;
+        return;
+      }
+
+      events.push_front(event);
+
+      wakeup = inbox->unblock();
     }
   }
+
+  // If the process was blocked then we are the (only) thread
+  // responsible for scheduling it.
+  if (wakeup) {
+    CHECK(state == BLOCKED);
+    state = READY;
+    process_manager->enqueue(this);
+  }
+}
+
+
+void ProcessBase::drain()
+{
+  inbox->drain(&events);
 }
 
 
@@ -3127,7 +3441,7 @@ void ProcessBase::visit(const MessageEvent& event)
 
 void ProcessBase::visit(const DispatchEvent& event)
 {
-  (*event.f)(this);
+  event.f(this);
 }
 
 
@@ -3165,6 +3479,39 @@ void ProcessBase::visit(const HttpEvent& event)
     }
 
     HttpEndpoint endpoint = handlers.http[name];
+
+    // Deliver the request the way the route expects the body, which
+    // means buffering a streamed body for routes that don't stream.
+    Future<Request> request = *event.request;
+
+    if (endpoint.options.requestStreaming) {
+      if (event.request->type == Request::BODY) {
+        Pipe pipe;
+        Pipe::Writer writer = pipe.writer();
+        writer.write(event.request->body);
+        writer.close();
+
+        Request streamed = *event.request;
+        streamed.type = Request::PIPE;
+        streamed.body.clear();
+        streamed.reader = pipe.reader();
+
+        request = streamed;
+      }
+    } else if (event.request->type == Request::PIPE) {
+      CHECK_SOME(event.request->reader);
+
+      Request buffered = *event.request;
+
+      request = buffered.reader->readAll()
+        .then([buffered](const string& body) mutable -> Request {
+          buffered.type = Request::BODY;
+          buffered.body = body;
+          buffered.reader = None();
+          return buffered;
+        });
+    }
+
     Future<Option<AuthenticationResult>> authentication = None();
 
     if (endpoint.realm.isSome()) {
@@ -3172,23 +3519,26 @@ void ProcessBase::visit(const HttpEvent& event)
           *event.request, endpoint.realm.get());
     }
 
-    // Sequence the authentication future to ensure the handlers
-    // are invoked in the same order that requests arrive.
+    // Sequence the authentication future (along with the buffering of
+    // the body) to ensure the handlers are invoked in the same order
+    // that requests arrive.
     authentication = handlers.httpSequence->add<Option<AuthenticationResult>>(
-        [authentication]() { return authentication; });
+        [authentication, request]() {
+          return request.then([authentication]() { return authentication; });
+        });
 
-    Request request = *event.request;
+    const string path = event.request->url.path;
     Promise<Response>* response = new Promise<Response>();
     event.response->associate(response->future());
 
     authentication
-      .onAny(defer(self(), [endpoint, request, response](
+      .onAny(defer(self(), [endpoint, path, request, response](
           const Future<Option<AuthenticationResult>>& authentication) {
         if (!authentication.isReady()) {
           response->set(InternalServerError());
 
           VLOG(1) << "Returning '" << response->future()->status << "'"
-                  << " for '" << request.url.path << "'"
+                  << " for '" << path << "'"
                   << " (authentication failed: "
                   << (authentication.isFailed()
                       ? authentication.failure()
@@ -3202,10 +3552,10 @@ void ProcessBase::visit(const HttpEvent& event)
           // Request didn't need authentication or authentication
           // is not applicable, just forward the request.
           if (endpoint.realm.isNone()) {
-            response->associate(endpoint.handler.get()(request));
+            response->associate(endpoint.handler.get()(request.get()));
           } else {
             response->associate(endpoint.authenticatedHandler.get()(
-                request, None()));
+                request.get(), None()));
           }
 
           delete response;
@@ -3222,7 +3572,7 @@ void ProcessBase::visit(const HttpEvent& event)
           Option<string> principal = authentication.get()->principal;
 
           response->associate(endpoint.authenticatedHandler.get()(
-              request, principal));
+              request.get(), principal));
         }
 
         delete response;
@@ -3295,13 +3645,15 @@ UPID ProcessBase::link(const UPID& to)
 void ProcessBase::route(
     const string& name,
     const Option<string>& help_,
-    const HttpRequestHandler& handler)
+    const HttpRequestHandler& handler,
+    const RouteOptions& options)
 {
   // Routes must start with '/'.
   CHECK(name.find('/') == 0);
 
   HttpEndpoint endpoint;
   endpoint.handler = handler;
+  endpoint.options = options;
 
   handlers.http[name.substr(1)] = endpoint;
 
@@ -3313,7 +3665,8 @@ void ProcessBase::route(
     const string& name,
     const string& realm,
     const Option<string>& help_,
-    const AuthenticatedHttpRequestHandler& handler)
+    const AuthenticatedHttpRequestHandler& handler,
+    const RouteOptions& options)
 {
   // Routes must start with '/'.
   CHECK(name.find('/') == 0);
@@ -3321,6 +3674,7 @@ void ProcessBase::route(
   HttpEndpoint endpoint;
   endpoint.realm = realm;
   endpoint.authenticatedHandler = handler;
+  endpoint.options = options;
 
   handlers.http[name.substr(1)] = endpoint;
 
@@ -3477,12 +3831,14 @@ namespace internal {
 
 void dispatch(
     const UPID& pid,
-    const std::shared_ptr<lambda::function<void(ProcessBase*)>>& f,
-    const Option<const std::type_info*>& functionType)
+    DispatchFunction&& f,
+    const Option<const std::type_info*>& functionType,
+    const Option<MethodId>& method)
 {
   process::initialize();
 
-  DispatchEvent* event = new DispatchEvent(pid, f, functionType);
+  DispatchEvent* event =
+    new DispatchEvent(pid, std::move(f), functionType, method);
   process_manager->deliver(pid, event, __process__);
 }
 
@@ -0,0 +1,132 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __RUN_QUEUE_HPP__
+#define __RUN_QUEUE_HPP__
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
+
+#include <process/process.hpp>
+
+#include <stout/synchronized.hpp>
+
+namespace process {
+
+// Queue of runnable processes owned by a single processing thread.
+//
+// The owning thread takes processes from the front of the queue while
+// idle threads steal from the back, so the owner and a thief only
+// contend when the queue is nearly empty. Any thread may push onto
+// any queue (e.g., the event loop thread delivering a message), but
+// since every processing thread has its own queue that contention is
+// spread across threads rather than funnelled through a single lock.
+//
+// NOTE: The queue is guarded by a mutex rather than being lock-free,
+// since any thread may push onto it, not only its owner.
+class RunQueue
+{
+public:
+  RunQueue() : size_(0) {}
+
+  void push(ProcessBase* process)
+  {
+    synchronized (mutex) {
+      processes.push_back(process);
+      size_.fetch_add(1);
+    }
+  }
+
+  // Removes and returns the process at the front of the queue, or
+  // NULL if the queue is empty. Only called by the owning thread.
+  ProcessBase* pop()
+  {
+    // Avoid taking the lock when there is obviously nothing to do.
+    if (size_.load() == 0) {
+      return NULL;
+    }
+
+    synchronized (mutex) {
+      if (!processes.empty()) {
+        ProcessBase* process = processes.front();
+        processes.pop_front();
+        size_.fetch_sub(1);
+        return process;
+      }
+    }
+
+    return NULL;
+  }
+
+  // Removes and returns the process at the back of the queue, or
+  // NULL if the queue is empty. Called by non-owning threads.
+  ProcessBase* steal()
+  {
+    if (size_.load() == 0) {
+      return NULL;
+    }
+
+    synchronized (mutex) {
+      if (!processes.empty()) {
+        ProcessBase* process = processes.back();
+        processes.pop_back();
+        size_.fetch_sub(1);
+        return process;
+      }
+    }
+
+    return NULL;
+  }
+
+  // Removes the specified process from the queue, returning true if
+  // the process was found.
+  bool remove(ProcessBase* process)
+  {
+    if (size_.load() == 0) {
+      return false;
+    }
+
+    synchronized (mutex) {
+      std::deque<ProcessBase*>::iterator it =
+        std::find(processes.begin(), processes.end(), process);
+
+      if (it != processes.end()) {
+        processes.erase(it);
+        size_.fetch_sub(1);
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  // NOTE: This is only a snapshot and may be stale by the time the
+  // caller looks at it.
+  size_t size() const
+  {
+    return size_.load();
+  }
+
+private:
+  std::deque<ProcessBase*> processes;
+  std::mutex mutex;
+
+  // Mirrors 'processes.size()' so that it can be read without
+  // acquiring the lock.
+  std::atomic_size_t size_;
+};
+
+} // namespace process {
+
+#endif // __RUN_QUEUE_HPP__
@@ -244,5 +244,15 @@ Future<Nothing> Socket::Impl::send(const string& _data)
 }
 
 
+Future<size_t> Socket::Impl::sendv(const struct iovec* iov, int iovcnt)
+{
+  CHECK_GT(iovcnt, 0);
+
+  // Callers handle partial sends, so sending only the first buffer is
+  // correct, if not as efficient as a scatter/gather write.
+  return send(static_cast<const char*>(iov[0].iov_base), iov[0].iov_len);
+}
+
+
 } // namespace network {
 } // namespace process {
@@ -18,30 +18,42 @@
 
 #include <gmock/gmock.h>
 
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include <process/clock.hpp>
 #include <process/collect.hpp>
+#include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
 #include <process/owned.hpp>
 #include <process/process.hpp>
+#include <process/timer.hpp>
 
 #include <stout/duration.hpp>
 #include <stout/gtest.hpp>
 #include <stout/hashset.hpp>
 #include <stout/stopwatch.hpp>
 
+#include "pool.hpp"
+
 namespace http = process::http;
 
+using process::Clock;
 using process::Future;
 using process::Owned;
 using process::Process;
 using process::ProcessBase;
 using process::Promise;
+using process::Timer;
 using process::UPID;
 
 using std::cout;
@@ -293,6 +305,299 @@ TEST(ProcessTest, Process_BENCHMARK_ClientServer)
 }
 
 
+// Launches an increasing number of independent client / server pairs
+// and measures the aggregate throughput. Since the pairs don't share
+// any processes, throughput should scale with the number of cores
+// rather than being bounded by contention on the run queues.
+TEST(ProcessTest, Process_BENCHMARK_ThroughputScaling)
+{
+  const size_t numRequests = 50000;
+  const size_t concurrency = 250;
+  const Bytes messageSize = Bytes(3);
+
+  const long cpus = std::max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+
+  for (long numPairs = 1; numPairs <= cpus; numPairs *= 2) {
+    vector<Owned<ServerProcess>> servers;
+    vector<Owned<ClientProcess>> clients;
+
+    for (long i = 0; i < numPairs; i++) {
+      servers.push_back(Owned<ServerProcess>(new ServerProcess()));
+      spawn(servers.back().get());
+
+      clients.push_back(Owned<ClientProcess>(new ClientProcess()));
+      spawn(clients.back().get());
+    }
+
+    Stopwatch watch;
+    watch.start();
+
+    // Start the ping / pongs, each client playing against its own server.
+    list<Future<http::Response>> futures;
+    for (long i = 0; i < numPairs; i++) {
+      const string query = strings::join(
+          "&",
+          "server=" + stringify(servers[i]->self()),
+          "requests=" + stringify(numRequests),
+          "concurrency=" + stringify(concurrency),
+          "messageSize=" + stringify(messageSize));
+
+      futures.push_back(http::get(clients[i]->self(), "run", query));
+    }
+
+    Future<list<http::Response>> responses = collect(futures);
+    AWAIT_READY(responses);
+
+    Duration elapsed = watch.elapsed();
+
+    foreach (const http::Response& response, responses.get()) {
+      ASSERT_EQ(http::Status::OK, response.code);
+    }
+
+    // Each request is a 'ping' and a 'pong' message.
+    double throughput = (2 * numRequests * numPairs) / elapsed.secs();
+
+    cout << numPairs << " pairs: " << throughput << " messages / sec" << endl;
+
+    foreach (const Owned<ClientProcess>& client, clients) {
+      terminate(*client);
+      wait(*client);
+    }
+
+    foreach (const Owned<ServerProcess>& server, servers) {
+      terminate(*server);
+      wait(*server);
+    }
+  }
+}
+
+
+// A process that counts the dispatches it receives and completes a
+// promise once it has received the expected number.
+class CounterProcess : public Process<CounterProcess>
+{
+public:
+  explicit CounterProcess(size_t _expected)
+    : expected(_expected), count(0) {}
+
+  Future<Nothing> done()
+  {
+    return promise.future();
+  }
+
+  void increment()
+  {
+    if (++count == expected) {
+      promise.set(Nothing());
+    }
+  }
+
+private:
+  const size_t expected;
+  size_t count;
+  Promise<Nothing> promise;
+};
+
+
+// Measures the throughput of many threads concurrently enqueueing
+// events on the mailbox of a single process, as happens with the
+// master and allocator processes.
+TEST(ProcessTest, Process_BENCHMARK_MailboxContention)
+{
+  const size_t numEvents = 1000000;
+  const vector<size_t> numProducers = {1, 2, 4, 8, 16};
+
+  foreach (size_t producers, numProducers) {
+    const size_t eventsPerProducer = numEvents / producers;
+
+    CounterProcess counter(eventsPerProducer * producers);
+    const process::PID<CounterProcess> pid = spawn(&counter);
+
+    Stopwatch watch;
+    watch.start();
+
+    vector<std::thread> threads;
+    for (size_t i = 0; i < producers; i++) {
+      threads.emplace_back([=]() {
+        for (size_t j = 0; j < eventsPerProducer; j++) {
+          process::dispatch(pid, &CounterProcess::increment);
+        }
+      });
+    }
+
+    foreach (std::thread& thread, threads) {
+      thread.join();
+    }
+
+    AWAIT_READY(counter.done());
+
+    Duration elapsed = watch.elapsed();
+
+    cout << producers << " producers: "
+         << (eventsPerProducer * producers) / elapsed.secs()
+         << " events / sec" << endl;
+
+    terminate(counter);
+    wait(counter);
+  }
+}
+
+
+// A process that bounces a "ball" back and forth with a peer via
+// dispatch, completing a promise once the ball has been bounced the
+// requested number of times.
+class BouncerProcess : public Process<BouncerProcess>
+{
+public:
+  void setPeer(const process::PID<BouncerProcess>& _peer)
+  {
+    peer = _peer;
+  }
+
+  Future<Nothing> start(size_t bounces)
+  {
+    promise.reset(new Promise<Nothing>());
+    process::dispatch(peer, &BouncerProcess::bounce, bounces, self());
+    return promise->future();
+  }
+
+  void bounce(size_t remaining, const process::PID<BouncerProcess>& owner)
+  {
+    if (remaining == 0) {
+      process::dispatch(owner, &BouncerProcess::done);
+    } else {
+      process::dispatch(peer, &BouncerProcess::bounce, remaining - 1, owner);
+    }
+  }
+
+  void done()
+  {
+    promise->set(Nothing());
+  }
+
+private:
+  process::PID<BouncerProcess> peer;
+  Owned<Promise<Nothing>> promise;
+};
+
+
+// Measures the number of events allocated from the heap per dispatch
+// between two local processes once libprocess has warmed up. Event
+// pooling should keep this close to zero.
+TEST(ProcessTest, Process_BENCHMARK_DispatchAllocations)
+{
+  const size_t numBounces = 1000000;
+
+  BouncerProcess first;
+  BouncerProcess second;
+
+  spawn(first);
+  spawn(second);
+
+  dispatch(first, &BouncerProcess::setPeer, second.self());
+  dispatch(second, &BouncerProcess::setPeer, first.self());
+
+  // Warm up the per-thread pools.
+  AWAIT_READY(dispatch(first, &BouncerProcess::start, numBounces / 10));
+
+  const size_t before = process::pool::misses();
+
+  Stopwatch watch;
+  watch.start();
+
+  AWAIT_READY(dispatch(first, &BouncerProcess::start, numBounces));
+
+  Duration elapsed = watch.elapsed();
+
+  const size_t count = process::pool::misses() - before;
+
+  cout << "Dispatches: " << numBounces << endl
+       << "Elapsed: " << elapsed << endl
+       << "Heap allocated events: " << count << " ("
+       << static_cast<double>(count) / numBounces << " per dispatch)"
+       << endl;
+
+  terminate(first);
+  wait(first);
+
+  terminate(second);
+  wait(second);
+}
+
+
+// Schedules and cancels a large number of timers with timeouts spread
+// over an hour (starting a minute out so that none expire while being
+// scheduled), as is the case for offer and filter timeouts in the
+// master, and then measures how fast the same number of timers expire
+// when the (paused) clock is advanced past all of them.
+TEST(ProcessTest, Process_BENCHMARK_Timers)
+{
+  const size_t numTimers = 2000000;
+
+  // Timers are scheduled on the event loop, which (unlike spawning a
+  // process) 'Clock::timer' does not initialize.
+  process::initialize();
+
+  vector<Duration> durations;
+  durations.reserve(numTimers);
+
+  for (size_t i = 0; i < numTimers; i++) {
+    durations.push_back(Minutes(1) + Milliseconds(rand() % 3600000));
+  }
+
+  vector<Timer> timers;
+  timers.reserve(numTimers);
+
+  Stopwatch watch;
+  watch.start();
+
+  foreach (const Duration& duration, durations) {
+    timers.push_back(Clock::timer(duration, []() {}));
+  }
+
+  cout << "Scheduled " << numTimers << " timers in "
+       << watch.elapsed() << endl;
+
+  std::random_shuffle(timers.begin(), timers.end());
+
+  watch.start();
+
+  size_t canceled = 0;
+  foreach (const Timer& timer, timers) {
+    if (Clock::cancel(timer)) {
+      canceled++;
+    }
+  }
+
+  cout << "Canceled " << canceled << " timers in "
+       << watch.elapsed() << endl;
+
+  EXPECT_EQ(numTimers, canceled);
+
+  timers.clear();
+
+  Clock::pause();
+
+  std::atomic_size_t expired(0);
+
+  foreach (const Duration& duration, durations) {
+    Clock::timer(duration, [&expired]() { expired.fetch_add(1); });
+  }
+
+  watch.start();
+
+  Clock::advance(Hours(2));
+  Clock::settle();
+
+  cout << "Expired " << expired.load() << " timers in "
+       << watch.elapsed() << endl;
+
+  EXPECT_EQ(numTimers, expired.load());
+
+  Clock::resume();
+}
+
+
 class LinkerProcess : public Process<LinkerProcess>
 {
 public:
@@ -20,13 +20,17 @@
 #include <stout/gtest.hpp>
 
 #include "decoder.hpp"
+#include "encoder.hpp"
 
 namespace http = process::http;
 
 using process::DataDecoder;
 using process::Future;
+using process::Message;
+using process::MessageEncoder;
 using process::ResponseDecoder;
 using process::StreamingResponseDecoder;
+using process::UPID;
 
 using process::network::Socket;
 
@@ -71,6 +75,112 @@ TEST(DecoderTest, Request)
 }
 
 
+TEST(DecoderTest, StreamingRequest)
+{
+  Try<Socket> socket = Socket::create();
+  ASSERT_SOME(socket);
+  DataDecoder decoder = DataDecoder(socket.get());
+
+  const string headers =
+    "POST /path HTTP/1.1\r\n"
+    "Host: localhost\r\n"
+    "Content-Length: 4\r\n"
+    "\r\n";
+
+  // The request is decoded once its headers are complete.
+  deque<http::Request*> requests =
+    decoder.decode(headers.data(), headers.length());
+
+  ASSERT_FALSE(decoder.failed());
+  ASSERT_EQ(1, requests.size());
+
+  http::Request* request = requests[0];
+  EXPECT_EQ("POST", request->method);
+  EXPECT_EQ("/path", request->url.path);
+  EXPECT_TRUE(request->body.empty());
+
+  ASSERT_EQ(http::Request::PIPE, request->type);
+  ASSERT_SOME(request->reader);
+
+  http::Pipe::Reader reader = request->reader.get();
+  Future<string> read = reader.readAll();
+  EXPECT_TRUE(read.isPending());
+
+  const string body = "body";
+  requests = decoder.decode(body.data(), body.length());
+  ASSERT_FALSE(decoder.failed());
+  EXPECT_TRUE(requests.empty());
+
+  EXPECT_TRUE(read.isReady());
+  EXPECT_EQ("body", read.get());
+  EXPECT_TRUE(decoder.drained().isReady());
+
+  delete request;
+}
+
+
+TEST(DecoderTest, Messages)
+{
+  Try<Socket> socket = Socket::create();
+  ASSERT_SOME(socket);
+  DataDecoder decoder = DataDecoder(socket.get());
+
+  Message message;
+  message.name = "name";
+  message.from = UPID("from", process::address());
+  message.to = UPID("to", process::address());
+  message.body = "body";
+
+  const string request =
+    "GET /path HTTP/1.1\r\n"
+    "Host: localhost\r\n"
+    "\r\n";
+
+  // Libprocess messages are decoded into messages, while other requests
+  // are still decoded into HTTP requests.
+  const string encoded = MessageEncoder::encode(&message);
+  const string data = encoded + request + encoded;
+
+  // Split the data within the headers and the body of the first
+  // message to exercise decoding a message across calls.
+  // NOTE: We don't split the URL since the decoder expects it whole.
+  const size_t split1 = encoded.find("\r\n") + 5;
+  const size_t split2 = encoded.find(message.body) + 2;
+
+  deque<Message*> messages;
+
+  deque<http::Request*> requests =
+    decoder.decode(data.data(), split1, &messages);
+
+  EXPECT_TRUE(requests.empty());
+  EXPECT_TRUE(messages.empty());
+
+  requests = decoder.decode(data.data() + split1, split2 - split1, &messages);
+
+  EXPECT_TRUE(requests.empty());
+  EXPECT_TRUE(messages.empty());
+
+  requests = decoder.decode(
+      data.data() + split2, data.size() - split2, &messages);
+
+  ASSERT_FALSE(decoder.failed());
+
+  ASSERT_EQ(1u, requests.size());
+  EXPECT_EQ("/path", requests[0]->url.path);
+  delete requests[0];
+
+  ASSERT_EQ(2u, messages.size());
+
+  foreach (Message* decoded, messages) {
+    EXPECT_EQ(message.name, decoded->name);
+    EXPECT_EQ(message.from, decoded->from);
+    EXPECT_EQ(message.to, decoded->to);
+    EXPECT_EQ(message.body, decoded->body);
+    delete decoded;
+  }
+}
+
+
 TEST(DecoderTest, RequestHeaderContinuation)
 {
   Try<Socket> socket = Socket::create();
@@ -12,6 +12,7 @@
 
 #include <gmock/gmock.h>
 
+#include <algorithm>
 #include <deque>
 #include <string>
 #include <vector>
@@ -26,8 +27,14 @@
 
 namespace http = process::http;
 
+using process::BatchEncoder;
 using process::HttpResponseEncoder;
+using process::Message;
+using process::MessageEncoder;
 using process::ResponseDecoder;
+using process::UPID;
+
+using process::network::Socket;
 
 using std::deque;
 using std::string;
@@ -63,6 +70,56 @@ TEST(EncoderTest, Response)
 }
 
 
+TEST(EncoderTest, Messages)
+{
+  Try<Socket> socket = Socket::create();
+  ASSERT_SOME(socket);
+
+  string expected;
+
+  BatchEncoder batch(socket.get());
+
+  for (int i = 0; i < 3; i++) {
+    Message* message = new Message();
+    message->name = "message";
+    message->from = UPID("from", process::address());
+    message->to = UPID("to", process::address());
+
+    // Include a message without a body.
+    message->body = i == 1 ? "" : string(1000 * (i + 1), 'a' + i);
+
+    expected += MessageEncoder::encode(message);
+
+    batch.add(new MessageEncoder(socket.get(), message));
+  }
+
+  EXPECT_EQ(expected.size(), batch.remaining());
+
+  // Gather the data while only "sending" part of it at a time.
+  string encoded;
+
+  while (batch.remaining() > 0) {
+    int count;
+    size_t length;
+    const struct iovec* iov = batch.next(&count, &length);
+
+    ASSERT_GT(count, 0);
+
+    size_t sent = std::min<size_t>(length, 777);
+
+    for (int i = 0; i < count && sent > 0; i++) {
+      const size_t size = std::min(sent, iov[i].iov_len);
+      encoded.append(static_cast<const char*>(iov[i].iov_base), size);
+      sent -= size;
+    }
+
+    batch.backup(length - std::min<size_t>(length, 777));
+  }
+
+  EXPECT_EQ(expected, encoded);
+}
+
+
 TEST(EncoderTest, AcceptableEncodings)
 {
   // Create requests that do not accept gzip encoding.
@@ -28,6 +28,7 @@
 #include <process/http.hpp>
 #include <process/id.hpp>
 #include <process/io.hpp>
+#include <process/limiter.hpp>
 #include <process/owned.hpp>
 #include <process/socket.hpp>
 
@@ -54,6 +55,7 @@ using process::Owned;
 using process::PID;
 using process::Process;
 using process::Promise;
+using process::RateLimiter;
 
 using process::http::URL;
 
@@ -82,6 +84,7 @@ public:
   MOCK_METHOD1(requestDelete, Future<http::Response>(const http::Request&));
   MOCK_METHOD1(a, Future<http::Response>(const http::Request&));
   MOCK_METHOD1(abc, Future<http::Response>(const http::Request&));
+  MOCK_METHOD1(stream, Future<http::Response>(const http::Request&));
 
   MOCK_METHOD2(
       authenticated,
@@ -98,6 +101,11 @@ protected:
     route("/delete", None(), &HttpProcess::requestDelete);
     route("/a", None(), &HttpProcess::a);
     route("/a/b/c", None(), &HttpProcess::abc);
+
+    RouteOptions options;
+    options.requestStreaming = true;
+
+    route("/stream", None(), &HttpProcess::stream, options);
     route("/authenticated", "realm", None(), &HttpProcess::authenticated);
   }
 };
@@ -347,6 +355,48 @@ TEST(HTTPTest, PipeEOF)
 }
 
 
+TEST(HTTPTest, PipeDrained)
+{
+  http::Pipe pipe;
+  http::Pipe::Reader reader = pipe.reader();
+  http::Pipe::Writer writer = pipe.writer();
+
+  // Nothing has been written yet.
+  AWAIT_READY(writer.drained());
+
+  EXPECT_TRUE(writer.write("hello"));
+  EXPECT_TRUE(writer.write("world"));
+
+  Future<Nothing> drained = writer.drained();
+  Future<Nothing> halfDrained = writer.drained(5);
+
+  EXPECT_TRUE(drained.isPending());
+  EXPECT_TRUE(halfDrained.isPending());
+  AWAIT_READY(writer.drained(10));
+
+  AWAIT_EQ("hello", reader.read());
+  EXPECT_TRUE(drained.isPending());
+  AWAIT_READY(halfDrained);
+
+  AWAIT_EQ("world", reader.read());
+  AWAIT_READY(drained);
+
+  // Data written straight to a pending read is never unread.
+  Future<string> read = reader.read();
+  EXPECT_TRUE(writer.write("!"));
+  AWAIT_EQ("!", read);
+  AWAIT_READY(writer.drained());
+
+  // Closing the read end drops the unread data.
+  EXPECT_TRUE(writer.write("!"));
+  drained = writer.drained();
+  EXPECT_TRUE(drained.isPending());
+
+  EXPECT_TRUE(reader.close());
+  AWAIT_READY(drained);
+}
+
+
 TEST(HTTPTest, PipeFailure)
 {
   http::Pipe pipe;
@@ -535,6 +585,110 @@ TEST(HTTPTest, Get)
 }
 
 
+// Tests sending (parts of) files, with and without range requests.
+TEST(HTTPTest, Path)
+{
+  Http http;
+
+  Try<string> path = os::mktemp();
+  ASSERT_SOME(path);
+  ASSERT_SOME(os::write(path.get(), "0123456789"));
+
+  http::OK file;
+  file.type = http::Response::PATH;
+  file.path = path.get();
+
+  EXPECT_CALL(*http.process, get(_))
+    .WillRepeatedly(Return(file));
+
+  Future<http::Response> response = http::get(http.process->self(), "get");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("0123456789", response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("bytes", "Accept-Ranges", response);
+
+  http::Headers headers;
+  headers["Range"] = "bytes=2-4";
+
+  response = http::get(http.process->self(), "get", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      http::Status::string(http::Status::PARTIAL_CONTENT), response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("234", response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("bytes 2-4/10", "Content-Range", response);
+
+  // A suffix range.
+  headers["Range"] = "bytes=-3";
+
+  response = http::get(http.process->self(), "get", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("789", response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("bytes 7-9/10", "Content-Range", response);
+
+  // Multiple ranges are not supported, the whole file is sent.
+  headers["Range"] = "bytes=0-1,4-5";
+
+  response = http::get(http.process->self(), "get", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("0123456789", response);
+
+  headers["Range"] = "bytes=10-";
+
+  response = http::get(http.process->self(), "get", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      http::Status::string(http::Status::REQUESTED_RANGE_NOT_SATISFIABLE),
+      response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("bytes */10", "Content-Range", response);
+
+  // A range set by the handler, which gets clamped to the file.
+  http::Response part(http::Status::PARTIAL_CONTENT);
+  part.type = http::Response::PATH;
+  part.path = path.get();
+  part.offset = 8;
+  part.length = 100;
+
+  EXPECT_CALL(*http.process, get(_))
+    .WillOnce(Return(part));
+
+  response = http::get(http.process->self(), "get");
+
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("89", response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("bytes 8-9/10", "Content-Range", response);
+
+  ASSERT_SOME(os::rm(path.get()));
+}
+
+
+// Tests that a file is sent in chunks when its bandwidth is limited.
+TEST(HTTPTest, PathLimited)
+{
+  Http http;
+
+  const string data(1024 * 1024, 'x');
+
+  Try<string> path = os::mktemp();
+  ASSERT_SOME(path);
+  ASSERT_SOME(os::write(path.get(), data));
+
+  http::OK file;
+  file.type = http::Response::PATH;
+  file.path = path.get();
+  file.limiter.reset(new RateLimiter(100.0 * data.size()));
+
+  EXPECT_CALL(*http.process, get(_))
+    .WillOnce(Return(file));
+
+  Future<http::Response> response = http::get(http.process->self(), "get");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ(data, response);
+
+  ASSERT_SOME(os::rm(path.get()));
+}
+
+
 TEST(HTTPTest, NestedGet)
 {
   Http http;
@@ -718,6 +872,58 @@ TEST(HTTPTest, Post)
 }
 
 
+TEST(HTTPTest, StreamingRequest)
+{
+  Http http;
+
+  // Make the body large enough for the socket to stop receiving
+  // until the body has been read.
+  const string body(4 * 1024 * 1024, 'x');
+
+  Future<http::Request> request;
+  Promise<http::Response> promise;
+
+  EXPECT_CALL(*http.process, stream(_))
+    .WillOnce(DoAll(FutureArg<0>(&request), Return(promise.future())));
+
+  Future<http::Response> response =
+    http::post(http.process->self(), "stream", None(), body, "text/plain");
+
+  AWAIT_READY(request);
+  EXPECT_EQ(http::Request::PIPE, request->type);
+  EXPECT_TRUE(request->body.empty());
+  ASSERT_SOME(request->reader);
+
+  http::Pipe::Reader reader = request->reader.get();
+  AWAIT_EQ(body, reader.readAll());
+
+  promise.set(http::OK("streamed"));
+
+  AWAIT_READY(response);
+  EXPECT_EQ(http::Status::OK, response->code);
+  EXPECT_EQ("streamed", response->body);
+
+  // A buffered body is provided through a reader as well. Requests
+  // to routes that don't stream are unaffected (see 'Post').
+  EXPECT_CALL(*http.process, stream(_))
+    .WillOnce(Invoke([](const http::Request& request) {
+      EXPECT_EQ(http::Request::PIPE, request.type);
+
+      http::Pipe::Reader reader = request.reader.get();
+      return reader.readAll()
+        .then([](const string& body) -> http::Response {
+          return http::OK(body);
+        });
+    }));
+
+  response = http::get(http.process->self(), "stream");
+
+  AWAIT_READY(response);
+  EXPECT_EQ(http::Status::OK, response->code);
+  EXPECT_EQ("", response->body);
+}
+
+
 http::Response validateDelete(const http::Request& request)
 {
   EXPECT_EQ("DELETE", request.method);
@@ -53,6 +53,37 @@ TEST(LimiterTest, Acquire)
 }
 
 
+// Tests that acquiring several permits at once delays the next
+// acquisition accordingly.
+TEST(LimiterTest, AcquireMultiple)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  RateLimiter limiter(10, Seconds(1));
+
+  Clock::pause();
+
+  Future<Nothing> acquire1 = limiter.acquire(5);
+  Future<Nothing> acquire2 = limiter.acquire();
+  Future<Nothing> acquire3 = limiter.acquire();
+
+  AWAIT_READY(acquire1);
+
+  Clock::advance(Milliseconds(499));
+  Clock::settle();
+  EXPECT_TRUE(acquire2.isPending());
+
+  Clock::advance(Milliseconds(1));
+  AWAIT_READY(acquire2);
+  EXPECT_TRUE(acquire3.isPending());
+
+  Clock::advance(Milliseconds(100));
+  AWAIT_READY(acquire3);
+
+  Clock::resume();
+}
+
+
 // In this test 4 permits are given, but the 2nd permit's acquire
 // is immediately discarded. So, 1st, 3rd and 4th permits should
 // be acquired according to the rate limit.
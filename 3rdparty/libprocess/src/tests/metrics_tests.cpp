@@ -29,6 +29,7 @@
 #include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
 #include <process/metrics/metrics.hpp>
+#include <process/metrics/push_gauge.hpp>
 #include <process/metrics/timer.hpp>
 
 namespace http = process::http;
@@ -40,6 +41,7 @@ using http::Response;
 
 using metrics::Counter;
 using metrics::Gauge;
+using metrics::PushGauge;
 using metrics::Timer;
 
 using process::Clock;
@@ -130,6 +132,37 @@ TEST(MetricsTest, Gauge)
 }
 
 
+TEST(MetricsTest, PushGauge)
+{
+  PushGauge gauge("test/pushgauge");
+
+  AWAIT_READY(metrics::add(gauge));
+
+  AWAIT_EXPECT_EQ(0.0, gauge.value());
+
+  gauge = 42;
+  AWAIT_EXPECT_EQ(42.0, gauge.value());
+
+  ++gauge;
+  AWAIT_EXPECT_EQ(43.0, gauge.value());
+
+  gauge -= 42;
+  AWAIT_EXPECT_EQ(1.0, gauge.value());
+
+  --gauge;
+  AWAIT_EXPECT_EQ(0.0, gauge.value());
+
+  // Copies share the value.
+  PushGauge copy = gauge;
+  copy += 0.5;
+  AWAIT_EXPECT_EQ(0.5, gauge.value());
+
+  EXPECT_NONE(gauge.statistics());
+
+  AWAIT_READY(metrics::remove(gauge));
+}
+
+
 TEST(MetricsTest, Statistics)
 {
   Counter counter("test/counter", process::TIME_SERIES_WINDOW);
@@ -263,11 +296,15 @@ TEST(MetricsTest, SnapshotTimeout)
   Gauge gauge("test/gauge", defer(pid, &GaugeProcess::get));
   Gauge gaugeFail("test/gauge_fail", defer(pid, &GaugeProcess::fail));
   Gauge gaugeTimeout("test/gauge_timeout", defer(pid, &GaugeProcess::pending));
+  PushGauge pushGauge("test/push_gauge");
   Counter counter("test/counter");
 
+  pushGauge = 7;
+
   AWAIT_READY(metrics::add(gauge));
   AWAIT_READY(metrics::add(gaugeFail));
   AWAIT_READY(metrics::add(gaugeTimeout));
+  AWAIT_READY(metrics::add(pushGauge));
   AWAIT_READY(metrics::add(counter));
 
   // Advance the clock to avoid rate limit.
@@ -302,6 +339,11 @@ TEST(MetricsTest, SnapshotTimeout)
   EXPECT_EQ(1u, values.count("test/gauge"));
   EXPECT_FLOAT_EQ(42.0, values["test/gauge"].as<JSON::Number>().as<double>());
 
+  EXPECT_EQ(1u, values.count("test/push_gauge"));
+  EXPECT_FLOAT_EQ(
+      7.0,
+      values["test/push_gauge"].as<JSON::Number>().as<double>());
+
   EXPECT_EQ(0u, values.count("test/gauge_fail"));
   EXPECT_EQ(0u, values.count("test/gauge_timeout"));
 
@@ -309,6 +351,7 @@ TEST(MetricsTest, SnapshotTimeout)
   AWAIT_READY(metrics::remove(gauge));
   AWAIT_READY(metrics::remove(gaugeFail));
   AWAIT_READY(metrics::remove(gaugeTimeout));
+  AWAIT_READY(metrics::remove(pushGauge));
   AWAIT_READY(metrics::remove(counter));
 
   // Advance the clock to avoid rate limit.
@@ -431,6 +474,38 @@ TEST(MetricsTest, Timer)
 }
 
 
+TEST(MetricsTest, TimerRecord)
+{
+  metrics::Timer<Milliseconds> timer("test/timer", Seconds(60));
+  EXPECT_EQ("test/timer_ms", timer.name());
+
+  AWAIT_READY(metrics::add(timer));
+
+  // The history of a metric is keyed by the time that a value is
+  // pushed at, hence the clock is advanced between the events.
+  Clock::pause();
+
+  timer.record(Microseconds(1500));
+  Clock::advance(Seconds(1));
+  timer.record(Milliseconds(3));
+
+  Clock::resume();
+
+  Future<double> value = timer.value();
+  AWAIT_READY(value);
+  EXPECT_FLOAT_EQ(3.0, value.get());
+
+  // The recorded events are in the statistics of the timer.
+  Option<Statistics<double>> statistics = timer.statistics();
+  ASSERT_SOME(statistics);
+  EXPECT_EQ(2u, statistics->count);
+  EXPECT_FLOAT_EQ(1.5, statistics->min);
+  EXPECT_FLOAT_EQ(3.0, statistics->max);
+
+  AWAIT_READY(metrics::remove(timer));
+}
+
+
 static Future<int> advanceAndReturn()
 {
   Clock::advance(Seconds(1));
@@ -20,6 +20,8 @@
 #include <netinet/tcp.h>
 
 #include <atomic>
+#include <chrono>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <tuple>
@@ -42,6 +44,7 @@
 #include <process/run.hpp>
 #include <process/socket.hpp>
 #include <process/time.hpp>
+#include <process/timer.hpp>
 
 #include <stout/duration.hpp>
 #include <stout/gtest.hpp>
@@ -52,6 +55,7 @@
 #include <stout/os.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
+#include <stout/synchronized.hpp>
 #include <stout/try.hpp>
 
 #include "encoder.hpp"
@@ -63,6 +67,7 @@ using process::async;
 using process::Clock;
 using process::defer;
 using process::Deferred;
+using process::DispatchEvent;
 using process::Event;
 using process::Executor;
 using process::ExitedEvent;
@@ -70,6 +75,7 @@ using process::Future;
 using process::Message;
 using process::MessageEncoder;
 using process::MessageEvent;
+using process::MethodId;
 using process::Owned;
 using process::PID;
 using process::Process;
@@ -77,6 +83,7 @@ using process::ProcessBase;
 using process::run;
 using process::TerminateEvent;
 using process::Time;
+using process::Timer;
 using process::UPID;
 
 using process::firewall::DisabledEndpointsFirewallRule;
@@ -185,6 +192,112 @@ TEST(ProcessTest, Dispatch)
 }
 
 
+// Keeps the time at which the last dispatch was enqueued.
+class TimestampProcess : public Process<TimestampProcess>
+{
+public:
+  explicit TimestampProcess(bool timestamped)
+  {
+    timestampEvents(timestamped);
+  }
+
+  std::chrono::steady_clock::time_point enqueued() { return last; }
+
+protected:
+  virtual void visit(const DispatchEvent& event)
+  {
+    last = event.enqueued;
+    ProcessBase::visit(event);
+  }
+
+private:
+  std::chrono::steady_clock::time_point last;
+};
+
+
+// Only the processes that timestamp their events see the time at
+// which the events were enqueued.
+TEST(ProcessTest, TimestampEvents)
+{
+  const std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+
+  TimestampProcess timestamped(true);
+  PID<TimestampProcess> pid = spawn(&timestamped);
+
+  Future<std::chrono::steady_clock::time_point> enqueued =
+    dispatch(pid, &TimestampProcess::enqueued);
+
+  AWAIT_READY(enqueued);
+  EXPECT_LE(start, enqueued.get());
+  EXPECT_GE(std::chrono::steady_clock::now(), enqueued.get());
+
+  terminate(pid);
+  wait(pid);
+
+  TimestampProcess untimestamped(false);
+  pid = spawn(&untimestamped);
+
+  enqueued = dispatch(pid, &TimestampProcess::enqueued);
+
+  AWAIT_READY(enqueued);
+  EXPECT_EQ(std::chrono::steady_clock::time_point(), enqueued.get());
+
+  terminate(pid);
+  wait(pid);
+}
+
+
+// Keeps the method invoked by the last dispatch.
+class MethodProcess : public Process<MethodProcess>
+{
+public:
+  Option<MethodId> first() { return last; }
+  Option<MethodId> second() { return last; }
+
+protected:
+  virtual void visit(const DispatchEvent& event)
+  {
+    last = event.method;
+    ProcessBase::visit(event);
+  }
+
+private:
+  Option<MethodId> last;
+};
+
+
+// Dispatches tell apart the methods they invoke even when the methods
+// have the same signature, while dispatches of functions have none.
+TEST(ProcessTest, DispatchMethod)
+{
+  MethodProcess process;
+  PID<MethodProcess> pid = spawn(&process);
+
+  Future<Option<MethodId>> first = dispatch(pid, &MethodProcess::first);
+  AWAIT_READY(first);
+  ASSERT_SOME(first.get());
+  EXPECT_TRUE(first.get().get() == MethodId(&MethodProcess::first));
+
+  Future<Option<MethodId>> second = dispatch(pid, &MethodProcess::second);
+  AWAIT_READY(second);
+  ASSERT_SOME(second.get());
+  EXPECT_TRUE(second.get().get() == MethodId(&MethodProcess::second));
+  EXPECT_TRUE(second.get().get() != first.get().get());
+
+  Future<Option<MethodId>> function =
+    dispatch(pid, std::function<Option<MethodId>()>([&process]() {
+      return process.first();
+    }));
+
+  AWAIT_READY(function);
+  EXPECT_NONE(function.get());
+
+  terminate(pid);
+  wait(pid);
+}
+
+
 TEST(ProcessTest, Defer1)
 {
   ASSERT_TRUE(GTEST_IS_THREADSAFE);
@@ -768,6 +881,63 @@ TEST(ProcessTest, Settle)
 }
 
 
+// Tests that timers spread across all levels of the clock's timing
+// wheel (including timers too far out for any level) fire in order of
+// their timeout, that timers with the same timeout fire in the order
+// they were created, and that only pending timers can be canceled.
+TEST(ProcessTest, Timers)
+{
+  Clock::pause();
+
+  std::mutex mutex;
+  vector<int> fired;
+
+  auto timer = [&](const Duration& duration, int id) {
+    return Clock::timer(duration, [&mutex, &fired, id]() {
+      synchronized (mutex) {
+        fired.push_back(id);
+      }
+    });
+  };
+
+  timer(Days(100), 7);
+  timer(Hours(10), 6);
+  timer(Minutes(1), 4);
+  timer(Milliseconds(500), 2);
+  timer(Milliseconds(1), 1);
+  timer(Minutes(1), 5);
+
+  Timer canceled = timer(Seconds(1), 3);
+
+  EXPECT_TRUE(Clock::cancel(canceled));
+  EXPECT_FALSE(Clock::cancel(canceled));
+
+  Clock::advance(Seconds(1));
+  Clock::settle();
+
+  synchronized (mutex) {
+    EXPECT_EQ(vector<int>({1, 2}), fired);
+  }
+
+  Clock::advance(Days(100));
+  Clock::settle();
+
+  synchronized (mutex) {
+    EXPECT_EQ(vector<int>({1, 2, 4, 5, 6, 7}), fired);
+  }
+
+  // A timer that has fired can no longer be canceled.
+  Timer expired = timer(Seconds(1), 8);
+
+  Clock::advance(Seconds(1));
+  Clock::settle();
+
+  EXPECT_FALSE(Clock::cancel(expired));
+
+  Clock::resume();
+}
+
+
 TEST(ProcessTest, Pid)
 {
   ASSERT_TRUE(GTEST_IS_THREADSAFE);
@@ -0,0 +1,221 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <sys/socket.h>
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <thread>
+
+#include <process/future.hpp>
+#include <process/gtest.hpp>
+#include <process/io.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/gtest.hpp>
+#include <stout/nothing.hpp>
+#include <stout/os.hpp>
+#include <stout/try.hpp>
+
+#include "epoll.hpp"
+
+#ifdef HAVE_LINUX_IO_URING_H
+#include "io_uring.hpp"
+#endif // HAVE_LINUX_IO_URING_H
+
+namespace io = process::io;
+
+using process::EpollPoller;
+using process::Future;
+using process::Poll;
+using process::Promise;
+using process::Reactor;
+
+#ifdef HAVE_LINUX_IO_URING_H
+using process::IoUringPoller;
+#endif // HAVE_LINUX_IO_URING_H
+
+// These tests run a reactor of their own on a separate thread (rather
+// than the reactors of the event loop, whose poller depends on the
+// environment) so that each poller gets exercised.
+template <typename T>
+class ReactorTest : public ::testing::Test
+{
+protected:
+  ReactorTest() : reactor(NULL), thread(NULL), ids(1) {}
+
+  virtual void SetUp()
+  {
+    Try<T*> poller = T::create();
+
+    // Creating an 'IoUringPoller' fails if the kernel lacks io_uring,
+    // in which case the tests do nothing.
+    if (poller.isError()) {
+      LOG(WARNING) << "Skipping test: " << poller.error();
+      return;
+    }
+
+    reactor = new Reactor(poller.get());
+    thread = new std::thread([this]() { reactor->loop(); });
+  }
+
+  virtual void TearDown()
+  {
+    if (reactor != NULL) {
+      reactor->stop();
+      thread->join();
+      delete thread;
+      delete reactor;
+    }
+  }
+
+  // Polls 'fd' in the reactor, like 'io::poll' does.
+  Future<short> poll(int fd, short events)
+  {
+    Poll* poll = new Poll();
+    poll->id = ids.fetch_add(1);
+    poll->fd = fd;
+    poll->events = events;
+
+    Future<short> future = poll->promise.future();
+
+    const uint64_t id = poll->id;
+    Reactor* reactor = this->reactor;
+
+    reactor->run([reactor, poll]() {
+      reactor->poll(poll);
+    });
+
+    future.onDiscard([reactor, id]() {
+      reactor->run([reactor, id]() {
+        reactor->discard(id);
+      });
+    });
+
+    return future;
+  }
+
+  // Returns a future which is satisfied once the reactor has run a
+  // delay of 'duration'.
+  Future<Nothing> delay(const Duration& duration)
+  {
+    Promise<Nothing>* promise = new Promise<Nothing>();
+    Future<Nothing> future = promise->future();
+
+    Reactor* reactor = this->reactor;
+
+    reactor->run([reactor, duration, promise]() {
+      reactor->delay(duration, [promise]() {
+        promise->set(Nothing());
+        delete promise;
+      });
+    });
+
+    return future;
+  }
+
+  Reactor* reactor;
+  std::thread* thread;
+  std::atomic<uint64_t> ids;
+};
+
+
+#ifdef HAVE_LINUX_IO_URING_H
+typedef ::testing::Types<EpollPoller, IoUringPoller> Pollers;
+#else
+typedef ::testing::Types<EpollPoller> Pollers;
+#endif // HAVE_LINUX_IO_URING_H
+
+
+TYPED_TEST_CASE(ReactorTest, Pollers);
+
+
+TYPED_TEST(ReactorTest, Poll)
+{
+  if (this->reactor == NULL) {
+    return;
+  }
+
+  int pipes[2];
+  ASSERT_NE(-1, pipe(pipes));
+
+  // Test discard when polling.
+  Future<short> future = this->poll(pipes[0], io::READ);
+  EXPECT_TRUE(future.isPending());
+  future.discard();
+  AWAIT_DISCARDED(future);
+
+  // Test successful polling.
+  future = this->poll(pipes[0], io::READ);
+  EXPECT_TRUE(future.isPending());
+  ASSERT_EQ(3, write(pipes[1], "hi", 3));
+  AWAIT_EXPECT_EQ(io::READ, future);
+
+  // The descriptor is still readable, so polling it again (which
+  // re-arms an existing registration) completes right away.
+  AWAIT_EXPECT_EQ(io::READ, this->poll(pipes[0], io::READ));
+
+  ASSERT_SOME(os::close(pipes[0]));
+  ASSERT_SOME(os::close(pipes[1]));
+}
+
+
+TYPED_TEST(ReactorTest, Socket)
+{
+  if (this->reactor == NULL) {
+    return;
+  }
+
+  int sockets[2];
+  ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+
+  // A read and a write poll of the same socket are pending at the
+  // same time, and the socket is writable right away.
+  Future<short> readable = this->poll(sockets[0], io::READ);
+  Future<short> writable = this->poll(sockets[0], io::WRITE);
+
+  AWAIT_EXPECT_EQ(io::WRITE, writable);
+  EXPECT_TRUE(readable.isPending());
+
+  ASSERT_EQ(1, ::send(sockets[1], "a", 1, 0));
+  AWAIT_EXPECT_EQ(io::READ, readable);
+
+  // Closing the peer makes the socket readable (at end of file).
+  readable = this->poll(sockets[1], io::READ);
+  EXPECT_TRUE(readable.isPending());
+
+  ASSERT_SOME(os::close(sockets[0]));
+  AWAIT_EXPECT_EQ(io::READ, readable);
+
+  ASSERT_SOME(os::close(sockets[1]));
+}
+
+
+TYPED_TEST(ReactorTest, Timer)
+{
+  if (this->reactor == NULL) {
+    return;
+  }
+
+  // Delays run in the order of their deadlines, not in the order
+  // they were added.
+  Future<Nothing> later = this->delay(Milliseconds(50));
+  Future<Nothing> sooner = this->delay(Milliseconds(10));
+
+  AWAIT_READY(sooner);
+  EXPECT_TRUE(later.isPending());
+  AWAIT_READY(later);
+
+  // A negative duration still runs the function from the reactor.
+  AWAIT_READY(this->delay(Seconds(-1)));
+}
@@ -0,0 +1,505 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <string.h>
+
+#include <algorithm>
+#include <list>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include <stout/duration.hpp>
+#include <stout/foreach.hpp>
+
+#include "timer_wheel.hpp"
+
+using std::list;
+using std::vector;
+
+namespace process {
+
+const int64_t TimerWheel::RESOLUTION = Milliseconds(1).ns();
+
+
+TimerWheel::TimerWheel()
+  : free(NULL),
+    size_(0),
+    sequence(0),
+    base(0),
+    stale(false)
+{
+  clear();
+}
+
+
+Timer TimerWheel::insert(
+    const Timeout& timeout,
+    const UPID& pid,
+    const lambda::function<void()>& thunk)
+{
+  if (free == NULL) {
+    CHECK_LT(chunks.size(), UINT32_MAX / CHUNK) << "Too many timers";
+
+    Node* chunk = new Node[CHUNK];
+
+    for (uint32_t i = CHUNK; i > 0; i--) {
+      Node* node = &chunk[i - 1];
+      node->index = chunks.size() * CHUNK + (i - 1);
+      node->generation = 1;
+      node->next = free;
+      free = node;
+    }
+
+    chunks.push_back(chunk);
+  }
+
+  Node* node = free;
+  free = node->next;
+
+  const uint64_t id = (uint64_t(node->generation) << 32) | node->index;
+
+  node->timer.push_back(Timer(id, timeout, pid, thunk));
+  node->timeout = timeout.time();
+  node->sequence = sequence++;
+  node->tick = std::max(ticks(node->timeout), base);
+
+  link(node);
+
+  size_++;
+
+  // The new timer can only make the earliest timeout earlier.
+  if (!stale && (cached.isNone() || node->timeout < cached.get())) {
+    cached = node->timeout;
+  }
+
+  return node->timer.front();
+}
+
+
+bool TimerWheel::erase(const Timer& timer)
+{
+  Node* node = find(timer);
+
+  if (node == NULL) {
+    return false;
+  }
+
+  if (!stale && cached.isSome() && node->timeout == cached.get()) {
+    stale = true;
+  }
+
+  unlink(node);
+  release(node);
+
+  return true;
+}
+
+
+void TimerWheel::expire(const Time& now, list<Timer>* expired)
+{
+  stale = true;
+
+  // The clock might have gone backwards (e.g., wall clock adjustments),
+  // in which case we still need to look at the current slot since
+  // it holds any timers that were added with a timeout in the past.
+  const uint64_t tick = std::max(ticks(now), base);
+
+  while (true) {
+    // Find the first occupied slot of the lowest occupied level.
+    int level = 0;
+    Option<int> slot = first(level);
+
+    while (slot.isNone() && ++level < LEVELS) {
+      slot = first(level);
+    }
+
+    if (slot.isNone()) {
+      // Only timers in the overflow list (if any) are left, so move to
+      // the earliest of them, which relinks them into the wheel.
+      Option<uint64_t> earliest = this->earliest();
+
+      if (earliest.isNone() || earliest.get() > tick) {
+        advance(tick);
+        return;
+      }
+
+      advance(earliest.get());
+      continue;
+    }
+
+    const uint64_t start = this->start(level, slot.get());
+    const uint64_t end = start + (uint64_t(1) << (BITS * level));
+
+    if (start > tick) {
+      advance(tick);
+      return;
+    }
+
+    Slot* current = &wheel[level][slot.get()];
+
+    if (end <= tick) {
+      // All timers in this slot are due (their tick is before the
+      // current tick), so expire them as a batch rather than first
+      // cascading them through the lower levels. We leave 'base' as
+      // is, since moving it past this slot would cascade the next one
+      // even though it might be due as a whole as well.
+      batch.clear();
+
+      for (Node* node = current->head; node != NULL; node = node->next) {
+        Expired timer = {node->timeout, node->sequence, node};
+        batch.push_back(timer);
+      }
+
+      expire(&batch, expired);
+      continue;
+    }
+
+    advance(start);
+
+    if (level > 0) {
+      // The timers of the slot have been cascaded into lower levels.
+      continue;
+    }
+
+    // This is the slot of the current tick, in which only the timers
+    // at or before 'now' are due. All other timers are in later ticks.
+    batch.clear();
+
+    for (Node* node = current->head; node != NULL; node = node->next) {
+      if (node->timeout <= now) {
+        Expired timer = {node->timeout, node->sequence, node};
+        batch.push_back(timer);
+      }
+    }
+
+    expire(&batch, expired);
+    return;
+  }
+}
+
+
+Option<Time> TimerWheel::next() const
+{
+  if (!stale) {
+    return cached;
+  }
+
+  cached = None();
+  stale = false;
+
+  for (int level = 0; level < LEVELS; level++) {
+    Option<int> slot = first(level);
+
+    if (slot.isNone()) {
+      continue;
+    }
+
+    if (level > 0) {
+      cached = time(start(level, slot.get()));
+      return cached;
+    }
+
+    // All timers in a level 0 slot share their tick, so we can afford
+    // to find the exact earliest timeout.
+    for (Node* node = wheel[0][slot.get()].head;
+         node != NULL;
+         node = node->next) {
+      if (cached.isNone() || node->timeout < cached.get()) {
+        cached = node->timeout;
+      }
+    }
+
+    return cached;
+  }
+
+  for (Node* node = overflow.head; node != NULL; node = node->next) {
+    if (cached.isNone() || node->timeout < cached.get()) {
+      cached = node->timeout;
+    }
+  }
+
+  return cached;
+}
+
+
+void TimerWheel::reset(const Time& now)
+{
+  CHECK(empty());
+
+  base = ticks(now);
+}
+
+
+void TimerWheel::clear()
+{
+  // Rebuild the free list from all nodes, freeing pending timers.
+  free = NULL;
+
+  for (size_t i = chunks.size(); i > 0; i--) {
+    for (uint32_t j = CHUNK; j > 0; j--) {
+      Node* node = &chunks[i - 1][j - 1];
+
+      if (!node->timer.empty()) {
+        node->timer.clear();
+        node->generation = node->generation == UINT32_MAX
+          ? 1
+          : node->generation + 1;
+      }
+
+      node->next = free;
+      free = node;
+    }
+  }
+
+  size_ = 0;
+
+  memset(wheel, 0, sizeof(wheel));
+  memset(occupied, 0, sizeof(occupied));
+
+  overflow.head = NULL;
+  overflow.tail = NULL;
+
+  cached = None();
+  stale = false;
+}
+
+
+uint64_t TimerWheel::ticks(const Time& time)
+{
+  const int64_t nanoseconds = time.duration().ns();
+  return nanoseconds < 0 ? 0 : nanoseconds / RESOLUTION;
+}
+
+
+Time TimerWheel::time(uint64_t tick)
+{
+  return Time::epoch() + Nanoseconds(tick * RESOLUTION);
+}
+
+
+TimerWheel::Node* TimerWheel::find(const Timer& timer) const
+{
+  const uint32_t index = timer.id & UINT32_MAX;
+  const uint32_t generation = timer.id >> 32;
+
+  if (index / CHUNK >= chunks.size()) {
+    return NULL;
+  }
+
+  Node* node = &chunks[index / CHUNK][index % CHUNK];
+
+  if (node->generation != generation || node->timer.empty()) {
+    return NULL;
+  }
+
+  return node;
+}
+
+
+void TimerWheel::release(Node* node)
+{
+  node->timer.clear();
+
+  // Invalidate the id of the timer. Generation 0 is never used so that
+  // the id of a default constructed 'Timer' never matches.
+  node->generation = node->generation == UINT32_MAX
+    ? 1
+    : node->generation + 1;
+
+  node->next = free;
+  free = node;
+
+  size_--;
+}
+
+
+void TimerWheel::link(Node* node)
+{
+  // The level is determined by the most significant group of 'BITS'
+  // in which the tick differs from 'base'.
+  const uint64_t difference = node->tick ^ base;
+
+  int level = 0;
+  while (level < LEVELS && (difference >> (BITS * (level + 1))) != 0) {
+    level++;
+  }
+
+  Slot* slot = NULL;
+
+  if (level == LEVELS) {
+    node->slot = 0;
+    slot = &overflow;
+  } else {
+    node->slot = (node->tick >> (BITS * level)) % SLOTS;
+    slot = &wheel[level][node->slot];
+    occupied[level][node->slot / 64] |= uint64_t(1) << (node->slot % 64);
+  }
+
+  node->level = level;
+  node->prev = slot->tail;
+  node->next = NULL;
+
+  if (slot->tail != NULL) {
+    slot->tail->next = node;
+  } else {
+    slot->head = node;
+  }
+
+  slot->tail = node;
+}
+
+
+void TimerWheel::unlink(Node* node)
+{
+  Slot* slot = node->level == LEVELS
+    ? &overflow
+    : &wheel[node->level][node->slot];
+
+  if (node->prev != NULL) {
+    node->prev->next = node->next;
+  } else {
+    slot->head = node->next;
+  }
+
+  if (node->next != NULL) {
+    node->next->prev = node->prev;
+  } else {
+    slot->tail = node->prev;
+  }
+
+  node->prev = NULL;
+  node->next = NULL;
+
+  if (slot->head == NULL && node->level < LEVELS) {
+    occupied[node->level][node->slot / 64] &=
+      ~(uint64_t(1) << (node->slot % 64));
+  }
+}
+
+
+Option<int> TimerWheel::first(int level) const
+{
+  for (int word = 0; word < WORDS; word++) {
+    if (occupied[level][word] != 0) {
+      return word * 64 + __builtin_ctzll(occupied[level][word]);
+    }
+  }
+
+  return None();
+}
+
+
+uint64_t TimerWheel::start(int level, int slot) const
+{
+  const int shift = BITS * level;
+  const uint64_t rotation = (base >> (shift + BITS)) << (shift + BITS);
+
+  return rotation | (uint64_t(slot) << shift);
+}
+
+
+Option<uint64_t> TimerWheel::earliest() const
+{
+  // Slots at each level only ever hold ticks after 'base' within the
+  // current rotation of the level above, and every level holds ticks
+  // after those of the levels below it, so the first occupied slot
+  // of the lowest occupied level starts the earliest tick.
+  for (int level = 0; level < LEVELS; level++) {
+    Option<int> slot = first(level);
+
+    if (slot.isSome()) {
+      return start(level, slot.get());
+    }
+  }
+
+  Option<uint64_t> earliest = None();
+
+  for (Node* node = overflow.head; node != NULL; node = node->next) {
+    if (earliest.isNone() || node->tick < earliest.get()) {
+      earliest = node->tick;
+    }
+  }
+
+  return earliest;
+}
+
+
+void TimerWheel::advance(uint64_t tick)
+{
+  CHECK_GE(tick, base);
+
+  const uint64_t previous = base;
+
+  base = tick;
+
+  // Cascade from the top so that timers moved out of a higher level
+  // are cascaded further if they land in the current slot of a lower
+  // level.
+  if (overflow.head != NULL &&
+      (previous >> (BITS * LEVELS)) != (base >> (BITS * LEVELS))) {
+    Node* node = overflow.head;
+
+    overflow.head = NULL;
+    overflow.tail = NULL;
+
+    while (node != NULL) {
+      Node* next = node->next;
+      link(node);
+      node = next;
+    }
+  }
+
+  for (int level = LEVELS - 1; level > 0; level--) {
+    const int index = (base >> (BITS * level)) % SLOTS;
+
+    Slot* slot = &wheel[level][index];
+    Node* node = slot->head;
+
+    if (node == NULL) {
+      continue;
+    }
+
+    slot->head = NULL;
+    slot->tail = NULL;
+
+    occupied[level][index / 64] &= ~(uint64_t(1) << (index % 64));
+
+    while (node != NULL) {
+      Node* next = node->next;
+      link(node);
+      node = next;
+    }
+  }
+}
+
+
+void TimerWheel::expire(vector<Expired>* batch, list<Timer>* expired)
+{
+  std::sort(
+      batch->begin(),
+      batch->end(),
+      [](const Expired& left, const Expired& right) {
+        if (left.timeout != right.timeout) {
+          return left.timeout < right.timeout;
+        }
+        return left.sequence < right.sequence;
+      });
+
+  foreach (const Expired& timer, *batch) {
+    expired->splice(expired->end(), timer.node->timer);
+    unlink(timer.node);
+    release(timer.node);
+  }
+}
+
+} // namespace process {
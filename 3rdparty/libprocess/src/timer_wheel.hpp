@@ -0,0 +1,198 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __TIMER_WHEEL_HPP__
+#define __TIMER_WHEEL_HPP__
+
+#include <stdint.h>
+
+#include <list>
+#include <vector>
+
+#include <process/pid.hpp>
+#include <process/time.hpp>
+#include <process/timeout.hpp>
+#include <process/timer.hpp>
+
+#include <stout/lambda.hpp>
+#include <stout/option.hpp>
+
+namespace process {
+
+// Hierarchical timing wheel holding the pending timers of the clock.
+//
+// Time is divided into 'ticks' of 'RESOLUTION' which are mapped onto
+// 'LEVELS' wheels of 'SLOTS' slots each: level 0 spans 'SLOTS' ticks,
+// level 1 spans 'SLOTS' level 0 rotations, and so on. A timer lives in
+// the lowest level whose current rotation contains its tick and is
+// cascaded down a level as the wheel advances into its slot. Timers
+// beyond the last level are kept in an (unordered) overflow list.
+//
+// Timers are kept in a slab of nodes and the id of a timer encodes the
+// index of its node, so inserting and erasing a timer is O(1) without
+// any lookup structure. Expiring is O(1) per timer (plus at most one
+// move per level), and slots that are entirely due are expired as a
+// batch without cascading. Empty slots are skipped using a bitmap of
+// occupied slots per level, so advancing over long idle periods (or a
+// large 'Clock::advance') is cheap.
+//
+// Timers are expired based on their exact timeout, not their tick, so
+// 'RESOLUTION' only affects performance and never when a timer fires.
+//
+// NOTE: This class is not thread safe, callers must synchronize.
+class TimerWheel
+{
+public:
+  TimerWheel();
+
+  // Creates and adds a timer.
+  Timer insert(
+      const Timeout& timeout,
+      const UPID& pid,
+      const lambda::function<void()>& thunk);
+
+  // Removes the timer, returning false if it is not pending (e.g., it
+  // has already expired or been erased).
+  bool erase(const Timer& timer);
+
+  // Removes all timers whose timeout is at or before 'now' and appends
+  // them to 'expired' ordered by timeout (ties broken by insertion).
+  void expire(const Time& now, std::list<Timer>* expired);
+
+  // Returns a time that is no later than the earliest pending timeout,
+  // or None if there are no pending timers. The returned time is exact
+  // for timers expiring within the current tick but may otherwise be
+  // the start of the slot holding the earliest timer, in which case an
+  // 'expire' at that time only cascades timers. Unless a timer at or
+  // before 'now' has since been inserted, the returned time is after
+  // 'now' following 'expire(now)'.
+  Option<Time> next() const;
+
+  // Moves an empty wheel to 'now'. Since timers are placed relative to
+  // the time of the last 'expire', this avoids placing new timers in
+  // the higher levels (or the overflow list) after an idle period.
+  void reset(const Time& now);
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+
+  void clear();
+
+private:
+  static const int64_t RESOLUTION; // In nanoseconds.
+  static const int LEVELS = 4;
+  static const int BITS = 8;
+  static const int SLOTS = 1 << BITS;
+  static const int WORDS = SLOTS / 64;
+
+  // Number of nodes allocated at a time.
+  static const uint32_t CHUNK = 4096;
+
+  struct Node
+  {
+    // The timer is kept in a list of its own so that expiring it only
+    // splices it into the list of expired timers, rather than copying
+    // it while holding the clock's lock. Empty if the node is free.
+    std::list<Timer> timer;
+
+    Time timeout;
+    uint64_t sequence;
+    uint64_t tick;
+
+    // The id of a timer is its node's generation (bumped every time
+    // the node is freed) followed by the node's index, which makes it
+    // unique across all timers.
+    uint32_t index;
+    uint32_t generation;
+
+    int level; // 'LEVELS' denotes the overflow list.
+    int slot;
+
+    // Links within the slot, or the free list.
+    Node* prev;
+    Node* next;
+  };
+
+  struct Slot
+  {
+    Node* head;
+    Node* tail;
+  };
+
+  // An expired timer, with its sort key copied out of the node so that
+  // sorting a batch does not chase pointers.
+  struct Expired
+  {
+    Time timeout;
+    uint64_t sequence;
+    Node* node;
+  };
+
+  static uint64_t ticks(const Time& time);
+  static Time time(uint64_t tick);
+
+  // Returns the node of a pending timer, or NULL.
+  Node* find(const Timer& timer) const;
+
+  // Returns the node to the free list.
+  void release(Node* node);
+
+  // Links 'node' into the slot determined by its tick and 'base'.
+  void link(Node* node);
+  void unlink(Node* node);
+
+  // Returns the first occupied slot of 'level', if any.
+  Option<int> first(int level) const;
+
+  // Returns the first tick covered by 'slot' of 'level' in the current
+  // rotation of that level.
+  uint64_t start(int level, int slot) const;
+
+  // Returns the earliest tick at which a timer may expire, without
+  // considering timeouts within a tick, or None if there are no
+  // pending timers.
+  Option<uint64_t> earliest() const;
+
+  // Moves the wheel to 'tick', cascading the timers of the slots that
+  // now belong to the current rotation of a lower level. Requires that
+  // no timer is in a slot before 'tick' (see 'earliest').
+  void advance(uint64_t tick);
+
+  // Removes the timers in 'batch' and appends them to 'expired' ordered
+  // by timeout (ties broken by insertion).
+  void expire(std::vector<Expired>* batch, std::list<Timer>* expired);
+
+  std::vector<Node*> chunks;
+  Node* free;
+
+  size_t size_;
+  uint64_t sequence;
+
+  Slot wheel[LEVELS][SLOTS];
+  uint64_t occupied[LEVELS][WORDS];
+
+  Slot overflow;
+
+  // All ticks before 'base' have been expired.
+  uint64_t base;
+
+  // Reused across calls to 'expire' to avoid allocating.
+  std::vector<Expired> batch;
+
+  // Cached result of 'next', valid unless 'stale'.
+  mutable Option<Time> cached;
+  mutable bool stale;
+};
+
+} // namespace process {
+
+#endif // __TIMER_WHEEL_HPP__
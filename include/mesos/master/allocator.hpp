@@ -42,6 +42,27 @@ namespace mesos {
 namespace master {
 namespace allocator {
 
+/**
+ * Options that tune an allocator. An allocator may ignore any of them,
+ * which ones it supports depends on the implementation.
+ */
+struct Options
+{
+  /**
+   * How long the allocator may wait after an event that triggers an
+   * allocation, so that a burst of events results in a single
+   * allocation.
+   */
+  Duration allocationWindow = Duration::zero();
+
+  /**
+   * The order in which the allocator allocates the resources of the
+   * agents, e.g., `random` or `best_fit`.
+   */
+  std::string agentOrdering = "random";
+};
+
+
 /**
  * Basic model of an allocator: resources are allocated to a framework
  * in the form of offers. A framework can refuse some resources in
@@ -84,6 +105,7 @@ public:
    *     allocations from the frameworks.
    * @param weights Configured per-role weights. Any roles that do not
    *     appear in this map will be assigned the default weight of 1.
+   * @param options Options that tune the allocator, see `Options`.
    */
   virtual void initialize(
       const Duration& allocationInterval,
@@ -94,7 +116,8 @@ public:
           void(const FrameworkID&,
                const hashmap<SlaveID, UnavailableResources>&)>&
         inverseOfferCallback,
-      const hashmap<std::string, double>& weights) = 0;
+      const hashmap<std::string, double>& weights,
+      const Options& options) = 0;
 
   /**
    * Informs the allocator of the recovered state from the master.
@@ -17,8 +17,10 @@
 #ifndef __RESOURCES_HPP__
 #define __RESOURCES_HPP__
 
+#include <atomic>
 #include <map>
 #include <iosfwd>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -59,6 +61,14 @@ namespace mesos {
 // objects will be silently stripped. Invalid Resource objects will
 // also be silently ignored when used in arithmetic operations (e.g.,
 // +=, -=, etc.).
+//
+// NOTE: Copies of a Resources object share the Resource objects until
+// either copy is mutated (i.e., copy-on-write), so copying is cheap.
+// The aggregates that do not take arguments (e.g., 'scalars()' or
+// 'revocable()') are computed once and shared as well, until the next
+// mutation. Like for other types, a Resources object must not be
+// mutated concurrently with other accesses, but copies can be used by
+// different threads.
 class Resources
 {
 public:
@@ -197,19 +207,19 @@ public:
   /*implicit*/
   Resources(const google::protobuf::RepeatedPtrField<Resource>& _resources);
 
-  Resources(const Resources& that) : resources(that.resources) {}
+  Resources(const Resources& that) : storage(that.storage) {}
 
   Resources& operator=(const Resources& that)
   {
     if (this != &that) {
-      resources = that.resources;
+      storage = that.storage;
     }
     return *this;
   }
 
-  bool empty() const { return resources.size() == 0; }
+  bool empty() const { return resources().size() == 0; }
 
-  size_t size() const { return resources.size(); }
+  size_t size() const { return resources().size(); }
 
   // Checks if this Resources is a superset of the given Resources.
   bool contains(const Resources& that) const;
@@ -344,20 +354,11 @@ public:
   typedef google::protobuf::RepeatedPtrField<Resource>::const_iterator
   const_iterator;
 
-  const_iterator begin()
-  {
-    using google::protobuf::RepeatedPtrField;
-    return static_cast<const RepeatedPtrField<Resource>&>(resources).begin();
-  }
-
-  const_iterator end()
-  {
-    using google::protobuf::RepeatedPtrField;
-    return static_cast<const RepeatedPtrField<Resource>&>(resources).end();
-  }
+  const_iterator begin() { return resources().begin(); }
+  const_iterator end() { return resources().end(); }
 
-  const_iterator begin() const { return resources.begin(); }
-  const_iterator end() const { return resources.end(); }
+  const_iterator begin() const { return resources().begin(); }
+  const_iterator end() const { return resources().end(); }
 
   // Using this operator makes it easy to copy a resources object into
   // a protocol buffer field.
@@ -396,7 +397,63 @@ private:
   // returns Resources.
   Option<Resources> find(const Resource& target) const;
 
-  google::protobuf::RepeatedPtrField<Resource> resources;
+  // Computes 'flatten()', which caches the result for the defaults.
+  Resources _flatten(
+      const std::string& role,
+      const Option<Resource::ReservationInfo>& reservation) const;
+
+  // The aggregates that are cached, see `Storage`.
+  enum Aggregate
+  {
+    SCALARS,
+    RESERVED,
+    UNRESERVED,
+    REVOCABLE,
+    NON_REVOCABLE,
+    FLATTENED,
+    AGGREGATES // The number of aggregates.
+  };
+
+  // The Resource objects shared by the copies of a Resources object,
+  // along with the aggregates computed from them. The aggregates are
+  // computed upon first use, possibly by different threads, hence
+  // they are set atomically (and the losing thread discards its own).
+  //
+  // NOTE: An aggregate must never share the storage it is cached in,
+  // as that would form a cycle of shared pointers.
+  struct Storage
+  {
+    Storage();
+    explicit Storage(const google::protobuf::RepeatedPtrField<Resource>& r);
+    ~Storage();
+
+    // Discards the aggregates, upon mutating the Resource objects.
+    void invalidate();
+
+    google::protobuf::RepeatedPtrField<Resource> resources;
+
+    std::atomic<Resources*> aggregates[AGGREGATES];
+  };
+
+  const google::protobuf::RepeatedPtrField<Resource>& resources() const
+  {
+    return storage ? storage->resources : emptyResources();
+  }
+
+  // Returns the Resource objects for mutation, which copies them
+  // first if they are shared with other Resources objects.
+  google::protobuf::RepeatedPtrField<Resource>& mutableResources();
+
+  // Returns the aggregate, computing and caching it if needed.
+  Resources aggregate(
+      Aggregate aggregate,
+      const lambda::function<Resources()>& compute) const;
+
+  static const google::protobuf::RepeatedPtrField<Resource>& emptyResources();
+
+  // NULL if there are no Resource objects (e.g., for a default
+  // constructed Resources object), to avoid allocating the storage.
+  std::shared_ptr<Storage> storage;
 };
 
 
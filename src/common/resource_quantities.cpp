@@ -0,0 +1,343 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+
+#include <glog/logging.h>
+
+#include <stout/foreach.hpp>
+#include <stout/none.hpp>
+#include <stout/option.hpp>
+#include <stout/synchronized.hpp>
+#include <stout/unreachable.hpp>
+
+#include "common/resource_quantities.hpp"
+
+using std::ostream;
+using std::string;
+using std::vector;
+
+namespace mesos {
+
+// The interned resource names. There are only a handful of distinct
+// resource names, so indices are never reclaimed.
+//
+// The names are looked up on the hot paths of the allocator, including
+// by the threads that compute the agents' available resources in
+// parallel. Hence the table is append-only: the names are kept in
+// segments that are never moved or freed, and are published by
+// incrementing `size`. Lookups scan the published names without taking
+// the lock, which is only needed to append a name.
+struct ResourceNames
+{
+  // The first segment holds `BASE` names, and each next segment twice
+  // as many as the previous one, hence the segments never run out.
+  static constexpr size_t BASE = 16;
+  static constexpr size_t SEGMENTS = 32;
+
+  ResourceNames() : size(0)
+  {
+    std::fill_n(segments, SEGMENTS, static_cast<string*>(nullptr));
+  }
+
+  // Returns the slot of the name at 'index'.
+  string& at(size_t index)
+  {
+    size_t segment = 0;
+    size_t capacity = BASE;
+
+    while (index >= capacity) {
+      index -= capacity;
+      capacity *= 2;
+      segment++;
+    }
+
+    CHECK_LT(segment, SEGMENTS);
+
+    if (segments[segment] == nullptr) {
+      segments[segment] = new string[capacity];
+    }
+
+    return segments[segment][index];
+  }
+
+  // Returns the index of the name among the first 'count' names.
+  Option<size_t> find(const string& name, size_t count)
+  {
+    for (size_t index = 0; index < count; index++) {
+      if (at(index) == name) {
+        return index;
+      }
+    }
+
+    return None();
+  }
+
+  std::mutex mutex;
+
+  // The number of published names. A name (and its segment) is written
+  // before `size` is incremented past it, and read only after `size`
+  // has been seen past it, hence it is never accessed concurrently
+  // with its write.
+  std::atomic<size_t> size;
+
+  string* segments[SEGMENTS];
+};
+
+
+static ResourceNames* names()
+{
+  // NOTE: This is intentionally leaked to avoid problems with the
+  // order of destruction of static objects.
+  static ResourceNames* names = new ResourceNames();
+  return names;
+}
+
+
+// Returns the index of the resource name, if it is interned.
+static Option<size_t> lookup(const string& name)
+{
+  ResourceNames* names_ = names();
+
+  return names_->find(name, names_->size.load(std::memory_order_acquire));
+}
+
+
+// Returns the index of the resource name, interning it if necessary.
+static size_t intern(const string& name)
+{
+  Option<size_t> index = lookup(name);
+
+  if (index.isSome()) {
+    return index.get();
+  }
+
+  ResourceNames* names_ = names();
+
+  synchronized (names_->mutex) {
+    const size_t size = names_->size.load(std::memory_order_relaxed);
+
+    // The name might have been appended since it was looked up.
+    index = names_->find(name, size);
+
+    if (index.isSome()) {
+      return index.get();
+    }
+
+    names_->at(size) = name;
+    names_->size.store(size + 1, std::memory_order_release);
+
+    return size;
+  }
+
+  UNREACHABLE();
+}
+
+
+// Returns the resource name of an index.
+static string name(size_t index)
+{
+  ResourceNames* names_ = names();
+
+  CHECK_LT(index, names_->size.load(std::memory_order_acquire));
+
+  return names_->at(index);
+}
+
+
+// See `convertToFixed` and `convertToFloating` in common/values.cpp.
+static int64_t convertToFixed(double floatValue)
+{
+  return std::llround(floatValue * 1000);
+}
+
+
+static double convertToFloating(int64_t fixedValue)
+{
+  double quotient = static_cast<double>(fixedValue / 1000);
+  double remainder = static_cast<double>(fixedValue % 1000) / 1000.0;
+
+  return quotient + remainder;
+}
+
+
+ResourceQuantities::ResourceQuantities(const Resources& resources)
+{
+  foreach (const Resource& resource, resources) {
+    add(resource);
+  }
+}
+
+
+ResourceQuantities::ResourceQuantities(
+    const google::protobuf::RepeatedPtrField<Resource>& resources)
+{
+  foreach (const Resource& resource, resources) {
+    add(resource);
+  }
+}
+
+
+double ResourceQuantities::get(const string& name) const
+{
+  Option<size_t> index = lookup(name);
+
+  if (index.isNone()) {
+    return 0.0;
+  }
+
+  return at(index.get());
+}
+
+
+bool ResourceQuantities::empty() const
+{
+  foreach (double quantity, quantities) {
+    if (quantity != 0.0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+bool ResourceQuantities::contains(const ResourceQuantities& that) const
+{
+  const size_t size = std::min(quantities.size(), that.quantities.size());
+
+  for (size_t i = 0; i < size; i++) {
+    if (quantities[i] < that.quantities[i]) {
+      return false;
+    }
+  }
+
+  for (size_t i = size; i < that.quantities.size(); i++) {
+    if (that.quantities[i] > 0.0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+bool ResourceQuantities::operator==(const ResourceQuantities& that) const
+{
+  return contains(that) && that.contains(*this);
+}
+
+
+bool ResourceQuantities::operator!=(const ResourceQuantities& that) const
+{
+  return !(*this == that);
+}
+
+
+ResourceQuantities ResourceQuantities::operator+(
+    const ResourceQuantities& that) const
+{
+  ResourceQuantities result = *this;
+  result += that;
+  return result;
+}
+
+
+ResourceQuantities& ResourceQuantities::operator+=(
+    const ResourceQuantities& that)
+{
+  if (quantities.size() < that.quantities.size()) {
+    quantities.resize(that.quantities.size(), 0.0);
+  }
+
+  for (size_t i = 0; i < that.quantities.size(); i++) {
+    quantities[i] = convertToFloating(
+        convertToFixed(quantities[i]) + convertToFixed(that.quantities[i]));
+  }
+
+  return *this;
+}
+
+
+ResourceQuantities ResourceQuantities::operator-(
+    const ResourceQuantities& that) const
+{
+  ResourceQuantities result = *this;
+  result -= that;
+  return result;
+}
+
+
+ResourceQuantities& ResourceQuantities::operator-=(
+    const ResourceQuantities& that)
+{
+  const size_t size = std::min(quantities.size(), that.quantities.size());
+
+  for (size_t i = 0; i < size; i++) {
+    quantities[i] = convertToFloating(std::max<int64_t>(
+        convertToFixed(quantities[i]) - convertToFixed(that.quantities[i]),
+        0));
+  }
+
+  return *this;
+}
+
+
+void ResourceQuantities::add(const Resource& resource)
+{
+  if (resource.type() != Value::SCALAR) {
+    return;
+  }
+
+  const size_t index = intern(resource.name());
+
+  if (quantities.size() <= index) {
+    quantities.resize(index + 1, 0.0);
+  }
+
+  // NOTE: Like `Resources`, we ignore negative quantities.
+  quantities[index] = convertToFloating(
+      convertToFixed(quantities[index]) +
+      std::max<int64_t>(convertToFixed(resource.scalar().value()), 0));
+}
+
+
+ostream& operator<<(ostream& stream, const ResourceQuantities& quantities)
+{
+  bool first = true;
+
+  for (size_t i = 0; i < quantities.quantities.size(); i++) {
+    if (quantities.quantities[i] == 0.0) {
+      continue;
+    }
+
+    if (!first) {
+      stream << ";";
+    }
+
+    stream << name(i) << ":" << quantities.at(i);
+    first = false;
+  }
+
+  return stream;
+}
+
+} // namespace mesos {
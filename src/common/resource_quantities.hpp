@@ -0,0 +1,99 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __RESOURCE_QUANTITIES_HPP__
+#define __RESOURCE_QUANTITIES_HPP__
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <mesos/mesos.hpp>
+#include <mesos/resources.hpp>
+
+namespace mesos {
+
+// The quantities of scalar resources by name (e.g., "cpus:4;mem:512"),
+// without any of the metadata of a `Resource` such as roles,
+// reservations, disks or revocability. This is meant for the scalar
+// arithmetic on the hot paths of the allocator, where `Resources`
+// would need to scan and compare protobufs for every operation.
+//
+// Resource names are interned, so the quantities are kept in a dense
+// vector indexed by name. Like `Value::Scalar` arithmetic, additions
+// and subtractions are done in fixed point (i.e., with thousandths),
+// so the quantities always equal those of the same `Resources`. Since
+// that is the case, comparisons are done on the doubles directly.
+class ResourceQuantities
+{
+public:
+  ResourceQuantities() {}
+
+  // Sums up the quantities of the scalar resources by name.
+  // Resources of other types are ignored.
+  explicit ResourceQuantities(const Resources& resources);
+
+  explicit ResourceQuantities(
+      const google::protobuf::RepeatedPtrField<Resource>& resources);
+
+  // Returns the quantity of the named resource, or 0 if there is none.
+  double get(const std::string& name) const;
+
+  // Returns the number of quantities that can be accessed by their
+  // index. The index of a resource name is the same for all
+  // instances, so quantities can be compared index by index.
+  size_t size() const { return quantities.size(); }
+
+  // Returns the quantity at 'index', or 0 if 'index' is out of range.
+  double at(size_t index) const
+  {
+    return index < quantities.size() ? quantities[index] : 0.0;
+  }
+
+  // Returns true if all quantities are zero.
+  bool empty() const;
+
+  // Returns true if every quantity is at least that of 'that'.
+  bool contains(const ResourceQuantities& that) const;
+
+  bool operator==(const ResourceQuantities& that) const;
+  bool operator!=(const ResourceQuantities& that) const;
+
+  ResourceQuantities operator+(const ResourceQuantities& that) const;
+  ResourceQuantities& operator+=(const ResourceQuantities& that);
+
+  // Like for `Resources`, quantities are not subtracted below zero.
+  ResourceQuantities operator-(const ResourceQuantities& that) const;
+  ResourceQuantities& operator-=(const ResourceQuantities& that);
+
+private:
+  friend std::ostream& operator<<(
+      std::ostream& stream,
+      const ResourceQuantities& quantities);
+
+  void add(const Resource& resource);
+
+  std::vector<double> quantities;
+};
+
+
+std::ostream& operator<<(
+    std::ostream& stream,
+    const ResourceQuantities& quantities);
+
+} // namespace mesos {
+
+#endif // __RESOURCE_QUANTITIES_HPP__
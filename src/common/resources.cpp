@@ -820,9 +820,14 @@ Resources::Resources(const RepeatedPtrField<Resource>& _resources)
 
 bool Resources::contains(const Resources& that) const
 {
+  // Copies of the same resources contain each other.
+  if (storage == that.storage) {
+    return true;
+  }
+
   Resources remaining = *this;
 
-  foreach (const Resource& resource, that.resources) {
+  foreach (const Resource& resource, that.resources()) {
     // NOTE: We use _contains because Resources only contain valid
     // Resource objects, and we don't want the performance hit of the
     // validity check.
@@ -850,7 +855,7 @@ Resources Resources::filter(
     const lambda::function<bool(const Resource&)>& predicate) const
 {
   Resources result;
-  foreach (const Resource& resource, resources) {
+  foreach (const Resource& resource, resources()) {
     if (predicate(resource)) {
       result += resource;
     }
@@ -863,7 +868,7 @@ hashmap<string, Resources> Resources::reservations() const
 {
   hashmap<string, Resources> result;
 
-  foreach (const Resource& resource, resources) {
+  foreach (const Resource& resource, resources()) {
     if (isReserved(resource)) {
       result[resource.role()] += resource;
     }
@@ -875,13 +880,21 @@ hashmap<string, Resources> Resources::reservations() const
 
 Resources Resources::reserved(const Option<string>& role) const
 {
-  return filter(lambda::bind(isReserved, lambda::_1, role));
+  if (role.isSome()) {
+    return filter(lambda::bind(isReserved, lambda::_1, role));
+  }
+
+  return aggregate(RESERVED, [this]() {
+    return filter(lambda::bind(isReserved, lambda::_1, None()));
+  });
 }
 
 
 Resources Resources::unreserved() const
 {
-  return filter(isUnreserved);
+  return aggregate(UNRESERVED, [this]() {
+    return filter(isUnreserved);
+  });
 }
 
 
@@ -893,24 +906,42 @@ Resources Resources::persistentVolumes() const
 
 Resources Resources::revocable() const
 {
-  return filter(isRevocable);
+  return aggregate(REVOCABLE, [this]() {
+    return filter(isRevocable);
+  });
 }
 
 
 Resources Resources::nonRevocable() const
 {
-  return filter(
-      [](const Resource& resource) { return !isRevocable(resource); });
+  return aggregate(NON_REVOCABLE, [this]() {
+    return filter(
+        [](const Resource& resource) { return !isRevocable(resource); });
+  });
 }
 
 
 Resources Resources::flatten(
     const string& role,
     const Option<Resource::ReservationInfo>& reservation) const
+{
+  if (role == "*" && reservation.isNone()) {
+    return aggregate(FLATTENED, [this]() {
+      return _flatten("*", None());
+    });
+  }
+
+  return _flatten(role, reservation);
+}
+
+
+Resources Resources::_flatten(
+    const string& role,
+    const Option<Resource::ReservationInfo>& reservation) const
 {
   Resources flattened;
 
-  foreach (Resource resource, resources) {
+  foreach (Resource resource, resources()) {
     resource.set_role(role);
     if (reservation.isNone()) {
       resource.clear_reservation();
@@ -928,7 +959,7 @@ Resources Resources::createStrippedScalarQuantity() const
 {
   Resources stripped;
 
-  foreach (const Resource& resource, resources) {
+  foreach (const Resource& resource, resources()) {
     if (resource.type() == Value::SCALAR) {
       Resource scalar = resource;
       scalar.clear_reservation();
@@ -1119,7 +1150,7 @@ Option<Value::Scalar> Resources::get(const string& name) const
   Value::Scalar total;
   bool found = false;
 
-  foreach (const Resource& resource, resources) {
+  foreach (const Resource& resource, resources()) {
     if (resource.name() == name &&
         resource.type() == Value::SCALAR) {
       total += resource.scalar();
@@ -1141,7 +1172,7 @@ Option<Value::Set> Resources::get(const string& name) const
   Value::Set total;
   bool found = false;
 
-  foreach (const Resource& resource, resources) {
+  foreach (const Resource& resource, resources()) {
     if (resource.name() == name &&
         resource.type() == Value::SET) {
       total += resource.set();
@@ -1163,7 +1194,7 @@ Option<Value::Ranges> Resources::get(const string& name) const
   Value::Ranges total;
   bool found = false;
 
-  foreach (const Resource& resource, resources) {
+  foreach (const Resource& resource, resources()) {
     if (resource.name() == name &&
         resource.type() == Value::RANGES) {
       total += resource.ranges();
@@ -1189,8 +1220,10 @@ Resources Resources::get(const string& name) const
 
 Resources Resources::scalars() const
 {
-  return filter([=](const Resource& resource) {
-    return resource.type() == Value::SCALAR;
+  return aggregate(SCALARS, [this]() {
+    return filter([](const Resource& resource) {
+      return resource.type() == Value::SCALAR;
+    });
   });
 }
 
@@ -1198,7 +1231,7 @@ Resources Resources::scalars() const
 set<string> Resources::names() const
 {
   set<string> result;
-  foreach (const Resource& resource, resources) {
+  foreach (const Resource& resource, resources()) {
     result.insert(resource.name());
   }
 
@@ -1209,7 +1242,7 @@ set<string> Resources::names() const
 map<string, Value_Type> Resources::types() const
 {
   map<string, Value_Type> result;
-  foreach (const Resource& resource, resources) {
+  foreach (const Resource& resource, resources()) {
     result[resource.name()] = resource.type();
   }
 
@@ -1287,9 +1320,96 @@ Option<Value::Ranges> Resources::ephemeral_ports() const
 // Private member functions.
 /////////////////////////////////////////////////
 
+Resources::Storage::Storage()
+{
+  for (size_t i = 0; i < AGGREGATES; i++) {
+    aggregates[i] = NULL;
+  }
+}
+
+
+Resources::Storage::Storage(const RepeatedPtrField<Resource>& _resources)
+  : resources(_resources)
+{
+  for (size_t i = 0; i < AGGREGATES; i++) {
+    aggregates[i] = NULL;
+  }
+}
+
+
+Resources::Storage::~Storage()
+{
+  invalidate();
+}
+
+
+void Resources::Storage::invalidate()
+{
+  for (size_t i = 0; i < AGGREGATES; i++) {
+    delete aggregates[i].exchange(NULL);
+  }
+}
+
+
+const RepeatedPtrField<Resource>& Resources::emptyResources()
+{
+  static const RepeatedPtrField<Resource>* empty =
+    new RepeatedPtrField<Resource>();
+
+  return *empty;
+}
+
+
+RepeatedPtrField<Resource>& Resources::mutableResources()
+{
+  if (!storage) {
+    storage = std::make_shared<Storage>();
+  } else if (storage.use_count() > 1) {
+    storage = std::make_shared<Storage>(storage->resources);
+  } else {
+    // The count is read without synchronizing with the (now released)
+    // copies that might have been read by other threads, hence the
+    // fence before we write to the storage.
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    storage->invalidate();
+  }
+
+  return storage->resources;
+}
+
+
+Resources Resources::aggregate(
+    Aggregate aggregate,
+    const lambda::function<Resources()>& compute) const
+{
+  if (!storage) {
+    return Resources();
+  }
+
+  std::atomic<Resources*>& cached = storage->aggregates[aggregate];
+
+  Resources* result = cached.load(std::memory_order_acquire);
+
+  if (result == NULL) {
+    Resources* computed = new Resources(compute());
+
+    // NOTE: Upon failure, 'result' is set to the aggregate that was
+    // cached by another thread in the meantime.
+    if (cached.compare_exchange_strong(result, computed)) {
+      result = computed;
+    } else {
+      delete computed;
+    }
+  }
+
+  return *result;
+}
+
+
 bool Resources::_contains(const Resource& that) const
 {
-  foreach (const Resource& resource, resources) {
+  foreach (const Resource& resource, resources()) {
     if (internal::contains(resource, that)) {
       return true;
     }
@@ -1344,7 +1464,7 @@ Option<Resources> Resources::find(const Resource& target) const
 
 Resources::operator const RepeatedPtrField<Resource>&() const
 {
-  return resources;
+  return resources();
 }
 
 
@@ -1379,6 +1499,8 @@ Resources Resources::operator+(const Resources& that) const
 Resources& Resources::operator+=(const Resource& that)
 {
   if (validate(that).isNone() && !isEmpty(that)) {
+    RepeatedPtrField<Resource>& resources = mutableResources();
+
     bool found = false;
     foreach (Resource& resource, resources) {
       if (internal::addable(resource, that)) {
@@ -1400,7 +1522,14 @@ Resources& Resources::operator+=(const Resource& that)
 
 Resources& Resources::operator+=(const Resources& that)
 {
-  foreach (const Resource& resource, that.resources) {
+  // Adding to empty resources (e.g., when summing up resources) only
+  // needs to share the Resource objects of 'that'.
+  if (empty()) {
+    storage = that.storage;
+    return *this;
+  }
+
+  foreach (const Resource& resource, that.resources()) {
     *this += resource;
   }
 
@@ -1427,10 +1556,13 @@ Resources Resources::operator-(const Resources& that) const
 Resources& Resources::operator-=(const Resource& that)
 {
   if (validate(that).isNone() && !isEmpty(that)) {
-    for (int i = 0; i < resources.size(); i++) {
-      Resource* resource = resources.Mutable(i);
+    for (int i = 0; i < resources().size(); i++) {
+      if (internal::subtractable(resources().Get(i), that)) {
+        // NOTE: Copying the Resource objects (if they are shared)
+        // preserves their order, so 'i' remains valid.
+        RepeatedPtrField<Resource>& resources = mutableResources();
 
-      if (internal::subtractable(*resource, that)) {
+        Resource* resource = resources.Mutable(i);
         *resource -= that;
 
         // Remove the resource if it becomes invalid or zero. We need
@@ -1456,7 +1588,14 @@ Resources& Resources::operator-=(const Resource& that)
 
 Resources& Resources::operator-=(const Resources& that)
 {
-  foreach (const Resource& resource, that.resources) {
+  // Subtracting resources from themselves (or from a copy of them)
+  // leaves nothing.
+  if (storage == that.storage) {
+    storage.reset();
+    return *this;
+  }
+
+  foreach (const Resource& resource, that.resources()) {
     *this -= resource;
   }
 
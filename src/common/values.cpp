@@ -35,6 +35,8 @@
 #include <stout/foreach.hpp>
 #include <stout/strings.hpp>
 
+using google::protobuf::RepeatedPtrField;
+
 using std::max;
 using std::min;
 using std::ostream;
@@ -148,13 +150,21 @@ void coalesce(Value::Ranges* result, vector<Range> ranges)
     return;
   }
 
-  std::sort(
-      ranges.begin(),
-      ranges.end(),
-      [](const Range& left, const Range& right) {
-        return std::tie(left.start, left.end) <
-               std::tie(right.start, right.end);
-      });
+  auto less = [](const Range& left, const Range& right) {
+    return std::tie(left.start, left.end) < std::tie(right.start, right.end);
+  };
+
+  // The ranges are usually the concatenation of already coalesced
+  // ranges (e.g., when adding to the ranges of a `Resource`). So we
+  // only sort the ranges after the longest sorted prefix and merge
+  // them into the prefix, which is linear if the rest is sorted too.
+  vector<Range>::iterator middle =
+    std::is_sorted_until(ranges.begin(), ranges.end(), less);
+
+  if (middle != ranges.end()) {
+    std::sort(middle, ranges.end(), less);
+    std::inplace_merge(ranges.begin(), middle, ranges.end(), less);
+  }
 
   // We build up initial state of the current range.
   CHECK(!ranges.empty());
@@ -216,6 +226,89 @@ void coalesce(Value::Ranges* result, vector<Range> ranges)
   CHECK_EQ(result->range_size(), count);
 }
 
+
+// Returns true if the ranges are coalesced, i.e., each range is valid
+// and the ranges are sorted, disjoint and not adjacent to each other.
+// This holds for the ranges of any `Resource` since we coalesce them
+// upon parsing and arithmetic, which lets us use the protobuf as an
+// interval set without copying and sorting it.
+static bool coalesced(const Value::Ranges& ranges)
+{
+  for (int i = 0; i < ranges.range_size(); i++) {
+    const Value::Range& range = ranges.range(i);
+
+    if (range.begin() > range.end()) {
+      return false;
+    }
+
+    if (i > 0 &&
+        (range.begin() == 0 ||
+         range.begin() - 1 <= ranges.range(i - 1).end())) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+// A coalesced view of the given ranges, which refers to the ranges
+// themselves if they are coalesced already and to a coalesced copy
+// otherwise. Since the view is sorted, we can find the range that
+// contains a value using binary search.
+class Intervals
+{
+public:
+  explicit Intervals(const Value::Ranges& _ranges)
+    : ranges(&_ranges)
+  {
+    if (!coalesced(_ranges)) {
+      vector<Range> copy;
+      copy.reserve(_ranges.range_size());
+
+      foreach (const Value::Range& range, _ranges.range()) {
+        copy.push_back({range.begin(), range.end()});
+      }
+
+      internal::coalesce(&coalescedRanges, std::move(copy));
+      ranges = &coalescedRanges;
+    }
+  }
+
+  Intervals(const Intervals&) = delete;
+  Intervals& operator=(const Intervals&) = delete;
+
+  const Value::Ranges& get() const { return *ranges; }
+
+  // Returns true if a single interval contains the given range. Since
+  // the intervals are not adjacent, this is the case iff the union of
+  // the intervals contains the range.
+  bool contains(const Value::Range& range) const
+  {
+    // Find the first interval that begins after the range begins, the
+    // interval before it is the only one that may contain the range.
+    auto interval = std::upper_bound(
+        ranges->range().begin(),
+        ranges->range().end(),
+        range.begin(),
+        [](uint64_t begin, const Value::Range& interval) {
+          return begin < interval.begin();
+        });
+
+    if (interval == ranges->range().begin()) {
+      return false;
+    }
+
+    --interval;
+
+    return range.end() <= interval->end();
+  }
+
+private:
+  const Value::Ranges* ranges;
+  Value::Ranges coalescedRanges;
+};
+
 } // namespace internal {
 
 
@@ -266,46 +359,70 @@ void coalesce(Value::Ranges* result, const Value::Range& addedRange)
 }
 
 
-// Removes a range from already coalesced ranges.
-// The algorithms constructs a new vector of ranges which is then
-// coalesced into a Value::Ranges instance.
-static void remove(Value::Ranges* _ranges, const Value::Range& removal)
+// Removes a range from already coalesced ranges in place. We find the
+// first affected range using binary search and then only trim, split
+// or delete the ranges that overlap with `removal`, which moves the
+// pointers of the subsequent ranges at most.
+static void remove(Value::Ranges* ranges, const Value::Range& removal)
 {
-  vector<internal::Range> ranges;
-  ranges.reserve(_ranges->range_size());
+  if (removal.begin() > removal.end()) {
+    return;
+  }
 
-  foreach (const Value::Range& range, _ranges->range()) {
-    // Skip if the entire range is subsumed by `removal`.
-    if (range.begin() >= removal.begin() && range.end() <= removal.end()) {
-      continue;
-    }
+  RepeatedPtrField<Value::Range>* field = ranges->mutable_range();
+
+  // Find the first range that ends at or after the removal begins.
+  int index = std::lower_bound(
+      field->begin(),
+      field->end(),
+      removal.begin(),
+      [](const Value::Range& range, uint64_t begin) {
+        return range.end() < begin;
+      }) - field->begin();
+
+  // Return early if the removal does not overlap with any range.
+  if (index == field->size() || field->Get(index).begin() > removal.end()) {
+    return;
+  }
 
+  Value::Range* range = field->Mutable(index);
+
+  if (range->begin() < removal.begin()) {
     // Divide if the range subsumes the `removal`.
-    if (range.begin() < removal.begin() && range.end() > removal.end()) {
-      // Front.
-      ranges.emplace_back(internal::Range{range.begin(), removal.begin() - 1});
-      // Back.
-      ranges.emplace_back(internal::Range{removal.end() + 1, range.end()});
-    }
+    if (range->end() > removal.end()) {
+      Value::Range* back = field->Add();
+      back->set_begin(removal.end() + 1);
+      back->set_end(range->end());
 
-    // Fully Emplace if the range doesn't intersect.
-    if (range.end() < removal.begin() || range.begin() > removal.end()) {
-      ranges.emplace_back(internal::Range{range.begin(), range.end()});
-    } else {
-      // Trim if the range does intersect.
-      if (range.end() > removal.end()) {
-        // Trim front.
-        ranges.emplace_back(internal::Range{removal.end() + 1, range.end()});
-      } else {
-        // Trim back.
-        CHECK(range.begin() < removal.begin());
-        ranges.emplace_back(
-            internal::Range{range.begin(), removal.begin() - 1});
+      range->set_end(removal.begin() - 1);
+
+      // Move the back right behind the front.
+      for (int i = field->size() - 1; i > index + 1; i--) {
+        field->SwapElements(i, i - 1);
       }
+
+      return;
     }
+
+    // Trim back.
+    range->set_end(removal.begin() - 1);
+    index++;
+  }
+
+  // Skip the ranges that are entirely subsumed by `removal`.
+  int end = index;
+  while (end < field->size() && field->Get(end).end() <= removal.end()) {
+    end++;
+  }
+
+  // Trim front.
+  if (end < field->size() && field->Get(end).begin() <= removal.end()) {
+    field->Mutable(end)->set_begin(removal.end() + 1);
   }
 
-  internal::coalesce(_ranges, std::move(ranges));
+  if (end > index) {
+    field->DeleteSubrange(index, end - index);
+  }
 }
 
 
@@ -325,55 +442,33 @@ ostream& operator<<(ostream& stream, const Value::Ranges& ranges)
 
 bool operator==(const Value::Ranges& _left, const Value::Ranges& _right)
 {
-  Value::Ranges left;
-  coalesce(&left, {_left});
-
-  Value::Ranges right;
-  coalesce(&right, {_right});
+  internal::Intervals left(_left);
+  internal::Intervals right(_right);
 
-  if (left.range_size() == right.range_size()) {
-    for (int i = 0; i < left.range_size(); i++) {
-      // Make sure this range is equal to a range in the right.
-      bool found = false;
-      for (int j = 0; j < right.range_size(); j++) {
-        if (left.range(i).begin() == right.range(j).begin() &&
-            left.range(i).end() == right.range(j).end()) {
-          found = true;
-          break;
-        }
-      }
+  if (left.get().range_size() != right.get().range_size()) {
+    return false;
+  }
 
-      if (!found) {
-        return false;
-      }
+  // Coalesced ranges are sorted, so we can compare them in order.
+  for (int i = 0; i < left.get().range_size(); i++) {
+    if (left.get().range(i).begin() != right.get().range(i).begin() ||
+        left.get().range(i).end() != right.get().range(i).end()) {
+      return false;
     }
-
-    return true;
   }
 
-  return false;
+  return true;
 }
 
 
-bool operator<=(const Value::Ranges& _left, const Value::Ranges& _right)
+bool operator<=(const Value::Ranges& left, const Value::Ranges& _right)
 {
-  Value::Ranges left;
-  coalesce(&left, {_left});
-
-  Value::Ranges right;
-  coalesce(&right, {_right});
+  internal::Intervals right(_right);
 
-  for (int i = 0; i < left.range_size(); i++) {
-    // Make sure this range is a subset of a range in right.
-    bool matched = false;
-    for (int j = 0; j < right.range_size(); j++) {
-      if (left.range(i).begin() >= right.range(j).begin() &&
-          left.range(i).end() <= right.range(j).end()) {
-        matched = true;
-        break;
-      }
-    }
-    if (!matched) {
+  // Make sure each range is a subset of a range in right. We do not
+  // need to coalesce left for this, see `Intervals::contains()`.
+  foreach (const Value::Range& range, left.range()) {
+    if (!right.contains(range)) {
       return false;
     }
   }
@@ -392,8 +487,7 @@ Value::Ranges operator+(const Value::Ranges& left, const Value::Ranges& right)
 
 Value::Ranges operator-(const Value::Ranges& left, const Value::Ranges& right)
 {
-  Value::Ranges result;
-  coalesce(&result, {left});
+  Value::Ranges result = left;
   return result -= right;
 }
 
@@ -407,7 +501,10 @@ Value::Ranges& operator+=(Value::Ranges& left, const Value::Ranges& right)
 
 Value::Ranges& operator-=(Value::Ranges& left, const Value::Ranges& right)
 {
-  coalesce(&left);
+  if (!internal::coalesced(left)) {
+    coalesce(&left);
+  }
+
   for (int i = 0; i < right.range_size(); ++i) {
     remove(&left, right.range(i));
   }
@@ -22,6 +22,7 @@
 
 #include <algorithm>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -33,9 +34,11 @@
 #include <process/help.hpp>
 #include <process/http.hpp>
 #include <process/io.hpp>
+#include <process/limiter.hpp>
 #include <process/mime.hpp>
 #include <process/process.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/error.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/json.hpp>
@@ -62,6 +65,8 @@ using process::TLDR;
 using process::USAGE;
 using process::wait; // Necessary on some OS's to disambiguate.
 
+using process::RateLimiter;
+
 using process::http::BadRequest;
 using process::http::InternalServerError;
 using process::http::NotFound;
@@ -80,7 +85,9 @@ namespace internal {
 class FilesProcess : public Process<FilesProcess>
 {
 public:
-  FilesProcess(const Option<string>& _authenticationRealm);
+  FilesProcess(
+      const Option<string>& _authenticationRealm,
+      const Option<Bytes>& bandwidthLimit);
 
   // Files implementation.
   Future<Nothing> attach(const string& path, const string& name);
@@ -109,7 +116,10 @@ private:
       const Option<string>& principal);
 
   // Reads data from a file at a given offset and for a given length.
-  // See the jquery pailer for the expected behavior.
+  // See the jquery pailer for the expected behavior. With 'raw=true'
+  // the data is sent as is (using 'sendfile'), in a '206 Partial
+  // Content' response whose 'Content-Range' header holds the offset
+  // and the size of the file.
   Future<Response> read(
       const Request& request,
       const Option<string>& principal);
@@ -117,6 +127,7 @@ private:
   // Returns the raw file contents for a given path.
   // Requests have the following parameters:
   //   path: The directory to browse. Required.
+  // A single range may be requested with the 'Range' header.
   Future<Response> download(
       const Request& request,
       const Option<string>& principal);
@@ -133,15 +144,27 @@ private:
 
   hashmap<string, string> paths;
 
+  // Limits the bandwidth of the file contents sent by 'read' (in raw
+  // mode) and 'download', if a limit is set. Shared with libprocess,
+  // which acquires a permit per byte before sending it.
+  std::shared_ptr<RateLimiter> limiter;
+
   // The authentication realm, if any, into which this process'
   // endpoints will be installed.
   Option<string> authenticationRealm;
 };
 
 
-FilesProcess::FilesProcess(const Option<string>& _authenticationRealm)
+FilesProcess::FilesProcess(
+    const Option<string>& _authenticationRealm,
+    const Option<Bytes>& bandwidthLimit)
   : ProcessBase("files"),
-    authenticationRealm(_authenticationRealm) {}
+    authenticationRealm(_authenticationRealm)
+{
+  if (bandwidthLimit.isSome() && bandwidthLimit.get() > Bytes(0)) {
+    limiter.reset(new RateLimiter(double(bandwidthLimit.get().bytes())));
+  }
+}
 
 
 void FilesProcess::initialize()
@@ -334,7 +357,9 @@ const string FilesProcess::READ_HELP = HELP(
         ">        path=VALUE          The path of directory to browse.",
         ">        offset=VALUE        Value added to base address to obtain "
         "a second address",
-        ">        length=VALUE        Length of file to read."));
+        ">        length=VALUE        Length of file to read.",
+        ">        raw=true            Return the data as is, in a "
+        "'206 Partial Content' response."));
 
 
 Future<Response> FilesProcess::read(
@@ -385,6 +410,39 @@ Future<Response> FilesProcess::read(
     return BadRequest("Cannot read a directory.\n");
   }
 
+  // In raw mode libprocess sends the data straight from the file
+  // (using 'sendfile'), so it is neither copied nor JSON encoded.
+  if (request.url.query.get("raw") == string("true")) {
+    Try<Bytes> size = os::stat::size(resolvedPath.get());
+
+    if (size.isError()) {
+      string error = strings::format(
+          "Failed to get the size of file at '%s': %s",
+          resolvedPath.get(),
+          size.error()).get();
+
+      LOG(WARNING) << error;
+      return InternalServerError(error + ".\n");
+    }
+
+    Response response(process::http::Status::PARTIAL_CONTENT);
+    response.type = Response::PATH;
+    response.path = resolvedPath.get();
+    response.headers["Content-Type"] = "application/octet-stream";
+
+    // As in JSON mode, nothing but the size of the file is returned
+    // if no offset is given.
+    response.offset = offset < 0 ? size.get().bytes() : offset;
+
+    if (length >= 0) {
+      response.length = length;
+    }
+
+    response.limiter = limiter;
+
+    return response;
+  }
+
   // TODO(benh): Cache file descriptors so we aren't constantly
   // opening them and paging the data in from disk.
   Try<int> fd = os::open(resolvedPath.get(), O_RDONLY | O_CLOEXEC);
@@ -472,7 +530,8 @@ const string FilesProcess::DOWNLOAD_HELP = HELP(
         "Returns the raw file contents for a given path."),
     DESCRIPTION(
         "This endpoint will return the raw file contents for the",
-        "given path.",
+        "given path. A single range of the file can be requested",
+        "using the 'Range' header.",
         "",
         "Query parameters:",
         "",
@@ -507,6 +566,7 @@ Future<Response> FilesProcess::download(
   OK response;
   response.type = response.PATH;
   response.path = resolvedPath.get();
+  response.limiter = limiter;
   response.headers["Content-Type"] = "application/octet-stream";
   response.headers["Content-Disposition"] =
     strings::format("attachment; filename=%s", basename).get();
@@ -609,9 +669,11 @@ Result<string> FilesProcess::resolve(const string& path)
 }
 
 
-Files::Files(const Option<string>& authenticationRealm)
+Files::Files(
+    const Option<string>& authenticationRealm,
+    const Option<Bytes>& bandwidthLimit)
 {
-  process = new FilesProcess(authenticationRealm);
+  process = new FilesProcess(authenticationRealm, bandwidthLimit);
   spawn(process);
 }
 
@@ -32,6 +32,7 @@
 #include <process/future.hpp>
 #include <process/http.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/format.hpp>
 #include <stout/json.hpp>
 #include <stout/nothing.hpp>
@@ -59,7 +60,11 @@ class FilesProcess;
 class Files
 {
 public:
-  Files(const Option<std::string>& authenticationRealm = None());
+  // If a 'bandwidthLimit' is given, serving file contents via the
+  // raw '/read' and the '/download' endpoints is limited to the
+  // bandwidth, in Bytes per second, across all requests.
+  Files(const Option<std::string>& authenticationRealm = None(),
+        const Option<Bytes>& bandwidthLimit = None());
   ~Files();
 
   // Returns the result of trying to attach the specified path
@@ -55,7 +55,8 @@ public:
           void(const FrameworkID&,
                const hashmap<SlaveID, UnavailableResources>&)>&
         inverseOfferCallback,
-      const hashmap<std::string, double>& weights);
+      const hashmap<std::string, double>& weights,
+      const mesos::master::allocator::Options& options);
 
   void recover(
       const int expectedAgentCount,
@@ -182,7 +183,8 @@ public:
           void(const FrameworkID&,
                const hashmap<SlaveID, UnavailableResources>&)>&
         inverseOfferCallback,
-      const hashmap<std::string, double>& weights) = 0;
+      const hashmap<std::string, double>& weights,
+      const mesos::master::allocator::Options& options) = 0;
 
   virtual void recover(
       const int expectedAgentCount,
@@ -317,7 +319,8 @@ inline void MesosAllocator<AllocatorProcess>::initialize(
         void(const FrameworkID&,
               const hashmap<SlaveID, UnavailableResources>&)>&
       inverseOfferCallback,
-    const hashmap<std::string, double>& weights)
+    const hashmap<std::string, double>& weights,
+    const mesos::master::allocator::Options& options)
 {
   process::dispatch(
       process,
@@ -325,7 +328,8 @@ inline void MesosAllocator<AllocatorProcess>::initialize(
       allocationInterval,
       offerCallback,
       inverseOfferCallback,
-      weights);
+      weights,
+      options);
 }
 
 
@@ -22,11 +22,15 @@
 #include <mesos/resources.hpp>
 #include <mesos/type_utils.hpp>
 
+#include <process/clock.hpp>
 #include <process/event.hpp>
 #include <process/delay.hpp>
+#include <process/dispatch.hpp>
 #include <process/id.hpp>
+#include <process/time.hpp>
 #include <process/timeout.hpp>
 
+#include <stout/abort.hpp>
 #include <stout/check.hpp>
 #include <stout/hashset.hpp>
 #include <stout/stopwatch.hpp>
@@ -37,8 +41,10 @@ using std::vector;
 
 using mesos::master::InverseOfferStatus;
 
+using process::Clock;
 using process::Failure;
 using process::Future;
+using process::Time;
 using process::Timeout;
 
 namespace mesos {
@@ -54,13 +60,19 @@ public:
   virtual ~OfferFilter() {}
 
   virtual bool filter(const Resources& resources) = 0;
+
+  // Returns true if this filter filters whatever the other filter
+  // does, at least for as long as the other filter is active. Such
+  // an other filter is redundant.
+  virtual bool covers(const OfferFilter& other) = 0;
 };
 
 
 class RefusedOfferFilter : public OfferFilter
 {
 public:
-  RefusedOfferFilter(const Resources& _resources) : resources(_resources) {}
+  RefusedOfferFilter(const Resources& _resources, const Time& _expiry)
+    : resources(_resources), expiry(_expiry) {}
 
   virtual bool filter(const Resources& _resources)
   {
@@ -72,8 +84,19 @@ public:
     return resources.contains(_resources); // Refused resources are superset.
   }
 
+  virtual bool covers(const OfferFilter& other)
+  {
+    const RefusedOfferFilter* refused =
+      dynamic_cast<const RefusedOfferFilter*>(&other);
+
+    return refused != NULL &&
+           expiry >= refused->expiry &&
+           resources.contains(refused->resources);
+  }
+
 private:
   const Resources resources;
+  const Time expiry;
 };
 
 
@@ -114,6 +137,47 @@ private:
 };
 
 
+// The resources available for allocation on an agent, i.e., its total
+// minus its allocated resources, split by their reservation.
+struct Available
+{
+  Available() {}
+
+  Available(const Resources& total, const Resources& allocated)
+  {
+    const Resources available = total - allocated;
+
+    unreserved = available.unreserved();
+
+    foreach (const Resource& resource, available.reserved()) {
+      reserved[resource.role()] += resource;
+    }
+  }
+
+  // Returns the available resources reserved for `role`.
+  Resources reservedFor(const string& role) const
+  {
+    return reserved.get(role).getOrElse(Resources());
+  }
+
+  Resources unreserved;
+  hashmap<string, Resources> reserved;
+};
+
+
+HierarchicalAllocatorProcess::~HierarchicalAllocatorProcess()
+{
+  foreachvalue (const vector<OfferFilterExpiry>& expiries,
+                offerFilterExpiries) {
+    foreach (const OfferFilterExpiry& expiry, expiries) {
+      delete expiry.offerFilter;
+    }
+  }
+
+  delete agentSorter;
+}
+
+
 void HierarchicalAllocatorProcess::initialize(
     const Duration& _allocationInterval,
     const lambda::function<
@@ -123,23 +187,39 @@ void HierarchicalAllocatorProcess::initialize(
         void(const FrameworkID&,
              const hashmap<SlaveID, UnavailableResources>&)>&
       _inverseOfferCallback,
-    const hashmap<string, double>& _weights)
+    const hashmap<string, double>& _weights,
+    const mesos::master::allocator::Options& options)
 {
   allocationInterval = _allocationInterval;
+  allocationWindow = options.allocationWindow;
   offerCallback = _offerCallback;
   inverseOfferCallback = _inverseOfferCallback;
   weights = _weights;
   initialized = true;
   paused = false;
 
+  // NOTE: The master validates `--agent_ordering` on startup.
+  Try<AgentSorter*> _agentSorter = AgentSorter::create(options.agentOrdering);
+  CHECK_SOME(_agentSorter)
+    << "Failed to create the agent sorter for '" << options.agentOrdering
+    << "'";
+
+  agentSorter = _agentSorter.get();
+
+  // Offer filters are expired at a granularity of (at most) 100ms,
+  // see `offerFilterExpiries`. Filters are active for at least an
+  // `allocationInterval` anyway (see `recoverResources()`).
+  offerFilterEpoch = Clock::now();
+  offerFilterTick = std::max<Duration>(
+      std::min<Duration>(allocationInterval, Milliseconds(100)),
+      Milliseconds(1));
+
   // Resources for quota'ed roles are allocated separately and prior to
   // non-quota'ed roles, hence a dedicated sorter for quota'ed roles is
-  // necessary. We create an instance of the same sorter type we use for
-  // all roles.
-  //
-  // TODO(alexr): Consider introducing a sorter type for quota'ed roles.
+  // necessary. We sort the quota'ed roles with an instance of the same
+  // sorter type we use for all roles, omitting satisfied roles.
   roleSorter = roleSorterFactory();
-  quotaRoleSorter = roleSorterFactory();
+  quotaRoleSorter = new QuotaSorter(roleSorterFactory());
 
   VLOG(1) << "Initialized hierarchical allocator process";
 
@@ -265,7 +345,7 @@ void HierarchicalAllocatorProcess::addFramework(
 
   LOG(INFO) << "Added framework " << frameworkId;
 
-  allocate();
+  allocate(frameworkId);
 }
 
 
@@ -325,6 +405,7 @@ void HierarchicalAllocatorProcess::removeFramework(
   // HierarchicalAllocatorProcess::reviveOffers and
   // HierarchicalAllocatorProcess::expire.
   frameworks.erase(frameworkId);
+  frameworkCandidates.erase(frameworkId);
 
   LOG(INFO) << "Removed framework " << frameworkId;
 }
@@ -343,7 +424,7 @@ void HierarchicalAllocatorProcess::activateFramework(
 
   LOG(INFO) << "Activated framework " << frameworkId;
 
-  allocate();
+  allocate(frameworkId);
 }
 
 
@@ -399,6 +480,10 @@ void HierarchicalAllocatorProcess::updateFramework(
       frameworks[frameworkId].revocable = true;
     }
   }
+
+  // The framework might now accept revocable resources that it was not
+  // offered before, which the next batch allocation takes care of.
+  frameworkCandidates.insert(frameworkId);
 }
 
 
@@ -448,6 +533,9 @@ void HierarchicalAllocatorProcess::addSlave(
   slaves[slaveId].activated = true;
   slaves[slaveId].hostname = slaveInfo.hostname();
 
+  agentSorter->add(slaveId, slaveInfo);
+  agentSorter->update(slaveId, total, slaves[slaveId].allocated);
+
   // NOTE: We currently implement maintenance in the allocator to be able to
   // leverage state and features such as the FrameworkSorter and OfferFilter.
   if (unavailability.isSome()) {
@@ -498,7 +586,10 @@ void HierarchicalAllocatorProcess::removeSlave(
   // See comment at `quotaRoleSorter` declaration regarding non-revocable.
   quotaRoleSorter->remove(slaveId, slaves[slaveId].total.nonRevocable());
 
+  agentSorter->remove(slaveId);
+
   slaves.erase(slaveId);
+  allocationCandidates.erase(slaveId);
 
   // Note that we DO NOT actually delete any filters associated with
   // this slave, that will occur when the delayed
@@ -525,6 +616,9 @@ void HierarchicalAllocatorProcess::updateSlave(
   // add the new estimate of oversubscribed resources.
   slaves[slaveId].total = slaves[slaveId].total.nonRevocable() + oversubscribed;
 
+  agentSorter->update(
+      slaveId, slaves[slaveId].total, slaves[slaveId].allocated);
+
   // Now, update the total resources in the role sorters.
   roleSorter->update(slaveId, slaves[slaveId].total);
 
@@ -548,6 +642,9 @@ void HierarchicalAllocatorProcess::activateSlave(
 
   slaves[slaveId].activated = true;
 
+  // Offer the slave's resources in the next batch allocation.
+  allocationCandidates.insert(slaveId);
+
   LOG(INFO)<< "Slave " << slaveId << " reactivated";
 }
 
@@ -580,6 +677,10 @@ void HierarchicalAllocatorProcess::updateWhitelist(
   } else {
     LOG(INFO) << "Advertising offers for all slaves";
   }
+
+  // Offer the resources of newly whitelisted slaves in the next batch
+  // allocation.
+  sweep = true;
 }
 
 
@@ -653,6 +754,9 @@ void HierarchicalAllocatorProcess::updateAllocation(
 
   slaves[slaveId].total = updatedTotal.get();
 
+  agentSorter->update(
+      slaveId, slaves[slaveId].total, slaves[slaveId].allocated);
+
   LOG(INFO) << "Updated allocation of framework " << frameworkId
             << " on slave " << slaveId
             << " from " << frameworkAllocation
@@ -692,12 +796,18 @@ Future<Nothing> HierarchicalAllocatorProcess::updateAvailable(
 
   slaves[slaveId].total = updatedTotal.get();
 
+  agentSorter->update(
+      slaveId, slaves[slaveId].total, slaves[slaveId].allocated);
+
   // Now, update the total resources in the role sorters.
   roleSorter->update(slaveId, slaves[slaveId].total);
 
   // See comment at `quotaRoleSorter` declaration regarding non-revocable.
   quotaRoleSorter->update(slaveId, slaves[slaveId].total.nonRevocable());
 
+  // Offer the updated resources in the next batch allocation.
+  allocationCandidates.insert(slaveId);
+
   return Nothing();
 }
 
@@ -759,6 +869,7 @@ void HierarchicalAllocatorProcess::updateInverseOffer(
     // We always remove the outstanding offer so that we will send a new offer
     // out the next time we schedule inverse offers.
     maintenance.offersOutstanding.erase(frameworkId);
+    allocationCandidates.insert(slaveId);
 
     // If the response is `Some`, this means the framework responded. Otherwise
     // if it is `None` the inverse offer timed out or was rescinded.
@@ -890,11 +1001,19 @@ void HierarchicalAllocatorProcess::recoverResources(
 
     slaves[slaveId].allocated -= resources;
 
+    agentSorter->update(
+        slaveId, slaves[slaveId].total, slaves[slaveId].allocated);
+
     VLOG(1) << "Recovered " << resources
             << " (total: " << slaves[slaveId].total
             << ", allocated: " << slaves[slaveId].allocated
             << ") on slave " << slaveId
             << " from framework " << frameworkId;
+
+    // Offer the recovered resources in the next batch allocation. We do
+    // not allocate them right away, since most are recovered because a
+    // framework declined them.
+    allocationCandidates.insert(slaveId);
   }
 
   // No need to install the filter if 'filters' is none.
@@ -931,17 +1050,6 @@ void HierarchicalAllocatorProcess::recoverResources(
             << " filtered slave " << slaveId
             << " for " << timeout.get();
 
-    // Create a new filter.
-    OfferFilter* offerFilter = new RefusedOfferFilter(resources);
-    frameworks[frameworkId].offerFilters[slaveId].insert(offerFilter);
-
-    // We need to disambiguate the function call to pick the correct
-    // expire() overload.
-    void (Self::*expireOffer)(
-              const FrameworkID&,
-              const SlaveID&,
-              OfferFilter*) = &Self::expire;
-
     // Expire the filter after both an `allocationInterval` and the
     // `timeout` have elapsed. This ensures that the filter does not
     // expire before we perform the next allocation for this agent,
@@ -951,12 +1059,51 @@ void HierarchicalAllocatorProcess::recoverResources(
     // (MESOS-3078), we would not need to increase the timeout here.
     timeout = std::max(allocationInterval, timeout.get());
 
-    delay(timeout.get(),
-          self(),
-          expireOffer,
-          frameworkId,
-          slaveId,
-          offerFilter);
+    // Round the expiry up to the next tick of the expiry wheel, so
+    // that the filter does not expire early.
+    const int64_t ticks = offerFilterTick.ns();
+    const int64_t tick =
+      ((Clock::now() + timeout.get() - offerFilterEpoch).ns() + ticks - 1) /
+      ticks;
+
+    const Time expiry = offerFilterEpoch + Nanoseconds(tick * ticks);
+
+    // Create a new filter, unless an existing filter covers it.
+    OfferFilter* offerFilter = new RefusedOfferFilter(resources, expiry);
+
+    hashset<OfferFilter*>& offerFilters =
+      frameworks[frameworkId].offerFilters[slaveId];
+
+    foreach (OfferFilter* existing, offerFilters) {
+      if (existing->covers(*offerFilter)) {
+        delete offerFilter;
+        return;
+      }
+    }
+
+    // Remove the existing filters the new filter covers. These are
+    // deleted upon their expiry, see `expire()`.
+    vector<OfferFilter*> covered;
+    foreach (OfferFilter* existing, offerFilters) {
+      if (offerFilter->covers(*existing)) {
+        covered.push_back(existing);
+      }
+    }
+
+    foreach (OfferFilter* existing, covered) {
+      offerFilters.erase(existing);
+    }
+
+    offerFilters.insert(offerFilter);
+
+    if (!offerFilterExpiries.contains(tick)) {
+      delay(expiry - Clock::now(),
+            self(),
+            &Self::expireOfferFilters,
+            tick);
+    }
+
+    offerFilterExpiries[tick].push_back({frameworkId, slaveId, offerFilter});
   }
 }
 
@@ -990,7 +1137,7 @@ void HierarchicalAllocatorProcess::reviveOffers(
 
   LOG(INFO) << "Removed offer filters for framework " << frameworkId;
 
-  allocate();
+  allocate(frameworkId);
 }
 
 
@@ -1010,6 +1157,8 @@ void HierarchicalAllocatorProcess::setQuota(
   // allocation group.
   quotas[role] = quota;
   quotaRoleSorter->add(role, roleWeight(role));
+  quotaRoleSorter->guarantee(
+      role, ResourceQuantities(quota.info.guarantee()));
 
   // Copy allocation information for the quota'ed role.
   if (roleSorter->contains(role)) {
@@ -1110,68 +1259,123 @@ void HierarchicalAllocatorProcess::resume()
     VLOG(1) << "Allocation resumed";
 
     paused = false;
+    sweep = true;
   }
 }
 
 
 void HierarchicalAllocatorProcess::batch()
 {
-  allocate();
+  // Most allocations are triggered by the events which make resources
+  // allocatable, see `allocate()`. Here we only allocate the slaves and
+  // frameworks which changed without triggering an allocation, e.g.,
+  // because resources were recovered, and all slaves if we `sweep`.
+  // Hence a cluster where nothing changes is not allocated at all.
+  if (sweep) {
+    allocationCandidates = slaves.keys();
+  }
+
+  _allocate();
+
   delay(allocationInterval, self(), &Self::batch);
 }
 
 
 void HierarchicalAllocatorProcess::allocate()
 {
-  if (paused) {
-    VLOG(1) << "Skipped allocation because the allocator is paused";
+  allocationCandidates = slaves.keys();
 
-    return;
-  }
+  scheduleAllocation();
+}
 
-  Stopwatch stopwatch;
-  stopwatch.start();
 
-  metrics.allocation_run.start();
+void HierarchicalAllocatorProcess::allocate(
+    const SlaveID& slaveId)
+{
+  allocationCandidates.insert(slaveId);
 
-  allocate(slaves.keys());
+  scheduleAllocation();
+}
 
-  metrics.allocation_run.stop();
 
-  VLOG(1) << "Performed allocation for " << slaves.size() << " slaves in "
-            << stopwatch.elapsed();
+void HierarchicalAllocatorProcess::allocate(
+    const FrameworkID& frameworkId)
+{
+  frameworkCandidates.insert(frameworkId);
+
+  scheduleAllocation();
 }
 
 
-void HierarchicalAllocatorProcess::allocate(
-    const SlaveID& slaveId)
+void HierarchicalAllocatorProcess::scheduleAllocation()
 {
+  if (allocationScheduled) {
+    return;
+  }
+
+  allocationScheduled = true;
+
+  // NOTE: Even without a window, we dispatch the allocation so that it
+  // coalesces with the events which are already queued up.
+  if (allocationWindow == Duration::zero()) {
+    dispatch(self(), &Self::_allocate);
+  } else {
+    delay(allocationWindow, self(), &Self::_allocate);
+  }
+}
+
+
+void HierarchicalAllocatorProcess::_allocate()
+{
+  allocationScheduled = false;
+
   if (paused) {
     VLOG(1) << "Skipped allocation because the allocator is paused";
 
     return;
   }
 
+  // NOTE: A batch allocation might have already performed the
+  // scheduled allocation.
+  if (allocationCandidates.empty() && frameworkCandidates.empty()) {
+    return;
+  }
+
   Stopwatch stopwatch;
   stopwatch.start();
+
   metrics.allocation_run.start();
 
-  hashset<SlaveID> slaves({slaveId});
-  allocate(slaves);
+  hashset<SlaveID> slaveIds;
+  hashset<FrameworkID> frameworkIds;
+  std::swap(slaveIds, allocationCandidates);
+  std::swap(frameworkIds, frameworkCandidates);
+
+  allocate(slaveIds, frameworkIds);
+
+  // See the comment on `sweep`.
+  if (slaveIds.size() == slaves.size()) {
+    sweep = false;
+  } else if (!quotas.empty()) {
+    sweep = true;
+  }
 
   metrics.allocation_run.stop();
 
-  VLOG(1) << "Performed allocation for slave " << slaveId << " in "
-          << stopwatch.elapsed();
+  VLOG(1) << "Performed allocation for " << slaveIds.size() << " slaves and "
+          << frameworkIds.size() << " frameworks in " << stopwatch.elapsed();
 }
 
 
 // TODO(alexr): Consider factoring out the quota allocation logic.
 void HierarchicalAllocatorProcess::allocate(
-    const hashset<SlaveID>& slaveIds_)
+    const hashset<SlaveID>& slaveIds_,
+    const hashset<FrameworkID>& frameworkIds)
 {
   ++metrics.allocation_runs;
 
+  metrics.allocation_run_snapshot.start();
+
   // Compute the offerable resources, per framework:
   //   (1) For reserved resources on the slave, allocate these to a
   //       framework having the corresponding role.
@@ -1182,55 +1386,76 @@ void HierarchicalAllocatorProcess::allocate(
   // NOTE: This function can operate on a small subset of slaves, we have to
   // make sure that we don't assume cluster knowledge when summing resources
   // from that set.
+  //
+  // We offer the resources of the slaves in `slaveIds_` to all frameworks,
+  // while `frameworkIds` are offered the resources of all slaves. Other
+  // frameworks have already been offered the resources of other slaves,
+  // so we skip them (see `allocationCandidates`).
+  const hashset<SlaveID> candidates =
+    frameworkIds.empty() ? slaveIds_ : slaves.keys();
+
+  // The roles of `frameworkIds`, which we skip otherwise.
+  hashset<string> roles;
+  foreach (const FrameworkID& frameworkId, frameworkIds) {
+    roles.insert(frameworks[frameworkId].role);
+  }
 
   vector<SlaveID> slaveIds;
-  slaveIds.reserve(slaveIds_.size());
+  slaveIds.reserve(candidates.size());
 
   // Filter out non-whitelisted and deactivated slaves in order not to send
   // offers for them.
-  foreach (const SlaveID& slaveId, slaveIds_) {
+  foreach (const SlaveID& slaveId, candidates) {
     if (isWhitelisted(slaveId) && slaves[slaveId].activated) {
       slaveIds.push_back(slaveId);
     }
   }
 
-  // Randomize the order in which slaves' resources are allocated.
-  //
-  // TODO(vinod): Implement a smarter sorting algorithm.
-  std::random_shuffle(slaveIds.begin(), slaveIds.end());
-
-  // Returns the __quantity__ of resources allocated to a quota role. Since we
-  // account for reservations and persistent volumes toward quota, we strip
-  // reservation and persistent volume related information for comparability.
-  // The result is used to determine whether a role's quota is satisfied, and
-  // also to determine how many resources the role would need in order to meet
-  // its quota.
-  //
-  // NOTE: Revocable resources are excluded in `quotaRoleSorter`.
-  auto getQuotaRoleAllocatedResources = [this](const string& role) {
-    CHECK(quotas.contains(role));
+  // Order the slaves whose resources are allocated, e.g., randomly or
+  // to bin-pack them, see `AgentSorter`.
+  agentSorter->sort(&slaveIds);
 
-    // NOTE: `allocationScalarQuantities` omits dynamic reservation and
-    // persistent volume info, but we additionally strip `role` here.
-    Resources resources;
+  // Whether the resources of a slave, by index into `slaveIds`, are
+  // offered to all frameworks, or only to `frameworkIds`.
+  vector<bool> all(slaveIds.size());
+  for (size_t i = 0; i < slaveIds.size(); i++) {
+    all[i] = slaveIds_.contains(slaveIds[i]);
+  }
 
-    foreach (Resource resource,
-             quotaRoleSorter->allocationScalarQuantities(role)) {
-      CHECK(!resource.has_reservation());
-      CHECK(!resource.has_disk());
+  // The resources available on each slave, by index into `slaveIds`.
+  // These are computed once per slave here, rather than for every
+  // (slave, framework) pair below, and only recomputed for a slave
+  // after allocating on it.
+  vector<Available> available;
+  available.reserve(slaveIds.size());
 
-      resource.set_role("*");
-      resources += resource;
-    }
+  foreach (const SlaveID& slaveId, slaveIds) {
+    const Slave& slave = slaves.at(slaveId);
+    available.push_back(Available(slave.total, slave.allocated));
+  }
+
+  metrics.allocation_run_snapshot.stop();
 
-    return resources;
-  };
+  metrics.allocation_run_quota.start();
 
   // Quota comes first and fair share second. Here we process only those
   // roles, for which quota is set (quota'ed roles). Such roles form a
   // special allocation group with a dedicated sorter.
-  foreach (const SlaveID& slaveId, slaveIds) {
-    foreach (const string& role, quotaRoleSorter->sort()) {
+  //
+  // NOTE: The quota role sorter only returns the roles whose quota is not
+  // satisfied. If the quota of a role is satisfied, we do not need to do
+  // any further allocations for this role, at least at this stage.
+  for (size_t i = 0; i < slaveIds.size(); i++) {
+    const SlaveID& slaveId = slaveIds[i];
+
+    const vector<string>& quotaRoles = quotaRoleSorter->sorted();
+
+    // Once all quotas are satisfied, there is nothing left to do.
+    if (quotaRoles.empty()) {
+      break;
+    }
+
+    foreach (const string& role, quotaRoles) {
       CHECK(quotas.contains(role));
 
       // If there are no active frameworks in this role, we do not
@@ -1239,51 +1464,42 @@ void HierarchicalAllocatorProcess::allocate(
         continue;
       }
 
-      // Get the total quantity of resources allocated to a quota role. The
-      // value omits role, reservation, and persistence info.
-      Resources roleConsumedResources = getQuotaRoleAllocatedResources(role);
-
-      // If quota for the role is satisfied, we do not need to do any further
-      // allocations for this role, at least at this stage.
-      //
-      // TODO(alexr): Skipping satisfied roles is pessimistic. Better
-      // alternatives are:
-      //   * A custom sorter that is aware of quotas and sorts accordingly.
-      //   * Removing satisfied roles from the sorter.
-      if (roleConsumedResources.contains(quotas[role].info.guarantee())) {
+      if (!all[i] && !roles.contains(role)) {
         continue;
       }
 
+      // The resources we offer are the unreserved resources as well as the
+      // reserved resources for this particular role. This is necessary to
+      // ensure that we don't offer resources that are reserved for another
+      // role.
+      //
+      // NOTE: Currently, frameworks are allowed to have '*' role.
+      // There are no resources reserved for '*'.
+      //
+      // Quota is satisfied from the available non-revocable resources on the
+      // agent. It's important that we include reserved resources here since
+      // reserved resources are accounted towards the quota guarantee. If we
+      // were to rely on stage 2 to offer them out, they would not be checked
+      // against the quota guarantee.
+      Resources resources =
+        (available[i].unreserved + available[i].reservedFor(role))
+          .nonRevocable();
+
       // Fetch frameworks according to their fair share.
-      foreach (const string& frameworkId_, frameworkSorters[role]->sort()) {
+      foreach (const string& frameworkId_, frameworkSorters[role]->sorted()) {
         FrameworkID frameworkId;
         frameworkId.set_value(frameworkId_);
 
+        if (!all[i] && !frameworkIds.contains(frameworkId)) {
+          continue;
+        }
+
         // If the framework has suppressed offers, ignore. The Unallocated
         // part of the quota will not be allocated to other roles.
         if (frameworks[frameworkId].suppressed) {
           continue;
         }
 
-        // Calculate the currently available resources on the slave.
-        Resources available = slaves[slaveId].total - slaves[slaveId].allocated;
-
-        // The resources we offer are the unreserved resources as well as the
-        // reserved resources for this particular role. This is necessary to
-        // ensure that we don't offer resources that are reserved for another
-        // role.
-        //
-        // NOTE: Currently, frameworks are allowed to have '*' role.
-        // Calling reserved('*') returns an empty Resources object.
-        //
-        // Quota is satisfied from the available non-revocable resources on the
-        // agent. It's important that we include reserved resources here since
-        // reserved resources are accounted towards the quota guarantee. If we
-        // were to rely on stage 2 to offer them out, they would not be checked
-        // against the quota guarantee.
-        Resources resources =
-          (available.unreserved() + available.reserved(role)).nonRevocable();
-
         // It is safe to break here, because all frameworks under a role would
         // consider the same resources, so in case we don't have allocatable
         // resources, we don't have to check for other frameworks under the
@@ -1312,6 +1528,9 @@ void HierarchicalAllocatorProcess::allocate(
         offerable[frameworkId][slaveId] += resources;
         slaves[slaveId].allocated += resources;
 
+        agentSorter->update(
+            slaveId, slaves[slaveId].total, slaves[slaveId].allocated);
+
         // Resources allocated as part of the quota count towards the
         // role's and the framework's fair share.
         //
@@ -1320,38 +1539,49 @@ void HierarchicalAllocatorProcess::allocate(
         frameworkSorters[role]->allocated(frameworkId_, slaveId, resources);
         roleSorter->allocated(role, slaveId, resources);
         quotaRoleSorter->allocated(role, slaveId, resources);
+
+        available[i] =
+          Available(slaves[slaveId].total, slaves[slaveId].allocated);
+
+        resources =
+          (available[i].unreserved + available[i].reservedFor(role))
+            .nonRevocable();
       }
     }
   }
 
+  metrics.allocation_run_quota.stop();
+
+  metrics.allocation_run_fair_share.start();
+
   // Calculate the total quantity of scalar resources (including revocable
   // and reserved) that are available for allocation in the next round. We
   // need this in order to ensure we do not over-allocate resources during
   // the second stage.
   //
-  // For performance reasons (MESOS-4833), this omits information about
-  // dynamic reservations or persistent volumes in the resources.
+  // For performance reasons (MESOS-4833), these are the quantities of the
+  // resources only, i.e., they omit information about roles, reservations or
+  // persistent volumes.
   //
   // NOTE: We use total cluster resources, and not just those based on the
   // agents participating in the current allocation (i.e. provided as an
   // argument to the `allocate()` call) so that frameworks in roles without
   // quota are not unnecessarily deprived of resources.
-  Resources remainingClusterResources = roleSorter->totalScalarQuantities();
+  ResourceQuantities remainingClusterResources =
+    roleSorter->totalScalarQuantities();
   foreachkey (const string& role, activeRoles) {
     remainingClusterResources -= roleSorter->allocationScalarQuantities(role);
   }
 
   // Frameworks in a quota'ed role may temporarily reject resources by
   // filtering or suppressing offers. Hence quotas may not be fully allocated.
-  Resources unallocatedQuotaResources;
-  foreachpair (const string& name, const Quota& quota, quotas) {
-    // Compute the amount of quota that the role does not have allocated.
+  ResourceQuantities unallocatedQuotaResources;
+  foreachkey (const string& name, quotas) {
+    // Add the amount of quota that the role does not have allocated.
     //
     // NOTE: Revocable resources are excluded in `quotaRoleSorter`.
     // NOTE: Only scalars are considered for quota.
-    Resources allocated = getQuotaRoleAllocatedResources(name);
-    const Resources required = quota.info.guarantee();
-    unallocatedQuotaResources += (required - allocated);
+    unallocatedQuotaResources += quotaRoleSorter->remaining(name);
   }
 
   // Determine how many resources we may allocate during the next stage.
@@ -1369,52 +1599,60 @@ void HierarchicalAllocatorProcess::allocate(
   //     (`allocatedStage2` + potential offer). In this case we skip this
   //     agent and continue to the next one.
   //
-  // NOTE: Like `remainingClusterResources`, `allocatedStage2` omits
-  // information about dynamic reservations and persistent volumes for
-  // performance reasons. This invariant is preserved because we only add
-  // resources to it that have also had this metadata stripped from them
-  // (typically by using `Resources::createStrippedScalarQuantity`).
-  Resources allocatedStage2;
+  // NOTE: Like `remainingClusterResources`, `allocatedStage2` only tracks
+  // the quantities of the resources for performance reasons.
+  ResourceQuantities allocatedStage2;
 
   // At this point resources for quotas are allocated or accounted for.
   // Proceed with allocating the remaining free pool.
-  foreach (const SlaveID& slaveId, slaveIds) {
+  for (size_t i = 0; i < slaveIds.size(); i++) {
+    const SlaveID& slaveId = slaveIds[i];
+
     // If there are no resources available for the second stage, stop.
     if (!allocatable(remainingClusterResources - allocatedStage2)) {
       break;
     }
 
-    foreach (const string& role, roleSorter->sort()) {
+    foreach (const string& role, roleSorter->sorted()) {
+      if (!all[i] && !roles.contains(role)) {
+        continue;
+      }
+
+      // The resources we offer are the unreserved resources as well as the
+      // reserved resources for this particular role. This is necessary to
+      // ensure that we don't offer resources that are reserved for another
+      // role.
+      //
+      // NOTE: Currently, frameworks are allowed to have '*' role.
+      // There are no resources reserved for '*'.
+      //
+      // NOTE: We do not offer roles with quota any more non-revocable
+      // resources once their quota is satisfied. However, note that this is
+      // not strictly true due to the coarse-grained nature (per agent) of the
+      // allocation algorithm in stage 1.
+      //
+      // TODO(mpark): Offer unreserved resources as revocable beyond quota.
+      Resources resources = available[i].reservedFor(role);
+      if (!quotas.contains(role)) {
+        resources += available[i].unreserved;
+      }
+
+      // The non-revocable part of `resources`, which we only compute once
+      // a framework that has not opted for revocable resources needs it.
+      Option<Resources> nonRevocable;
+
       foreach (const string& frameworkId_,
-               frameworkSorters[role]->sort()) {
+               frameworkSorters[role]->sorted()) {
         FrameworkID frameworkId;
         frameworkId.set_value(frameworkId_);
 
-        // If the framework has suppressed offers, ignore.
-        if (frameworks[frameworkId].suppressed) {
+        if (!all[i] && !frameworkIds.contains(frameworkId)) {
           continue;
         }
 
-        // Calculate the currently available resources on the slave.
-        Resources available = slaves[slaveId].total - slaves[slaveId].allocated;
-
-        // The resources we offer are the unreserved resources as well as the
-        // reserved resources for this particular role. This is necessary to
-        // ensure that we don't offer resources that are reserved for another
-        // role.
-        //
-        // NOTE: Currently, frameworks are allowed to have '*' role.
-        // Calling reserved('*') returns an empty Resources object.
-        //
-        // NOTE: We do not offer roles with quota any more non-revocable
-        // resources once their quota is satisfied. However, note that this is
-        // not strictly true due to the coarse-grained nature (per agent) of the
-        // allocation algorithm in stage 1.
-        //
-        // TODO(mpark): Offer unreserved resources as revocable beyond quota.
-        Resources resources = available.reserved(role);
-        if (!quotas.contains(role)) {
-          resources += available.unreserved();
+        // If the framework has suppressed offers, ignore.
+        if (frameworks[frameworkId].suppressed) {
+          continue;
         }
 
         // It is safe to break here, because all frameworks under a role would
@@ -1432,20 +1670,25 @@ void HierarchicalAllocatorProcess::allocate(
 
         // Remove revocable resources if the framework has not opted
         // for them.
+        const Resources* offered = &resources;
         if (!frameworks[frameworkId].revocable) {
-          resources = resources.nonRevocable();
+          if (nonRevocable.isNone()) {
+            nonRevocable = resources.nonRevocable();
+          }
+
+          offered = &nonRevocable.get();
         }
 
         // If the resources are not allocatable, ignore.
         // We can not break here, because another framework under the same role
         // could accept revocable resources and breaking would skip all other
         // frameworks.
-        if (!allocatable(resources)) {
+        if (!allocatable(*offered)) {
           continue;
         }
 
         // If the framework filters these resources, ignore.
-        if (isFiltered(frameworkId, slaveId, resources)) {
+        if (isFiltered(frameworkId, slaveId, *offered)) {
           continue;
         }
 
@@ -1453,15 +1696,14 @@ void HierarchicalAllocatorProcess::allocate(
         // stage to use more than `remainingClusterResources`, move along.
         // We do not terminate early, as offers generated further in the
         // loop may be small enough to fit within `remainingClusterResources`.
-        const Resources scalarQuantity =
-          resources.createStrippedScalarQuantity();
+        const ResourceQuantities scalarQuantity(*offered);
 
         if (!remainingClusterResources.contains(
                 allocatedStage2 + scalarQuantity)) {
           continue;
         }
 
-        VLOG(2) << "Allocating " << resources << " on slave " << slaveId
+        VLOG(2) << "Allocating " << *offered << " on slave " << slaveId
                 << " to framework " << frameworkId;
 
         // NOTE: We perform "coarse-grained" allocation, meaning that we always
@@ -1469,23 +1711,40 @@ void HierarchicalAllocatorProcess::allocate(
         //
         // NOTE: We may have already allocated some resources on the current
         // agent as part of quota.
-        offerable[frameworkId][slaveId] += resources;
+        offerable[frameworkId][slaveId] += *offered;
         allocatedStage2 += scalarQuantity;
-        slaves[slaveId].allocated += resources;
+        slaves[slaveId].allocated += *offered;
 
-        frameworkSorters[role]->add(slaveId, resources);
-        frameworkSorters[role]->allocated(frameworkId_, slaveId, resources);
-        roleSorter->allocated(role, slaveId, resources);
+        agentSorter->update(
+            slaveId, slaves[slaveId].total, slaves[slaveId].allocated);
+
+        frameworkSorters[role]->add(slaveId, *offered);
+        frameworkSorters[role]->allocated(frameworkId_, slaveId, *offered);
+        roleSorter->allocated(role, slaveId, *offered);
 
         if (quotas.contains(role)) {
           // See comment at `quotaRoleSorter` declaration regarding
           // non-revocable.
-          quotaRoleSorter->allocated(role, slaveId, resources.nonRevocable());
+          quotaRoleSorter->allocated(role, slaveId, offered->nonRevocable());
+        }
+
+        available[i] =
+          Available(slaves[slaveId].total, slaves[slaveId].allocated);
+
+        resources = available[i].reservedFor(role);
+        if (!quotas.contains(role)) {
+          resources += available[i].unreserved;
         }
+
+        nonRevocable = None();
       }
     }
   }
 
+  metrics.allocation_run_fair_share.stop();
+
+  metrics.allocation_run_offers.start();
+
   if (offerable.empty()) {
     VLOG(1) << "No resources available to allocate!";
   } else {
@@ -1499,6 +1758,8 @@ void HierarchicalAllocatorProcess::allocate(
   // allocator. We leverage the existing timer/cycle of offers to also do any
   // "deallocation" (inverse offers) necessary to satisfy maintenance needs.
   deallocate(slaveIds_);
+
+  metrics.allocation_run_offers.stop();
 }
 
 
@@ -1609,12 +1870,32 @@ void HierarchicalAllocatorProcess::expire(
     if (frameworks[frameworkId].offerFilters[slaveId].empty()) {
       frameworks[frameworkId].offerFilters.erase(slaveId);
     }
+
+    // Offer the previously filtered resources in the next batch
+    // allocation.
+    if (slaves.contains(slaveId)) {
+      allocationCandidates.insert(slaveId);
+    }
   }
 
   delete offerFilter;
 }
 
 
+void HierarchicalAllocatorProcess::expireOfferFilters(int64_t tick)
+{
+  if (!offerFilterExpiries.contains(tick)) {
+    return;
+  }
+
+  foreach (const OfferFilterExpiry& expiry, offerFilterExpiries[tick]) {
+    expire(expiry.frameworkId, expiry.slaveId, expiry.offerFilter);
+  }
+
+  offerFilterExpiries.erase(tick);
+}
+
+
 void HierarchicalAllocatorProcess::expire(
     const FrameworkID& frameworkId,
     const SlaveID& slaveId,
@@ -1635,6 +1916,10 @@ void HierarchicalAllocatorProcess::expire(
     if(frameworks[frameworkId].inverseOfferFilters[slaveId].empty()) {
       frameworks[frameworkId].inverseOfferFilters.erase(slaveId);
     }
+
+    if (slaves.contains(slaveId)) {
+      allocationCandidates.insert(slaveId);
+    }
   }
 
   delete inverseOfferFilter;
@@ -1721,6 +2006,15 @@ bool HierarchicalAllocatorProcess::allocatable(
 }
 
 
+bool HierarchicalAllocatorProcess::allocatable(
+    const ResourceQuantities& quantities)
+{
+  // NOTE: Like `Resources::mem`, we truncate the megabytes.
+  return quantities.get("cpus") >= MIN_CPUS ||
+         Megabytes(static_cast<uint64_t>(quantities.get("mem"))) >= MIN_MEM;
+}
+
+
 double HierarchicalAllocatorProcess::_resources_offered_or_allocated(
     const string& resource)
 {
@@ -1742,11 +2036,7 @@ double HierarchicalAllocatorProcess::_resources_offered_or_allocated(
 double HierarchicalAllocatorProcess::_resources_total(
     const string& resource)
 {
-  Option<Value::Scalar> total =
-    roleSorter->totalScalarQuantities()
-      .get<Value::Scalar>(resource);
-
-  return total.isSome() ? total->value() : 0;
+  return roleSorter->totalScalarQuantities().get(resource);
 }
 
 
@@ -1754,11 +2044,7 @@ double HierarchicalAllocatorProcess::_quota_allocated(
     const string& role,
     const string& resource)
 {
-  Option<Value::Scalar> used =
-    quotaRoleSorter->allocationScalarQuantities(role)
-      .get<Value::Scalar>(resource);
-
-  return used.isSome() ? used->value() : 0;
+  return quotaRoleSorter->allocationScalarQuantities(role).get(resource);
 }
 
 
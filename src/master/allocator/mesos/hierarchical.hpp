@@ -18,11 +18,13 @@
 #define __MASTER_ALLOCATOR_MESOS_HIERARCHICAL_HPP__
 
 #include <string>
+#include <vector>
 
 #include <mesos/mesos.hpp>
 
 #include <process/future.hpp>
 #include <process/id.hpp>
+#include <process/time.hpp>
 
 #include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
@@ -30,10 +32,15 @@
 #include <stout/lambda.hpp>
 #include <stout/option.hpp>
 
+#include "common/resource_quantities.hpp"
+
 #include "master/allocator/mesos/allocator.hpp"
 #include "master/allocator/mesos/metrics.hpp"
 
+#include "master/allocator/sorter/agent/sorter.hpp"
+
 #include "master/allocator/sorter/drf/sorter.hpp"
+#include "master/allocator/sorter/quota/sorter.hpp"
 
 #include "master/constants.hpp"
 
@@ -72,13 +79,16 @@ public:
     : ProcessBase(process::ID::generate("hierarchical-allocator")),
       initialized(false),
       paused(true),
+      allocationScheduled(false),
+      sweep(false),
       metrics(*this),
       roleSorter(NULL),
       quotaRoleSorter(NULL),
       roleSorterFactory(_roleSorterFactory),
-      frameworkSorterFactory(_frameworkSorterFactory) {}
+      frameworkSorterFactory(_frameworkSorterFactory),
+      agentSorter(NULL) {}
 
-  virtual ~HierarchicalAllocatorProcess() {}
+  virtual ~HierarchicalAllocatorProcess();
 
   process::PID<HierarchicalAllocatorProcess> self() const
   {
@@ -94,7 +104,8 @@ public:
           void(const FrameworkID&,
                const hashmap<SlaveID, UnavailableResources>&)>&
         inverseOfferCallback,
-      const hashmap<std::string, double>& weights);
+      const hashmap<std::string, double>& weights,
+      const mesos::master::allocator::Options& options);
 
   void recover(
       const int _expectedAgentCount,
@@ -191,6 +202,12 @@ public:
   void updateWeights(
       const std::vector<WeightInfo>& weightInfos);
 
+  // Performs the scheduled allocation, if any, see `allocate()`.
+  //
+  // NOTE: This is public so that tests can wait for an allocation
+  // with `FUTURE_DISPATCH`.
+  void _allocate();
+
 protected:
   // Useful typedefs for dispatch/delay/defer to self()/this.
   typedef HierarchicalAllocatorProcess Self;
@@ -203,14 +220,25 @@ protected:
   // Callback for doing batch allocations.
   void batch();
 
-  // Allocate any allocatable resources.
+  // Schedules an allocation of the resources of all slaves.
   void allocate();
 
-  // Allocate resources just from the specified slave.
+  // Schedules an allocation of the resources of the specified slave.
   void allocate(const SlaveID& slaveId);
 
-  // Allocate resources from the specified slaves.
-  void allocate(const hashset<SlaveID>& slaveIds);
+  // Schedules an allocation of the resources of all slaves to the
+  // specified framework.
+  void allocate(const FrameworkID& frameworkId);
+
+  // Schedules `_allocate()` after the `allocationWindow`, unless an
+  // allocation is already scheduled.
+  void scheduleAllocation();
+
+  // Allocate resources from the specified slaves to all frameworks,
+  // and from all slaves to the specified frameworks.
+  void allocate(
+      const hashset<SlaveID>& slaveIds,
+      const hashset<FrameworkID>& frameworkIds);
 
   // Send inverse offers from the specified slaves.
   void deallocate(const hashset<SlaveID>& slaveIds);
@@ -221,6 +249,10 @@ protected:
       const SlaveID& slaveId,
       OfferFilter* offerFilter);
 
+  // Remove the offer filters that expire at the specified tick, see
+  // `offerFilterExpiries`.
+  void expireOfferFilters(int64_t tick);
+
   // Remove an inverse offer filter for the specified framework.
   void expire(
       const FrameworkID& frameworkId,
@@ -248,6 +280,8 @@ protected:
 
   bool allocatable(const Resources& resources);
 
+  bool allocatable(const ResourceQuantities& quantities);
+
   bool initialized;
   bool paused;
 
@@ -255,6 +289,48 @@ protected:
   Option<int> expectedAgentCount;
 
   Duration allocationInterval;
+  Duration allocationWindow;
+
+  // The slaves and frameworks that changed since the last allocation
+  // considered them, e.g., a slave's resources were recovered or a
+  // framework revived offers. Allocations only consider these, see
+  // `allocate()`.
+  hashset<SlaveID> allocationCandidates;
+  hashset<FrameworkID> frameworkCandidates;
+
+  // Whether an allocation of the candidates has been scheduled, so
+  // that events within the `allocationWindow` are coalesced.
+  bool allocationScheduled;
+
+  // Whether the next batch allocation should consider all slaves.
+  //
+  // With quota, a change on one slave (e.g., recovered resources that
+  // are no longer needed for the stage 2 headroom) can make resources
+  // allocatable on any other slave. Hence we set this after allocating
+  // only some of the slaves while quota is set.
+  bool sweep;
+
+  // Offer filters are expired in bulk: a filter's expiry is rounded
+  // up to the next multiple of `offerFilterTick` after
+  // `offerFilterEpoch` and the filters of a tick expire together,
+  // with a single timer per tick. Since filters never expire early
+  // and at most one tick late, this keeps the number of pending
+  // timers low when many frameworks decline offers at once.
+  //
+  // NOTE: The filters are owned by this wheel rather than by the
+  // `Framework::offerFilters` index, since a filter that is removed
+  // from the index (e.g., upon reviving offers) is only deleted upon
+  // its expiry, see `expire()`.
+  struct OfferFilterExpiry
+  {
+    FrameworkID frameworkId;
+    SlaveID slaveId;
+    OfferFilter* offerFilter;
+  };
+
+  process::Time offerFilterEpoch;
+  Duration offerFilterTick;
+  hashmap<int64_t, std::vector<OfferFilterExpiry>> offerFilterExpiries;
 
   lambda::function<
       void(const FrameworkID&,
@@ -278,6 +354,10 @@ protected:
     bool revocable;
 
     // Active offer and inverse offer filters for the framework.
+    //
+    // NOTE: No offer filter of a slave covers another one (see
+    // `OfferFilter::covers()`), so there is usually a single filter
+    // per slave to check regardless of how often offers are declined.
     hashmap<SlaveID, hashset<OfferFilter*>> offerFilters;
     hashmap<SlaveID, hashset<InverseOfferFilter*>> inverseOfferFilters;
   };
@@ -438,7 +518,10 @@ protected:
   // the quota roles as it pertains to their level of quota satisfaction.
   // Since revocable resources do not increase a role's level of satisfaction
   // toward its quota, we choose to exclude them from the quota role sorter.
-  Sorter* quotaRoleSorter;
+  //
+  // NOTE: The quota role sorter only sorts the roles whose quota is not
+  // satisfied, see `QuotaSorter`.
+  QuotaSorter* quotaRoleSorter;
 
   // A collection of sorters, one per active role. Each sorter determines
   // the order in which frameworks that belong to the same role are allocated
@@ -448,9 +531,16 @@ protected:
 
   // Factory functions for sorters.
   //
-  // NOTE: `quotaRoleSorter` currently reuses `roleSorterFactory`.
+  // NOTE: `quotaRoleSorter` currently reuses `roleSorterFactory` for
+  // the sorter that the `QuotaSorter` wraps.
   const std::function<Sorter*()> roleSorterFactory;
   const std::function<Sorter*()> frameworkSorterFactory;
+
+  // Determines the order in which the resources of the slaves are
+  // allocated, see `allocate()`. It is updated whenever the total or
+  // allocated resources of a slave change, including by offer
+  // operations in `updateAllocation()` and `updateAvailable()`.
+  AgentSorter* agentSorter;
 };
 
 
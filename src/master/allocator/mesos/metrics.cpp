@@ -45,12 +45,22 @@ Metrics::Metrics(const HierarchicalAllocatorProcess& _allocator)
         process::defer(
             allocator, &HierarchicalAllocatorProcess::_event_queue_dispatches)),
     allocation_runs("allocator/mesos/allocation_runs"),
-    allocation_run("allocator/mesos/allocation_run", Hours(1))
+    allocation_run("allocator/mesos/allocation_run", Hours(1)),
+    allocation_run_snapshot(
+        "allocator/mesos/allocation_run/snapshot", Hours(1)),
+    allocation_run_quota("allocator/mesos/allocation_run/quota", Hours(1)),
+    allocation_run_fair_share(
+        "allocator/mesos/allocation_run/fair_share", Hours(1)),
+    allocation_run_offers("allocator/mesos/allocation_run/offers", Hours(1))
 {
   process::metrics::add(event_queue_dispatches);
   process::metrics::add(event_queue_dispatches_);
   process::metrics::add(allocation_runs);
   process::metrics::add(allocation_run);
+  process::metrics::add(allocation_run_snapshot);
+  process::metrics::add(allocation_run_quota);
+  process::metrics::add(allocation_run_fair_share);
+  process::metrics::add(allocation_run_offers);
 
   // Create and install gauges for the total and allocated
   // amount of standard scalar resources.
@@ -89,6 +99,10 @@ Metrics::~Metrics()
   process::metrics::remove(event_queue_dispatches_);
   process::metrics::remove(allocation_runs);
   process::metrics::remove(allocation_run);
+  process::metrics::remove(allocation_run_snapshot);
+  process::metrics::remove(allocation_run_quota);
+  process::metrics::remove(allocation_run_fair_share);
+  process::metrics::remove(allocation_run_offers);
 
   foreach (const Gauge& gauge, resources_total) {
     process::metrics::remove(gauge);
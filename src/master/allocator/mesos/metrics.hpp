@@ -66,6 +66,14 @@ struct Metrics
   // Latency of the allocation algorithm.
   process::metrics::Timer<Milliseconds> allocation_run;
 
+  // Latencies of the phases of the allocation algorithm: computing the
+  // resources available on the agents, allocating to the roles with
+  // quota, allocating the fair shares, and sending the (inverse) offers.
+  process::metrics::Timer<Milliseconds> allocation_run_snapshot;
+  process::metrics::Timer<Milliseconds> allocation_run_quota;
+  process::metrics::Timer<Milliseconds> allocation_run_fair_share;
+  process::metrics::Timer<Milliseconds> allocation_run_offers;
+
   // Gauges for the total amount of each resource in the cluster.
   std::vector<process::metrics::Gauge> resources_total;
 
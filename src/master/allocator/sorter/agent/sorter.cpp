@@ -0,0 +1,249 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+
+#include <glog/logging.h>
+
+#include <mesos/attributes.hpp>
+
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+
+#include "common/resource_quantities.hpp"
+
+#include "master/allocator/sorter/agent/sorter.hpp"
+
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace master {
+namespace allocator {
+
+class RandomAgentSorter : public AgentSorter
+{
+public:
+  virtual void add(const SlaveID& slaveId, const SlaveInfo& slaveInfo) {}
+
+  virtual void remove(const SlaveID& slaveId) {}
+
+  virtual void update(
+      const SlaveID& slaveId,
+      const Resources& total,
+      const Resources& allocated) {}
+
+  virtual void sort(vector<SlaveID>* slaveIds) const
+  {
+    std::random_shuffle(slaveIds->begin(), slaveIds->end());
+  }
+};
+
+
+// Orders the agents by their share of free resources, i.e., by the
+// average over the resource names of the fraction of the agent's
+// total that is not allocated. The shares are rounded into buckets of
+// 1%, so that an update only moves the agent to another bucket and
+// the agents can be ordered with a counting sort.
+class FreeShareAgentSorter : public AgentSorter
+{
+public:
+  explicit FreeShareAgentSorter(bool _ascending)
+    : ascending(_ascending) {}
+
+  virtual void add(const SlaveID& slaveId, const SlaveInfo& slaveInfo)
+  {
+    CHECK(!buckets.contains(slaveId));
+
+    // The agent has no resources until they are updated.
+    buckets[slaveId] = 0;
+  }
+
+  virtual void remove(const SlaveID& slaveId)
+  {
+    CHECK(buckets.contains(slaveId));
+
+    buckets.erase(slaveId);
+  }
+
+  virtual void update(
+      const SlaveID& slaveId,
+      const Resources& total,
+      const Resources& allocated)
+  {
+    CHECK(buckets.contains(slaveId));
+
+    const ResourceQuantities totals(total);
+    const ResourceQuantities allocations(allocated);
+
+    double share = 0.0;
+    size_t count = 0;
+
+    for (size_t i = 0; i < totals.size(); i++) {
+      if (totals.at(i) > 0.0) {
+        // NOTE: The agent may be over-allocated, see `Slave::allocated`.
+        share += std::max(totals.at(i) - allocations.at(i), 0.0) /
+                 totals.at(i);
+        count++;
+      }
+    }
+
+    buckets[slaveId] = count == 0
+      ? 0
+      : static_cast<size_t>(std::round(share / count * (BUCKETS - 1)));
+  }
+
+  virtual void sort(vector<SlaveID>* slaveIds) const
+  {
+    // Shuffle the agents first, so that the agents within a bucket
+    // remain shuffled by the (stable) counting sort.
+    std::random_shuffle(slaveIds->begin(), slaveIds->end());
+
+    vector<size_t> offsets(BUCKETS + 1, 0);
+
+    foreach (const SlaveID& slaveId, *slaveIds) {
+      offsets[key(slaveId) + 1]++;
+    }
+
+    for (size_t i = 1; i < offsets.size(); i++) {
+      offsets[i] += offsets[i - 1];
+    }
+
+    vector<SlaveID> sorted(slaveIds->size());
+
+    foreach (const SlaveID& slaveId, *slaveIds) {
+      sorted[offsets[key(slaveId)]++] = slaveId;
+    }
+
+    slaveIds->swap(sorted);
+  }
+
+private:
+  // The shares from 0% to 100%.
+  static const size_t BUCKETS = 101;
+
+  size_t key(const SlaveID& slaveId) const
+  {
+    const size_t bucket = buckets.at(slaveId);
+    return ascending ? bucket : BUCKETS - 1 - bucket;
+  }
+
+  const bool ascending;
+
+  hashmap<SlaveID, size_t> buckets;
+};
+
+
+// Groups the agents by the value of an attribute, in the order in
+// which the (shuffled) agents first have each value.
+class AttributeAgentSorter : public AgentSorter
+{
+public:
+  explicit AttributeAgentSorter(const string& _name)
+    : name(_name) {}
+
+  virtual void add(const SlaveID& slaveId, const SlaveInfo& slaveInfo)
+  {
+    CHECK(!values.contains(slaveId));
+
+    // Agents without the attribute are grouped by the empty string,
+    // which no stringified attribute equals.
+    string value;
+
+    foreach (const Attribute& attribute, slaveInfo.attributes()) {
+      if (attribute.name() == name) {
+        value = stringify(attribute);
+        break;
+      }
+    }
+
+    values[slaveId] = value;
+  }
+
+  virtual void remove(const SlaveID& slaveId)
+  {
+    CHECK(values.contains(slaveId));
+
+    values.erase(slaveId);
+  }
+
+  virtual void update(
+      const SlaveID& slaveId,
+      const Resources& total,
+      const Resources& allocated) {}
+
+  virtual void sort(vector<SlaveID>* slaveIds) const
+  {
+    std::random_shuffle(slaveIds->begin(), slaveIds->end());
+
+    vector<string> order;
+    hashmap<string, vector<SlaveID>> groups;
+
+    foreach (const SlaveID& slaveId, *slaveIds) {
+      const string& value = values.at(slaveId);
+
+      if (!groups.contains(value)) {
+        order.push_back(value);
+      }
+
+      groups[value].push_back(slaveId);
+    }
+
+    slaveIds->clear();
+
+    foreach (const string& value, order) {
+      const vector<SlaveID>& group = groups.at(value);
+      slaveIds->insert(slaveIds->end(), group.begin(), group.end());
+    }
+  }
+
+private:
+  const string name;
+
+  hashmap<SlaveID, string> values;
+};
+
+
+Try<AgentSorter*> AgentSorter::create(const string& ordering)
+{
+  if (ordering == "random") {
+    return new RandomAgentSorter();
+  } else if (ordering == "best_fit") {
+    return new FreeShareAgentSorter(true);
+  } else if (ordering == "spread") {
+    return new FreeShareAgentSorter(false);
+  } else if (strings::startsWith(ordering, "attribute:")) {
+    const string name = ordering.substr(string("attribute:").size());
+
+    if (name.empty()) {
+      return Error("Missing the attribute name in '" + ordering + "'");
+    }
+
+    return new AttributeAgentSorter(name);
+  }
+
+  return Error("Unknown agent ordering '" + ordering + "'");
+}
+
+} // namespace allocator {
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,87 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __MASTER_ALLOCATOR_SORTER_AGENT_SORTER_HPP__
+#define __MASTER_ALLOCATOR_SORTER_AGENT_SORTER_HPP__
+
+#include <string>
+#include <vector>
+
+#include <mesos/mesos.hpp>
+#include <mesos/resources.hpp>
+
+#include <stout/try.hpp>
+
+
+namespace mesos {
+namespace internal {
+namespace master {
+namespace allocator {
+
+// Determines the order in which the allocator allocates the resources
+// of the agents, see `HierarchicalAllocatorProcess::allocate()`. The
+// supported orderings are:
+//
+//   random            The agents are shuffled for every allocation.
+//
+//   best_fit          The agents with the smallest share of free
+//                     resources come first, so that agents are filled
+//                     up before others are used. This leaves whole
+//                     agents free for large tasks (i.e., bin-packing).
+//
+//   spread            The agents with the largest share of free
+//                     resources come first, which spreads the load.
+//
+//   attribute:<name>  The agents with the same value of the named
+//                     attribute (e.g., the same rack) come one after
+//                     another, so that a framework tends to be
+//                     allocated resources of agents close to each
+//                     other. Agents without the attribute are grouped
+//                     together as well.
+//
+// Agents that are otherwise equal are shuffled, as with `random`.
+//
+// A sorter keeps track of what it orders the agents by as their
+// resources change, so that ordering the agents for an allocation
+// takes time linear in the number of agents rather than comparing
+// them with each other.
+class AgentSorter
+{
+public:
+  static Try<AgentSorter*> create(const std::string& ordering);
+
+  virtual ~AgentSorter() {}
+
+  virtual void add(const SlaveID& slaveId, const SlaveInfo& slaveInfo) = 0;
+
+  virtual void remove(const SlaveID& slaveId) = 0;
+
+  // Updates the total and the allocated resources of the agent.
+  virtual void update(
+      const SlaveID& slaveId,
+      const Resources& total,
+      const Resources& allocated) = 0;
+
+  // Orders the given agents, which must have been added.
+  virtual void sort(std::vector<SlaveID>* slaveIds) const = 0;
+};
+
+} // namespace allocator {
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MASTER_ALLOCATOR_SORTER_AGENT_SORTER_HPP__
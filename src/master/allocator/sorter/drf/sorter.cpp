@@ -14,13 +14,15 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+
 #include "logging/logging.hpp"
 
 #include "master/allocator/sorter/drf/sorter.hpp"
 
 using std::list;
-using std::set;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -39,55 +41,79 @@ bool DRFComparator::operator()(const Client& client1, const Client& client2)
 }
 
 
+DRFSorter::DRFSorter()
+  : dirty(false),
+    reordered(false) {}
+
+
 void DRFSorter::add(const string& name, double weight)
 {
-  Client client(name, 0, 0);
-  clients.insert(client);
+  CHECK(!nodes.contains(name));
+
+  Node* node = &nodes.emplace(name, Node(name, weight)).first->second;
 
-  allocations[name] = Allocation();
-  weights[name] = weight;
+  insert(node);
 }
 
 
 void DRFSorter::update(const string& name, double weight)
 {
-  CHECK(weights.contains(name));
-  weights[name] = weight;
+  CHECK(nodes.contains(name));
+
+  Node* node = &nodes.at(name);
+  node->weight = weight;
+
+  update(node);
 }
 
 
 void DRFSorter::remove(const string& name)
 {
-  set<Client, DRFComparator>::iterator it = find(name);
+  if (!nodes.contains(name)) {
+    return;
+  }
+
+  Node* node = &nodes.at(name);
 
-  if (it != clients.end()) {
-    clients.erase(it);
+  if (node->active) {
+    erase(node);
   }
 
-  allocations.erase(name);
-  weights.erase(name);
+  nodes.erase(name);
 }
 
 
 void DRFSorter::activate(const string& name)
 {
-  CHECK(allocations.contains(name));
+  CHECK(nodes.contains(name));
 
-  Client client(name, calculateShare(name), 0);
-  clients.insert(client);
+  Node* node = &nodes.at(name);
+
+  if (!node->active) {
+    node->client.share = calculateShare(*node);
+    node->client.allocations = 0;
+    node->active = true;
+
+    insert(node);
+  }
 }
 
 
 void DRFSorter::deactivate(const string& name)
 {
-  set<Client, DRFComparator>::iterator it = find(name);
+  if (!nodes.contains(name)) {
+    return;
+  }
 
-  if (it != clients.end()) {
+  Node* node = &nodes.at(name);
+
+  if (node->active) {
     // TODO(benh): Removing the client is an unfortuante strategy
     // because we lose information such as the number of allocations
     // for this client which means the fairness can be gamed by a
     // framework disconnecting and reconnecting.
-    clients.erase(it);
+    erase(node);
+    node->active = false;
   }
 }
 
@@ -97,30 +123,16 @@ void DRFSorter::allocated(
     const SlaveID& slaveId,
     const Resources& resources)
 {
-  set<Client, DRFComparator>::iterator it = find(name);
-
-  if (it != clients.end()) { // TODO(benh): This should really be a CHECK.
-    // TODO(benh): Refactor 'update' to be able to reuse it here.
-    Client client(*it);
+  CHECK(nodes.contains(name));
 
-    // Update the 'allocations' to reflect the allocator decision.
-    client.allocations++;
-
-    // Remove and reinsert it to update the ordering appropriately.
-    clients.erase(it);
-    clients.insert(client);
-  }
+  Node* node = &nodes.at(name);
+  Allocation& allocation = node->allocation;
 
-  allocations[name].resources[slaveId] += resources;
-  allocations[name].scalarQuantities +=
-    resources.createStrippedScalarQuantity();
+  allocation.resources[slaveId] += resources;
+  allocation.scalarQuantities += ResourceQuantities(resources);
 
-  // If the total resources have changed, we're going to
-  // recalculate all the shares, so don't bother just
-  // updating this client.
-  if (!dirty) {
-    update(name);
-  }
+  // Update the 'allocations' to reflect the allocator decision.
+  update(node, true);
 }
 
 
@@ -137,10 +149,8 @@ void DRFSorter::update(
   // Otherwise, we need to ensure we re-calculate the shares, as
   // is being currently done, for safety.
 
-  const Resources oldAllocationQuantity =
-    oldAllocation.createStrippedScalarQuantity();
-  const Resources newAllocationQuantity =
-    newAllocation.createStrippedScalarQuantity();
+  const ResourceQuantities oldAllocationQuantity(oldAllocation);
+  const ResourceQuantities newAllocationQuantity(newAllocation);
 
   CHECK(total_.resources[slaveId].contains(oldAllocation));
   CHECK(total_.scalarQuantities.contains(oldAllocationQuantity));
@@ -148,20 +158,25 @@ void DRFSorter::update(
   total_.resources[slaveId] -= oldAllocation;
   total_.resources[slaveId] += newAllocation;
 
-  total_.scalarQuantities -= oldAllocationQuantity;
-  total_.scalarQuantities += newAllocationQuantity;
+  Allocation& allocation = nodes.at(name).allocation;
 
-  CHECK(allocations[name].resources[slaveId].contains(oldAllocation));
-  CHECK(allocations[name].scalarQuantities.contains(oldAllocationQuantity));
+  CHECK(allocation.resources[slaveId].contains(oldAllocation));
+  CHECK(allocation.scalarQuantities.contains(oldAllocationQuantity));
 
-  allocations[name].resources[slaveId] -= oldAllocation;
-  allocations[name].resources[slaveId] += newAllocation;
+  allocation.resources[slaveId] -= oldAllocation;
+  allocation.resources[slaveId] += newAllocation;
 
-  allocations[name].scalarQuantities -= oldAllocationQuantity;
-  allocations[name].scalarQuantities += newAllocationQuantity;
+  // The shares only change if the quantities do, in which case the
+  // total has changed as well.
+  if (oldAllocationQuantity != newAllocationQuantity) {
+    total_.scalarQuantities -= oldAllocationQuantity;
+    total_.scalarQuantities += newAllocationQuantity;
 
-  // Just assume the total has changed, per the TODO above.
-  dirty = true;
+    allocation.scalarQuantities -= oldAllocationQuantity;
+    allocation.scalarQuantities += newAllocationQuantity;
+
+    dirty = true;
+  }
 }
 
 
@@ -169,15 +184,16 @@ const hashmap<SlaveID, Resources>& DRFSorter::allocation(const string& name)
 {
   CHECK(contains(name));
 
-  return allocations[name].resources;
+  return nodes.at(name).allocation.resources;
 }
 
 
-const Resources& DRFSorter::allocationScalarQuantities(const string& name)
+const ResourceQuantities& DRFSorter::allocationScalarQuantities(
+    const string& name)
 {
   CHECK(contains(name));
 
-  return allocations[name].scalarQuantities;
+  return nodes.at(name).allocation.scalarQuantities;
 }
 
 
@@ -189,11 +205,11 @@ hashmap<string, Resources> DRFSorter::allocation(const SlaveID& slaveId)
 
   hashmap<string, Resources> result;
 
-  foreachpair (const string& name, const Allocation& allocation, allocations) {
-    if (allocation.resources.contains(slaveId)) {
+  foreachpair (const string& name, const Node& node, nodes) {
+    if (node.allocation.resources.contains(slaveId)) {
       // It is safe to use `at()` here because we've just checked the existence
       // of the key. This avoid un-necessary copies.
-      result.emplace(name, allocation.resources.at(slaveId));
+      result.emplace(name, node.allocation.resources.at(slaveId));
     }
   }
 
@@ -205,8 +221,10 @@ Resources DRFSorter::allocation(const string& name, const SlaveID& slaveId)
 {
   CHECK(contains(name));
 
-  if (allocations[name].resources.contains(slaveId)) {
-    return allocations[name].resources[slaveId];
+  const Allocation& allocation = nodes.at(name).allocation;
+
+  if (allocation.resources.contains(slaveId)) {
+    return allocation.resources.at(slaveId);
   }
 
   return Resources();
@@ -219,7 +237,7 @@ const hashmap<SlaveID, Resources>& DRFSorter::total() const
 }
 
 
-const Resources& DRFSorter::totalScalarQuantities() const
+const ResourceQuantities& DRFSorter::totalScalarQuantities() const
 {
   return total_.scalarQuantities;
 }
@@ -230,17 +248,19 @@ void DRFSorter::unallocated(
     const SlaveID& slaveId,
     const Resources& resources)
 {
-  allocations[name].resources[slaveId] -= resources;
-  allocations[name].scalarQuantities -=
-    resources.createStrippedScalarQuantity();
+  CHECK(nodes.contains(name));
 
-  if (allocations[name].resources[slaveId].empty()) {
-    allocations[name].resources.erase(slaveId);
-  }
+  Node* node = &nodes.at(name);
+  Allocation& allocation = node->allocation;
 
-  if (!dirty) {
-    update(name);
+  allocation.resources[slaveId] -= resources;
+  allocation.scalarQuantities -= ResourceQuantities(resources);
+
+  if (allocation.resources[slaveId].empty()) {
+    allocation.resources.erase(slaveId);
   }
+
+  update(node);
 }
 
 
@@ -248,7 +268,7 @@ void DRFSorter::add(const SlaveID& slaveId, const Resources& resources)
 {
   if (!resources.empty()) {
     total_.resources[slaveId] += resources;
-    total_.scalarQuantities += resources.createStrippedScalarQuantity();
+    total_.scalarQuantities += ResourceQuantities(resources);
 
     // We have to recalculate all shares when the total resources
     // change, but we put it off until sort is called so that if
@@ -265,7 +285,7 @@ void DRFSorter::remove(const SlaveID& slaveId, const Resources& resources)
     CHECK(total_.resources.contains(slaveId));
 
     total_.resources[slaveId] -= resources;
-    total_.scalarQuantities -= resources.createStrippedScalarQuantity();
+    total_.scalarQuantities -= ResourceQuantities(resources);
 
     if (total_.resources[slaveId].empty()) {
       total_.resources.erase(slaveId);
@@ -278,13 +298,12 @@ void DRFSorter::remove(const SlaveID& slaveId, const Resources& resources)
 
 void DRFSorter::update(const SlaveID& slaveId, const Resources& resources)
 {
-  const Resources oldSlaveQuantity =
-    total_.resources[slaveId].createStrippedScalarQuantity();
+  const ResourceQuantities oldSlaveQuantity(total_.resources[slaveId]);
 
   CHECK(total_.scalarQuantities.contains(oldSlaveQuantity));
 
   total_.scalarQuantities -= oldSlaveQuantity;
-  total_.scalarQuantities += resources.createStrippedScalarQuantity();
+  total_.scalarQuantities += ResourceQuantities(resources);
 
   total_.resources[slaveId] = resources;
 
@@ -298,63 +317,95 @@ void DRFSorter::update(const SlaveID& slaveId, const Resources& resources)
 
 list<string> DRFSorter::sort()
 {
-  if (dirty) {
-    set<Client, DRFComparator> temp;
+  const vector<string>& result = sorted();
+
+  return list<string>(result.begin(), result.end());
+}
 
-    set<Client, DRFComparator>::iterator it;
-    for (it = clients.begin(); it != clients.end(); it++) {
-      Client client(*it);
 
+const vector<string>& DRFSorter::sorted()
+{
+  if (dirty) {
+    foreachvalue (Node& node, nodes) {
       // Update the 'share' to get proper sorting.
-      client.share = calculateShare(client.name);
+      node.client.share = calculateShare(node);
+    }
+
+    // A change of the total resources often preserves the order of
+    // the clients (e.g., if they share the same dominant resource).
+    // So we only sort the clients after the longest ordered prefix,
+    // which includes those that have been updated in the meantime
+    // (see `insert()`), and merge them into the prefix.
+    vector<Client*>::iterator middle =
+      std::is_sorted_until(clients.begin(), clients.end(), DRFComparator());
 
-      temp.insert(client);
+    if (middle != clients.end()) {
+      std::sort(middle, clients.end(), DRFComparator());
+      std::inplace_merge(
+          clients.begin(), middle, clients.end(), DRFComparator());
+
+      reordered = true;
     }
 
-    clients = temp;
+    dirty = false;
   }
 
-  list<string> result;
+  // Only rebuild the names if the order has changed since the last
+  // call. Assigning the names reuses the storage of the previous ones,
+  // so this does not allocate either unless clients have been added.
+  if (reordered) {
+    names.resize(clients.size());
+
+    for (size_t i = 0; i < clients.size(); i++) {
+      names[i] = clients[i]->name;
+    }
 
-  set<Client, DRFComparator>::iterator it;
-  for (it = clients.begin(); it != clients.end(); it++) {
-    result.push_back((*it).name);
+    reordered = false;
   }
 
-  return result;
+  return names;
 }
 
 
 bool DRFSorter::contains(const string& name)
 {
-  return allocations.contains(name);
+  return nodes.contains(name);
 }
 
 
 int DRFSorter::count()
 {
-  return allocations.size();
+  return nodes.size();
 }
 
 
-void DRFSorter::update(const string& name)
+void DRFSorter::update(Node* node, bool allocated)
 {
-  set<Client, DRFComparator>::iterator it = find(name);
+  // If the client is not active it is not chosen for allocations, and
+  // its share is recalculated once it gets activated.
+  if (!node->active) {
+    return;
+  }
 
-  if (it != clients.end()) {
-    Client client(*it);
+  // Remove and reinsert it to update the ordering appropriately.
+  erase(node);
 
-    // Update the 'share' to get proper sorting.
-    client.share = calculateShare(client.name);
+  if (allocated) {
+    node->client.allocations++;
+  }
 
-    // Remove and reinsert it to update the ordering appropriately.
-    clients.erase(it);
-    clients.insert(client);
+  // If the total resources have changed, we're going to
+  // recalculate all the shares, so don't bother just
+  // updating this client.
+  if (!dirty) {
+    node->client.share = calculateShare(*node);
   }
+
+  insert(node);
 }
 
 
-double DRFSorter::calculateShare(const string& name)
+double DRFSorter::calculateShare(const Node& node) const
 {
   double share = 0.0;
 
@@ -362,57 +413,65 @@ double DRFSorter::calculateShare(const string& name)
   // currently does not take into account resources that are not
   // scalars.
 
-  foreach (const string& scalar, total_.scalarQuantities.names()) {
-    // We collect the scalar accumulated total value from the
-    // `Resources` object.
-    //
-    // NOTE: Although in principle scalar resources may be spread
-    // across multiple `Resource` objects (e.g., persistent volumes),
-    // we currently strip persistence and reservation metadata from
-    // the resources in `scalarQuantities`.
-    Option<Value::Scalar> __total =
-      total_.scalarQuantities.get<Value::Scalar>(scalar);
+  const ResourceQuantities& allocation = node.allocation.scalarQuantities;
+
+  // The quantities of both are indexed by resource name, and resources
+  // that the client has no allocation of do not affect its share.
+  const size_t size =
+    std::min(allocation.size(), total_.scalarQuantities.size());
 
-    CHECK_SOME(__total);
-    const double _total = __total.get().value();
+  for (size_t i = 0; i < size; i++) {
+    const double _total = total_.scalarQuantities.at(i);
 
     if (_total > 0.0) {
-      double allocation = 0.0;
-
-      // We collect the scalar accumulated allocation value from the
-      // `Resources` object.
-      //
-      // NOTE: Although in principle scalar resources may be spread
-      // across multiple `Resource` objects (e.g., persistent volumes),
-      // we currently strip persistence and reservation metadata from
-      // the resources in `scalarQuantities`.
-      Option<Value::Scalar> _allocation =
-        allocations[name].scalarQuantities.get<Value::Scalar>(scalar);
-
-      if (_allocation.isSome()) {
-        allocation = _allocation.get().value();
-      }
-
-      share = std::max(share, allocation / _total);
+      share = std::max(share, allocation.at(i) / _total);
     }
   }
 
-  return share / weights[name];
+  return share / node.weight;
 }
 
 
-set<Client, DRFComparator>::iterator DRFSorter::find(const string& name)
+void DRFSorter::erase(Node* node)
 {
-  set<Client, DRFComparator>::iterator it;
-  for (it = clients.begin(); it != clients.end(); it++) {
-    if (name == (*it).name) {
-      break;
-    }
+  vector<Client*>::iterator it;
+
+  if (dirty) {
+    // The clients get sorted once the shares are recalculated, so
+    // they may be out of order until then.
+    it = std::find(clients.begin(), clients.end(), &node->client);
+  } else {
+    // The clients are unique with respect to the comparator (the
+    // names break ties), so the client is found at its lower bound.
+    it = std::lower_bound(
+        clients.begin(), clients.end(), &node->client, DRFComparator());
   }
 
-  return it;
+  CHECK(it != clients.end() && *it == &node->client);
+
+  clients.erase(it);
+
+  reordered = true;
 }
 
+
+void DRFSorter::insert(Node* node)
+{
+  if (dirty) {
+    // Appending the client leaves it to be sorted along with the
+    // others once the shares are recalculated.
+    clients.push_back(&node->client);
+  } else {
+    clients.insert(
+        std::lower_bound(
+            clients.begin(), clients.end(), &node->client, DRFComparator()),
+        &node->client);
+  }
+
+  reordered = true;
+}
+
+
 } // namespace allocator {
 } // namespace master {
 } // namespace internal {
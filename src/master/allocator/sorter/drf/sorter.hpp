@@ -17,8 +17,8 @@
 #ifndef __MASTER_ALLOCATOR_SORTER_DRF_SORTER_HPP__
 #define __MASTER_ALLOCATOR_SORTER_DRF_SORTER_HPP__
 
-#include <set>
 #include <string>
+#include <vector>
 
 #include <mesos/resources.hpp>
 
@@ -55,12 +55,19 @@ struct DRFComparator
 {
   virtual ~DRFComparator() {}
   virtual bool operator()(const Client& client1, const Client& client2);
+
+  bool operator()(const Client* client1, const Client* client2)
+  {
+    return (*this)(*client1, *client2);
+  }
 };
 
 
 class DRFSorter : public Sorter
 {
 public:
+  DRFSorter();
+
   virtual ~DRFSorter() {}
 
   virtual void add(const std::string& name, double weight = 1);
@@ -92,7 +99,8 @@ public:
   virtual const hashmap<SlaveID, Resources>& allocation(
       const std::string& name);
 
-  virtual const Resources& allocationScalarQuantities(const std::string& name);
+  virtual const ResourceQuantities& allocationScalarQuantities(
+      const std::string& name);
 
   virtual hashmap<std::string, Resources> allocation(const SlaveID& slaveId);
 
@@ -100,7 +108,7 @@ public:
 
   virtual const hashmap<SlaveID, Resources>& total() const;
 
-  virtual const Resources& totalScalarQuantities() const;
+  virtual const ResourceQuantities& totalScalarQuantities() const;
 
   virtual void add(const SlaveID& slaveId, const Resources& resources);
 
@@ -110,30 +118,43 @@ public:
 
   virtual std::list<std::string> sort();
 
+  virtual const std::vector<std::string>& sorted();
+
   virtual bool contains(const std::string& name);
 
   virtual int count();
 
 private:
-  // Recalculates the share for the client and moves
-  // it in 'clients' accordingly.
-  void update(const std::string& name);
+  struct Node;
+
+  // Recalculates the share of the client (unless all shares are
+  // going to be recalculated anyway) and moves it in 'clients'
+  // accordingly. If 'allocated' is true, the client has also been
+  // chosen for an allocation.
+  void update(Node* node, bool allocated = false);
 
   // Returns the dominant resource share for the client.
-  double calculateShare(const std::string& name);
+  double calculateShare(const Node& node) const;
+
+  // Removes the (active) client from 'clients'.
+  void erase(Node* node);
 
-  // Returns an iterator to the specified client, if
-  // it exists in this Sorter.
-  std::set<Client, DRFComparator>::iterator find(const std::string& name);
+  // Inserts the (active) client into 'clients'.
+  void insert(Node* node);
 
   // If true, sort() will recalculate all shares.
   bool dirty;
 
-  // A set of Clients (names and shares) sorted by share.
-  std::set<Client, DRFComparator> clients;
+  // If true, the order of 'clients' has changed since 'names' was
+  // last built.
+  bool reordered;
+
+  // The active clients sorted by share. The clients are owned by
+  // 'nodes', whose elements are never moved.
+  std::vector<Client*> clients;
 
-  // Maps client names to the weights that should be applied to their shares.
-  hashmap<std::string, double> weights;
+  // The names of the active clients as last returned by sorted().
+  std::vector<std::string> names;
 
   // Total resources.
   struct Total {
@@ -143,23 +164,39 @@ private:
     // that to speed up the calculation of shares. See MESOS-2891 for
     // the reasons why we want to do that.
     //
-    // NOTE: We omit information about dynamic reservations and persistent
-    // volumes here to enable resources to be aggregated across slaves
-    // more effectively. See MESOS-4833 for more information.
-    Resources scalarQuantities;
+    // NOTE: We omit all metadata of the resources here to enable
+    // resources to be aggregated across slaves more effectively. See
+    // MESOS-4833 for more information.
+    ResourceQuantities scalarQuantities;
   } total_;
 
   // Allocation for a client.
   struct Allocation {
     hashmap<SlaveID, Resources> resources;
 
-    // Similarly, we aggregate scalars across slaves and omit information
-    // about dynamic reservations and persistent volumes. See notes above.
-    Resources scalarQuantities;
+    // Similarly, we aggregate scalars across slaves and omit all
+    // metadata of the resources. See notes above.
+    ResourceQuantities scalarQuantities;
+  };
+
+  struct Node
+  {
+    Node(const std::string& name, double _weight)
+      : client(name, 0, 0), weight(_weight), active(true) {}
+
+    Client client;
+
+    // The weight that should be applied to the share of the client.
+    double weight;
+
+    // Whether the client is contained in 'clients'.
+    bool active;
+
+    Allocation allocation;
   };
 
-  // Maps client names to the resources they have been allocated.
-  hashmap<std::string, Allocation> allocations;
+  // Maps client names to their state, either active or deactivated.
+  hashmap<std::string, Node> nodes;
 };
 
 } // namespace allocator {
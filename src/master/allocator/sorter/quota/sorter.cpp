@@ -0,0 +1,263 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <glog/logging.h>
+
+#include "master/allocator/sorter/quota/sorter.hpp"
+
+using std::list;
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace master {
+namespace allocator {
+
+QuotaSorter::QuotaSorter(Sorter* _sorter)
+  : sorter(_sorter)
+{
+  CHECK_NOTNULL(sorter);
+}
+
+
+QuotaSorter::~QuotaSorter()
+{
+  delete sorter;
+}
+
+
+void QuotaSorter::guarantee(
+    const string& name,
+    const ResourceQuantities& guarantee)
+{
+  CHECK(quotas.contains(name));
+
+  quotas.at(name).guarantee = guarantee;
+
+  refresh(name);
+}
+
+
+const ResourceQuantities& QuotaSorter::remaining(const string& name)
+{
+  CHECK(quotas.contains(name));
+
+  return quotas.at(name).remaining;
+}
+
+
+bool QuotaSorter::satisfied(const string& name)
+{
+  return remaining(name).empty();
+}
+
+
+void QuotaSorter::add(const string& name, double weight)
+{
+  CHECK(!quotas.contains(name));
+
+  sorter->add(name, weight);
+
+  // Without a guarantee the client is satisfied, so it is not sorted.
+  Quota quota;
+  quota.active = true;
+
+  quotas[name] = quota;
+
+  sorter->deactivate(name);
+}
+
+
+void QuotaSorter::update(const string& name, double weight)
+{
+  sorter->update(name, weight);
+}
+
+
+void QuotaSorter::remove(const string& name)
+{
+  sorter->remove(name);
+  quotas.erase(name);
+}
+
+
+void QuotaSorter::activate(const string& name)
+{
+  CHECK(quotas.contains(name));
+
+  Quota& quota = quotas.at(name);
+
+  if (!quota.active) {
+    quota.active = true;
+
+    if (!quota.remaining.empty()) {
+      sorter->activate(name);
+    }
+  }
+}
+
+
+void QuotaSorter::deactivate(const string& name)
+{
+  if (!quotas.contains(name)) {
+    return;
+  }
+
+  quotas.at(name).active = false;
+
+  sorter->deactivate(name);
+}
+
+
+void QuotaSorter::allocated(
+    const string& name,
+    const SlaveID& slaveId,
+    const Resources& resources)
+{
+  sorter->allocated(name, slaveId, resources);
+
+  refresh(name);
+}
+
+
+void QuotaSorter::update(
+    const string& name,
+    const SlaveID& slaveId,
+    const Resources& oldAllocation,
+    const Resources& newAllocation)
+{
+  // NOTE: The quantities of the allocation do not change.
+  sorter->update(name, slaveId, oldAllocation, newAllocation);
+}
+
+
+void QuotaSorter::unallocated(
+    const string& name,
+    const SlaveID& slaveId,
+    const Resources& resources)
+{
+  sorter->unallocated(name, slaveId, resources);
+
+  refresh(name);
+}
+
+
+const hashmap<SlaveID, Resources>& QuotaSorter::allocation(const string& name)
+{
+  return sorter->allocation(name);
+}
+
+
+const ResourceQuantities& QuotaSorter::allocationScalarQuantities(
+    const string& name)
+{
+  return sorter->allocationScalarQuantities(name);
+}
+
+
+hashmap<string, Resources> QuotaSorter::allocation(const SlaveID& slaveId)
+{
+  return sorter->allocation(slaveId);
+}
+
+
+Resources QuotaSorter::allocation(const string& name, const SlaveID& slaveId)
+{
+  return sorter->allocation(name, slaveId);
+}
+
+
+const hashmap<SlaveID, Resources>& QuotaSorter::total() const
+{
+  return sorter->total();
+}
+
+
+const ResourceQuantities& QuotaSorter::totalScalarQuantities() const
+{
+  return sorter->totalScalarQuantities();
+}
+
+
+void QuotaSorter::add(const SlaveID& slaveId, const Resources& resources)
+{
+  sorter->add(slaveId, resources);
+}
+
+
+void QuotaSorter::remove(const SlaveID& slaveId, const Resources& resources)
+{
+  sorter->remove(slaveId, resources);
+}
+
+
+void QuotaSorter::update(const SlaveID& slaveId, const Resources& resources)
+{
+  sorter->update(slaveId, resources);
+}
+
+
+list<string> QuotaSorter::sort()
+{
+  return sorter->sort();
+}
+
+
+const vector<string>& QuotaSorter::sorted()
+{
+  return sorter->sorted();
+}
+
+
+bool QuotaSorter::contains(const string& name)
+{
+  return quotas.contains(name);
+}
+
+
+int QuotaSorter::count()
+{
+  return quotas.size();
+}
+
+
+void QuotaSorter::refresh(const string& name)
+{
+  CHECK(quotas.contains(name));
+
+  Quota& quota = quotas.at(name);
+
+  const bool sorted = quota.active && !quota.remaining.empty();
+
+  quota.remaining =
+    quota.guarantee - sorter->allocationScalarQuantities(name);
+
+  if (!quota.active || sorted == !quota.remaining.empty()) {
+    return;
+  }
+
+  if (quota.remaining.empty()) {
+    sorter->deactivate(name);
+  } else {
+    sorter->activate(name);
+  }
+}
+
+} // namespace allocator {
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,149 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __MASTER_ALLOCATOR_SORTER_QUOTA_SORTER_HPP__
+#define __MASTER_ALLOCATOR_SORTER_QUOTA_SORTER_HPP__
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include <mesos/resources.hpp>
+
+#include <stout/hashmap.hpp>
+
+#include "common/resource_quantities.hpp"
+
+#include "master/allocator/sorter/sorter.hpp"
+
+
+namespace mesos {
+namespace internal {
+namespace master {
+namespace allocator {
+
+// A sorter for roles with quota, which sorts the roles using another
+// sorter but omits the roles whose quota guarantee is satisfied. For
+// that, it keeps track of the remaining guarantee of every role, i.e.,
+// of the quantities of the scalar resources the role needs to be
+// allocated in addition in order to satisfy its guarantee.
+//
+// A client that is satisfied is deactivated in the underlying sorter
+// (and activated again once it is no longer satisfied), so iterating
+// the sorted clients only takes the unsatisfied clients into account.
+class QuotaSorter : public Sorter
+{
+public:
+  // Takes ownership of the underlying sorter.
+  explicit QuotaSorter(Sorter* sorter);
+
+  virtual ~QuotaSorter();
+
+  // Sets the quota guarantee of the client, which is empty if unset.
+  void guarantee(
+      const std::string& name,
+      const ResourceQuantities& guarantee);
+
+  // Returns the quantities the client needs to be allocated in order
+  // to satisfy its quota guarantee. This is empty if it is satisfied.
+  const ResourceQuantities& remaining(const std::string& name);
+
+  // Returns true if the quota guarantee of the client is satisfied.
+  bool satisfied(const std::string& name);
+
+  virtual void add(const std::string& name, double weight = 1);
+
+  virtual void update(const std::string& name, double weight);
+
+  virtual void remove(const std::string& name);
+
+  virtual void activate(const std::string& name);
+
+  virtual void deactivate(const std::string& name);
+
+  virtual void allocated(
+      const std::string& name,
+      const SlaveID& slaveId,
+      const Resources& resources);
+
+  virtual void update(
+      const std::string& name,
+      const SlaveID& slaveId,
+      const Resources& oldAllocation,
+      const Resources& newAllocation);
+
+  virtual void unallocated(
+      const std::string& name,
+      const SlaveID& slaveId,
+      const Resources& resources);
+
+  virtual const hashmap<SlaveID, Resources>& allocation(
+      const std::string& name);
+
+  virtual const ResourceQuantities& allocationScalarQuantities(
+      const std::string& name);
+
+  virtual hashmap<std::string, Resources> allocation(const SlaveID& slaveId);
+
+  virtual Resources allocation(const std::string& name, const SlaveID& slaveId);
+
+  virtual const hashmap<SlaveID, Resources>& total() const;
+
+  virtual const ResourceQuantities& totalScalarQuantities() const;
+
+  virtual void add(const SlaveID& slaveId, const Resources& resources);
+
+  virtual void remove(const SlaveID& slaveId, const Resources& resources);
+
+  virtual void update(const SlaveID& slaveId, const Resources& resources);
+
+  // Returns the active clients whose quota guarantee is not satisfied.
+  virtual std::list<std::string> sort();
+
+  // Returns the active clients whose quota guarantee is not satisfied.
+  virtual const std::vector<std::string>& sorted();
+
+  virtual bool contains(const std::string& name);
+
+  virtual int count();
+
+private:
+  // Recalculates the remaining guarantee of the client after its
+  // allocation changed, and (de)activates it in 'sorter' accordingly.
+  void refresh(const std::string& name);
+
+  Sorter* sorter;
+
+  struct Quota
+  {
+    ResourceQuantities guarantee;
+    ResourceQuantities remaining;
+
+    // Whether the client is active, as opposed to deactivated by the
+    // user of the sorter. The client is only active in 'sorter' if it
+    // is active and its guarantee is not satisfied.
+    bool active;
+  };
+
+  hashmap<std::string, Quota> quotas;
+};
+
+} // namespace allocator {
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MASTER_ALLOCATOR_SORTER_QUOTA_SORTER_HPP__
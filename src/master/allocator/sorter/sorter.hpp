@@ -19,10 +19,13 @@
 
 #include <list>
 #include <string>
+#include <vector>
 
 #include <mesos/resources.hpp>
 #include <mesos/type_utils.hpp>
 
+#include "common/resource_quantities.hpp"
+
 namespace mesos {
 namespace internal {
 namespace master {
@@ -83,9 +86,9 @@ public:
       const std::string& client) = 0;
 
   // Returns the total scalar resource quantities that are allocated to
-  // this client. This omits metadata about dynamic reservations and
-  // persistent volumes; see `Resources::createStrippedScalarQuantity`.
-  virtual const Resources& allocationScalarQuantities(
+  // this client. This omits all metadata of the resources, such as
+  // roles, reservations and persistent volumes.
+  virtual const ResourceQuantities& allocationScalarQuantities(
       const std::string& client) = 0;
 
   // Returns the clients that have allocations on this slave.
@@ -102,9 +105,9 @@ public:
   virtual const hashmap<SlaveID, Resources>& total() const = 0;
 
   // Returns the total scalar resource quantities in this sorter. This
-  // omits metadata about dynamic reservations and persistent volumes; see
-  // `Resources::createStrippedScalarQuantity`.
-  virtual const Resources& totalScalarQuantities() const = 0;
+  // omits all metadata of the resources, such as roles, reservations
+  // and persistent volumes.
+  virtual const ResourceQuantities& totalScalarQuantities() const = 0;
 
   // Add resources to the total pool of resources this
   // Sorter should consider.
@@ -120,6 +123,12 @@ public:
   // should be allocated to, according to this Sorter's policy.
   virtual std::list<std::string> sort() = 0;
 
+  // Like `sort()`, but returns the clients without copying them into
+  // a new list. The returned vector is owned by the sorter and stays
+  // unchanged (in particular, while allocating to the clients it
+  // contains) until the next call to `sort()` or `sorted()`.
+  virtual const std::vector<std::string>& sorted() = 0;
+
   // Returns true if this Sorter contains the specified client,
   // either active or deactivated.
   virtual bool contains(const std::string& client) = 0;
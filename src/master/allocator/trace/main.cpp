@@ -0,0 +1,227 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include <mesos/master/allocator.hpp>
+
+#include <mesos/module/module.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/flags.hpp>
+#include <stout/foreach.hpp>
+#include <stout/none.hpp>
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
+#include <stout/path.hpp>
+#include <stout/stringify.hpp>
+#include <stout/try.hpp>
+
+#include "common/parse.hpp"
+
+#include "master/constants.hpp"
+
+#include "master/allocator/trace/replayer.hpp"
+
+#include "module/manager.hpp"
+
+using namespace mesos;
+using namespace mesos::internal;
+
+using mesos::internal::master::DEFAULT_ALLOCATOR;
+
+using mesos::internal::master::allocator::Replayer;
+
+using mesos::master::allocator::Allocator;
+
+using mesos::modules::ModuleManager;
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::setw;
+using std::string;
+
+
+class Flags : public flags::FlagsBase
+{
+public:
+  Flags()
+  {
+    add(&trace,
+        "trace",
+        "Path to the allocator trace to replay, as recorded by the master\n"
+        "with `--allocator_trace`.");
+
+    add(&allocator,
+        "allocator",
+        "Allocator to replay the trace against.\n"
+        "Use the default `" + string(DEFAULT_ALLOCATOR) + "` allocator, or\n"
+        "load an alternate allocator module using `--modules`.",
+        DEFAULT_ALLOCATOR);
+
+    add(&modules,
+        "modules",
+        "List of modules to be loaded, in the same format as the\n"
+        "`--modules` flag of the master.");
+
+    add(&offer_timeout,
+        "offer_timeout",
+        "Duration after which the offers that no call of the trace responds\n"
+        "to are recovered, as the master does with `--offer_timeout`. The\n"
+        "allocator may make other offers than when the trace was recorded,\n"
+        "which otherwise remain outstanding for the rest of the replay.");
+
+    add(&allocation_coalescing_window,
+        "allocation_coalescing_window",
+        "Amount of time the allocator waits for more events before it\n"
+        "allocates, see the `--allocation_coalescing_window` flag of the\n"
+        "master.");
+
+    add(&agent_ordering,
+        "agent_ordering",
+        "Order in which the allocator allocates the resources of the agents,\n"
+        "see the `--agent_ordering` flag of the master.\n"
+        "By default the allocator is initialized with the options the master\n"
+        "used when the trace was recorded. If any of the allocator's options\n"
+        "(`--allocation_coalescing_window` and `--agent_ordering`) is set,\n"
+        "these options are used instead, with the master's defaults for the\n"
+        "ones that are not set.");
+  }
+
+  Option<string> trace;
+  string allocator;
+  Option<Modules> modules;
+  Option<Duration> offer_timeout;
+  Option<Duration> allocation_coalescing_window;
+  Option<string> agent_ordering;
+};
+
+
+static void print(const string& name, const Replayer::Latencies& latencies)
+{
+  cout << std::left << setw(24) << name << std::right
+       << setw(10) << latencies.count
+       << setw(12) << stringify(latencies.p50)
+       << setw(12) << stringify(latencies.p90)
+       << setw(12) << stringify(latencies.p99)
+       << setw(12) << stringify(latencies.p999)
+       << setw(12) << stringify(latencies.max) << endl;
+}
+
+
+int main(int argc, char** argv)
+{
+  Flags flags;
+  flags.setUsageMessage(
+      "Usage: " + Path(argv[0]).basename() + " --trace=<path> [...]");
+
+  Try<Nothing> load = flags.load(None(), &argc, &argv);
+
+  if (load.isError()) {
+    cerr << flags.usage(load.error()) << endl;
+    return EXIT_FAILURE;
+  }
+
+  if (flags.help) {
+    cout << flags.usage() << endl;
+    return EXIT_SUCCESS;
+  }
+
+  if (flags.trace.isNone()) {
+    cerr << flags.usage("Missing required option --trace") << endl;
+    return EXIT_FAILURE;
+  }
+
+  if (flags.modules.isSome()) {
+    Try<Nothing> result = ModuleManager::load(flags.modules.get());
+    if (result.isError()) {
+      cerr << "Error loading modules: " << result.error() << endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  Try<Allocator*> allocator = Allocator::create(flags.allocator);
+
+  if (allocator.isError()) {
+    cerr << "Failed to create '" << flags.allocator << "' allocator: "
+         << allocator.error() << endl;
+    return EXIT_FAILURE;
+  }
+
+  // Replace the recorded options of the allocator if any is set.
+  Option<mesos::master::allocator::Options> options;
+
+  if (flags.allocation_coalescing_window.isSome() ||
+      flags.agent_ordering.isSome()) {
+    options = mesos::master::allocator::Options();
+
+    if (flags.allocation_coalescing_window.isSome()) {
+      options.get().allocationWindow =
+        flags.allocation_coalescing_window.get();
+    }
+
+    if (flags.agent_ordering.isSome()) {
+      options.get().agentOrdering = flags.agent_ordering.get();
+    }
+  }
+
+  Replayer replayer(allocator.get(), options, flags.offer_timeout);
+
+  Try<Replayer::Report> report = replayer.replay(flags.trace.get());
+
+  delete allocator.get();
+
+  if (report.isError()) {
+    cerr << report.error() << endl;
+    return EXIT_FAILURE;
+  }
+
+  cout << "Replayed " << report->calls << " calls"
+       << " in " << report->elapsed << endl;
+
+  cout << "Made " << report->offers << " offers"
+       << " (" << report->offers / report->elapsed.secs() << " per second)"
+       << " and " << report->inverseOffers << " inverse offers" << endl;
+
+  if (report->divergedCalls > 0) {
+    cout << report->divergedCalls << " calls referred to resources that"
+         << " the allocator did not allocate during the replay" << endl;
+  }
+
+  cout << endl
+       << std::left << setw(24) << "Latency" << std::right
+       << setw(10) << "count"
+       << setw(12) << "p50"
+       << setw(12) << "p90"
+       << setw(12) << "p99"
+       << setw(12) << "p99.9"
+       << setw(12) << "max" << endl;
+
+  if (report->allocations.isSome()) {
+    print("(batch allocations)", report->allocations.get());
+  }
+
+  foreachpair (const string& type,
+               const Replayer::Latencies& latencies,
+               report->latencies) {
+    print(type, latencies);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,627 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdint.h>
+
+#include <glog/logging.h>
+
+#include <process/clock.hpp>
+#include <process/dispatch.hpp>
+#include <process/id.hpp>
+#include <process/process.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/nothing.hpp>
+#include <stout/os.hpp>
+
+#include "master/allocator/trace/recorder.hpp"
+
+using std::string;
+using std::vector;
+
+using mesos::master::InverseOfferStatus;
+
+using process::Clock;
+using process::dispatch;
+using process::Future;
+using process::Process;
+
+namespace mesos {
+namespace internal {
+namespace master {
+namespace allocator {
+
+using trace::Call;
+
+
+// Writes the calls to the trace file. The calls are appended to a
+// buffer, which is written once the calls that were queued up at the
+// time have been appended, i.e., a busy recorder results in few large
+// writes rather than one write per call.
+class TraceWriterProcess : public Process<TraceWriterProcess>
+{
+public:
+  TraceWriterProcess(const string& _path, int _fd)
+    : ProcessBase(process::ID::generate("allocator-trace-writer")),
+      path(_path),
+      fd(_fd),
+      flushing(false) {}
+
+  virtual ~TraceWriterProcess() {}
+
+  // Appends the call to the trace, in the format of
+  // `::protobuf::write()`.
+  void append(const Call& call)
+  {
+    if (fd.isNone()) {
+      return;
+    }
+
+    const uint32_t size = call.ByteSize();
+    buffer.append(reinterpret_cast<const char*>(&size), sizeof(size));
+
+    if (!call.AppendToString(&buffer)) {
+      LOG(ERROR) << "Failed to serialize " << Call::Type_Name(call.type())
+                 << " for allocator trace '" << path << "'";
+
+      buffer.resize(buffer.size() - sizeof(size));
+      return;
+    }
+
+    // The flush is queued behind the calls that have already been
+    // dispatched to us, so they are written together.
+    if (!flushing) {
+      flushing = true;
+      dispatch(self(), &Self::flush);
+    }
+  }
+
+protected:
+  virtual void finalize()
+  {
+    flush();
+
+    if (fd.isSome()) {
+      Try<Nothing> close = os::close(fd.get());
+      if (close.isError()) {
+        LOG(ERROR) << "Failed to close allocator trace '" << path << "': "
+                   << close.error();
+      }
+    }
+  }
+
+private:
+  void flush()
+  {
+    flushing = false;
+
+    if (fd.isNone() || buffer.empty()) {
+      return;
+    }
+
+    Try<Nothing> write = os::write(fd.get(), buffer);
+
+    buffer.clear();
+
+    if (write.isError()) {
+      LOG(ERROR) << "Failed to write to allocator trace '" << path << "',"
+                 << " stopped recording: " << write.error();
+
+      os::close(fd.get());
+      fd = None();
+    }
+  }
+
+  const string path;
+
+  // The trace file, which is closed once writing to it failed.
+  Option<int> fd;
+
+  // The calls that have not been written yet.
+  string buffer;
+
+  // Whether a `flush()` has been dispatched.
+  bool flushing;
+};
+
+
+Try<mesos::master::allocator::Allocator*> RecordingAllocator::create(
+    mesos::master::allocator::Allocator* allocator,
+    const string& path)
+{
+  CHECK_NOTNULL(allocator);
+
+  Try<int> fd = os::open(
+      path,
+      O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC,
+      S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  if (fd.isError()) {
+    return Error(
+        "Failed to open allocator trace '" + path + "': " + fd.error());
+  }
+
+  return new RecordingAllocator(
+      allocator,
+      new TraceWriterProcess(path, fd.get()));
+}
+
+
+RecordingAllocator::RecordingAllocator(
+    mesos::master::allocator::Allocator* _allocator,
+    TraceWriterProcess* _writer)
+  : allocator(_allocator),
+    writer(_writer)
+{
+  process::spawn(writer);
+}
+
+
+RecordingAllocator::~RecordingAllocator()
+{
+  delete allocator;
+
+  // Terminating the writer flushes the calls it has not written yet.
+  process::terminate(writer, false);
+  process::wait(writer);
+  delete writer;
+}
+
+
+void RecordingAllocator::initialize(
+    const Duration& allocationInterval,
+    const lambda::function<
+        void(const FrameworkID&,
+             const hashmap<SlaveID, Resources>&)>& offerCallback,
+    const lambda::function<
+        void(const FrameworkID&,
+             const hashmap<SlaveID, UnavailableResources>&)>&
+      inverseOfferCallback,
+    const hashmap<string, double>& weights,
+    const mesos::master::allocator::Options& options)
+{
+  Call call = this->call(Call::INITIALIZE);
+  call.set_allocation_interval(allocationInterval.ns());
+  call.set_allocation_window(options.allocationWindow.ns());
+  call.set_agent_ordering(options.agentOrdering);
+
+  foreachpair (const string& role, double weight, weights) {
+    WeightInfo* weightInfo = call.add_weights();
+    weightInfo->set_role(role);
+    weightInfo->set_weight(weight);
+  }
+
+  record(call);
+
+  allocator->initialize(
+      allocationInterval,
+      offerCallback,
+      inverseOfferCallback,
+      weights,
+      options);
+}
+
+
+void RecordingAllocator::recover(
+    const int expectedAgentCount,
+    const hashmap<string, Quota>& quotas)
+{
+  Call call = this->call(Call::RECOVER);
+  call.set_expected_agent_count(expectedAgentCount);
+
+  foreachvalue (const Quota& quota, quotas) {
+    call.add_quotas()->CopyFrom(quota.info);
+  }
+
+  record(call);
+
+  allocator->recover(expectedAgentCount, quotas);
+}
+
+
+void RecordingAllocator::addFramework(
+    const FrameworkID& frameworkId,
+    const FrameworkInfo& frameworkInfo,
+    const hashmap<SlaveID, Resources>& used)
+{
+  Call call = this->call(Call::ADD_FRAMEWORK);
+  call.mutable_framework_id()->CopyFrom(frameworkId);
+  call.mutable_framework_info()->CopyFrom(frameworkInfo);
+
+  foreachpair (const SlaveID& slaveId, const Resources& resources, used) {
+    Call::Allocation* allocation = call.add_used();
+    allocation->mutable_slave_id()->CopyFrom(slaveId);
+    allocation->mutable_resources()->CopyFrom(resources);
+  }
+
+  record(call);
+
+  allocator->addFramework(frameworkId, frameworkInfo, used);
+}
+
+
+void RecordingAllocator::removeFramework(
+    const FrameworkID& frameworkId)
+{
+  Call call = this->call(Call::REMOVE_FRAMEWORK);
+  call.mutable_framework_id()->CopyFrom(frameworkId);
+
+  record(call);
+
+  allocator->removeFramework(frameworkId);
+}
+
+
+void RecordingAllocator::activateFramework(
+    const FrameworkID& frameworkId)
+{
+  Call call = this->call(Call::ACTIVATE_FRAMEWORK);
+  call.mutable_framework_id()->CopyFrom(frameworkId);
+
+  record(call);
+
+  allocator->activateFramework(frameworkId);
+}
+
+
+void RecordingAllocator::deactivateFramework(
+    const FrameworkID& frameworkId)
+{
+  Call call = this->call(Call::DEACTIVATE_FRAMEWORK);
+  call.mutable_framework_id()->CopyFrom(frameworkId);
+
+  record(call);
+
+  allocator->deactivateFramework(frameworkId);
+}
+
+
+void RecordingAllocator::updateFramework(
+    const FrameworkID& frameworkId,
+    const FrameworkInfo& frameworkInfo)
+{
+  Call call = this->call(Call::UPDATE_FRAMEWORK);
+  call.mutable_framework_id()->CopyFrom(frameworkId);
+  call.mutable_framework_info()->CopyFrom(frameworkInfo);
+
+  record(call);
+
+  allocator->updateFramework(frameworkId, frameworkInfo);
+}
+
+
+void RecordingAllocator::addSlave(
+    const SlaveID& slaveId,
+    const SlaveInfo& slaveInfo,
+    const Option<Unavailability>& unavailability,
+    const Resources& total,
+    const hashmap<FrameworkID, Resources>& used)
+{
+  Call call = this->call(Call::ADD_SLAVE);
+  call.mutable_slave_id()->CopyFrom(slaveId);
+  call.mutable_slave_info()->CopyFrom(slaveInfo);
+  call.mutable_resources()->CopyFrom(total);
+
+  if (unavailability.isSome()) {
+    call.mutable_unavailability()->CopyFrom(unavailability.get());
+  }
+
+  foreachpair (const FrameworkID& frameworkId,
+               const Resources& resources,
+               used) {
+    Call::Allocation* allocation = call.add_used();
+    allocation->mutable_framework_id()->CopyFrom(frameworkId);
+    allocation->mutable_resources()->CopyFrom(resources);
+  }
+
+  record(call);
+
+  allocator->addSlave(slaveId, slaveInfo, unavailability, total, used);
+}
+
+
+void RecordingAllocator::removeSlave(
+    const SlaveID& slaveId)
+{
+  Call call = this->call(Call::REMOVE_SLAVE);
+  call.mutable_slave_id()->CopyFrom(slaveId);
+
+  record(call);
+
+  allocator->removeSlave(slaveId);
+}
+
+
+void RecordingAllocator::updateSlave(
+    const SlaveID& slaveId,
+    const Resources& oversubscribed)
+{
+  Call call = this->call(Call::UPDATE_SLAVE);
+  call.mutable_slave_id()->CopyFrom(slaveId);
+  call.mutable_resources()->CopyFrom(oversubscribed);
+
+  record(call);
+
+  allocator->updateSlave(slaveId, oversubscribed);
+}
+
+
+void RecordingAllocator::activateSlave(
+    const SlaveID& slaveId)
+{
+  Call call = this->call(Call::ACTIVATE_SLAVE);
+  call.mutable_slave_id()->CopyFrom(slaveId);
+
+  record(call);
+
+  allocator->activateSlave(slaveId);
+}
+
+
+void RecordingAllocator::deactivateSlave(
+    const SlaveID& slaveId)
+{
+  Call call = this->call(Call::DEACTIVATE_SLAVE);
+  call.mutable_slave_id()->CopyFrom(slaveId);
+
+  record(call);
+
+  allocator->deactivateSlave(slaveId);
+}
+
+
+void RecordingAllocator::updateWhitelist(
+    const Option<hashset<string>>& whitelist)
+{
+  Call call = this->call(Call::UPDATE_WHITELIST);
+
+  if (whitelist.isSome()) {
+    Call::Whitelist* hostnames = call.mutable_whitelist();
+
+    foreach (const string& hostname, whitelist.get()) {
+      hostnames->add_hostnames(hostname);
+    }
+  }
+
+  record(call);
+
+  allocator->updateWhitelist(whitelist);
+}
+
+
+void RecordingAllocator::requestResources(
+    const FrameworkID& frameworkId,
+    const vector<Request>& requests)
+{
+  Call call = this->call(Call::REQUEST_RESOURCES);
+  call.mutable_framework_id()->CopyFrom(frameworkId);
+
+  foreach (const Request& request, requests) {
+    call.add_requests()->CopyFrom(request);
+  }
+
+  record(call);
+
+  allocator->requestResources(frameworkId, requests);
+}
+
+
+void RecordingAllocator::updateAllocation(
+    const FrameworkID& frameworkId,
+    const SlaveID& slaveId,
+    const vector<Offer::Operation>& operations)
+{
+  Call call = this->call(Call::UPDATE_ALLOCATION);
+  call.mutable_framework_id()->CopyFrom(frameworkId);
+  call.mutable_slave_id()->CopyFrom(slaveId);
+
+  foreach (const Offer::Operation& operation, operations) {
+    call.add_operations()->CopyFrom(operation);
+  }
+
+  record(call);
+
+  allocator->updateAllocation(frameworkId, slaveId, operations);
+}
+
+
+Future<Nothing> RecordingAllocator::updateAvailable(
+    const SlaveID& slaveId,
+    const vector<Offer::Operation>& operations)
+{
+  Call call = this->call(Call::UPDATE_AVAILABLE);
+  call.mutable_slave_id()->CopyFrom(slaveId);
+
+  foreach (const Offer::Operation& operation, operations) {
+    call.add_operations()->CopyFrom(operation);
+  }
+
+  record(call);
+
+  return allocator->updateAvailable(slaveId, operations);
+}
+
+
+void RecordingAllocator::updateUnavailability(
+    const SlaveID& slaveId,
+    const Option<Unavailability>& unavailability)
+{
+  Call call = this->call(Call::UPDATE_UNAVAILABILITY);
+  call.mutable_slave_id()->CopyFrom(slaveId);
+
+  if (unavailability.isSome()) {
+    call.mutable_unavailability()->CopyFrom(unavailability.get());
+  }
+
+  record(call);
+
+  allocator->updateUnavailability(slaveId, unavailability);
+}
+
+
+void RecordingAllocator::updateInverseOffer(
+    const SlaveID& slaveId,
+    const FrameworkID& frameworkId,
+    const Option<UnavailableResources>& unavailableResources,
+    const Option<InverseOfferStatus>& status,
+    const Option<Filters>& filters)
+{
+  Call call = this->call(Call::UPDATE_INVERSE_OFFER);
+  call.mutable_slave_id()->CopyFrom(slaveId);
+  call.mutable_framework_id()->CopyFrom(frameworkId);
+
+  // NOTE: The unavailability is set iff the unavailable resources are.
+  if (unavailableResources.isSome()) {
+    call.mutable_resources()->CopyFrom(unavailableResources->resources);
+    call.mutable_unavailability()->CopyFrom(
+        unavailableResources->unavailability);
+  }
+
+  if (status.isSome()) {
+    call.mutable_inverse_offer_status()->CopyFrom(status.get());
+  }
+
+  if (filters.isSome()) {
+    call.mutable_filters()->CopyFrom(filters.get());
+  }
+
+  record(call);
+
+  allocator->updateInverseOffer(
+      slaveId, frameworkId, unavailableResources, status, filters);
+}
+
+
+Future<hashmap<SlaveID, hashmap<FrameworkID, InverseOfferStatus>>>
+RecordingAllocator::getInverseOfferStatuses()
+{
+  // This does not change the state of the allocator, so we do not
+  // need to record it.
+  return allocator->getInverseOfferStatuses();
+}
+
+
+void RecordingAllocator::recoverResources(
+    const FrameworkID& frameworkId,
+    const SlaveID& slaveId,
+    const Resources& resources,
+    const Option<Filters>& filters)
+{
+  Call call = this->call(Call::RECOVER_RESOURCES);
+  call.mutable_framework_id()->CopyFrom(frameworkId);
+  call.mutable_slave_id()->CopyFrom(slaveId);
+  call.mutable_resources()->CopyFrom(resources);
+
+  if (filters.isSome()) {
+    call.mutable_filters()->CopyFrom(filters.get());
+  }
+
+  record(call);
+
+  allocator->recoverResources(frameworkId, slaveId, resources, filters);
+}
+
+
+void RecordingAllocator::suppressOffers(
+    const FrameworkID& frameworkId)
+{
+  Call call = this->call(Call::SUPPRESS_OFFERS);
+  call.mutable_framework_id()->CopyFrom(frameworkId);
+
+  record(call);
+
+  allocator->suppressOffers(frameworkId);
+}
+
+
+void RecordingAllocator::reviveOffers(
+    const FrameworkID& frameworkId)
+{
+  Call call = this->call(Call::REVIVE_OFFERS);
+  call.mutable_framework_id()->CopyFrom(frameworkId);
+
+  record(call);
+
+  allocator->reviveOffers(frameworkId);
+}
+
+
+void RecordingAllocator::setQuota(
+    const string& role,
+    const Quota& quota)
+{
+  Call call = this->call(Call::SET_QUOTA);
+  call.set_role(role);
+  call.mutable_quota()->CopyFrom(quota.info);
+
+  record(call);
+
+  allocator->setQuota(role, quota);
+}
+
+
+void RecordingAllocator::removeQuota(
+    const string& role)
+{
+  Call call = this->call(Call::REMOVE_QUOTA);
+  call.set_role(role);
+
+  record(call);
+
+  allocator->removeQuota(role);
+}
+
+
+void RecordingAllocator::updateWeights(
+    const vector<WeightInfo>& weightInfos)
+{
+  Call call = this->call(Call::UPDATE_WEIGHTS);
+
+  foreach (const WeightInfo& weightInfo, weightInfos) {
+    call.add_weights()->CopyFrom(weightInfo);
+  }
+
+  record(call);
+
+  allocator->updateWeights(weightInfos);
+}
+
+
+Call RecordingAllocator::call(Call::Type type)
+{
+  const process::Time now = Clock::now();
+
+  if (start.isNone()) {
+    start = now;
+  }
+
+  Call call;
+  call.set_type(type);
+  call.set_time((now - start.get()).ns());
+
+  return call;
+}
+
+
+void RecordingAllocator::record(const Call& call)
+{
+  dispatch(writer, &TraceWriterProcess::append, call);
+}
+
+} // namespace allocator {
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,197 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __MASTER_ALLOCATOR_TRACE_RECORDER_HPP__
+#define __MASTER_ALLOCATOR_TRACE_RECORDER_HPP__
+
+#include <string>
+#include <vector>
+
+#include <mesos/master/allocator.hpp>
+
+#include <process/future.hpp>
+#include <process/time.hpp>
+
+#include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
+#include <stout/option.hpp>
+#include <stout/try.hpp>
+
+#include "master/allocator/trace/trace.pb.h"
+
+namespace mesos {
+namespace internal {
+namespace master {
+namespace allocator {
+
+// Forward declarations.
+class TraceWriterProcess;
+
+// An allocator that records the calls the master makes to another
+// allocator into a trace file before forwarding them, so that the
+// calls can be replayed later against any allocator (see `Replayer`).
+//
+// NOTE: The calls are written to the trace file asynchronously by a
+// separate process, which batches the calls that queue up while it
+// writes, so that recording does not block the caller (i.e., the
+// master) on the file. Deleting the allocator flushes the trace. If
+// writing fails, we stop recording but continue to forward the calls.
+class RecordingAllocator : public mesos::master::allocator::Allocator
+{
+public:
+  // Creates (or truncates) the trace file at the given path. Takes
+  // ownership of the given allocator.
+  static Try<mesos::master::allocator::Allocator*> create(
+      mesos::master::allocator::Allocator* allocator,
+      const std::string& path);
+
+  virtual ~RecordingAllocator();
+
+  virtual void initialize(
+      const Duration& allocationInterval,
+      const lambda::function<
+          void(const FrameworkID&,
+               const hashmap<SlaveID, Resources>&)>& offerCallback,
+      const lambda::function<
+          void(const FrameworkID&,
+               const hashmap<SlaveID, UnavailableResources>&)>&
+        inverseOfferCallback,
+      const hashmap<std::string, double>& weights,
+      const mesos::master::allocator::Options& options);
+
+  virtual void recover(
+      const int expectedAgentCount,
+      const hashmap<std::string, Quota>& quotas);
+
+  virtual void addFramework(
+      const FrameworkID& frameworkId,
+      const FrameworkInfo& frameworkInfo,
+      const hashmap<SlaveID, Resources>& used);
+
+  virtual void removeFramework(
+      const FrameworkID& frameworkId);
+
+  virtual void activateFramework(
+      const FrameworkID& frameworkId);
+
+  virtual void deactivateFramework(
+      const FrameworkID& frameworkId);
+
+  virtual void updateFramework(
+      const FrameworkID& frameworkId,
+      const FrameworkInfo& frameworkInfo);
+
+  virtual void addSlave(
+      const SlaveID& slaveId,
+      const SlaveInfo& slaveInfo,
+      const Option<Unavailability>& unavailability,
+      const Resources& total,
+      const hashmap<FrameworkID, Resources>& used);
+
+  virtual void removeSlave(
+      const SlaveID& slaveId);
+
+  virtual void updateSlave(
+      const SlaveID& slave,
+      const Resources& oversubscribed);
+
+  virtual void activateSlave(
+      const SlaveID& slaveId);
+
+  virtual void deactivateSlave(
+      const SlaveID& slaveId);
+
+  virtual void updateWhitelist(
+      const Option<hashset<std::string>>& whitelist);
+
+  virtual void requestResources(
+      const FrameworkID& frameworkId,
+      const std::vector<Request>& requests);
+
+  virtual void updateAllocation(
+      const FrameworkID& frameworkId,
+      const SlaveID& slaveId,
+      const std::vector<Offer::Operation>& operations);
+
+  virtual process::Future<Nothing> updateAvailable(
+      const SlaveID& slaveId,
+      const std::vector<Offer::Operation>& operations);
+
+  virtual void updateUnavailability(
+      const SlaveID& slaveId,
+      const Option<Unavailability>& unavailability);
+
+  virtual void updateInverseOffer(
+      const SlaveID& slaveId,
+      const FrameworkID& frameworkId,
+      const Option<UnavailableResources>& unavailableResources,
+      const Option<mesos::master::InverseOfferStatus>& status,
+      const Option<Filters>& filters);
+
+  virtual process::Future<
+      hashmap<SlaveID, hashmap<FrameworkID, mesos::master::InverseOfferStatus>>>
+    getInverseOfferStatuses();
+
+  virtual void recoverResources(
+      const FrameworkID& frameworkId,
+      const SlaveID& slaveId,
+      const Resources& resources,
+      const Option<Filters>& filters);
+
+  virtual void suppressOffers(
+      const FrameworkID& frameworkId);
+
+  virtual void reviveOffers(
+      const FrameworkID& frameworkId);
+
+  virtual void setQuota(
+      const std::string& role,
+      const Quota& quota);
+
+  virtual void removeQuota(
+      const std::string& role);
+
+  virtual void updateWeights(
+      const std::vector<WeightInfo>& weightInfos);
+
+private:
+  RecordingAllocator(
+      mesos::master::allocator::Allocator* allocator,
+      TraceWriterProcess* writer);
+
+  RecordingAllocator(const RecordingAllocator&); // Not copyable.
+  RecordingAllocator& operator=(const RecordingAllocator&); // Not assignable.
+
+  // Returns a call of the given type at the current time.
+  trace::Call call(trace::Call::Type type);
+
+  // Appends the call to the trace.
+  void record(const trace::Call& call);
+
+  mesos::master::allocator::Allocator* allocator;
+
+  TraceWriterProcess* writer;
+
+  // The time of the first call, which the calls are relative to.
+  Option<process::Time> start;
+};
+
+} // namespace allocator {
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MASTER_ALLOCATOR_TRACE_RECORDER_HPP__
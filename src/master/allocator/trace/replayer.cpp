@@ -0,0 +1,581 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+#include <process/clock.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/os.hpp>
+#include <stout/protobuf.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/synchronized.hpp>
+
+#include "master/allocator/trace/replayer.hpp"
+
+using std::map;
+using std::string;
+using std::vector;
+
+using process::Clock;
+using process::Time;
+
+namespace mesos {
+namespace internal {
+namespace master {
+namespace allocator {
+
+using trace::Call;
+
+
+// Returns the latency percentiles of the given samples.
+static Replayer::Latencies latencies(vector<Duration> samples)
+{
+  CHECK(!samples.empty());
+
+  std::sort(samples.begin(), samples.end());
+
+  auto percentile = [&samples](double percentile) {
+    return samples[std::min(
+        samples.size() - 1,
+        static_cast<size_t>(percentile * samples.size()))];
+  };
+
+  Replayer::Latencies latencies;
+  latencies.count = samples.size();
+  latencies.p50 = percentile(0.5);
+  latencies.p90 = percentile(0.9);
+  latencies.p99 = percentile(0.99);
+  latencies.p999 = percentile(0.999);
+  latencies.max = samples.back();
+
+  return latencies;
+}
+
+
+// Returns those of the given resources that the pool contains.
+static Resources intersection(Resources pool, const Resources& resources)
+{
+  Resources result;
+
+  foreach (const Resource& resource, resources) {
+    if (pool.contains(resource)) {
+      result += resource;
+      pool -= resource;
+    }
+  }
+
+  return result;
+}
+
+
+Replayer::Replayer(
+    mesos::master::allocator::Allocator* _allocator,
+    const Option<mesos::master::allocator::Options>& _options,
+    const Option<Duration>& _offerTimeout)
+  : allocator(CHECK_NOTNULL(_allocator)),
+    options(_options),
+    offerTimeout(_offerTimeout),
+    offerCount(0),
+    inverseOfferCount(0) {}
+
+
+Try<Replayer::Report> Replayer::replay(const string& path)
+{
+  Try<int> fd = os::open(path, O_RDONLY | O_CLOEXEC);
+
+  if (fd.isError()) {
+    return Error(
+        "Failed to open allocator trace '" + path + "': " + fd.error());
+  }
+
+  Report report;
+  report.calls = 0;
+  report.divergedCalls = 0;
+
+  map<string, vector<Duration>> callSamples;
+  vector<Duration> allocationSamples;
+
+  const bool paused = Clock::paused();
+
+  Clock::pause();
+
+  const Time start = Clock::now();
+
+  Stopwatch elapsed;
+  elapsed.start();
+
+  Option<Error> error;
+
+  while (true) {
+    Result<Call> call = ::protobuf::read<Call>(fd.get());
+
+    if (call.isError()) {
+      error = Error(
+          "Failed to read allocator trace '" + path + "': " + call.error());
+      break;
+    } else if (call.isNone()) {
+      break;
+    }
+
+    Stopwatch stopwatch;
+
+    // Advance the clock to the time of the call, which performs the
+    // batch allocations that are due in the meantime.
+    const Duration delay =
+      Nanoseconds(call->time()) - (Clock::now() - start);
+
+    if (delay > Duration::zero()) {
+      stopwatch.start();
+
+      Clock::advance(delay);
+      Clock::settle();
+
+      allocationSamples.push_back(stopwatch.elapsed());
+
+      expire();
+    }
+
+    stopwatch.start();
+
+    if (!apply(call.get())) {
+      report.divergedCalls++;
+    }
+
+    Clock::settle();
+
+    callSamples[Call::Type_Name(call->type())].push_back(stopwatch.elapsed());
+
+    report.calls++;
+  }
+
+  report.elapsed = elapsed.elapsed();
+
+  if (!paused) {
+    Clock::resume();
+  }
+
+  os::close(fd.get());
+
+  if (error.isSome()) {
+    return error.get();
+  }
+
+  foreachpair (const string& type,
+               const vector<Duration>& samples,
+               callSamples) {
+    report.latencies[type] = latencies(samples);
+  }
+
+  if (!allocationSamples.empty()) {
+    report.allocations = latencies(allocationSamples);
+  }
+
+  synchronized (mutex) {
+    report.offers = offerCount;
+    report.inverseOffers = inverseOfferCount;
+  }
+
+  return report;
+}
+
+
+bool Replayer::apply(const Call& call)
+{
+  switch (call.type()) {
+    case Call::INITIALIZE: {
+      hashmap<string, double> weights;
+      foreach (const WeightInfo& weightInfo, call.weights()) {
+        weights[weightInfo.role()] = weightInfo.weight();
+      }
+
+      mesos::master::allocator::Options recorded;
+      recorded.allocationWindow = Nanoseconds(call.allocation_window());
+      recorded.agentOrdering = call.agent_ordering();
+
+      allocator->initialize(
+          Nanoseconds(call.allocation_interval()),
+          [this](const FrameworkID& frameworkId,
+                 const hashmap<SlaveID, Resources>& resources) {
+            offer(frameworkId, resources);
+          },
+          [this](const FrameworkID& frameworkId,
+                 const hashmap<SlaveID, UnavailableResources>& resources) {
+            inverseOffer(frameworkId, resources);
+          },
+          weights,
+          options.getOrElse(recorded));
+
+      return true;
+    }
+
+    case Call::RECOVER: {
+      hashmap<string, Quota> quotas;
+      foreach (const quota::QuotaInfo& info, call.quotas()) {
+        quotas[info.role()] = Quota{info};
+      }
+
+      allocator->recover(call.expected_agent_count(), quotas);
+      return true;
+    }
+
+    case Call::ADD_FRAMEWORK: {
+      hashmap<SlaveID, Resources> used;
+      foreach (const Call::Allocation& allocation, call.used()) {
+        used[allocation.slave_id()] += allocation.resources();
+      }
+
+      synchronized (mutex) {
+        foreachpair (const SlaveID& slaveId,
+                     const Resources& resources,
+                     used) {
+          allocations[call.framework_id()][slaveId] += resources;
+        }
+      }
+
+      allocator->addFramework(
+          call.framework_id(), call.framework_info(), used);
+
+      return true;
+    }
+
+    case Call::REMOVE_FRAMEWORK: {
+      synchronized (mutex) {
+        allocations.erase(call.framework_id());
+        offers.erase(call.framework_id());
+      }
+
+      allocator->removeFramework(call.framework_id());
+      return true;
+    }
+
+    case Call::ACTIVATE_FRAMEWORK:
+      allocator->activateFramework(call.framework_id());
+      return true;
+
+    case Call::DEACTIVATE_FRAMEWORK:
+      allocator->deactivateFramework(call.framework_id());
+      return true;
+
+    case Call::UPDATE_FRAMEWORK:
+      allocator->updateFramework(call.framework_id(), call.framework_info());
+      return true;
+
+    case Call::ADD_SLAVE: {
+      Option<Unavailability> unavailability;
+      if (call.has_unavailability()) {
+        unavailability = call.unavailability();
+      }
+
+      hashmap<FrameworkID, Resources> used;
+      foreach (const Call::Allocation& allocation, call.used()) {
+        used[allocation.framework_id()] += allocation.resources();
+      }
+
+      synchronized (mutex) {
+        foreachpair (const FrameworkID& frameworkId,
+                     const Resources& resources,
+                     used) {
+          allocations[frameworkId][call.slave_id()] += resources;
+        }
+      }
+
+      allocator->addSlave(
+          call.slave_id(),
+          call.slave_info(),
+          unavailability,
+          call.resources(),
+          used);
+
+      return true;
+    }
+
+    case Call::REMOVE_SLAVE: {
+      synchronized (mutex) {
+        foreachvalue (auto& slaves, allocations) {
+          slaves.erase(call.slave_id());
+        }
+
+        foreachvalue (auto& slaves, offers) {
+          slaves.erase(call.slave_id());
+        }
+      }
+
+      allocator->removeSlave(call.slave_id());
+      return true;
+    }
+
+    case Call::UPDATE_SLAVE:
+      allocator->updateSlave(call.slave_id(), call.resources());
+      return true;
+
+    case Call::ACTIVATE_SLAVE:
+      allocator->activateSlave(call.slave_id());
+      return true;
+
+    case Call::DEACTIVATE_SLAVE:
+      allocator->deactivateSlave(call.slave_id());
+      return true;
+
+    case Call::UPDATE_WHITELIST: {
+      Option<hashset<string>> whitelist;
+      if (call.has_whitelist()) {
+        whitelist = hashset<string>();
+        foreach (const string& hostname, call.whitelist().hostnames()) {
+          whitelist->insert(hostname);
+        }
+      }
+
+      allocator->updateWhitelist(whitelist);
+      return true;
+    }
+
+    case Call::REQUEST_RESOURCES:
+      allocator->requestResources(
+          call.framework_id(),
+          vector<Request>(call.requests().begin(), call.requests().end()));
+      return true;
+
+    case Call::UPDATE_ALLOCATION: {
+      const vector<mesos::Offer::Operation> operations(
+          call.operations().begin(), call.operations().end());
+
+      // The operations must apply to the resources the allocator has
+      // allocated to the framework on the agent.
+      synchronized (mutex) {
+        Resources& allocation =
+          allocations[call.framework_id()][call.slave_id()];
+
+        Try<Resources> updated = allocation.apply(operations);
+        if (updated.isError()) {
+          return false;
+        }
+
+        allocation = updated.get();
+
+        if (offers.contains(call.framework_id()) &&
+            offers.at(call.framework_id()).contains(call.slave_id())) {
+          Offer& offer = offers.at(call.framework_id()).at(call.slave_id());
+
+          Try<Resources> offered = offer.resources.apply(operations);
+          if (offered.isSome()) {
+            offer.resources = offered.get();
+          }
+        }
+      }
+
+      allocator->updateAllocation(
+          call.framework_id(), call.slave_id(), operations);
+
+      return true;
+    }
+
+    case Call::UPDATE_AVAILABLE:
+      // NOTE: The allocator fails the returned future if the operations
+      // do not apply to the available resources, which we ignore.
+      allocator->updateAvailable(
+          call.slave_id(),
+          vector<mesos::Offer::Operation>(
+              call.operations().begin(), call.operations().end()));
+      return true;
+
+    case Call::UPDATE_UNAVAILABILITY: {
+      Option<Unavailability> unavailability;
+      if (call.has_unavailability()) {
+        unavailability = call.unavailability();
+      }
+
+      allocator->updateUnavailability(call.slave_id(), unavailability);
+      return true;
+    }
+
+    case Call::UPDATE_INVERSE_OFFER: {
+      Option<UnavailableResources> unavailableResources;
+      if (call.has_unavailability()) {
+        unavailableResources =
+          UnavailableResources{call.resources(), call.unavailability()};
+      }
+
+      Option<mesos::master::InverseOfferStatus> status;
+      if (call.has_inverse_offer_status()) {
+        status = call.inverse_offer_status();
+      }
+
+      Option<Filters> filters;
+      if (call.has_filters()) {
+        filters = call.filters();
+      }
+
+      allocator->updateInverseOffer(
+          call.slave_id(),
+          call.framework_id(),
+          unavailableResources,
+          status,
+          filters);
+
+      return true;
+    }
+
+    case Call::RECOVER_RESOURCES: {
+      Option<Filters> filters;
+      if (call.has_filters()) {
+        filters = call.filters();
+
+        // The framework responded to the offer, so the offered resources
+        // that are not recovered are used by tasks now.
+        synchronized (mutex) {
+          if (offers.contains(call.framework_id())) {
+            offers.at(call.framework_id()).erase(call.slave_id());
+          }
+        }
+      }
+
+      return recover(
+          call.framework_id(),
+          call.slave_id(),
+          call.resources(),
+          filters);
+    }
+
+    case Call::SUPPRESS_OFFERS:
+      allocator->suppressOffers(call.framework_id());
+      return true;
+
+    case Call::REVIVE_OFFERS:
+      allocator->reviveOffers(call.framework_id());
+      return true;
+
+    case Call::SET_QUOTA:
+      allocator->setQuota(call.role(), Quota{call.quota()});
+      return true;
+
+    case Call::REMOVE_QUOTA:
+      allocator->removeQuota(call.role());
+      return true;
+
+    case Call::UPDATE_WEIGHTS:
+      allocator->updateWeights(
+          vector<WeightInfo>(call.weights().begin(), call.weights().end()));
+      return true;
+
+    case Call::UNKNOWN:
+      break;
+  }
+
+  LOG(WARNING) << "Ignoring call of unknown type " << call.type();
+  return false;
+}
+
+
+bool Replayer::recover(
+    const FrameworkID& frameworkId,
+    const SlaveID& slaveId,
+    const Resources& resources,
+    const Option<Filters>& filters)
+{
+  Resources recovered;
+
+  synchronized (mutex) {
+    if (allocations.contains(frameworkId) &&
+        allocations.at(frameworkId).contains(slaveId)) {
+      Resources& allocation = allocations.at(frameworkId).at(slaveId);
+
+      recovered = intersection(allocation, resources);
+      allocation -= recovered;
+    }
+  }
+
+  if (!recovered.empty()) {
+    allocator->recoverResources(frameworkId, slaveId, recovered, filters);
+  }
+
+  return recovered == resources;
+}
+
+
+void Replayer::expire()
+{
+  if (offerTimeout.isNone()) {
+    return;
+  }
+
+  const Time now = Clock::now();
+
+  hashmap<FrameworkID, hashmap<SlaveID, Resources>> expired;
+
+  synchronized (mutex) {
+    foreachpair (const FrameworkID& frameworkId, auto& slaves, offers) {
+      foreachpair (const SlaveID& slaveId, const Offer& offer, slaves) {
+        if (now - offer.time >= offerTimeout.get()) {
+          expired[frameworkId][slaveId] = offer.resources;
+        }
+      }
+
+      foreachkey (const SlaveID& slaveId, expired[frameworkId]) {
+        slaves.erase(slaveId);
+      }
+    }
+  }
+
+  foreachpair (const FrameworkID& frameworkId,
+               const auto& slaves,
+               expired) {
+    foreachpair (const SlaveID& slaveId, const Resources& resources, slaves) {
+      recover(frameworkId, slaveId, resources, None());
+    }
+  }
+
+  Clock::settle();
+}
+
+
+void Replayer::offer(
+    const FrameworkID& frameworkId,
+    const hashmap<SlaveID, Resources>& resources)
+{
+  const Time now = Clock::now();
+
+  synchronized (mutex) {
+    offerCount += resources.size();
+
+    foreachpair (const SlaveID& slaveId, const Resources& offered, resources) {
+      allocations[frameworkId][slaveId] += offered;
+
+      if (!offers[frameworkId].contains(slaveId)) {
+        offers[frameworkId][slaveId] = Offer{offered, now};
+      } else {
+        offers[frameworkId][slaveId].resources += offered;
+      }
+    }
+  }
+}
+
+
+void Replayer::inverseOffer(
+    const FrameworkID& frameworkId,
+    const hashmap<SlaveID, UnavailableResources>& resources)
+{
+  synchronized (mutex) {
+    inverseOfferCount += resources.size();
+  }
+}
+
+} // namespace allocator {
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
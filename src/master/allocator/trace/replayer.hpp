@@ -0,0 +1,174 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __MASTER_ALLOCATOR_TRACE_REPLAYER_HPP__
+#define __MASTER_ALLOCATOR_TRACE_REPLAYER_HPP__
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <mesos/master/allocator.hpp>
+
+#include <process/time.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/option.hpp>
+#include <stout/try.hpp>
+
+#include "master/allocator/trace/trace.pb.h"
+
+namespace mesos {
+namespace internal {
+namespace master {
+namespace allocator {
+
+// Replays an allocator trace (see `RecordingAllocator`) against an
+// allocator in-process, and measures how long the allocator takes to
+// process the calls.
+//
+// The replay pauses the libprocess clock and advances it to the time
+// of each call before making it, so the allocator performs its batch
+// allocations as it did when the trace was recorded, but the replay
+// takes only as long as the allocator takes.
+//
+// The replayer acts as the master regarding the offers: it keeps track
+// of the resources the allocator allocated to each framework on each
+// agent, and only recovers (or updates) those of the allocated ones
+// that the recorded calls refer to. An offer is considered responded
+// to once a recorded call recovers resources with filters for the same
+// framework and agent (i.e., the framework declined the offer, or
+// accepted it and the rest was declined), so the rest of the offer is
+// considered used by tasks. Since the allocator may make other offers
+// than it did when the trace was recorded, an offer timeout recovers
+// the offers that no recorded call responds to.
+class Replayer
+{
+public:
+  // The latency percentiles of a kind of event.
+  struct Latencies
+  {
+    size_t count;
+
+    Duration p50;
+    Duration p90;
+    Duration p99;
+    Duration p999;
+    Duration max;
+  };
+
+  struct Report
+  {
+    // The number of calls replayed.
+    size_t calls;
+
+    // The number of calls that referred to resources the allocator had
+    // not allocated (or not all of them) during the replay. The more
+    // calls diverged, the less the replay resembles the recorded run.
+    size_t divergedCalls;
+
+    // The number of offers, i.e., of allocations to a framework on an
+    // agent, and of inverse offers that the allocator made.
+    size_t offers;
+    size_t inverseOffers;
+
+    // The wall clock time the replay took.
+    Duration elapsed;
+
+    // The time it took to make a call, including the allocation it
+    // may trigger, by the type of the call.
+    std::map<std::string, Latencies> latencies;
+
+    // The time it took to advance the clock to the next call, during
+    // which the allocator performs its batch allocations.
+    Option<Latencies> allocations;
+  };
+
+  // Does not take ownership of the allocator, which must not have been
+  // initialized yet. If `options` are given, the allocator is
+  // initialized with them instead of the options the master used when
+  // the trace was recorded.
+  Replayer(
+      mesos::master::allocator::Allocator* allocator,
+      const Option<mesos::master::allocator::Options>& options = None(),
+      const Option<Duration>& offerTimeout = None());
+
+  // Replays the trace at the given path. The replayer can only be used
+  // for a single replay.
+  Try<Report> replay(const std::string& path);
+
+private:
+  Replayer(const Replayer&); // Not copyable.
+  Replayer& operator=(const Replayer&); // Not assignable.
+
+  // Makes the call to the allocator. Returns false if the call referred
+  // to resources that the allocator did not allocate.
+  bool apply(const trace::Call& call);
+
+  // Recovers the allocated resources among the given ones. Returns
+  // false if not all of the given resources are allocated.
+  bool recover(
+      const FrameworkID& frameworkId,
+      const SlaveID& slaveId,
+      const Resources& resources,
+      const Option<Filters>& filters);
+
+  // Recovers the offers that have not been responded to in time.
+  void expire();
+
+  // The callbacks of the allocator, which are invoked by the allocator
+  // while we wait for it to settle.
+  void offer(
+      const FrameworkID& frameworkId,
+      const hashmap<SlaveID, Resources>& resources);
+
+  void inverseOffer(
+      const FrameworkID& frameworkId,
+      const hashmap<SlaveID, UnavailableResources>& resources);
+
+  mesos::master::allocator::Allocator* allocator;
+
+  const Option<mesos::master::allocator::Options> options;
+  const Option<Duration> offerTimeout;
+
+  struct Offer
+  {
+    Resources resources;
+    process::Time time;
+  };
+
+  // Protects the state that the callbacks update.
+  std::mutex mutex;
+
+  // The resources the allocator allocated to each framework on each
+  // agent, including those used by tasks.
+  hashmap<FrameworkID, hashmap<SlaveID, Resources>> allocations;
+
+  // The offers that have not been responded to.
+  hashmap<FrameworkID, hashmap<SlaveID, Offer>> offers;
+
+  size_t offerCount;
+  size_t inverseOfferCount;
+};
+
+} // namespace allocator {
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MASTER_ALLOCATOR_TRACE_REPLAYER_HPP__
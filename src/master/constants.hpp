@@ -85,6 +85,26 @@ constexpr size_t DEFAULT_MAX_COMPLETED_FRAMEWORKS = 50;
 // to store in the cache.
 constexpr size_t DEFAULT_MAX_COMPLETED_TASKS_PER_FRAMEWORK = 1000;
 
+// Default maximum age of the snapshot of the state that the `/state`
+// endpoint is served from.
+constexpr Duration DEFAULT_MAX_STATE_SNAPSHOT_AGE = Duration::zero();
+
+// Default maximum number of events queued for a subscriber of the
+// `/events` endpoint.
+constexpr size_t DEFAULT_MAX_SUBSCRIBER_QUEUE_SIZE = 1000;
+
+// Factor of the maximum number of events queued for a subscriber of the
+// `/events` endpoint that bounds the events held back for it while its
+// snapshot is serialized, which may take a while in large clusters.
+constexpr size_t SUBSCRIBER_HELD_EVENTS_FACTOR = 10;
+
+// Default period of the events that the master profiles, i.e., one in
+// every that many events is profiled.
+constexpr size_t DEFAULT_EVENT_PROFILING_PERIOD = 100;
+
+// Default number of handlers (limit) for the `/profile` endpoint.
+constexpr size_t PROFILE_LIMIT = 10;
+
 // Time interval to check for updated watchers list.
 constexpr Duration WHITELIST_WATCH_INTERVAL = Seconds(5);
 
@@ -118,6 +138,13 @@ constexpr char DEFAULT_ALLOCATOR[] = "HierarchicalDRF";
 // The default interval between allocations.
 constexpr Duration DEFAULT_ALLOCATION_INTERVAL = Seconds(1);
 
+// Default time to wait for more events before performing an allocation
+// triggered by an event.
+constexpr Duration DEFAULT_ALLOCATION_COALESCING_WINDOW = Duration::zero();
+
+// Default order in which the resources of the agents are allocated.
+constexpr char DEFAULT_AGENT_ORDERING[] = "random";
+
 // Name of the default, local authorizer.
 constexpr char DEFAULT_AUTHORIZER[] = "local";
 
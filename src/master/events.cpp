@@ -0,0 +1,329 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include <glog/logging.h>
+
+#include <process/defer.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/jsonify.hpp>
+#include <stout/nothing.hpp>
+
+#include "common/http.hpp"
+
+#include "master/events.hpp"
+#include "master/master.hpp"
+
+using process::Future;
+using process::Owned;
+using process::UPID;
+
+using process::http::Pipe;
+
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace master {
+namespace events {
+
+// Returns an event of the given type about the given value.
+template <typename T>
+static string event(const string& type, const string& key, const T& value)
+{
+  return jsonify([&type, &key, &value](JSON::ObjectWriter* writer) {
+    writer->field("type", type);
+    writer->field(key, value);
+  });
+}
+
+
+string snapshot(const string& state)
+{
+  return event("SNAPSHOT", "snapshot", [&state](JSON::RawWriter* writer) {
+    writer->append(state);
+  });
+}
+
+
+string taskAdded(const Task& task)
+{
+  return event("TASK_ADDED", "task", task);
+}
+
+
+string taskUpdated(const Task& task)
+{
+  return event("TASK_UPDATED", "task", task);
+}
+
+
+string slaveAdded(const Slave& slave)
+{
+  return event("SLAVE_ADDED", "slave", [&slave](JSON::ObjectWriter* writer) {
+    writer->field("id", slave.id.value());
+    writer->field("pid", string(slave.pid));
+    writer->field("hostname", slave.info.hostname());
+    writer->field("resources", slave.totalResources);
+    writer->field("active", slave.active);
+    writer->field("version", slave.version);
+  });
+}
+
+
+string slaveRemoved(const SlaveID& slaveId)
+{
+  return event(
+      "SLAVE_REMOVED",
+      "slave",
+      [&slaveId](JSON::ObjectWriter* writer) {
+        writer->field("id", slaveId.value());
+      });
+}
+
+
+// Returns the representation of a framework in the events.
+static void describe(JSON::ObjectWriter* writer, const Framework& framework)
+{
+  writer->field("id", framework.id().value());
+  writer->field("name", framework.info.name());
+  writer->field("user", framework.info.user());
+  writer->field("role", framework.info.role());
+
+  // Omit pid for http frameworks.
+  if (framework.pid.isSome()) {
+    writer->field("pid", string(framework.pid.get()));
+  }
+
+  writer->field("active", framework.active);
+  writer->field("connected", framework.connected);
+}
+
+
+string frameworkAdded(const Framework& framework)
+{
+  return event(
+      "FRAMEWORK_ADDED",
+      "framework",
+      [&framework](JSON::ObjectWriter* writer) {
+        describe(writer, framework);
+      });
+}
+
+
+string frameworkUpdated(const Framework& framework)
+{
+  return event(
+      "FRAMEWORK_UPDATED",
+      "framework",
+      [&framework](JSON::ObjectWriter* writer) {
+        describe(writer, framework);
+      });
+}
+
+
+string frameworkRemoved(const FrameworkID& frameworkId)
+{
+  return event(
+      "FRAMEWORK_REMOVED",
+      "framework",
+      [&frameworkId](JSON::ObjectWriter* writer) {
+        writer->field("id", frameworkId.value());
+      });
+}
+
+
+string offerAdded(const Offer& offer)
+{
+  return event("OFFER_ADDED", "offer", [&offer](JSON::ObjectWriter* writer) {
+    writer->field("id", offer.id().value());
+    writer->field("framework_id", offer.framework_id().value());
+    writer->field("slave_id", offer.slave_id().value());
+    writer->field("resources", Resources(offer.resources()));
+  });
+}
+
+
+string offerRemoved(const Offer& offer)
+{
+  return event(
+      "OFFER_REMOVED",
+      "offer",
+      [&offer](JSON::ObjectWriter* writer) {
+        writer->field("id", offer.id().value());
+        writer->field("framework_id", offer.framework_id().value());
+        writer->field("slave_id", offer.slave_id().value());
+      });
+}
+
+} // namespace events {
+
+
+Subscribers::Subscribers(
+    const UPID& _pid,
+    size_t _capacity,
+    size_t _heldCapacity)
+  : pid(_pid),
+    capacity(_capacity),
+    heldCapacity(_heldCapacity),
+    encoder([](const string& event) { return event; }) {}
+
+
+Subscribers::~Subscribers()
+{
+  foreachvalue (const Owned<Subscriber>& subscriber, subscribers) {
+    subscriber->writer.close();
+  }
+}
+
+
+UUID Subscribers::add(const Pipe::Writer& writer)
+{
+  const UUID id = UUID::random();
+
+  subscribers[id] = Owned<Subscriber>(new Subscriber(writer));
+
+  // NOTE: The subscribers are owned by the master, which the callback
+  // is deferred to, hence `this` is valid when the callback runs.
+  writer.readerClosed()
+    .onAny(process::defer(pid, [this, id](const Future<Nothing>&) {
+      if (subscribers.contains(id)) {
+        LOG(INFO) << "Removing disconnected subscriber " << id;
+        remove(id);
+      }
+    }));
+
+  return id;
+}
+
+
+void Subscribers::start(const UUID& id, const Future<string>& snapshot)
+{
+  if (!subscribers.contains(id)) {
+    return;
+  }
+
+  Owned<Subscriber> subscriber = subscribers[id];
+
+  if (!snapshot.isReady()) {
+    subscriber->writer.fail(
+        "Failed to serialize the snapshot: " +
+        (snapshot.isFailed() ? snapshot.failure() : "discarded"));
+
+    remove(id);
+    return;
+  }
+
+  subscriber->queue.push_front(
+      encoder.encode(events::snapshot(snapshot.get())));
+  subscriber->started = true;
+
+  flush(id);
+}
+
+
+void Subscribers::send(const string& event)
+{
+  const string record = encoder.encode(event);
+
+  vector<UUID> overflowed;
+
+  foreachpair (const UUID& id, const Owned<Subscriber>& subscriber,
+               subscribers) {
+    // The events of a subscriber that has not been started yet are
+    // held back until its snapshot has been serialized, which does not
+    // depend on the subscriber, hence they count against its (larger)
+    // capacity for held back events. They are written out along with
+    // the snapshot.
+    const size_t limit = subscriber->started ? capacity : heldCapacity;
+
+    if (subscriber->queue.size() >= limit) {
+      overflowed.push_back(id);
+      continue;
+    }
+
+    subscriber->queue.push_back(record);
+  }
+
+  foreach (const UUID& id, overflowed) {
+    LOG(WARNING) << "Disconnecting subscriber " << id << " that has more than "
+                 << (subscribers[id]->started ? capacity : heldCapacity)
+                 << " events queued";
+
+    subscribers[id]->writer.fail("Too many events queued for the subscriber");
+    remove(id);
+  }
+
+  // NOTE: We iterate over a copy of the ids because `flush()` removes
+  // a subscriber whose reader has been closed, which can happen before
+  // the callback on `readerClosed()` has run.
+  foreach (const UUID& id, subscribers.keys()) {
+    flush(id);
+  }
+}
+
+
+void Subscribers::flush(const UUID& id)
+{
+  CHECK(subscribers.contains(id));
+
+  Owned<Subscriber> subscriber = subscribers[id];
+
+  if (!subscriber->started ||
+      subscriber->writing ||
+      subscriber->queue.empty()) {
+    return;
+  }
+
+  string batch;
+  foreach (const string& record, subscriber->queue) {
+    batch += record;
+  }
+
+  subscriber->queue.clear();
+
+  if (!subscriber->writer.write(batch)) {
+    remove(id);
+    return;
+  }
+
+  // Hold back the next batch until the pipe has been read.
+  subscriber->writing = true;
+
+  subscriber->writer.drained()
+    .onAny(process::defer(pid, [this, id](const Future<Nothing>&) {
+      if (subscribers.contains(id)) {
+        subscribers[id]->writing = false;
+        flush(id);
+      }
+    }));
+}
+
+
+void Subscribers::remove(const UUID& id)
+{
+  CHECK(subscribers.contains(id));
+
+  subscribers[id]->writer.close();
+  subscribers.erase(id);
+}
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,152 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __MASTER_EVENTS_HPP__
+#define __MASTER_EVENTS_HPP__
+
+#include <deque>
+#include <string>
+
+#include <mesos/mesos.hpp>
+
+#include <process/future.hpp>
+#include <process/http.hpp>
+#include <process/owned.hpp>
+#include <process/pid.hpp>
+
+#include <stout/hashmap.hpp>
+#include <stout/recordio.hpp>
+#include <stout/uuid.hpp>
+
+#include "messages/messages.hpp"
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// Forward declarations.
+struct Framework;
+struct Slave;
+
+
+// The events of the `/events` endpoint, as JSON objects with the type
+// of the event and the entity that it is about.
+namespace events {
+
+// Wraps the serialization of the state of the master (see
+// `StateSnapshot`), which is the first event of every subscriber.
+std::string snapshot(const std::string& state);
+
+std::string taskAdded(const Task& task);
+std::string taskUpdated(const Task& task);
+
+std::string slaveAdded(const Slave& slave);
+std::string slaveRemoved(const SlaveID& slaveId);
+
+std::string frameworkAdded(const Framework& framework);
+std::string frameworkUpdated(const Framework& framework);
+std::string frameworkRemoved(const FrameworkID& frameworkId);
+
+std::string offerAdded(const Offer& offer);
+std::string offerRemoved(const Offer& offer);
+
+} // namespace events {
+
+
+// The subscribers of the `/events` endpoint, which stream the events
+// of the master as RecordIO records over their HTTP responses.
+//
+// Every subscriber has a bounded queue of the events that have not
+// been written to its response yet. The events are written out in
+// batches, once the previous batch has been read off the pipe of the
+// response, so that a slow subscriber does not buffer an unbounded
+// number of events in the master. A subscriber whose queue overflows
+// is disconnected. The events sent while the snapshot of a subscriber
+// is serialized are held back regardless of how fast the subscriber
+// reads, hence they are bounded separately (and more loosely), and a
+// subscriber that is held back too many events is dropped.
+//
+// NOTE: The subscribers belong to the master, and must only be used
+// in its context.
+class Subscribers
+{
+public:
+  // The subscribers defer the callbacks of their pipes to the given
+  // process, i.e., the master. A subscriber may have `capacity` events
+  // queued once started, and `heldCapacity` events held back before.
+  Subscribers(
+      const process::UPID& pid,
+      size_t capacity,
+      size_t heldCapacity);
+
+  // Closes the responses of the subscribers.
+  ~Subscribers();
+
+  // Adds a subscriber, whose events are held back until it is started
+  // with the snapshot that it was subscribed along with.
+  UUID add(const process::http::Pipe::Writer& writer);
+
+  // Writes out the snapshot event (or fails the response if the
+  // snapshot could not be serialized), followed by the events that
+  // were held back.
+  void start(const UUID& id, const process::Future<std::string>& snapshot);
+
+  // Sends an event (see `events`) to all the subscribers.
+  void send(const std::string& event);
+
+  // NOTE: Callers check this before serializing an event, which would
+  // be wasted without subscribers.
+  bool empty() const { return subscribers.empty(); }
+
+  size_t size() const { return subscribers.size(); }
+
+private:
+  struct Subscriber
+  {
+    explicit Subscriber(const process::http::Pipe::Writer& _writer)
+      : writer(_writer), started(false), writing(false) {}
+
+    process::http::Pipe::Writer writer;
+
+    // The records that have not been written to the pipe yet.
+    std::deque<std::string> queue;
+
+    bool started;
+
+    // Whether a batch of records is in the pipe, unread.
+    bool writing;
+  };
+
+  // Writes the queued records to the pipe of a subscriber, unless the
+  // last batch has not been read yet.
+  void flush(const UUID& id);
+
+  void remove(const UUID& id);
+
+  const process::UPID pid;
+  const size_t capacity;
+  const size_t heldCapacity;
+
+  ::recordio::Encoder<std::string> encoder;
+
+  hashmap<UUID, process::Owned<Subscriber>> subscribers;
+};
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MASTER_EVENTS_HPP__
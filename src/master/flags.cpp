@@ -177,9 +177,33 @@ mesos::internal::master::Flags::Flags()
   add(&Flags::allocation_interval,
       "allocation_interval",
       "Amount of time to wait between performing\n"
-      " (batch) allocations (e.g., 500ms, 1sec, etc).",
+      " (batch) allocations (e.g., 500ms, 1sec, etc). A batch allocation\n"
+      " only considers the agents and frameworks that changed since they\n"
+      " were last allocated (e.g., because offers were declined), unless\n"
+      " quota is set and anything changed.",
       DEFAULT_ALLOCATION_INTERVAL);
 
+  add(&Flags::allocation_coalescing_window,
+      "allocation_coalescing_window",
+      "Amount of time to wait for more events after an event that triggers\n"
+      "an allocation (e.g., a framework or an agent is added, or offers are\n"
+      "revived) before performing it, so that a burst of events results in\n"
+      "a single allocation. Events queued up in the allocator are always\n"
+      "coalesced, even with the default of zero.",
+      DEFAULT_ALLOCATION_COALESCING_WINDOW);
+
+  add(&Flags::agent_ordering,
+      "agent_ordering",
+      "Order in which the allocator allocates the resources of the agents.\n"
+      "`random` shuffles the agents for every allocation. `best_fit` fills\n"
+      "up the agents with the smallest share of free resources first,\n"
+      "which leaves whole agents free for large tasks. `spread` starts\n"
+      "with the agents with the largest share of free resources instead.\n"
+      "`attribute:<name>` allocates the agents with the same value of the\n"
+      "named attribute (e.g., `attribute:rack`) one after another.\n"
+      "Only applies to the default allocator.",
+      DEFAULT_AGENT_ORDERING);
+
   add(&Flags::cluster,
       "cluster",
       "Human readable name for the cluster, displayed in the webui.");
@@ -403,6 +427,13 @@ mesos::internal::master::Flags::Flags()
       "load an alternate allocator module using `--modules`.",
       DEFAULT_ALLOCATOR);
 
+  add(&Flags::allocator_trace,
+      "allocator_trace",
+      "Path of a file to record the calls the master makes to the\n"
+      "allocator into, so that they can be replayed offline against any\n"
+      "allocator with `mesos-allocator-replay`. The file is truncated\n"
+      "when the master starts.");
+
   add(&Flags::hooks,
       "hooks",
       "A comma-separated list of hook modules to be\n"
@@ -472,4 +503,38 @@ mesos::internal::master::Flags::Flags()
       "max_completed_tasks_per_framework",
       "Maximum number of completed tasks per framework to store in memory.",
       DEFAULT_MAX_COMPLETED_TASKS_PER_FRAMEWORK);
+
+  add(&Flags::max_state_snapshot_age,
+      "max_state_snapshot_age",
+      "Maximum age of the snapshot of the master's state that requests to\n"
+      "the `/state` and `/frameworks` endpoints are served from after the\n"
+      "state has changed. The master reuses its last snapshot for as long\n"
+      "as its state does not change, and otherwise takes a new snapshot for\n"
+      "a request once the last one is older, so that polling the endpoints\n"
+      "frequently costs the master less in large, busy clusters.\n"
+      "By default, requests see every change of the state. Taking a\n"
+      "snapshot copies the agents, frameworks, executors and offers in the\n"
+      "master's context, which costs the master work proportional to the\n"
+      "size of the cluster. A request whose `If-None-Match` header matches\n"
+      "the current state gets `304 Not Modified` without a snapshot.",
+      DEFAULT_MAX_STATE_SNAPSHOT_AGE);
+
+  add(&Flags::max_subscriber_queue_size,
+      "max_subscriber_queue_size",
+      "Maximum number of events queued for a subscriber of the `/events`\n"
+      "endpoint that have not been read yet. A subscriber that falls further\n"
+      "behind is disconnected, so that it does not hold on to the memory\n"
+      "of the master. While the snapshot of a new subscriber is serialized,\n"
+      "up to ten times as many events are held back for it.",
+      DEFAULT_MAX_SUBSCRIBER_QUEUE_SIZE);
+
+  add(&Flags::event_profiling_period,
+      "event_profiling_period",
+      "The master profiles one in every this many of the events (i.e.,\n"
+      "messages and dispatches) that it processes, by timing how long the\n"
+      "event was queued and how long it took to process. The timings are\n"
+      "exported per handler under `master/handlers/` by the\n"
+      "`/metrics/snapshot` endpoint, and summed up by the `/profile`\n"
+      "endpoint. A value of 0 disables the profiling.",
+      DEFAULT_EVENT_PROFILING_PERIOD);
 }
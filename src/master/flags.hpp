@@ -61,6 +61,8 @@ public:
   std::string user_sorter;
   std::string framework_sorter;
   Duration allocation_interval;
+  Duration allocation_coalescing_window;
+  std::string agent_ordering;
   Option<std::string> cluster;
   Option<std::string> roles;
   Option<std::string> weights;
@@ -75,6 +77,7 @@ public:
   Option<Modules> modules;
   std::string authenticators;
   std::string allocator;
+  Option<std::string> allocator_trace;
   Option<std::string> hooks;
   Duration slave_ping_timeout;
   size_t max_slave_ping_timeouts;
@@ -82,6 +85,9 @@ public:
   std::string http_authenticators;
   size_t max_completed_frameworks;
   size_t max_completed_tasks_per_framework;
+  Duration max_state_snapshot_age;
+  size_t max_subscriber_queue_size;
+  size_t event_profiling_period;
 
 #ifdef WITH_NETWORK_ISOLATOR
   Option<size_t> max_executors_per_slave;
@@ -14,9 +14,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <functional>
 #include <iomanip>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <sstream>
 #include <string>
@@ -32,6 +35,8 @@
 
 #include <mesos/maintenance/maintenance.hpp>
 
+#include <process/async.hpp>
+#include <process/clock.hpp>
 #include <process/defer.hpp>
 #include <process/help.hpp>
 
@@ -67,6 +72,7 @@
 #include "master/machine.hpp"
 #include "master/maintenance.hpp"
 #include "master/master.hpp"
+#include "master/snapshot.hpp"
 #include "master/validation.hpp"
 
 #include "mesos/mesos.hpp"
@@ -152,10 +158,19 @@ struct Full : Representation<T>
 };
 
 
-static void json(JSON::ObjectWriter* writer, const Summary<Slave>& summary)
+// Splices the JSON of a task that has been serialized before.
+static void json(JSON::RawWriter* writer, const TaskFragment& fragment)
 {
-  const Slave& slave = summary;
+  writer->append(fragment.json());
+}
 
+
+// NOTE: The representations of the slaves and the frameworks below
+// apply to both the master's objects and their snapshots (see
+// `StateSnapshot`), which have the same members.
+template <typename SlaveType>
+static void summarizeSlave(JSON::ObjectWriter* writer, const SlaveType& slave)
+{
   writer->field("id", slave.id.value());
   writer->field("pid", string(slave.pid));
   writer->field("hostname", slave.info.hostname());
@@ -178,18 +193,11 @@ static void json(JSON::ObjectWriter* writer, const Summary<Slave>& summary)
 }
 
 
-static void json(JSON::ObjectWriter* writer, const Full<Slave>& full)
-{
-  const Slave& slave = full;
-
-  json(writer, Summary<Slave>(slave));
-}
-
-
-static void json(JSON::ObjectWriter* writer, const Summary<Framework>& summary)
+template <typename FrameworkType>
+static void summarizeFramework(
+    JSON::ObjectWriter* writer,
+    const FrameworkType& framework)
 {
-  const Framework& framework = summary;
-
   writer->field("id", framework.id().value());
   writer->field("name", framework.info.name());
 
@@ -208,11 +216,12 @@ static void json(JSON::ObjectWriter* writer, const Summary<Framework>& summary)
 }
 
 
-static void json(JSON::ObjectWriter* writer, const Full<Framework>& full)
+template <typename FrameworkType>
+static void describeFramework(
+    JSON::ObjectWriter* writer,
+    const FrameworkType& framework)
 {
-  const Framework& framework = full;
-
-  json(writer, Summary<Framework>(framework));
+  summarizeFramework(writer, framework);
 
   // Add additional fields to those generated by the
   // `Summary<Framework>` overload.
@@ -267,20 +276,20 @@ static void json(JSON::ObjectWriter* writer, const Full<Framework>& full)
       });
     }
 
-    foreachvalue (Task* task, framework.tasks) {
+    foreachvalue (const auto& task, framework.tasks) {
       writer->element(*task);
     }
   });
 
   writer->field("completed_tasks", [&framework](JSON::ArrayWriter* writer) {
-    foreach (const std::shared_ptr<Task>& task, framework.completedTasks) {
+    foreach (const auto& task, framework.completedTasks) {
       writer->element(*task);
     }
   });
 
   // Model all of the offers associated with a framework.
   writer->field("offers", [&framework](JSON::ArrayWriter* writer) {
-    foreach (Offer* offer, framework.offers) {
+    foreach (const auto& offer, framework.offers) {
       writer->element(*offer);
     }
   });
@@ -305,6 +314,40 @@ static void json(JSON::ObjectWriter* writer, const Full<Framework>& full)
 }
 
 
+static void json(JSON::ObjectWriter* writer, const Summary<Slave>& summary)
+{
+  summarizeSlave<Slave>(writer, summary);
+}
+
+
+static void json(JSON::ObjectWriter* writer, const Full<Slave>& full)
+{
+  summarizeSlave<Slave>(writer, full);
+}
+
+
+static void json(
+    JSON::ObjectWriter* writer,
+    const Full<StateSnapshot::Slave>& full)
+{
+  summarizeSlave<StateSnapshot::Slave>(writer, full);
+}
+
+
+static void json(JSON::ObjectWriter* writer, const Summary<Framework>& summary)
+{
+  summarizeFramework<Framework>(writer, summary);
+}
+
+
+static void json(
+    JSON::ObjectWriter* writer,
+    const Full<StateSnapshot::Framework>& full)
+{
+  describeFramework<StateSnapshot::Framework>(writer, full);
+}
+
+
 void Master::Http::log(const Request& request)
 {
   Option<string> userAgent = request.headers.get("User-Agent");
@@ -740,10 +783,64 @@ Future<Response> Master::Http::destroyVolumes(
 }
 
 
+string Master::Http::EVENTS_HELP()
+{
+  return HELP(
+    TLDR("Streams the events of the master."),
+    DESCRIPTION(
+        "Streams a snapshot of the state of the master, as exposed by the",
+        "/state endpoint, followed by an event whenever a task is added or",
+        "updated, an agent is added or removed, a framework is added,",
+        "updated or removed, or an offer is added or removed.",
+        "",
+        "The events are JSON objects with a 'type' field (i.e., SNAPSHOT,",
+        "TASK_ADDED, TASK_UPDATED, SLAVE_ADDED, SLAVE_REMOVED,",
+        "FRAMEWORK_ADDED, FRAMEWORK_UPDATED, FRAMEWORK_REMOVED,",
+        "OFFER_ADDED or OFFER_REMOVED), encoded in the RecordIO format.",
+        "",
+        "A subscriber that does not keep up with the events is",
+        "disconnected (see the --max_subscriber_queue_size flag)."),
+    AUTHENTICATION(true));
+}
+
+
+Future<Response> Master::Http::events(
+    const Request& request,
+    const Option<string>& /*principal*/) const
+{
+  // The events that happen while the snapshot is serialized are held
+  // back until the snapshot has been written out.
+  std::shared_ptr<const StateSnapshot> snapshot(new StateSnapshot(master));
+
+  Pipe pipe;
+  const UUID id = master->subscribers.add(pipe.writer());
+
+  LOG(INFO) << "Added subscriber " << id << " of the events";
+
+  process::async([snapshot]() -> string { return jsonify(*snapshot); })
+    .onAny(defer(master->self(), [this, id](const Future<string>& state) {
+      master->subscribers.start(id, state);
+    }));
+
+  OK ok;
+  ok.headers["Content-Type"] = "application/json";
+  ok.type = Response::PIPE;
+  ok.reader = pipe.reader();
+
+  return ok;
+}
+
+
 string Master::Http::FRAMEWORKS_HELP()
 {
   return HELP(
     TLDR("Exposes the frameworks info."),
+    DESCRIPTION(
+        "Query parameters:",
+        "",
+        ">        framework_id=VALUE   Only exposes the framework.",
+        ">        role=VALUE           Only exposes the frameworks of the "
+        "role."),
     AUTHENTICATION(true));
 }
 
@@ -752,37 +849,145 @@ Future<Response> Master::Http::frameworks(
     const Request& request,
     const Option<string>& /*principal*/) const
 {
-  auto frameworks = [this](JSON::ObjectWriter* writer) {
-    // Model all of the frameworks.
-    writer->field("frameworks", [this](JSON::ArrayWriter* writer) {
-      foreachvalue (Framework* framework, master->frameworks.registered) {
-        writer->element(Full<Framework>(*framework));
-      }
-    });
+  // Like the `/state` endpoint, the frameworks are serialized from a
+  // snapshot on another core.
+  std::shared_ptr<const StateSnapshot> snapshot = this->snapshot();
+
+  const Option<string> jsonp = request.url.query.get("jsonp");
+  const Option<string> frameworkId = request.url.query.get("framework_id");
+  const Option<string> role = request.url.query.get("role");
+
+  return process::async([snapshot, jsonp, frameworkId, role]() -> Response {
+    auto matches = [&frameworkId, &role](
+        const StateSnapshot::Framework& framework) {
+      return (frameworkId.isNone() ||
+              framework.id().value() == frameworkId.get()) &&
+             (role.isNone() || framework.info.role() == role.get());
+    };
+
+    auto frameworks = [&snapshot, &matches, &frameworkId, &role](
+        JSON::ObjectWriter* writer) {
+      // Model all of the frameworks.
+      writer->field(
+          "frameworks",
+          [&snapshot, &matches](JSON::ArrayWriter* writer) {
+            foreach (const StateSnapshot::Framework& framework,
+                     snapshot->frameworks) {
+              if (matches(framework)) {
+                writer->element(Full<StateSnapshot::Framework>(framework));
+              }
+            }
+          });
 
-    // Model all of the completed frameworks.
-    writer->field("completed_frameworks", [this](JSON::ArrayWriter* writer) {
-      foreach (const std::shared_ptr<Framework>& framework,
-               master->frameworks.completed) {
-        writer->element(Full<Framework>(*framework));
-      }
-    });
+      // Model all of the completed frameworks.
+      writer->field(
+          "completed_frameworks",
+          [&snapshot, &matches](JSON::ArrayWriter* writer) {
+            foreach (const StateSnapshot::Framework& framework,
+                     snapshot->completedFrameworks) {
+              if (matches(framework)) {
+                writer->element(Full<StateSnapshot::Framework>(framework));
+              }
+            }
+          });
 
-    // Model all currently unregistered frameworks. This can happen
-    // when a framework has yet to re-register after master failover.
-    writer->field("unregistered_frameworks", [this](JSON::ArrayWriter* writer) {
-      // Find unregistered frameworks.
-      foreachvalue (const Slave* slave, master->slaves.registered) {
-        foreachkey (const FrameworkID& frameworkId, slave->tasks) {
-          if (!master->frameworks.registered.contains(frameworkId)) {
-            writer->element(frameworkId.value());
-          }
-        }
+      // Model all currently unregistered frameworks. This can happen
+      // when a framework has yet to re-register after master failover.
+      // NOTE: The roles of these frameworks are not known.
+      writer->field(
+          "unregistered_frameworks",
+          [&snapshot, &frameworkId, &role](JSON::ArrayWriter* writer) {
+            if (role.isSome()) {
+              return;
+            }
+
+            foreach (const FrameworkID& id,
+                     snapshot->unregisteredFrameworks) {
+              if (frameworkId.isNone() || id.value() == frameworkId.get()) {
+                writer->element(id.value());
+              }
+            }
+          });
+    };
+
+    return OK(jsonify(frameworks), jsonp);
+  });
+}
+
+
+string Master::Http::PROFILE_HELP()
+{
+  return HELP(
+    TLDR(
+        "Lists the handlers that the master spends the most time in."),
+    DESCRIPTION(
+        "Lists the handlers of the events that the master profiles (see",
+        "the --event_profiling_period flag), i.e., the messages by name",
+        "and the dispatches by the name of the method that they invoke,",
+        "by the total time that the master spent processing their profiled",
+        "events.",
+        "",
+        "The timings of the handlers are also exported by the",
+        "/metrics/snapshot endpoint, under 'master/handlers/'.",
+        "",
+        "Query parameters:",
+        "",
+        ">        limit=VALUE          Maximum number of handlers returned "
+        "(default is " + stringify(PROFILE_LIMIT) + ")."),
+    AUTHENTICATION(true));
+}
+
+
+Future<Response> Master::Http::profile(
+    const Request& request,
+    const Option<string>& /*principal*/) const
+{
+  Result<int> result = numify<int>(request.url.query.get("limit"));
+  const size_t limit = result.isSome() ? result.get() : PROFILE_LIMIT;
+
+  typedef std::pair<string, const Metrics::Handler*> Handler;
+
+  vector<Handler> handlers;
+  foreachpair (const string& name,
+               const Owned<Metrics::Handler>& handler,
+               master->metrics->handlers) {
+    handlers.push_back(Handler(name, handler.get()));
+  }
+
+  const size_t count = std::min(limit, handlers.size());
+
+  std::partial_sort(
+      handlers.begin(),
+      handlers.begin() + count,
+      handlers.end(),
+      [](const Handler& left, const Handler& right) {
+        return left.second->total_processing_time >
+               right.second->total_processing_time;
+      });
+
+  handlers.resize(count);
+
+  auto profile = [this, &handlers](JSON::ObjectWriter* writer) {
+    writer->field("event_profiling_period",
+                  master->flags.event_profiling_period);
+
+    writer->field("handlers", [&handlers](JSON::ArrayWriter* writer) {
+      foreach (const Handler& handler, handlers) {
+        writer->element([&handler](JSON::ObjectWriter* writer) {
+          writer->field("name", handler.first);
+          writer->field("events", handler.second->events);
+          writer->field(
+              "queue_time_secs",
+              handler.second->total_queue_time.secs());
+          writer->field(
+              "processing_time_secs",
+              handler.second->total_processing_time.secs());
+        });
       }
     });
   };
 
-  return OK(jsonify(frameworks), request.url.query.get("jsonp"));
+  return OK(jsonify(profile), request.url.query.get("jsonp"));
 }
 
 
@@ -1305,118 +1510,204 @@ string Master::Http::STATE_HELP()
 }
 
 
-Future<Response> Master::Http::state(
-    const Request& request,
-    const Option<string>& /*principal*/) const
+// Serializes a snapshot of the master's state for the `/state`
+// endpoint. This happens outside of the master's context, and thus
+// must only access the snapshot.
+static void json(JSON::ObjectWriter* writer, const StateSnapshot& state)
 {
-  auto state = [this](JSON::ObjectWriter* writer) {
-    writer->field("version", MESOS_VERSION);
+  writer->field("version", MESOS_VERSION);
 
-    if (build::GIT_SHA.isSome()) {
-      writer->field("git_sha", build::GIT_SHA.get());
-    }
+  if (build::GIT_SHA.isSome()) {
+    writer->field("git_sha", build::GIT_SHA.get());
+  }
 
-    if (build::GIT_BRANCH.isSome()) {
-      writer->field("git_branch", build::GIT_BRANCH.get());
-    }
+  if (build::GIT_BRANCH.isSome()) {
+    writer->field("git_branch", build::GIT_BRANCH.get());
+  }
+
+  if (build::GIT_TAG.isSome()) {
+    writer->field("git_tag", build::GIT_TAG.get());
+  }
+
+  writer->field("build_date", build::DATE);
+  writer->field("build_time", build::TIME);
+  writer->field("build_user", build::USER);
+  writer->field("start_time", state.startTime.secs());
+
+  if (state.electedTime.isSome()) {
+    writer->field("elected_time", state.electedTime.get().secs());
+  }
+
+  writer->field("id", state.info.id());
+  writer->field("pid", string(state.pid));
+  writer->field("hostname", state.info.hostname());
+  writer->field("activated_slaves", state.activatedSlaves);
+  writer->field("deactivated_slaves", state.deactivatedSlaves);
 
-    if (build::GIT_TAG.isSome()) {
-      writer->field("git_tag", build::GIT_TAG.get());
+  if (state.flags.cluster.isSome()) {
+    writer->field("cluster", state.flags.cluster.get());
+  }
+
+  if (state.leader.isSome()) {
+    writer->field("leader", state.leader.get().pid());
+  }
+
+  if (state.flags.log_dir.isSome()) {
+    writer->field("log_dir", state.flags.log_dir.get());
+  }
+
+  if (state.flags.external_log_file.isSome()) {
+    writer->field("external_log_file", state.flags.external_log_file.get());
+  }
+
+  writer->field("flags", [&state](JSON::ObjectWriter* writer) {
+    foreachpair (const string& name, const flags::Flag& flag, state.flags) {
+      Option<string> value = flag.stringify(state.flags);
+      if (value.isSome()) {
+        writer->field(name, value.get());
+      }
     }
+  });
 
-    writer->field("build_date", build::DATE);
-    writer->field("build_time", build::TIME);
-    writer->field("build_user", build::USER);
-    writer->field("start_time", master->startTime.secs());
+  // Model all of the slaves.
+  writer->field("slaves", [&state](JSON::ArrayWriter* writer) {
+    foreach (const StateSnapshot::Slave& slave, state.slaves) {
+      writer->element(Full<StateSnapshot::Slave>(slave));
+    }
+  });
 
-    if (master->electedTime.isSome()) {
-      writer->field("elected_time", master->electedTime.get().secs());
+  // Model all of the frameworks.
+  writer->field("frameworks", [&state](JSON::ArrayWriter* writer) {
+    foreach (const StateSnapshot::Framework& framework, state.frameworks) {
+      writer->element(Full<StateSnapshot::Framework>(framework));
     }
+  });
 
-    writer->field("id", master->info().id());
-    writer->field("pid", string(master->self()));
-    writer->field("hostname", master->info().hostname());
-    writer->field("activated_slaves", master->_slaves_active());
-    writer->field("deactivated_slaves", master->_slaves_inactive());
+  // Model all of the completed frameworks.
+  writer->field("completed_frameworks", [&state](JSON::ArrayWriter* writer) {
+    foreach (const StateSnapshot::Framework& framework,
+             state.completedFrameworks) {
+      writer->element(Full<StateSnapshot::Framework>(framework));
+    }
+  });
 
-    if (master->flags.cluster.isSome()) {
-      writer->field("cluster", master->flags.cluster.get());
+  // Model all of the orphan tasks.
+  writer->field("orphan_tasks", [&state](JSON::ArrayWriter* writer) {
+    foreach (const std::shared_ptr<const TaskFragment>& task,
+             state.orphanTasks) {
+      writer->element(*task);
     }
+  });
 
-    if (master->leader.isSome()) {
-      writer->field("leader", master->leader.get().pid());
+  // Model all currently unregistered frameworks. This can happen
+  // when a framework has yet to re-register after master failover.
+  writer->field("unregistered_frameworks", [&state](JSON::ArrayWriter* writer) {
+    foreach (const FrameworkID& frameworkId, state.unregisteredFrameworks) {
+      writer->element(frameworkId.value());
     }
+  });
+}
+
+
+std::shared_ptr<const StateSnapshot> Master::Http::snapshot() const
+{
+  std::shared_ptr<const StateSnapshot> snapshot = master->stateSnapshot;
+
+  // The last snapshot is reused for as long as the state has not
+  // changed since, and otherwise until it is too old.
+  if (snapshot.get() == NULL ||
+      (snapshot->version != master->stateVersion &&
+       process::Clock::now() - snapshot->time >=
+         master->flags.max_state_snapshot_age)) {
+    snapshot.reset(new StateSnapshot(master));
+    master->stateSnapshot = snapshot;
+  }
+
+  return snapshot;
+}
+
 
-    if (master->flags.log_dir.isSome()) {
-      writer->field("log_dir", master->flags.log_dir.get());
+// Returns whether the `If-None-Match` header of a request matches the
+// given entity tag, see RFC 7232, section 3.2.
+static bool matches(const Option<string>& ifNoneMatch, const string& etag)
+{
+  if (ifNoneMatch.isNone()) {
+    return false;
+  }
+
+  foreach (const string& token, strings::tokenize(ifNoneMatch.get(), ",")) {
+    string tag = strings::trim(token);
+
+    // Use the weak comparison, see RFC 7232, section 2.3.2.
+    if (strings::startsWith(tag, "W/")) {
+      tag = tag.substr(2);
     }
 
-    if (master->flags.external_log_file.isSome()) {
-      writer->field("external_log_file", master->flags.external_log_file.get());
+    if (tag == "*" || tag == etag) {
+      return true;
     }
+  }
 
-    writer->field("flags", [this](JSON::ObjectWriter* writer) {
-      foreachpair (const string& name, const flags::Flag& flag, master->flags) {
-        Option<string> value = flag.stringify(master->flags);
-        if (value.isSome()) {
-          writer->field(name, value.get());
-        }
-      }
-    });
+  return false;
+}
 
-    // Model all of the slaves.
-    writer->field("slaves", [this](JSON::ArrayWriter* writer) {
-      foreachvalue (Slave* slave, master->slaves.registered) {
-        writer->element(Full<Slave>(*slave));
-      }
-    });
 
-    // Model all of the frameworks.
-    writer->field("frameworks", [this](JSON::ArrayWriter* writer) {
-      foreachvalue (Framework* framework, master->frameworks.registered) {
-        writer->element(Full<Framework>(*framework));
-      }
-    });
+Future<Response> Master::Http::state(
+    const Request& request,
+    const Option<string>& /*principal*/) const
+{
+  // Walking the whole state of a large cluster takes long, during
+  // which the master cannot process anything else. Hence the master
+  // only takes a snapshot of its state, which is serialized on
+  // another core, and requests may be served from a recent snapshot
+  // (see the `--max_state_snapshot_age` flag).
+  const Option<string> jsonp = request.url.query.get("jsonp");
+  const Option<string> ifNoneMatch = request.headers.get("If-None-Match");
+
+  // The entity tags identify the versions of the state, which lets
+  // the master answer pollers that have the current state without
+  // taking a snapshot, let alone serializing it.
+  // NOTE: JSONP responses are not tagged, since their callbacks
+  // (e.g., as generated by jQuery) tend to differ between requests.
+  if (jsonp.isNone()) {
+    const string etag =
+      StateSnapshot::tag(master->info(), master->stateVersion);
+
+    if (matches(ifNoneMatch, etag)) {
+      Response response(process::http::Status::NOT_MODIFIED);
+      response.headers["ETag"] = etag;
+      return response;
+    }
+  }
 
-    // Model all of the completed frameworks.
-    writer->field("completed_frameworks", [this](JSON::ArrayWriter* writer) {
-      foreach (const std::shared_ptr<Framework>& framework,
-               master->frameworks.completed) {
-        writer->element(Full<Framework>(*framework));
-      }
-    });
+  std::shared_ptr<const StateSnapshot> snapshot = this->snapshot();
 
-    // Model all of the orphan tasks.
-    writer->field("orphan_tasks", [this](JSON::ArrayWriter* writer) {
-      // Find those orphan tasks.
-      foreachvalue (const Slave* slave, master->slaves.registered) {
-        typedef hashmap<TaskID, Task*> TaskMap;
-        foreachvalue (const TaskMap& tasks, slave->tasks) {
-          foreachvalue (const Task* task, tasks) {
-            CHECK_NOTNULL(task);
-            if (!master->frameworks.registered.contains(task->framework_id())) {
-              writer->element(*task);
-            }
-          }
-        }
-      }
-    });
+  // A recent snapshot of an older version of the state may still
+  // match the request.
+  if (jsonp.isNone() && matches(ifNoneMatch, snapshot->etag)) {
+    Response response(process::http::Status::NOT_MODIFIED);
+    response.headers["ETag"] = snapshot->etag;
+    return response;
+  }
 
-    // Model all currently unregistered frameworks. This can happen
-    // when a framework has yet to re-register after master failover.
-    writer->field("unregistered_frameworks", [this](JSON::ArrayWriter* writer) {
-      // Find unregistered frameworks.
-      foreachvalue (const Slave* slave, master->slaves.registered) {
-        foreachkey (const FrameworkID& frameworkId, slave->tasks) {
-          if (!master->frameworks.registered.contains(frameworkId)) {
-            writer->element(frameworkId.value());
-          }
-        }
-      }
+  return process::async([snapshot, jsonp]() -> Response {
+    // The snapshot is serialized once, by the first request served
+    // from it.
+    std::call_once(snapshot->serialized, [&snapshot]() {
+      snapshot->json = jsonify(*snapshot);
     });
-  };
 
-  return OK(jsonify(state), request.url.query.get("jsonp"));
+    if (jsonp.isSome()) {
+      OK response(jsonp.get() + "(" + snapshot->json + ");");
+      response.headers["Content-Type"] = "text/javascript";
+      return response;
+    }
+
+    OK response(snapshot->json);
+    response.headers["Content-Type"] = "application/json";
+    response.headers["ETag"] = snapshot->etag;
+    return response;
+  });
 }
 
 
@@ -1442,9 +1733,11 @@ public:
         slavesToFrameworks[task->slave_id()].insert(frameworkId);
       }
 
-      foreach (const std::shared_ptr<Task>& task, framework->completedTasks) {
-        frameworksToSlaves[frameworkId].insert(task->slave_id());
-        slavesToFrameworks[task->slave_id()].insert(frameworkId);
+      foreach (const std::shared_ptr<const TaskFragment>& fragment,
+               framework->completedTasks) {
+        const Task& task = fragment->task;
+        frameworksToSlaves[frameworkId].insert(task.slave_id());
+        slavesToFrameworks[task.slave_id()].insert(frameworkId);
       }
     }
   }
@@ -1543,9 +1836,11 @@ public:
         slaveTaskSummaries[task->slave_id()].count(*task);
       }
 
-      foreach (const std::shared_ptr<Task>& task, framework->completedTasks) {
-        frameworkTaskSummaries[frameworkId].count(*task);
-        slaveTaskSummaries[task->slave_id()].count(*task);
+      foreach (const std::shared_ptr<const TaskFragment>& fragment,
+               framework->completedTasks) {
+        const Task& task = fragment->task;
+        frameworkTaskSummaries[frameworkId].count(task);
+        slaveTaskSummaries[task.slave_id()].count(task);
       }
     }
   }
@@ -1902,109 +2197,113 @@ string Master::Http::TASKS_HELP()
       "(default is " + stringify(TASK_LIMIT) + ").",
       ">        offset=VALUE         Starts task list at offset.",
       ">        order=(asc|desc)     Ascending or descending sort order "
-      "(default is descending)."
-      ""),
+      "(default is descending).",
+      ">        cursor=VALUE         Starts task list after the tasks of "
+      "a previous list, whose `next_cursor` is the value.",
+      ">        framework_id=VALUE   Only lists the tasks of the framework.",
+      ">        role=VALUE           Only lists the tasks of the frameworks "
+      "of the role.",
+      ">        slave_id=VALUE       Only lists the tasks of the slave.",
+      ">        state=VALUE          Only lists the tasks in the state "
+      "(e.g., `TASK_RUNNING`).",
+      ">        label=KEY[:VALUE]    Only lists the tasks with the label.",
+      "",
+      "The tasks are sorted by the time of their first status. If more",
+      "tasks match than are listed, the response has a `next_cursor`,",
+      "which lists the next tasks when passed as `cursor`."),
     AUTHENTICATION(true));
 }
 
 
-struct TaskComparator
+Future<Response> Master::Http::tasks(
+    const Request& request,
+    const Option<string>& /*principal*/) const
 {
-  static bool ascending(const Task* lhs, const Task* rhs)
-  {
-    size_t lhsSize = lhs->statuses().size();
-    size_t rhsSize = rhs->statuses().size();
+  TaskIndex::Query query;
 
-    if ((lhsSize == 0) && (rhsSize == 0)) {
-      return false;
-    }
+  // Get list options (limit and offset).
+  Result<int> result = numify<int>(request.url.query.get("limit"));
+  query.limit = result.isSome() ? result.get() : TASK_LIMIT;
 
-    if (lhsSize == 0) {
-      return true;
-    }
+  result = numify<int>(request.url.query.get("offset"));
+  query.offset = result.isSome() ? result.get() : 0;
+
+  // TODO(nnielsen): Currently, formatting errors in offset and/or limit
+  // will silently be ignored. This could be reported to the user instead.
+
+  // Sort tasks by task status timestamp. Default order is descending.
+  // The earliest timestamp is chosen for comparison when multiple are present.
+  Option<string> order = request.url.query.get("order");
+  query.ascending = order.isSome() && (order.get() == "asc");
 
-    if (rhsSize == 0) {
-      return false;
+  Option<string> cursor = request.url.query.get("cursor");
+  if (cursor.isSome()) {
+    Try<TaskIndex::Key> key = TaskIndex::Key::parse(cursor.get());
+    if (key.isError()) {
+      return BadRequest("Failed to parse 'cursor': " + key.error());
     }
 
-    return (lhs->statuses(0).timestamp() < rhs->statuses(0).timestamp());
+    query.cursor = key.get();
   }
 
-  static bool descending(const Task* lhs, const Task* rhs)
-  {
-    size_t lhsSize = lhs->statuses().size();
-    size_t rhsSize = rhs->statuses().size();
+  Option<string> frameworkId = request.url.query.get("framework_id");
+  if (frameworkId.isSome()) {
+    FrameworkID id;
+    id.set_value(frameworkId.get());
+    query.frameworkId = id;
+  }
 
-    if ((lhsSize == 0) && (rhsSize == 0)) {
-      return false;
-    }
+  query.role = request.url.query.get("role");
 
-    if (rhsSize == 0) {
-      return true;
-    }
+  Option<string> slaveId = request.url.query.get("slave_id");
+  if (slaveId.isSome()) {
+    SlaveID id;
+    id.set_value(slaveId.get());
+    query.slaveId = id;
+  }
 
-    if (lhsSize == 0) {
-      return false;
+  Option<string> state = request.url.query.get("state");
+  if (state.isSome()) {
+    TaskState state_;
+    if (!TaskState_Parse(state.get(), &state_)) {
+      return BadRequest("Failed to parse 'state': Unknown task state '" +
+                        state.get() + "'");
     }
 
-    return (lhs->statuses(0).timestamp() > rhs->statuses(0).timestamp());
+    query.state = state_;
   }
-};
 
+  Option<string> label = request.url.query.get("label");
+  if (label.isSome()) {
+    vector<string> tokens = strings::split(label.get(), ":", 2);
 
-Future<Response> Master::Http::tasks(
-    const Request& request,
-    const Option<string>& /*principal*/) const
-{
-  // Get list options (limit and offset).
-  Result<int> result = numify<int>(request.url.query.get("limit"));
-  size_t limit = result.isSome() ? result.get() : TASK_LIMIT;
-
-  result = numify<int>(request.url.query.get("offset"));
-  size_t offset = result.isSome() ? result.get() : 0;
+    Label label_;
+    label_.set_key(tokens[0]);
 
-  // TODO(nnielsen): Currently, formatting errors in offset and/or limit
-  // will silently be ignored. This could be reported to the user instead.
-
-  // Construct framework list with both active and completed frameworks.
-  vector<const Framework*> frameworks;
-  foreachvalue (Framework* framework, master->frameworks.registered) {
-    frameworks.push_back(framework);
-  }
-  foreach (const std::shared_ptr<Framework>& framework,
-           master->frameworks.completed) {
-    frameworks.push_back(framework.get());
-  }
-
-  // Construct task list with both running and finished tasks.
-  vector<const Task*> tasks;
-  foreach (const Framework* framework, frameworks) {
-    foreachvalue (Task* task, framework->tasks) {
-      CHECK_NOTNULL(task);
-      tasks.push_back(task);
+    if (tokens.size() == 2) {
+      label_.set_value(tokens[1]);
     }
-    foreach (const std::shared_ptr<Task>& task, framework->completedTasks) {
-      tasks.push_back(task.get());
-    }
-  }
 
-  // Sort tasks by task status timestamp. Default order is descending.
-  // The earliest timestamp is chosen for comparison when multiple are present.
-  Option<string> order = request.url.query.get("order");
-  if (order.isSome() && (order.get() == "asc")) {
-    sort(tasks.begin(), tasks.end(), TaskComparator::ascending);
-  } else {
-    sort(tasks.begin(), tasks.end(), TaskComparator::descending);
+    query.label = label_;
   }
 
-  auto tasksWriter = [&tasks, limit, offset](JSON::ObjectWriter* writer) {
-    writer->field("tasks", [&tasks, limit, offset](JSON::ArrayWriter* writer) {
-      size_t end = std::min(offset + limit, tasks.size());
-      for (size_t i = offset; i < end; i++) {
-        const Task* task = tasks[i];
-        writer->element(*task);
+  // The master indexes the tasks, so that listing a page of them does
+  // not walk (and sort) all of the tasks.
+  const TaskIndex::Page page = master->taskIndex.find(query);
+
+  // Like `/state`, splice the cached JSON of the tasks (see
+  // `TaskFragment`), which only the tasks that changed since they were
+  // last written out need to be serialized for.
+  auto tasksWriter = [this, &page](JSON::ObjectWriter* writer) {
+    writer->field("tasks", [this, &page](JSON::ArrayWriter* writer) {
+      foreach (const Task* task, page.tasks) {
+        writer->element(*master->fragment(task));
       }
     });
+
+    if (page.next.isSome()) {
+      writer->field("next_cursor", page.next->cursor());
+    }
   };
 
   return OK(jsonify(tasksWriter), request.url.query.get("jsonp"));
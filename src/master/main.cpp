@@ -63,6 +63,8 @@
 
 #include "master/allocator/mesos/hierarchical.hpp"
 
+#include "master/allocator/trace/recorder.hpp"
+
 #include "module/manager.hpp"
 
 #include "state/in_memory.hpp"
@@ -84,6 +86,8 @@ using mesos::MasterInfo;
 using mesos::Parameter;
 using mesos::Parameters;
 
+using mesos::internal::master::allocator::RecordingAllocator;
+
 using mesos::master::allocator::Allocator;
 
 using mesos::modules::Anonymous;
@@ -261,6 +265,19 @@ int main(int argc, char** argv)
   CHECK_NOTNULL(allocator.get());
   LOG(INFO) << "Using '" << allocatorName << "' allocator";
 
+  if (flags.allocator_trace.isSome()) {
+    allocator = RecordingAllocator::create(
+        allocator.get(), flags.allocator_trace.get());
+
+    if (allocator.isError()) {
+      EXIT(EXIT_FAILURE)
+        << "Failed to record allocator trace: " << allocator.error();
+    }
+
+    LOG(INFO) << "Recording allocator trace to '"
+              << flags.allocator_trace.get() << "'";
+  }
+
   state::Storage* storage = NULL;
   Log* log = NULL;
 
@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <cctype>
+#include <chrono>
 #include <fstream>
 #include <iomanip>
 #include <list>
@@ -81,6 +82,8 @@
 #include "logging/flags.hpp"
 #include "logging/logging.hpp"
 
+#include "master/allocator/sorter/agent/sorter.hpp"
+
 #include "master/flags.hpp"
 #include "master/master.hpp"
 #include "master/weights.hpp"
@@ -97,10 +100,12 @@ using std::vector;
 using process::await;
 using process::wait; // Necessary on some OS's to disambiguate.
 using process::Clock;
+using process::DispatchEvent;
 using process::ExitedEvent;
 using process::Failure;
 using process::Future;
 using process::MessageEvent;
+using process::MethodId;
 using process::Owned;
 using process::PID;
 using process::Process;
@@ -123,6 +128,8 @@ namespace authentication = process::http::authentication;
 
 using mesos::master::allocator::Allocator;
 
+using mesos::internal::master::allocator::AgentSorter;
+
 using mesos::http::authentication::BasicAuthenticatorFactory;
 
 
@@ -298,10 +305,112 @@ Master::Master(
     frameworks(flags),
     authenticator(None()),
     metrics(new Metrics(*this)),
-    electedTime(None())
+    processedEvents(0),
+    electedTime(None()),
+    stateVersion(0),
+    subscribers(
+        self(),
+        flags.max_subscriber_queue_size,
+        flags.max_subscriber_queue_size * SUBSCRIBER_HELD_EVENTS_FACTOR)
 {
   slaves.limiter = _slaveRemovalLimiter;
 
+  // The master profiles how long its events were queued for, which
+  // needs the time that they were enqueued at.
+  if (flags.event_profiling_period > 0) {
+    timestampEvents(true);
+
+    // Necessary to disambiguate the overloaded methods below.
+    typedef void(Self::*Visit)(const ExitedEvent&);
+    typedef void(Self::*Exited)(const FrameworkID&, const HttpConnection&);
+    typedef Nothing(Self::*RemoveSlave)(const Registry::Slave&);
+
+    typedef void(Self::*AuthorizedHttpSubscribe)(
+        HttpConnection,
+        const scheduler::Call::Subscribe&,
+        const Future<bool>&);
+
+    typedef void(Self::*Subscribe)(
+        const UPID&,
+        const scheduler::Call::Subscribe&);
+
+    typedef void(Self::*AuthorizedSubscribe)(
+        const UPID&,
+        const scheduler::Call::Subscribe&,
+        const Future<bool>&);
+
+    // The methods that the master dispatches to itself (mostly as the
+    // continuations of the futures that it waits for), that the
+    // allocator and the slave observers dispatch to it, and that its
+    // gauges are read with.
+    typedef std::pair<MethodId, string> Method;
+
+    const vector<Method> methods = {
+      {MethodId(&Self::detected), "detected"},
+      {MethodId(&Self::contended), "contended"},
+      {MethodId(&Self::lostCandidacy), "lostCandidacy"},
+      {MethodId(&Self::_recover), "_recover"},
+      {MethodId(&Self::recoveredSlavesTimeout), "recoveredSlavesTimeout"},
+      {MethodId(&Self::fileAttached), "fileAttached"},
+      {MethodId(&Self::throttled), "throttled"},
+      {MethodId(static_cast<Visit>(&Self::_visit)), "_visit"},
+      {MethodId(static_cast<Exited>(&Self::exited)), "exited"},
+      {MethodId(&Self::authenticate), "authenticate"},
+      {MethodId(&Self::_authenticate), "_authenticate"},
+      {MethodId(&Self::authenticationTimeout), "authenticationTimeout"},
+      {MethodId(&Self::registerSlave), "registerSlave"},
+      {MethodId(&Self::_registerSlave), "_registerSlave"},
+      {MethodId(&Self::reregisterSlave), "reregisterSlave"},
+      {MethodId(&Self::_reregisterSlave), "_reregisterSlave"},
+      {MethodId(&Self::shutdownSlave), "shutdownSlave"},
+      {MethodId(static_cast<RemoveSlave>(&Self::removeSlave)), "removeSlave"},
+      {MethodId(&Self::_removeSlave), "_removeSlave"},
+      {MethodId(static_cast<Subscribe>(&Self::subscribe)), "subscribe"},
+      {MethodId(static_cast<AuthorizedHttpSubscribe>(&Self::_subscribe)),
+       "_subscribe"},
+      {MethodId(static_cast<AuthorizedSubscribe>(&Self::_subscribe)),
+       "_subscribe"},
+      {MethodId(&Self::frameworkFailoverTimeout), "frameworkFailoverTimeout"},
+      {MethodId(&Self::offer), "offer"},
+      {MethodId(&Self::inverseOffer), "inverseOffer"},
+      {MethodId(&Self::offerTimeout), "offerTimeout"},
+      {MethodId(&Self::inverseOfferTimeout), "inverseOfferTimeout"},
+      {MethodId(&Self::_accept), "_accept"},
+      {MethodId(&Self::_apply), "_apply"},
+      {MethodId(&Self::_uptime_secs), "_uptime_secs"},
+      {MethodId(&Self::_slaves_connected), "_slaves_connected"},
+      {MethodId(&Self::_slaves_disconnected), "_slaves_disconnected"},
+      {MethodId(&Self::_slaves_active), "_slaves_active"},
+      {MethodId(&Self::_slaves_inactive), "_slaves_inactive"},
+      {MethodId(&Self::_frameworks_connected), "_frameworks_connected"},
+      {MethodId(&Self::_frameworks_disconnected), "_frameworks_disconnected"},
+      {MethodId(&Self::_frameworks_active), "_frameworks_active"},
+      {MethodId(&Self::_frameworks_inactive), "_frameworks_inactive"},
+      {MethodId(&Self::_outstanding_offers), "_outstanding_offers"},
+      {MethodId(&Self::_tasks_staging), "_tasks_staging"},
+      {MethodId(&Self::_tasks_starting), "_tasks_starting"},
+      {MethodId(&Self::_tasks_running), "_tasks_running"},
+      {MethodId(&Self::_tasks_killing), "_tasks_killing"},
+      {MethodId(&Self::_event_queue_messages), "_event_queue_messages"},
+      {MethodId(&Self::_event_queue_dispatches), "_event_queue_dispatches"},
+      {MethodId(&Self::_event_queue_http_requests),
+       "_event_queue_http_requests"},
+      {MethodId(&Self::_resources_total), "_resources_total"},
+      {MethodId(&Self::_resources_used), "_resources_used"},
+      {MethodId(&Self::_resources_percent), "_resources_percent"},
+      {MethodId(&Self::_resources_revocable_total),
+       "_resources_revocable_total"},
+      {MethodId(&Self::_resources_revocable_used),
+       "_resources_revocable_used"},
+      {MethodId(&Self::_resources_revocable_percent),
+       "_resources_revocable_percent"}
+    };
+
+    foreach (const Method& method, methods) {
+      dispatchHandlers[method.first.str()] = method.second;
+    }
+  }
+
   // NOTE: We populate 'info_' here instead of inside 'initialize()'
   // because 'StandaloneMasterDetector' needs access to the info.
 
@@ -699,12 +808,30 @@ void Master::initialize()
       << " for --offer_timeout: Must be greater than zero";
   }
 
+  // The agent ordering only applies to the default allocator, which
+  // expects it to be valid.
+  if (flags.allocator == DEFAULT_ALLOCATOR) {
+    Try<AgentSorter*> agentSorter = AgentSorter::create(flags.agent_ordering);
+    if (agentSorter.isError()) {
+      EXIT(EXIT_FAILURE)
+        << "Invalid value '" << flags.agent_ordering << "'"
+        << " for --agent_ordering: " << agentSorter.error();
+    }
+
+    delete agentSorter.get();
+  }
+
   // Initialize the allocator.
+  mesos::master::allocator::Options options;
+  options.allocationWindow = flags.allocation_coalescing_window;
+  options.agentOrdering = flags.agent_ordering;
+
   allocator->initialize(
       flags.allocation_interval,
       defer(self(), &Master::offer, lambda::_1, lambda::_2),
       defer(self(), &Master::inverseOffer, lambda::_1, lambda::_2),
-      weights);
+      weights,
+      options);
 
   // Parse the whitelist. Passing Allocator::updateWhitelist()
   // callback is safe because we shut down the whitelistWatcher in
@@ -862,6 +989,14 @@ void Master::initialize()
           Http::log(request);
           return http.destroyVolumes(request, principal);
         });
+  route("/events",
+        DEFAULT_HTTP_AUTHENTICATION_REALM,
+        Http::EVENTS_HELP(),
+        [this](const process::http::Request& request,
+               const Option<string>& principal) {
+          Http::log(request);
+          return http.events(request, principal);
+        });
   route("/frameworks",
         DEFAULT_HTTP_AUTHENTICATION_REALM,
         Http::FRAMEWORKS_HELP(),
@@ -891,6 +1026,14 @@ void Master::initialize()
           Http::log(request);
           return http.observe(request, principal);
         });
+  route("/profile",
+        DEFAULT_HTTP_AUTHENTICATION_REALM,
+        Http::PROFILE_HELP(),
+        [this](const process::http::Request& request,
+               const Option<string>& principal) {
+          Http::log(request);
+          return http.profile(request, principal);
+        });
   route("/redirect",
         Http::REDIRECT_HELP(),
         [this](const process::http::Request& request) {
@@ -1438,6 +1581,57 @@ void Master::visit(const ExitedEvent& event)
 }
 
 
+// Returns the time elapsed since the given time of the monotonic clock
+// that libprocess timestamps the events with (see `Event::enqueued`).
+static Duration elapsed(const std::chrono::steady_clock::time_point& since)
+{
+  return Nanoseconds(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - since).count());
+}
+
+
+string Master::dispatchHandler(const DispatchEvent& event) const
+{
+  if (event.method.isSome()) {
+    const Option<string> name =
+      dispatchHandlers.get(event.method.get().str());
+
+    if (name.isSome()) {
+      return name.get();
+    }
+  }
+
+  return "dispatch";
+}
+
+
+void Master::visit(const DispatchEvent& event)
+{
+  if (!profiled()) {
+    Process<Master>::visit(event);
+    return;
+  }
+
+  const Duration queueTime = elapsed(event.enqueued);
+
+  const std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+
+  Process<Master>::visit(event);
+
+  metrics->profile(dispatchHandler(event), queueTime, elapsed(start));
+}
+
+
+bool Master::profiled()
+{
+  const size_t period = flags.event_profiling_period;
+
+  return period > 0 && processedEvents++ % period == 0;
+}
+
+
 void Master::throttled(
     const MessageEvent& event,
     const Option<string>& principal)
@@ -1466,7 +1660,26 @@ void Master::_visit(const MessageEvent& event)
       ? frameworks.principals[event.message->from]
       : Option<string>::none();
 
-  ProtobufProcess<Master>::visit(event);
+  if (profiled()) {
+    // NOTE: The queue time includes the time that the message was
+    // throttled for, if any.
+    const Duration queueTime = elapsed(event.enqueued);
+
+    const std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+
+    ProtobufProcess<Master>::visit(event);
+
+    // NOTE: Message names are chosen by the senders, hence the messages
+    // that the master does not handle are profiled together, so that
+    // a peer cannot make the master add metrics for any name.
+    metrics->profile(
+        installed(event.message->name) ? event.message->name : "unknown",
+        queueTime,
+        elapsed(start));
+  } else {
+    ProtobufProcess<Master>::visit(event);
+  }
 
   // Increment 'messages_processed' counter if it still exists.
   // Note that it could be removed in handling
@@ -1822,6 +2035,9 @@ void Master::detected(const Future<Option<MasterInfo>>& _leader)
 
   bool wasElected = elected();
   leader = _leader.get();
+  stateVersion++;
+
+  metrics->elected = elected() ? 1 : 0;
 
   LOG(INFO) << "The newly elected leader is "
             << (leader.isSome()
@@ -2535,6 +2751,12 @@ void Master::_subscribe(
         allocator->activateFramework(framework->id());
       }
 
+      stateVersion++;
+
+      if (!subscribers.empty()) {
+        subscribers.send(events::frameworkUpdated(*framework));
+      }
+
       FrameworkReregisteredMessage message;
       message.mutable_framework_id()->MergeFrom(frameworkInfo.id());
       message.mutable_master_info()->MergeFrom(info_);
@@ -2668,6 +2890,12 @@ void Master::deactivate(Framework* framework)
   // Stop sending offers here for now.
   framework->active = false;
 
+  stateVersion++;
+
+  if (!subscribers.empty()) {
+    subscribers.send(events::frameworkUpdated(*framework));
+  }
+
   // Tell the allocator to stop allocating resources to this framework.
   allocator->deactivateFramework(framework->id());
 
@@ -2720,6 +2948,7 @@ void Master::deactivate(Slave* slave)
   LOG(INFO) << "Deactivating slave " << *slave;
 
   slave->active = false;
+  stateVersion++;
 
   allocator->deactivateSlave(slave->id);
 
@@ -3155,6 +3384,12 @@ Resources Master::addTask(
   slave->addTask(t);
   framework->addTask(t);
 
+  stateVersion++;
+
+  if (!subscribers.empty()) {
+    subscribers.send(events::taskAdded(*t));
+  }
+
   return resources;
 }
 
@@ -3306,6 +3541,7 @@ void Master::accept(
           // will not be launched.
           if (!framework->pendingTasks.contains(task.task_id())) {
             framework->pendingTasks[task.task_id()] = task;
+            stateVersion++;
           }
         }
         break;
@@ -3687,6 +3923,7 @@ void Master::_accept(
 
           // Remove from pending tasks.
           framework->pendingTasks.erase(task.task_id());
+          stateVersion++;
 
           CHECK(!authorization.isDiscarded());
 
@@ -3953,6 +4190,7 @@ void Master::kill(Framework* framework, const scheduler::Call::Kill& kill)
   if (framework->pendingTasks.contains(taskId)) {
     // Remove from pending tasks.
     framework->pendingTasks.erase(taskId);
+    stateVersion++;
 
     const StatusUpdate& update = protobuf::createStatusUpdate(
         framework->id(),
@@ -4539,6 +4777,7 @@ void Master::reregisterSlave(
 
   if (slave != NULL) {
     slave->reregisteredTime = Clock::now();
+    stateVersion++;
 
     // NOTE: This handles the case where a slave tries to
     // re-register with an existing master (e.g. because of a
@@ -4824,6 +5063,8 @@ void Master::updateSlave(
   slave->totalResources =
     slave->totalResources.nonRevocable() + oversubscribedResources.revocable();
 
+  stateVersion++;
+
   // Now, update the allocator with the new estimate.
   allocator->updateSlave(slaveId, oversubscribedResources);
 }
@@ -5475,6 +5716,12 @@ void Master::offer(const FrameworkID& frameworkId,
     framework->addOffer(offer);
     slave->addOffer(offer);
 
+    stateVersion++;
+
+    if (!subscribers.empty()) {
+      subscribers.send(events::offerAdded(*offer));
+    }
+
     if (flags.offer_timeout.isSome()) {
       // Rescind the offer after the timeout elapses.
       offerTimers[offer->id()] =
@@ -5944,6 +6191,12 @@ void Master::addFramework(Framework* framework)
       }
     }
   }
+
+  stateVersion++;
+
+  if (!subscribers.empty()) {
+    subscribers.send(events::frameworkAdded(*framework));
+  }
 }
 
 
@@ -6065,6 +6318,12 @@ void Master::_failoverFramework(Framework* framework)
     allocator->activateFramework(framework->id());
   }
 
+  stateVersion++;
+
+  if (!subscribers.empty()) {
+    subscribers.send(events::frameworkUpdated(*framework));
+  }
+
   // The scheduler driver safely ignores any duplicate registration
   // messages, so we don't need to compare the old and new pids here.
   FrameworkRegisteredMessage message;
@@ -6227,6 +6486,12 @@ void Master::removeFramework(Framework* framework)
   frameworks.registered.erase(framework->id());
   allocator->removeFramework(framework->id());
 
+  stateVersion++;
+
+  if (!subscribers.empty()) {
+    subscribers.send(events::frameworkRemoved(framework->id()));
+  }
+
   // The completedFramework buffer now owns the framework pointer.
   frameworks.completed.push_back(shared_ptr<Framework>(framework));
 }
@@ -6331,6 +6596,10 @@ void Master::addSlave(
                      << " of framework " << task->framework_id()
                      << " running on slave " << *slave;
       }
+
+      if (!subscribers.empty()) {
+        subscribers.send(events::taskAdded(*task));
+      }
     }
   }
 
@@ -6375,6 +6644,12 @@ void Master::addSlave(
       unavailability,
       slave->totalResources,
       slave->usedResources);
+
+  stateVersion++;
+
+  if (!subscribers.empty()) {
+    subscribers.send(events::slaveAdded(*slave));
+  }
 }
 
 
@@ -6455,6 +6730,12 @@ void Master::removeSlave(
   slaves.removed.put(slave->id, Nothing());
   authenticated.erase(slave->pid);
 
+  stateVersion++;
+
+  if (!subscribers.empty()) {
+    subscribers.send(events::slaveRemoved(slave->id));
+  }
+
   // Remove the slave from the `machines` mapping.
   CHECK(machines.contains(slave->machineId));
   CHECK(machines[slave->machineId].slaves.contains(slave->id));
@@ -6546,6 +6827,9 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
 {
   CHECK_NOTNULL(task);
 
+  // The fragment of the task no longer represents it.
+  taskFragments.erase(task);
+
   // Get the unacknowledged status.
   const TaskStatus& status = update.status();
 
@@ -6605,6 +6889,16 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
   // MESOS-1746.
   task->mutable_statuses(task->statuses_size() - 1)->clear_data();
 
+  // The index orders the tasks by their first status and looks them
+  // up by their state, which may both have changed.
+  taskIndex.update(task);
+
+  stateVersion++;
+
+  if (!subscribers.empty()) {
+    subscribers.send(events::taskUpdated(*task));
+  }
+
   LOG(INFO) << "Updating the state of task " << task->task_id()
             << " of framework " << task->framework_id()
             << " (latest state: " << task->state()
@@ -6686,10 +6980,26 @@ void Master::removeTask(Task* task)
   // Remove from slave.
   slave->removeTask(task);
 
+  taskFragments.erase(task);
+  stateVersion++;
+
   delete task;
 }
 
 
+shared_ptr<const TaskFragment> Master::fragment(const Task* task)
+{
+  CHECK_NOTNULL(task);
+
+  if (!taskFragments.contains(task)) {
+    taskFragments[task] =
+      shared_ptr<const TaskFragment>(new TaskFragment(*task));
+  }
+
+  return taskFragments[task];
+}
+
+
 void Master::removeExecutor(
     Slave* slave,
     const FrameworkID& frameworkId,
@@ -6713,6 +7023,7 @@ void Master::removeExecutor(
   }
 
   slave->removeExecutor(frameworkId, executorId);
+  stateVersion++;
 }
 
 
@@ -6743,6 +7054,7 @@ void Master::_apply(Slave* slave, const Offer::Operation& operation) {
   CHECK_NOTNULL(slave);
 
   slave->apply(operation);
+  stateVersion++;
 
   LOG(INFO) << "Sending checkpointed resources "
             << slave->checkpointedResources
@@ -6787,6 +7099,12 @@ void Master::removeOffer(Offer* offer, bool rescind)
 
   slave->removeOffer(offer);
 
+  stateVersion++;
+
+  if (!subscribers.empty()) {
+    subscribers.send(events::offerRemoved(*offer));
+  }
+
   if (rescind) {
     RescindResourceOfferMessage message;
     message.mutable_offer_id()->MergeFrom(offer->id());
@@ -70,10 +70,13 @@
 #include "master/constants.hpp"
 #include "master/contender.hpp"
 #include "master/detector.hpp"
+#include "master/events.hpp"
 #include "master/flags.hpp"
 #include "master/machine.hpp"
 #include "master/metrics.hpp"
 #include "master/registrar.hpp"
+#include "master/snapshot.hpp"
+#include "master/task_index.hpp"
 #include "master/validation.hpp"
 
 #include "messages/messages.hpp"
@@ -548,6 +551,7 @@ protected:
   virtual void finalize();
 
   virtual void visit(const process::MessageEvent& event);
+  virtual void visit(const process::DispatchEvent& event);
   virtual void visit(const process::ExitedEvent& event);
 
   virtual void exited(const process::UPID& pid);
@@ -1078,6 +1082,11 @@ private:
         const process::http::Request& request,
         const Option<std::string>& principal) const;
 
+    // /master/events
+    process::Future<process::http::Response> events(
+        const process::http::Request& request,
+        const Option<std::string>& principal) const;
+
     // /master/flags
     process::Future<process::http::Response> flags(
         const process::http::Request& request,
@@ -1088,6 +1097,11 @@ private:
         const process::http::Request& request,
         const Option<std::string>& principal) const;
 
+    // /master/profile
+    process::Future<process::http::Response> profile(
+        const process::http::Request& request,
+        const Option<std::string>& principal) const;
+
     // /master/health
     process::Future<process::http::Response> health(
         const process::http::Request& request) const;
@@ -1172,10 +1186,12 @@ private:
         const Option<std::string>& principal) const;
 
     static std::string SCHEDULER_HELP();
+    static std::string EVENTS_HELP();
     static std::string FLAGS_HELP();
     static std::string FRAMEWORKS_HELP();
     static std::string HEALTH_HELP();
     static std::string OBSERVE_HELP();
+    static std::string PROFILE_HELP();
     static std::string REDIRECT_HELP();
     static std::string ROLES_HELP();
     static std::string TEARDOWN_HELP();
@@ -1223,6 +1239,10 @@ private:
         Resources required,
         const Offer::Operation& operation) const;
 
+    // Returns a snapshot of the state of the master, which is shared
+    // with other requests for up to `--max_state_snapshot_age`.
+    std::shared_ptr<const StateSnapshot> snapshot() const;
+
     Master* master;
 
     // NOTE: The quota specific pieces of the Operator API are factored
@@ -1239,6 +1259,7 @@ private:
 
   friend struct Framework;
   friend struct Metrics;
+  friend struct StateSnapshot;
 
   // NOTE: Since 'getOffer' and 'slaves' are protected,
   // we need to make the following functions friends.
@@ -1403,6 +1424,18 @@ private:
     }
   } slaves;
 
+  // The tasks of the frameworks, including their completed tasks, as
+  // listed by the `/tasks` endpoint.
+  TaskIndex taskIndex;
+
+  // The cached fragments of the tasks, see `TaskFragment`.
+  hashmap<const Task*, std::shared_ptr<const TaskFragment>> taskFragments;
+
+  // NOTE: The task index and the fragments are declared before the
+  // frameworks, which remove their completed tasks from both when they
+  // are destroyed. The completed frameworks are only destroyed along
+  // with the master, after `finalize()`.
+
   struct Frameworks
   {
     Frameworks(const Flags& masterFlags)
@@ -1477,17 +1510,27 @@ private:
   // copyable metric types only.
   std::shared_ptr<Metrics> metrics;
 
+  // Number of events that the master has processed, which determines
+  // the events that it profiles (see `--event_profiling_period`).
+  uint64_t processedEvents;
+
+  // Returns whether to profile the next event, see `processedEvents`.
+  bool profiled();
+
+  // Names of the methods that get dispatched to the master keyed by
+  // `MethodId::str()`, which their dispatches are profiled as (the
+  // dispatches of other functions are profiled together as `dispatch`).
+  hashmap<std::string, std::string> dispatchHandlers;
+
+  // Returns the handler that a dispatch is profiled as.
+  std::string dispatchHandler(const process::DispatchEvent& event) const;
+
   // Gauge handlers.
   double _uptime_secs()
   {
     return (process::Clock::now() - startTime).secs();
   }
 
-  double _elected()
-  {
-    return elected() ? 1 : 0;
-  }
-
   double _slaves_connected();
   double _slaves_disconnected();
   double _slaves_active();
@@ -1535,6 +1578,26 @@ private:
 
   Option<process::Time> electedTime; // Time when this master is elected.
 
+  // The version of the state that the `/state` and `/frameworks`
+  // endpoints expose, which the master bumps whenever it changes that
+  // state (e.g., adds a task or removes an offer). Snapshots are only
+  // taken in between events, hence bumping the version once for each
+  // event that changes the state suffices.
+  uint64_t stateVersion;
+
+  // The last snapshot of the state, which the `/state` endpoint is
+  // served from for as long as the state has not changed since, or
+  // until it is older than `--max_state_snapshot_age`.
+  std::shared_ptr<const StateSnapshot> stateSnapshot;
+
+  // Returns the fragment of the given task, which is cached until the
+  // task is updated or removed. The fragments of completed tasks are
+  // cached for as long as the frameworks keep the completed tasks.
+  std::shared_ptr<const TaskFragment> fragment(const Task* task);
+
+  // The subscribers of the `/events` endpoint.
+  Subscribers subscribers;
+
   // Validates the framework including authorization.
   // Returns None if the framework is valid.
   // Returns Error if the framework is invalid.
@@ -1771,6 +1834,12 @@ struct Framework
     if (http.isSome()) {
       closeHttpConnection();
     }
+
+    foreach (const std::shared_ptr<const TaskFragment>& fragment,
+             completedTasks) {
+      master->taskIndex.remove(&fragment->task);
+      master->taskFragments.erase(&fragment->task);
+    }
   }
 
   Task* getTask(const TaskID& taskId)
@@ -1789,6 +1858,7 @@ struct Framework
       << " of framework " << task->framework_id();
 
     tasks[task->task_id()] = task;
+    master->taskIndex.add(task, info.role());
 
     if (!protobuf::isTerminalState(task->state())) {
       totalUsedResources += task->resources();
@@ -1837,7 +1907,23 @@ struct Framework
   void addCompletedTask(const Task& task)
   {
     // TODO(adam-mesos): Check if completed task already exists.
-    completedTasks.push_back(std::shared_ptr<Task>(new Task(task)));
+    if (completedTasks.full() && !completedTasks.empty()) {
+      master->taskIndex.remove(&completedTasks.front()->task);
+      master->taskFragments.erase(&completedTasks.front()->task);
+    }
+
+    completedTasks.push_back(
+        std::shared_ptr<const TaskFragment>(new TaskFragment(task)));
+
+    // The fragment of a completed task is cached as well, so that
+    // `/tasks` (which only sees the tasks) splices its JSON.
+    if (!completedTasks.empty()) {
+      const std::shared_ptr<const TaskFragment>& fragment =
+        completedTasks.back();
+
+      master->taskIndex.add(&fragment->task, info.role());
+      master->taskFragments[&fragment->task] = fragment;
+    }
   }
 
   void removeTask(Task* task)
@@ -1857,6 +1943,7 @@ struct Framework
     addCompletedTask(*task);
 
     tasks.erase(task->task_id());
+    master->taskIndex.remove(task);
   }
 
   void addOffer(Offer* offer)
@@ -2099,10 +2186,11 @@ struct Framework
 
   hashmap<TaskID, Task*> tasks;
 
-  // NOTE: We use a shared pointer for Task because clang doesn't like
-  // Boost's implementation of circular_buffer with Task (Boost
-  // attempts to do some memset's which are unsafe).
-  boost::circular_buffer<std::shared_ptr<Task>> completedTasks;
+  // NOTE: We use a shared pointer for the completed tasks because
+  // clang doesn't like Boost's implementation of circular_buffer with
+  // Task (Boost attempts to do some memset's which are unsafe). Their
+  // fragments (see `TaskFragment`) are shared with the snapshots.
+  boost::circular_buffer<std::shared_ptr<const TaskFragment>> completedTasks;
 
   hashset<Offer*> offers; // Active offers for framework.
 
@@ -14,6 +14,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cctype>
 #include <string>
 
 #include <process/metrics/counter.hpp>
@@ -21,6 +22,7 @@
 #include <process/metrics/metrics.hpp>
 
 #include <stout/foreach.hpp>
+#include <stout/strings.hpp>
 
 #include "master/master.hpp"
 #include "master/metrics.hpp"
@@ -42,8 +44,7 @@ Metrics::Metrics(const Master& master)
         "master/uptime_secs",
         defer(master, &Master::_uptime_secs)),
     elected(
-        "master/elected",
-        defer(master, &Master::_elected)),
+        "master/elected"),
     slaves_connected(
         "master/slaves_connected",
         defer(master, &Master::_slaves_connected)),
@@ -474,6 +475,37 @@ void Metrics::incrementTasksStates(
 }
 
 
+void Metrics::profile(
+    const string& handler,
+    const Duration& queueTime,
+    const Duration& processingTime)
+{
+  // The handler is part of the names of its metrics, whose components
+  // are separated by slashes, so the handler keeps only the characters
+  // that are safe in a component.
+  string name = handler;
+  foreach (char& c, name) {
+    if (!isalnum(static_cast<unsigned char>(c)) &&
+        c != '.' && c != '_' && c != '-') {
+      c = '_';
+    }
+  }
+
+  if (!handlers.contains(name)) {
+    handlers.put(name, process::Owned<Handler>(new Handler(name)));
+  }
+
+  Handler* metrics = handlers.at(name).get();
+
+  metrics->queue_time.record(queueTime);
+  metrics->processing_time.record(processingTime);
+
+  metrics->events++;
+  metrics->total_queue_time += queueTime;
+  metrics->total_processing_time += processingTime;
+}
+
+
 } // namespace master {
 } // namespace internal {
 } // namespace mesos {
@@ -23,7 +23,10 @@
 #include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
 #include <process/metrics/metrics.hpp>
+#include <process/metrics/push_gauge.hpp>
+#include <process/metrics/timer.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
 
 #include "mesos/mesos.hpp"
@@ -42,7 +45,7 @@ struct Metrics
   ~Metrics();
 
   process::metrics::Gauge uptime_secs;
-  process::metrics::Gauge elected;
+  process::metrics::PushGauge elected;
 
   process::metrics::Gauge slaves_connected;
   process::metrics::Gauge slaves_disconnected;
@@ -166,6 +169,49 @@ struct Metrics
   process::metrics::Gauge event_queue_dispatches;
   process::metrics::Gauge event_queue_http_requests;
 
+  // Metrics of the handlers of the events that the master profiles
+  // (see the `--event_profiling_period` flag), i.e., of the messages
+  // that the master handles by name (the others are profiled together
+  // as `unknown`), and of the dispatches by the name of the method
+  // that they invoke (see `Master::dispatchHandlers`).
+  // These metrics have names prefixed by "master/handlers/<handler>/".
+  struct Handler
+  {
+    // Time that the profiled events spent in the queue of the master,
+    // including the time that messages were throttled for.
+    process::metrics::Timer<Microseconds> queue_time;
+
+    // Time that the master spent processing the profiled events.
+    process::metrics::Timer<Microseconds> processing_time;
+
+    // Totals of the profiled events, see the `/profile` endpoint.
+    uint64_t events;
+    Duration total_queue_time;
+    Duration total_processing_time;
+
+    explicit Handler(const std::string& name)
+      : queue_time("master/handlers/" + name + "/queue_time", Hours(1)),
+        processing_time(
+            "master/handlers/" + name + "/processing_time", Hours(1)),
+        events(0),
+        total_queue_time(Duration::zero()),
+        total_processing_time(Duration::zero())
+    {
+      process::metrics::add(queue_time);
+      process::metrics::add(processing_time);
+    }
+
+    ~Handler()
+    {
+      process::metrics::remove(queue_time);
+      process::metrics::remove(processing_time);
+    }
+  };
+
+  // Per-handler metrics keyed by the name of the handler, which are
+  // added once an event of the handler is profiled.
+  hashmap<std::string, process::Owned<Handler>> handlers;
+
   // Successful registry operations.
   process::metrics::Counter slave_registrations;
   process::metrics::Counter slave_reregistrations;
@@ -193,6 +239,12 @@ struct Metrics
       const TaskState& state,
       const TaskStatus::Source& source,
       const TaskStatus::Reason& reason);
+
+  // Records a profiled event of the given handler.
+  void profile(
+      const std::string& handler,
+      const Duration& queueTime,
+      const Duration& processingTime);
 };
 
 } // namespace master {
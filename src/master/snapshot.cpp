@@ -0,0 +1,154 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <process/clock.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/jsonify.hpp>
+#include <stout/stringify.hpp>
+
+#include "common/http.hpp"
+
+#include "master/master.hpp"
+#include "master/snapshot.hpp"
+
+using std::shared_ptr;
+using std::string;
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+const string& TaskFragment::json() const
+{
+  std::call_once(serialized, [this]() {
+    serialization = jsonify(task);
+  });
+
+  return serialization;
+}
+
+
+StateSnapshot::Slave::Slave(const master::Slave& slave)
+  : id(slave.id),
+    info(slave.info),
+    pid(slave.pid),
+    version(slave.version),
+    registeredTime(slave.registeredTime),
+    reregisteredTime(slave.reregisteredTime),
+    active(slave.active),
+    usedResources(slave.usedResources),
+    offeredResources(slave.offeredResources),
+    totalResources(slave.totalResources) {}
+
+
+StateSnapshot::Framework::Framework(master::Framework* framework)
+  : info(framework->info),
+    pid(framework->pid),
+    active(framework->active),
+    registeredTime(framework->registeredTime),
+    reregisteredTime(framework->reregisteredTime),
+    unregisteredTime(framework->unregisteredTime),
+    pendingTasks(framework->pendingTasks),
+    completedTasks(
+        framework->completedTasks.begin(),
+        framework->completedTasks.end()),
+    executors(framework->executors),
+    totalUsedResources(framework->totalUsedResources),
+    totalOfferedResources(framework->totalOfferedResources)
+{
+  // The tasks are updated in place by the master, which hence shares
+  // the fragments of the tasks until they are updated. The offers are
+  // copied.
+  foreachpair (const TaskID& taskId, const Task* task, framework->tasks) {
+    tasks[taskId] = framework->master->fragment(task);
+  }
+
+  offers.reserve(framework->offers.size());
+
+  foreach (const Offer* offer, framework->offers) {
+    offers.push_back(shared_ptr<const Offer>(new Offer(*offer)));
+  }
+}
+
+
+StateSnapshot::StateSnapshot(Master* master)
+  : time(process::Clock::now()),
+    version(master->stateVersion),
+    flags(master->flags),
+    info(master->info()),
+    pid(master->self()),
+    startTime(master->startTime),
+    electedTime(master->electedTime),
+    leader(master->leader),
+    activatedSlaves(0),
+    deactivatedSlaves(0),
+    etag(tag(info, version))
+{
+  slaves.reserve(master->slaves.registered.size());
+
+  foreachvalue (const master::Slave* slave, master->slaves.registered) {
+    slaves.push_back(Slave(*slave));
+
+    if (slave->active) {
+      activatedSlaves++;
+    } else {
+      deactivatedSlaves++;
+    }
+
+    typedef hashmap<TaskID, Task*> TaskMap;
+    foreachpair (const FrameworkID& frameworkId,
+                 const TaskMap& tasks,
+                 slave->tasks) {
+      if (master->frameworks.registered.contains(frameworkId)) {
+        continue;
+      }
+
+      unregisteredFrameworks.push_back(frameworkId);
+
+      foreachvalue (const Task* task, tasks) {
+        CHECK_NOTNULL(task);
+        orphanTasks.push_back(master->fragment(task));
+      }
+    }
+  }
+
+  frameworks.reserve(master->frameworks.registered.size());
+
+  foreachvalue (master::Framework* framework,
+                master->frameworks.registered) {
+    frameworks.push_back(Framework(framework));
+  }
+
+  completedFrameworks.reserve(master->frameworks.completed.size());
+
+  foreach (const shared_ptr<master::Framework>& framework,
+           master->frameworks.completed) {
+    completedFrameworks.push_back(Framework(framework.get()));
+  }
+}
+
+
+string StateSnapshot::tag(const MasterInfo& info, uint64_t version)
+{
+  // The ID of the master distinguishes the versions of the states of
+  // different masters (e.g., after a failover), which all start at 0.
+  return "\"" + info.id() + "-" + stringify(version) + "\"";
+}
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,162 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __MASTER_SNAPSHOT_HPP__
+#define __MASTER_SNAPSHOT_HPP__
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <mesos/mesos.hpp>
+#include <mesos/resources.hpp>
+
+#include <process/pid.hpp>
+#include <process/time.hpp>
+
+#include <stout/hashmap.hpp>
+#include <stout/option.hpp>
+
+#include "master/flags.hpp"
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// Forward declarations.
+class Master;
+struct Framework;
+struct Slave;
+
+
+// A task along with its JSON representation, which the first endpoint
+// that writes out the task serializes. The master keeps the fragments
+// of its tasks until the tasks are updated (completed tasks are never
+// updated), so that the endpoints splice the JSON of the tasks that
+// did not change rather than serializing them again and again.
+struct TaskFragment
+{
+  explicit TaskFragment(const Task& _task) : task(_task) {}
+
+  // Returns the JSON representation of the task.
+  const std::string& json() const;
+
+  const Task task;
+
+private:
+  mutable std::once_flag serialized;
+  mutable std::string serialization;
+};
+
+
+// An immutable copy of the state of the master that the `/state` and
+// the `/frameworks` endpoints expose. The master takes the snapshot in
+// its own context, which only copies the state (e.g., the resources
+// and the tasks are shared rather than copied), so that the snapshot
+// can be serialized on other cores while the master goes on.
+//
+// The copies of the slaves and the frameworks have the same members
+// as the originals, so that they share their JSON representations.
+struct StateSnapshot
+{
+  struct Slave
+  {
+    explicit Slave(const master::Slave& slave);
+
+    SlaveID id;
+    SlaveInfo info;
+    process::UPID pid;
+    std::string version;
+    process::Time registeredTime;
+    Option<process::Time> reregisteredTime;
+    bool active;
+    hashmap<FrameworkID, Resources> usedResources;
+    Resources offeredResources;
+    Resources totalResources;
+  };
+
+  struct Framework
+  {
+    explicit Framework(master::Framework* framework);
+
+    const FrameworkID id() const { return info.id(); }
+
+    FrameworkInfo info;
+    Option<process::UPID> pid;
+    bool active;
+    process::Time registeredTime;
+    process::Time reregisteredTime;
+    process::Time unregisteredTime;
+    hashmap<TaskID, TaskInfo> pendingTasks;
+    hashmap<TaskID, std::shared_ptr<const TaskFragment>> tasks;
+    std::vector<std::shared_ptr<const TaskFragment>> completedTasks;
+    std::vector<std::shared_ptr<const Offer>> offers;
+    hashmap<SlaveID, hashmap<ExecutorID, ExecutorInfo>> executors;
+    Resources totalUsedResources;
+    Resources totalOfferedResources;
+  };
+
+  // NOTE: Taking a snapshot caches the fragments of the tasks of the
+  // master, which is thus not `const`.
+  explicit StateSnapshot(Master* master);
+
+  // Returns the entity tag of the given version of the state of the
+  // given master, which identifies the serialization of that state
+  // without serializing it.
+  static std::string tag(const MasterInfo& info, uint64_t version);
+
+  // The time at which the snapshot was taken.
+  const process::Time time;
+
+  // The version of the state of the master that the snapshot is of
+  // (see `Master::stateVersion`).
+  const uint64_t version;
+
+  Flags flags;
+  MasterInfo info;
+  process::UPID pid;
+  process::Time startTime;
+  Option<process::Time> electedTime;
+  Option<MasterInfo> leader;
+
+  size_t activatedSlaves;
+  size_t deactivatedSlaves;
+
+  std::vector<Slave> slaves;
+  std::vector<Framework> frameworks;
+  std::vector<Framework> completedFrameworks;
+
+  // The tasks whose frameworks have not re-registered (yet) after a
+  // master failover, and the IDs of those frameworks, once for every
+  // slave that runs their tasks.
+  std::vector<std::shared_ptr<const TaskFragment>> orphanTasks;
+  std::vector<FrameworkID> unregisteredFrameworks;
+
+  // The entity tag of the snapshot, see `tag()`.
+  const std::string etag;
+
+  // The serialization of the snapshot, which the first request served
+  // from the snapshot does.
+  mutable std::once_flag serialized;
+  mutable std::string json;
+};
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MASTER_SNAPSHOT_HPP__
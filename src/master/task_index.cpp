@@ -0,0 +1,380 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+
+#include <iterator>
+#include <limits>
+
+#include <glog/logging.h>
+
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/numify.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+
+#include "master/task_index.hpp"
+
+using std::set;
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// NOTE: The cursor holds the bits of the time rather than its decimal
+// representation, which would need to be parsed back exactly.
+string TaskIndex::Key::cursor() const
+{
+  uint64_t bits;
+  memcpy(&bits, &time, sizeof(bits));
+
+  return stringify(bits) + ":" + stringify(sequence);
+}
+
+
+Try<TaskIndex::Key> TaskIndex::Key::parse(const string& cursor)
+{
+  vector<string> tokens = strings::split(cursor, ":");
+
+  if (tokens.size() != 2) {
+    return Error("Expecting a cursor of the form '<time>:<sequence>'");
+  }
+
+  Try<uint64_t> bits = numify<uint64_t>(tokens[0]);
+  if (bits.isError()) {
+    return Error("Failed to parse the time: " + bits.error());
+  }
+
+  Try<uint64_t> sequence = numify<uint64_t>(tokens[1]);
+  if (sequence.isError()) {
+    return Error("Failed to parse the sequence: " + sequence.error());
+  }
+
+  Key key;
+  memcpy(&key.time, &bits.get(), sizeof(key.time));
+  key.sequence = sequence.get();
+
+  return key;
+}
+
+
+void TaskIndex::add(const Task* task, const string& role)
+{
+  CHECK_NOTNULL(task);
+  CHECK(!keys.contains(task))
+    << "Duplicate task " << task->task_id()
+    << " of framework " << task->framework_id();
+
+  Key key_ = key(task);
+  key_.sequence = sequence++;
+
+  insert(task, key_, role);
+}
+
+
+void TaskIndex::update(const Task* task)
+{
+  CHECK_NOTNULL(task);
+
+  if (!keys.contains(task)) {
+    return;
+  }
+
+  // Keep the sequence number of the task, so that it keeps its
+  // position relative to the tasks with the same time.
+  const uint64_t sequence_ = keys[task].sequence;
+  const string role = entries.at(keys[task]).role;
+
+  remove(task);
+
+  Key key_ = key(task);
+  key_.sequence = sequence_;
+
+  insert(task, key_, role);
+}
+
+
+// Removes a key from a secondary index, along with the set of keys
+// once it is empty.
+template <typename Index, typename T>
+static void erase(Index* index, const T& value, const TaskIndex::Key& key)
+{
+  CHECK(index->contains(value));
+
+  set<TaskIndex::Key>& keys = index->at(value);
+  keys.erase(key);
+
+  if (keys.empty()) {
+    index->erase(value);
+  }
+}
+
+
+void TaskIndex::remove(const Task* task)
+{
+  CHECK_NOTNULL(task);
+
+  if (!keys.contains(task)) {
+    return;
+  }
+
+  const Key key_ = keys[task];
+  const Entry& entry = entries.at(key_);
+
+  erase(&frameworks, task->framework_id(), key_);
+  erase(&roles, entry.role, key_);
+  erase(&slaves, task->slave_id(), key_);
+  erase(&states, entry.state, key_);
+
+  // NOTE: A task may have labels with the same key and different
+  // values, but is indexed by that key once.
+  set<string> labelKeys_;
+
+  foreach (const LabelValue& label, labels(task)) {
+    erase(&labelValues, label, key_);
+    labelKeys_.insert(label.first);
+  }
+
+  foreach (const string& labelKey, labelKeys_) {
+    erase(&labelKeys, labelKey, key_);
+  }
+
+  entries.erase(key_);
+  keys.erase(task);
+}
+
+
+template <typename Keys, typename KeyOf>
+TaskIndex::Page TaskIndex::scan(
+    const Keys& keys,
+    const KeyOf& keyOf,
+    const Query& query) const
+{
+  Page page;
+  size_t skipped = 0;
+
+  // Returns whether to go on with the next task.
+  auto visit = [this, &page, &skipped, &query](const Key& key) {
+    const Entry& entry = entries.at(key);
+
+    if (!matches(entry, query)) {
+      return true;
+    }
+
+    if (skipped < query.offset) {
+      skipped++;
+      return true;
+    }
+
+    if (page.tasks.size() == query.limit) {
+      if (!page.tasks.empty()) {
+        page.next = this->keys.at(page.tasks.back());
+      }
+
+      return false;
+    }
+
+    page.tasks.push_back(entry.task);
+    return true;
+  };
+
+  if (query.ascending) {
+    auto iterator = query.cursor.isSome()
+      ? keys.upper_bound(query.cursor.get())
+      : keys.begin();
+
+    for (; iterator != keys.end(); ++iterator) {
+      if (!visit(keyOf(*iterator))) {
+        break;
+      }
+    }
+  } else {
+    auto iterator = query.cursor.isSome()
+      ? typename Keys::const_reverse_iterator(
+            keys.lower_bound(query.cursor.get()))
+      : keys.rbegin();
+
+    for (; iterator != keys.rend(); ++iterator) {
+      if (!visit(keyOf(*iterator))) {
+        break;
+      }
+    }
+  }
+
+  return page;
+}
+
+
+// Returns the keys of the tasks with the given value in a secondary
+// index, if any.
+template <typename Index, typename T>
+static Option<const set<TaskIndex::Key>*> lookup(
+    const Index& index,
+    const T& value)
+{
+  const auto iterator = index.find(value);
+  if (iterator == index.end()) {
+    return None();
+  }
+
+  return &iterator->second;
+}
+
+
+TaskIndex::Page TaskIndex::find(const Query& query) const
+{
+  // Scan the smallest of the secondary indexes that the query
+  // filters by, if any, and check the other filters for every task.
+  const set<Key>* index = NULL;
+  bool empty = false;
+
+  auto narrow = [&index, &empty](const Option<const set<Key>*>& keys) {
+    if (keys.isNone()) {
+      empty = true;
+    } else if (index == NULL || keys.get()->size() < index->size()) {
+      index = keys.get();
+    }
+  };
+
+  if (query.frameworkId.isSome()) {
+    narrow(lookup(frameworks, query.frameworkId.get()));
+  }
+
+  if (query.role.isSome()) {
+    narrow(lookup(roles, query.role.get()));
+  }
+
+  if (query.slaveId.isSome()) {
+    narrow(lookup(slaves, query.slaveId.get()));
+  }
+
+  if (query.state.isSome()) {
+    narrow(lookup(states, query.state.get()));
+  }
+
+  if (query.label.isSome()) {
+    const Label& label = query.label.get();
+
+    if (label.has_value()) {
+      narrow(lookup(labelValues, LabelValue(label.key(), label.value())));
+    } else {
+      narrow(lookup(labelKeys, label.key()));
+    }
+  }
+
+  if (empty) {
+    return Page();
+  }
+
+  if (index != NULL) {
+    return scan(*index, [](const Key& key) { return key; }, query);
+  }
+
+  return scan(
+      entries,
+      [](const std::pair<const Key, Entry>& entry) { return entry.first; },
+      query);
+}
+
+
+void TaskIndex::insert(const Task* task, const Key& key, const string& role)
+{
+  keys[task] = key;
+  entries[key] = Entry{task, role, task->state()};
+
+  frameworks[task->framework_id()].insert(key);
+  roles[role].insert(key);
+  slaves[task->slave_id()].insert(key);
+  states[task->state()].insert(key);
+
+  foreach (const LabelValue& label, labels(task)) {
+    labelKeys[label.first].insert(key);
+    labelValues[label].insert(key);
+  }
+}
+
+
+set<TaskIndex::LabelValue> TaskIndex::labels(const Task* task)
+{
+  set<LabelValue> labels;
+  foreach (const Label& label, task->labels().labels()) {
+    labels.insert(LabelValue(label.key(), label.value()));
+  }
+
+  return labels;
+}
+
+
+TaskIndex::Key TaskIndex::key(const Task* task)
+{
+  Key key;
+
+  // NOTE: As for the `/tasks` endpoint, the earliest status is used
+  // if the task has multiple statuses.
+  key.time = task->statuses_size() > 0
+    ? task->statuses(0).timestamp()
+    : -std::numeric_limits<double>::infinity();
+
+  key.sequence = 0;
+
+  return key;
+}
+
+
+bool TaskIndex::matches(const Entry& entry, const Query& query) const
+{
+  const Task& task = *entry.task;
+
+  if (query.frameworkId.isSome() &&
+      task.framework_id() != query.frameworkId.get()) {
+    return false;
+  }
+
+  if (query.role.isSome() && entry.role != query.role.get()) {
+    return false;
+  }
+
+  if (query.slaveId.isSome() && task.slave_id() != query.slaveId.get()) {
+    return false;
+  }
+
+  if (query.state.isSome() && entry.state != query.state.get()) {
+    return false;
+  }
+
+  if (query.label.isSome()) {
+    const Label& label = query.label.get();
+
+    foreach (const Label& candidate, task.labels().labels()) {
+      if (candidate.key() == label.key() &&
+          (!label.has_value() || candidate.value() == label.value())) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  return true;
+}
+
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
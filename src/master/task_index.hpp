@@ -0,0 +1,184 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __MASTER_TASK_INDEX_HPP__
+#define __MASTER_TASK_INDEX_HPP__
+
+#include <stdint.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+
+#include <mesos/mesos.hpp>
+#include <mesos/type_utils.hpp>
+
+#include <stout/hashmap.hpp>
+#include <stout/option.hpp>
+#include <stout/try.hpp>
+
+#include "messages/messages.hpp"
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// An index of the tasks of the frameworks, including their completed
+// tasks, in the order of the `/tasks` endpoint (i.e., by the time of
+// their first status). Along with the secondary indexes of the tasks
+// by framework, role, slave, state and labels, this lets the master
+// list a page of the tasks that match a query without walking all of
+// them.
+//
+// NOTE: The index refers to the tasks, which must be removed from the
+// index before they are deleted, and updated in the index when their
+// statuses change.
+class TaskIndex
+{
+public:
+  // The position of a task in the index. Tasks without a status come
+  // first, and the sequence number, which is assigned when a task is
+  // indexed, orders the tasks with the same time.
+  struct Key
+  {
+    bool operator<(const Key& that) const
+    {
+      if (time != that.time) {
+        return time < that.time;
+      }
+
+      return sequence < that.sequence;
+    }
+
+    // Returns the key as a cursor to continue a listing after the
+    // task at this position.
+    std::string cursor() const;
+
+    static Try<Key> parse(const std::string& cursor);
+
+    double time;
+    uint64_t sequence;
+  };
+
+  struct Query
+  {
+    Query() : ascending(false), offset(0), limit(0) {}
+
+    Option<FrameworkID> frameworkId;
+    Option<std::string> role;
+    Option<SlaveID> slaveId;
+    Option<TaskState> state;
+
+    // Matches the tasks with a label of the same key, and of the same
+    // value if the label has one.
+    Option<Label> label;
+
+    bool ascending;
+
+    // The listing continues after this position, if any, where
+    // `offset` matching tasks are skipped.
+    Option<Key> cursor;
+    size_t offset;
+    size_t limit;
+  };
+
+  struct Page
+  {
+    std::vector<const Task*> tasks;
+
+    // The position of the last task of the page if more tasks match.
+    Option<Key> next;
+  };
+
+  TaskIndex() : sequence(0) {}
+
+  // Adds a task of a framework with the given role.
+  void add(const Task* task, const std::string& role);
+
+  // Repositions a task after its statuses changed.
+  void update(const Task* task);
+
+  void remove(const Task* task);
+
+  Page find(const Query& query) const;
+
+  size_t size() const { return entries.size(); }
+
+private:
+  struct Entry
+  {
+    const Task* task;
+    std::string role;
+
+    // The state of the task as indexed, since the master updates the
+    // task before it updates the index.
+    TaskState state;
+  };
+
+  // The key and the value of a label, which is empty if the label
+  // has none (as the label filter of a query treats it).
+  typedef std::pair<std::string, std::string> LabelValue;
+
+  struct LabelValueHash
+  {
+    size_t operator()(const LabelValue& label) const
+    {
+      size_t seed = 0;
+      boost::hash_combine(seed, label.first);
+      boost::hash_combine(seed, label.second);
+      return seed;
+    }
+  };
+
+  void insert(const Task* task, const Key& key, const std::string& role);
+
+  // Returns the distinct labels of a task, which may have a label (or
+  // a key) more than once.
+  static std::set<LabelValue> labels(const Task* task);
+
+  // Returns the key of a task, without a sequence number.
+  static Key key(const Task* task);
+
+  bool matches(const Entry& entry, const Query& query) const;
+
+  template <typename Keys, typename KeyOf>
+  Page scan(const Keys& keys, const KeyOf& keyOf, const Query& query) const;
+
+  std::map<Key, Entry> entries;
+  hashmap<const Task*, Key> keys;
+
+  hashmap<FrameworkID, std::set<Key>> frameworks;
+  hashmap<std::string, std::set<Key>> roles;
+  hashmap<SlaveID, std::set<Key>> slaves;
+  hashmap<TaskState, std::set<Key>> states;
+
+  // The tasks by the keys of their labels, and by the keys along with
+  // the values.
+  hashmap<std::string, std::set<Key>> labelKeys;
+  hashmap<LabelValue, std::set<Key>, LabelValueHash> labelValues;
+
+  uint64_t sequence;
+};
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MASTER_TASK_INDEX_HPP__
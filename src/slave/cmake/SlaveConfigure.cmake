@@ -80,8 +80,8 @@ if (NOT WIN32)
     )
 endif (NOT WIN32)
 
-if (NOT ENABLE_LIBEVENT)
-  set(AGENT_LIBS ${AGENT_LIBS} ${LIBEV_LFLAG})
-elseif (ENABLE_LIBEVENT)
+if (ENABLE_LIBEVENT)
   set(AGENT_LIBS ${AGENT_LIBS} ${LIBEVENT_LFLAG})
-endif (NOT ENABLE_LIBEVENT)
+elseif (NOT ENABLE_EPOLL)
+  set(AGENT_LIBS ${AGENT_LIBS} ${LIBEV_LFLAG})
+endif (ENABLE_LIBEVENT)
@@ -173,6 +173,13 @@ mesos::internal::slave::Flags::Flags()
       "(one subdirectory per slave).",
       "/tmp/mesos/fetch");
 
+  add(&Flags::files_bandwidth_limit,
+      "files_bandwidth_limit",
+      "The limit of the bandwidth used to serve file contents via the\n"
+      "`/files/read` (with `raw=true`) and `/files/download` endpoints,\n"
+      "in Bytes/s, shared by all requests. If not specified, the\n"
+      "bandwidth is not limited.");
+
   add(&Flags::work_dir,
       "work_dir",
       "Directory path to place framework work directories\n", "/tmp/mesos");
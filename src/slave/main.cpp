@@ -302,7 +302,7 @@ int main(int argc, char** argv)
     // terminating.
   }
 
-  Files files(DEFAULT_HTTP_AUTHENTICATION_REALM);
+  Files files(DEFAULT_HTTP_AUTHENTICATION_REALM, flags.files_bandwidth_limit);
   GarbageCollector gc;
   StatusUpdateManager statusUpdateManager(flags);
 
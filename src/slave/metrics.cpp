@@ -86,8 +86,7 @@ Metrics::Metrics(const Slave& slave)
     invalid_framework_messages(
         "slave/invalid_framework_messages"),
     executor_directory_max_allowed_age_secs(
-        "slave/executor_directory_max_allowed_age_secs",
-        defer(slave, &Slave::_executor_directory_max_allowed_age_secs)),
+        "slave/executor_directory_max_allowed_age_secs"),
     container_launch_errors(
         "slave/container_launch_errors")
 {
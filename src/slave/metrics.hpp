@@ -21,6 +21,7 @@
 
 #include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
+#include <process/metrics/push_gauge.hpp>
 
 
 namespace mesos {
@@ -63,7 +64,7 @@ struct Metrics
   process::metrics::Counter valid_framework_messages;
   process::metrics::Counter invalid_framework_messages;
 
-  process::metrics::Gauge executor_directory_max_allowed_age_secs;
+  process::metrics::PushGauge executor_directory_max_allowed_age_secs;
 
   process::metrics::Counter container_launch_errors;
 
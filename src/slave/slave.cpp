@@ -153,7 +153,11 @@ Slave::Slave(const std::string& id,
     reauthenticate(false),
     executorDirectoryMaxAllowedAge(age(0)),
     resourceEstimator(_resourceEstimator),
-    qosController(_qosController) {}
+    qosController(_qosController)
+{
+  metrics.executor_directory_max_allowed_age_secs =
+    executorDirectoryMaxAllowedAge.secs();
+}
 
 
 Slave::~Slave()
@@ -4579,6 +4583,8 @@ void Slave::_checkDiskUsage(const Future<double>& usage)
                << (usage.isFailed() ? usage.failure() : "future discarded");
   } else {
     executorDirectoryMaxAllowedAge = age(usage.get());
+    metrics.executor_directory_max_allowed_age_secs =
+      executorDirectoryMaxAllowedAge.secs();
     LOG(INFO) << "Current disk usage " << std::setiosflags(std::ios::fixed)
               << std::setprecision(2) << 100 * usage.get() << "%."
               << " Max allowed age: " << executorDirectoryMaxAllowedAge;
@@ -5312,12 +5318,6 @@ double Slave::_executors_terminating()
 }
 
 
-double Slave::_executor_directory_max_allowed_age_secs()
-{
-  return executorDirectoryMaxAllowedAge.secs();
-}
-
-
 void Slave::sendExecutorTerminatedStatusUpdate(
     const TaskID& taskId,
     const Future<containerizer::Termination>& termination,
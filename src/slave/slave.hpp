@@ -486,8 +486,6 @@ private:
   double _executors_running();
   double _executors_terminating();
 
-  double _executor_directory_max_allowed_age_secs();
-
   void sendExecutorTerminatedStatusUpdate(
       const TaskID& taskId,
       const Future<containerizer::Termination>& termination,
@@ -14,12 +14,18 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <unistd.h>
+
+#include <iostream>
+#include <list>
 #include <string>
+#include <vector>
 
 #include <gmock/gmock.h>
 
 #include <mesos/authentication/http/basic_authenticator_factory.hpp>
 
+#include <process/collect.hpp>
 #include <process/future.hpp>
 #include <process/gtest.hpp>
 #include <process/http.hpp>
@@ -29,6 +35,7 @@
 #include <stout/gtest.hpp>
 #include <stout/json.hpp>
 #include <stout/os.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
 
 #include <stout/tests/utils.hpp>
@@ -48,7 +55,13 @@ using process::http::OK;
 using process::http::Response;
 using process::http::Unauthorized;
 
+using std::cout;
+using std::endl;
+using std::list;
 using std::string;
+using std::vector;
+
+using testing::WithParamInterface;
 
 using mesos::http::authentication::BasicAuthenticatorFactory;
 
@@ -179,6 +192,43 @@ TEST_F(FilesTest, ReadTest)
 }
 
 
+TEST_F(FilesTest, ReadRawTest)
+{
+  Files files;
+  process::UPID upid("files", process::address());
+
+  ASSERT_SOME(os::write("file", "body"));
+  AWAIT_EXPECT_READY(files.attach("file", "myname"));
+
+  const string partialContent =
+    process::http::Status::string(process::http::Status::PARTIAL_CONTENT);
+
+  Future<Response> response = process::http::get(
+      upid, "read", "path=myname&offset=1&length=2&raw=true");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(partialContent, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("od", response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("bytes 1-2/4", "Content-Range", response);
+
+  // Without an offset only the size of the file is returned.
+  response = process::http::get(upid, "read", "path=myname&raw=true");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(partialContent, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("", response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("bytes */4", "Content-Range", response);
+
+  // Range requests are supported when downloading.
+  process::http::Headers headers;
+  headers["Range"] = "bytes=1-";
+
+  response = process::http::get(upid, "download", "path=myname", headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(partialContent, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("ody", response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("bytes 1-3/4", "Content-Range", response);
+}
+
+
 TEST_F(FilesTest, ResolveTest)
 {
   Files files;
@@ -412,6 +462,90 @@ TEST_F(FilesTest, AuthenticationTest)
             expectedAuthorizationHeader);
 }
 
+
+
+class Files_BENCHMARK_Test
+  : public TemporaryDirectoryTest,
+    public WithParamInterface<size_t> {};
+
+
+// The files benchmark tests are parameterized by the number of
+// concurrent tailers.
+INSTANTIATE_TEST_CASE_P(
+    TailerCount,
+    Files_BENCHMARK_Test,
+    ::testing::Values(10U, 100U, 500U));
+
+
+// Measures the CPU time used when many tailers concurrently read a
+// sandbox file chunk by chunk, using JSON and raw '/files/read'
+// requests. Since the tailers run in this process as well, the CPU
+// time includes receiving the responses (which is the same for both).
+TEST_P(Files_BENCHMARK_Test, Tailers)
+{
+  Files files;
+  process::UPID upid("files", process::address());
+
+  const size_t tailerCount = GetParam();
+  const size_t chunkSize = 64 * 1024;
+  const size_t chunkCount = 16;
+
+  // Simulate a log with characters that need to be escaped in JSON.
+  const string line = "I0101 00:00:00.000000 1 main.cpp:1] \"Started\"\t\n";
+
+  string data;
+  while (data.size() < chunkSize * chunkCount) {
+    data += line;
+  }
+
+  ASSERT_SOME(os::write("stdout", data));
+  AWAIT_READY(files.attach("stdout", "stdout"));
+
+  foreach (const string& mode, vector<string>({"json", "raw"})) {
+    Result<os::Process> before = os::process(::getpid());
+    ASSERT_SOME(before);
+
+    Stopwatch watch;
+    watch.start();
+
+    for (size_t i = 0; i < chunkCount; i++) {
+      string query =
+        "path=stdout&offset=" + stringify(i * chunkSize) +
+        "&length=" + stringify(chunkSize);
+
+      if (mode == "raw") {
+        query += "&raw=true";
+      }
+
+      list<Future<Response>> responses;
+      for (size_t j = 0; j < tailerCount; j++) {
+        responses.push_back(process::http::get(upid, "read", query));
+      }
+
+      Future<list<Response>> collect = process::collect(responses);
+      AWAIT_READY_FOR(collect, Minutes(5));
+    }
+
+    const Duration elapsed = watch.elapsed();
+
+    Result<os::Process> after = os::process(::getpid());
+    ASSERT_SOME(after);
+
+    ASSERT_SOME(before.get().utime);
+    ASSERT_SOME(before.get().stime);
+    ASSERT_SOME(after.get().utime);
+    ASSERT_SOME(after.get().stime);
+
+    const Duration cpu =
+      (after.get().utime.get() + after.get().stime.get()) -
+      (before.get().utime.get() + before.get().stime.get());
+
+    cout << tailerCount << " tailers read " << Bytes(data.size())
+         << " each using " << mode << " reads in " << elapsed
+         << " (" << cpu << " of CPU)" << endl;
+  }
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -43,6 +43,9 @@
 
 #include "master/allocator/mesos/hierarchical.hpp"
 
+#include "master/allocator/trace/recorder.hpp"
+#include "master/allocator/trace/replayer.hpp"
+
 #include "tests/allocator.hpp"
 #include "tests/mesos.hpp"
 #include "tests/utils.hpp"
@@ -51,6 +54,9 @@ using mesos::internal::master::MIN_CPUS;
 using mesos::internal::master::MIN_MEM;
 
 using mesos::internal::master::allocator::HierarchicalDRFAllocator;
+using mesos::internal::master::allocator::HierarchicalDRFAllocatorProcess;
+using mesos::internal::master::allocator::RecordingAllocator;
+using mesos::internal::master::allocator::Replayer;
 
 using mesos::internal::protobuf::createLabel;
 
@@ -66,6 +72,7 @@ using std::map;
 using std::string;
 using std::vector;
 
+using testing::_;
 using testing::WithParamInterface;
 
 namespace mesos {
@@ -174,11 +181,16 @@ protected:
         };
     }
 
+    mesos::master::allocator::Options options;
+    options.allocationWindow = flags.allocation_coalescing_window;
+    options.agentOrdering = flags.agent_ordering;
+
     allocator->initialize(
         flags.allocation_interval,
         offerCallback.get(),
         inverseOfferCallback.get(),
-        hashmap<string, double>());
+        hashmap<string, double>(),
+        options);
   }
 
   SlaveInfo createSlaveInfo(const string& resources)
@@ -961,6 +973,61 @@ TEST_F(HierarchicalAllocatorTest, Reservations)
 }
 
 
+// Checks that the allocations triggered by events are coalesced within
+// the allocation window, and that batch allocations pick up the agents
+// whose resources were recovered.
+TEST_F(HierarchicalAllocatorTest, AllocationCoalescingWindow)
+{
+  Clock::pause();
+
+  master::Flags flags_;
+  flags_.allocation_coalescing_window = Milliseconds(100);
+
+  initialize(flags_);
+
+  SlaveInfo slave1 = createSlaveInfo("cpus:1;mem:512;disk:0");
+  allocator->addSlave(slave1.id(), slave1, None(), slave1.resources(), {});
+
+  SlaveInfo slave2 = createSlaveInfo("cpus:1;mem:512;disk:0");
+  allocator->addSlave(slave2.id(), slave2, None(), slave2.resources(), {});
+
+  FrameworkInfo framework = createFrameworkInfo("role1");
+  allocator->addFramework(framework.id(), framework, {});
+
+  // Nothing is allocated before the window has passed.
+  Future<Allocation> allocation = allocations.get();
+
+  Clock::settle();
+  EXPECT_TRUE(allocation.isPending());
+
+  // Then the resources of both agents are allocated at once.
+  Clock::advance(flags_.allocation_coalescing_window);
+
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+  EXPECT_EQ(2u, allocation.get().resources.size());
+  EXPECT_EQ(slave1.resources() + slave2.resources(),
+            Resources::sum(allocation.get().resources));
+
+  // Recovered resources are not allocated right away, but by the next
+  // batch allocation.
+  allocator->recoverResources(
+      framework.id(), slave1.id(), slave1.resources(), None());
+
+  allocation = allocations.get();
+
+  Clock::settle();
+  EXPECT_TRUE(allocation.isPending());
+
+  Clock::advance(flags_.allocation_interval);
+
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+  EXPECT_EQ(1u, allocation.get().resources.size());
+  EXPECT_TRUE(allocation.get().resources.contains(slave1.id()));
+}
+
+
 // Checks that recovered resources are re-allocated correctly.
 TEST_F(HierarchicalAllocatorTest, RecoverResources)
 {
@@ -1248,6 +1315,80 @@ TEST_F(HierarchicalAllocatorTest, UpdateAvailableFail)
   AWAIT_EXPECT_FAILED(update);
 }
 
+
+// This test ensures that the `best_fit` agent ordering still allocates
+// the fuller agent first after a call to 'updateAvailable'.
+TEST_F(HierarchicalAllocatorTest, UpdateAvailableBestFit)
+{
+  Clock::pause();
+
+  master::Flags flags_;
+  flags_.allocation_coalescing_window = Milliseconds(100);
+  flags_.agent_ordering = "best_fit";
+
+  initialize(flags_);
+
+  // The roles have the same share, so the agent allocated first goes
+  // to the framework of "role1" and the other one to "role2".
+  FrameworkInfo framework1 = createFrameworkInfo("role1");
+  allocator->addFramework(framework1.id(), framework1, {});
+
+  FrameworkInfo framework2 = createFrameworkInfo("role2");
+  allocator->addFramework(framework2.id(), framework2, {});
+
+  // Half of the first agent is used by a framework that is unknown to
+  // the allocator, hence it does not count towards the roles' shares.
+  FrameworkID unknown;
+  unknown.set_value("unknown");
+
+  hashmap<FrameworkID, Resources> used;
+  used[unknown] = Resources::parse("cpus:1;mem:512").get();
+
+  SlaveInfo slave1 = createSlaveInfo("cpus:2;mem:1024;disk:100");
+  allocator->addSlave(slave1.id(), slave1, None(), slave1.resources(), used);
+
+  SlaveInfo slave2 = createSlaveInfo("cpus:2;mem:1024;disk:100");
+  allocator->addSlave(slave2.id(), slave2, None(), slave2.resources(), {});
+
+  // Reserve the disk of the first agent for "role1".
+  Resources unreserved = Resources::parse("disk:100").get();
+  Resources dynamicallyReserved =
+    unreserved.flatten("role1", createReservationInfo("ops"));
+
+  Future<Nothing> update =
+    allocator->updateAvailable(slave1.id(), {RESERVE(dynamicallyReserved)});
+
+  AWAIT_EXPECT_READY(update);
+
+  Clock::advance(flags_.allocation_coalescing_window);
+
+  hashmap<FrameworkID, Allocation> frameworkAllocations;
+
+  for (int i = 0; i < 2; i++) {
+    Future<Allocation> allocation = allocations.get();
+    AWAIT_READY(allocation);
+
+    frameworkAllocations[allocation.get().frameworkId] = allocation.get();
+  }
+
+  ASSERT_TRUE(frameworkAllocations.contains(framework1.id()));
+  ASSERT_TRUE(frameworkAllocations.contains(framework2.id()));
+
+  // The first agent has the smaller share of free resources, hence it
+  // is allocated first, to the framework of "role1".
+  Allocation allocation = frameworkAllocations[framework1.id()];
+  EXPECT_EQ(1u, allocation.resources.size());
+  EXPECT_TRUE(allocation.resources.contains(slave1.id()));
+  EXPECT_EQ(Resources::parse("cpus:1;mem:512").get() + dynamicallyReserved,
+            Resources::sum(allocation.resources));
+
+  allocation = frameworkAllocations[framework2.id()];
+  EXPECT_EQ(1u, allocation.resources.size());
+  EXPECT_TRUE(allocation.resources.contains(slave2.id()));
+  EXPECT_EQ(slave2.resources(), Resources::sum(allocation.resources));
+}
+
+
 // This test ensures that when oversubscribed resources are updated
 // subsequent allocations properly account for that.
 TEST_F(HierarchicalAllocatorTest, UpdateSlave)
@@ -2566,6 +2707,9 @@ TEST_F(HierarchicalAllocatorTest, AllocationRunsMetric)
   allocator->addSlave(agent.id(), agent, None(), agent.resources(), {});
   ++allocations; // Adding an agent triggers allocations.
 
+  // Settle so that the allocations are not coalesced.
+  Clock::settle();
+
   FrameworkInfo framework = createFrameworkInfo("role");
   allocator->addFramework(framework.id(), framework, {});
   ++allocations; // Adding a framework triggers allocations.
@@ -2617,8 +2761,15 @@ TEST_F(HierarchicalAllocatorTest, AllocationRunTimerMetrics)
 
   // Trigger at least two calls to allocate occur
   // to generate the window statistics.
-  SlaveInfo agent = createSlaveInfo("cpus:2;mem:1024;disk:0");
-  allocator->addSlave(agent.id(), agent, None(), agent.resources(), {});
+  Future<Nothing> allocate =
+    FUTURE_DISPATCH(_, &HierarchicalDRFAllocatorProcess::_allocate);
+
+  SlaveInfo agent1 = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  allocator->addSlave(agent1.id(), agent1, None(), agent1.resources(), {});
+
+  // Wait for the allocation to start so that the allocation triggered
+  // by adding the framework is not coalesced with it.
+  AWAIT_READY(allocate);
 
   FrameworkInfo framework = createFrameworkInfo("role1");
   allocator->addFramework(framework.id(), framework, {});
@@ -2626,11 +2777,15 @@ TEST_F(HierarchicalAllocatorTest, AllocationRunTimerMetrics)
   // Wait for the allocation to complete.
   AWAIT_READY(allocations.get());
 
-  // Ensure the timer has been stopped so that
-  // the second measurement to be recorded.
-  Clock::pause();
-  Clock::settle();
-  Clock::resume();
+  // The allocator performs one allocation at a time, so once another
+  // one starts the timer of the second one has been stopped and its
+  // measurement has been recorded.
+  allocate = FUTURE_DISPATCH(_, &HierarchicalDRFAllocatorProcess::_allocate);
+
+  SlaveInfo agent2 = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  allocator->addSlave(agent2.id(), agent2, None(), agent2.resources(), {});
+
+  AWAIT_READY(allocate);
 
   metrics = Metrics();
   values = metrics.values;
@@ -2650,6 +2805,19 @@ TEST_F(HierarchicalAllocatorTest, AllocationRunTimerMetrics)
     EXPECT_EQ(1u, values.count(statistic))
       << "Expected " << statistic << " to be present";
   }
+
+  // So should the timings of the phases of the allocations.
+  auto phases = {
+    "allocator/mesos/allocation_run/snapshot_ms",
+    "allocator/mesos/allocation_run/quota_ms",
+    "allocator/mesos/allocation_run/fair_share_ms",
+    "allocator/mesos/allocation_run/offers_ms",
+  };
+
+  foreach (const string& phase, phases) {
+    EXPECT_EQ(1u, values.count(phase))
+      << "Expected " << phase << " to be present";
+  }
 }
 
 
@@ -2745,6 +2913,81 @@ TEST_F(HierarchicalAllocatorTest, ActiveOfferFiltersMetrics)
 }
 
 
+// Verifies that the allocator only keeps the offer filters that are
+// not covered by another filter of the framework for the same agent,
+// i.e., by a filter that refuses at least the same resources for at
+// least as long.
+TEST_F(HierarchicalAllocatorTest, RedundantOfferFilters)
+{
+  // Pausing the clock is not necessary, but ensures that the test
+  // doesn't rely on the batch allocation in the allocator, which
+  // would slow down the test.
+  Clock::pause();
+
+  initialize();
+
+  SlaveInfo agent = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  allocator->addSlave(agent.id(), agent, None(), agent.resources(), {});
+
+  Duration filterTimeout = flags.allocation_interval * 100;
+  Filters offerFilter;
+  offerFilter.set_refuse_seconds(filterTimeout.secs());
+
+  FrameworkInfo framework = createFrameworkInfo("roleA");
+  allocator->addFramework(framework.id(), framework, {});
+
+  Future<Allocation> allocation = allocations.get();
+
+  AWAIT_READY(allocation);
+  ASSERT_EQ(framework.id(), allocation->frameworkId);
+  ASSERT_EQ(agent.resources(), Resources::sum(allocation->resources));
+
+  // The framework declines both halves of the agent. The second
+  // filter refuses the same resources as the first one, and expires
+  // at the same time, hence it is redundant.
+  Resources half = Resources::parse("cpus:1;mem:512").get();
+
+  allocator->recoverResources(framework.id(), agent.id(), half, offerFilter);
+  allocator->recoverResources(framework.id(), agent.id(), half, offerFilter);
+
+  JSON::Object expected;
+  expected.values = {
+      {"allocator/mesos/offer_filters/roles/roleA/active", 1},
+  };
+
+  JSON::Value metrics = Metrics();
+
+  EXPECT_TRUE(metrics.contains(expected));
+
+  // The whole agent is not filtered, hence it is offered again.
+  Clock::advance(flags.allocation_interval);
+
+  allocation = allocations.get();
+
+  AWAIT_READY(allocation);
+  ASSERT_EQ(framework.id(), allocation->frameworkId);
+  ASSERT_EQ(agent.resources(), Resources::sum(allocation->resources));
+
+  // Declining the whole agent installs a filter that covers the
+  // existing one, which is hence removed.
+  allocator->recoverResources(
+      framework.id(),
+      agent.id(),
+      agent.resources(),
+      offerFilter);
+
+  metrics = Metrics();
+
+  EXPECT_TRUE(metrics.contains(expected));
+
+  // The agent stays filtered.
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  EXPECT_TRUE(allocations.get().isPending());
+}
+
+
 // This test ensures that resource allocation is done according to each role's
 // weight. This is done by having six agents and three frameworks and making
 // sure each framework gets the appropriate number of resources.
@@ -2780,6 +3023,10 @@ TEST_F(HierarchicalAllocatorTest, UpdateWeight)
   FrameworkInfo framework1 = createFrameworkInfo("role1");
   allocator->addFramework(framework1.id(), framework1, {});
 
+  // Settle so that the allocation is not coalesced with the one
+  // triggered by adding framework2.
+  Clock::settle();
+
   // Framework2 registers with 'role2' which also uses the default weight.
   // It will not get any offers due to all resources having outstanding offers
   // to framework1 when it registered.
@@ -2940,6 +3187,66 @@ TEST_F(HierarchicalAllocatorTest, UpdateWeight)
 }
 
 
+// Checks that the calls recorded by the `RecordingAllocator` can be
+// replayed against another allocator, which makes the same offers.
+TEST_F(HierarchicalAllocatorTest, RecordAndReplay)
+{
+  Clock::pause();
+
+  Try<string> path = os::mktemp();
+  ASSERT_SOME(path);
+
+  // The recording allocator takes ownership of the wrapped allocator,
+  // and is deleted in its place.
+  Try<Allocator*> recorder = RecordingAllocator::create(allocator, path.get());
+  ASSERT_SOME(recorder);
+
+  allocator = recorder.get();
+
+  initialize();
+
+  SlaveInfo agent = createSlaveInfo("cpus:2;mem:1024");
+  allocator->addSlave(agent.id(), agent, None(), agent.resources(), {});
+
+  FrameworkInfo framework = createFrameworkInfo("role1");
+  allocator->addFramework(framework.id(), framework, {});
+
+  Future<Allocation> allocation = allocations.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+  EXPECT_EQ(agent.resources(), Resources::sum(allocation.get().resources));
+
+  // Decline the offer.
+  allocator->recoverResources(
+      framework.id(), agent.id(), agent.resources(), Filters());
+
+  Clock::settle();
+
+  // Deleting the recorder flushes the trace.
+  delete allocator;
+  allocator = NULL;
+
+  Allocator* replayed = createAllocator<HierarchicalDRFAllocator>();
+
+  Replayer replayer(replayed);
+  Try<Replayer::Report> report = replayer.replay(path.get());
+
+  delete replayed;
+
+  ASSERT_SOME(report);
+
+  EXPECT_EQ(4u, report.get().calls);
+  EXPECT_EQ(0u, report.get().divergedCalls);
+  EXPECT_EQ(1u, report.get().offers);
+  EXPECT_EQ(0u, report.get().inverseOffers);
+
+  EXPECT_TRUE(report.get().latencies.count("ADD_FRAMEWORK") > 0);
+  EXPECT_TRUE(report.get().latencies.count("RECOVER_RESOURCES") > 0);
+
+  EXPECT_SOME(os::rm(path.get()));
+}
+
+
 class HierarchicalAllocator_BENCHMARK_Test
   : public HierarchicalAllocatorTestBase,
     public WithParamInterface<std::tr1::tuple<size_t, size_t>> {};
@@ -3166,6 +3473,116 @@ TEST_F(HierarchicalAllocator_BENCHMARK_Test, DeclineOffers)
 }
 
 
+// This benchmark measures allocation cycles in a cluster in which half
+// of the roles have quota. In every cycle all the resources are offered
+// again, which exercises the arithmetic on resource quantities that is
+// done for quota and for the fair share of the roles and frameworks.
+TEST_F(HierarchicalAllocator_BENCHMARK_Test, Quota)
+{
+  unsigned roleCount = 20;
+  unsigned frameworkCount = 200;
+  unsigned slaveCount = 2000;
+  master::Flags flags;
+
+  // Choose an interval longer than the time we expect a single cycle to take so
+  // that we don't back up the process queue.
+  flags.allocation_interval = Hours(1);
+
+  // Pause the clock because we want to manually drive the allocations.
+  Clock::pause();
+
+  // Number of allocations. This is used to determine the termination
+  // condition.
+  atomic<size_t> offerCount(0);
+
+  struct OfferedResources {
+    FrameworkID   frameworkId;
+    SlaveID       slaveId;
+    Resources     resources;
+  };
+
+  vector<OfferedResources> offers;
+
+  auto offerCallback = [&offerCount, &offers](
+      const FrameworkID& frameworkId,
+      const hashmap<SlaveID, Resources>& resources_)
+  {
+    for (auto resources : resources_) {
+      offers.push_back(
+          OfferedResources{frameworkId, resources.first, resources.second});
+    }
+
+    offerCount++;
+  };
+
+  vector<SlaveInfo> slaves;
+  vector<FrameworkInfo> frameworks;
+
+  cout << "Using " << slaveCount << " slaves, " << frameworkCount
+       << " frameworks and " << roleCount << " roles" << endl;
+
+  slaves.reserve(slaveCount);
+  frameworks.reserve(frameworkCount);
+
+  initialize(flags, offerCallback);
+
+  // Set a quota for every other role that is large enough not to be
+  // satisfied by the first stage of the allocation alone.
+  for (unsigned i = 0; i < roleCount; i += 2) {
+    const string role = "role" + stringify(i);
+    allocator->setQuota(role, createQuota(role, "cpus:1000;mem:200000"));
+  }
+
+  for (unsigned i = 0; i < frameworkCount; i++) {
+    const string role = "role" + stringify(i % roleCount);
+    frameworks.push_back(createFrameworkInfo(role));
+    allocator->addFramework(frameworks[i].id(), frameworks[i], {});
+  }
+
+  for (unsigned i = 0; i < slaveCount; i++) {
+    slaves.push_back(createSlaveInfo(
+        "cpus:24;mem:4096;disk:4096;ports:[31000-32000]"));
+
+    allocator->addSlave(
+        slaves[i].id(), slaves[i], None(), slaves[i].resources(), {});
+  }
+
+  // Wait for all the `addSlave` operations to be processed.
+  Clock::settle();
+
+  for (unsigned count = 0; count < 10; count++) {
+    // Recover the offered resources without filtering them, so that
+    // they are offered again in the next allocation cycle.
+    for (auto offer : offers) {
+      allocator->recoverResources(
+          offer.frameworkId, offer.slaveId, offer.resources, None());
+    }
+
+    // Wait for the declined offers.
+    Clock::settle();
+    offers.clear();
+    offerCount = 0;
+
+    {
+      Stopwatch watch;
+
+      watch.start();
+
+      // Advance the clock and trigger a background allocation cycle.
+      Clock::advance(flags.allocation_interval);
+      Clock::settle();
+
+      cout << "round " << count
+           << " allocate took " << watch.elapsed()
+           << " to make " << offerCount.load() << " offers"
+           << endl;
+    }
+  }
+
+  Clock::resume();
+}
+
+
 // This returns a `Labels` that has 12 key-value pairs, which should
 // be more than we expect most frameworks to use in practice. We
 // ensure that the first 11 key-value pairs are equal, which results
@@ -16,6 +16,7 @@
 
 #include <unistd.h>
 
+#include <limits>
 #include <memory>
 #include <string>
 #include <vector>
@@ -30,27 +31,37 @@
 #include <mesos/scheduler/scheduler.hpp>
 
 #include <process/clock.hpp>
+#include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/http.hpp>
+#include <process/latch.hpp>
 #include <process/owned.hpp>
 #include <process/pid.hpp>
+#include <process/process.hpp>
 
 #include <process/metrics/counter.hpp>
 #include <process/metrics/metrics.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/json.hpp>
+#include <stout/jsonify.hpp>
 #include <stout/net.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
+#include <stout/recordio.hpp>
+#include <stout/result.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/strings.hpp>
 #include <stout/try.hpp>
 
 #include "common/build.hpp"
 #include "common/protobuf_utils.hpp"
+#include "common/recordio.hpp"
 
 #include "master/flags.hpp"
 #include "master/master.hpp"
+#include "master/snapshot.hpp"
 
 #include "master/allocator/mesos/allocator.hpp"
 
@@ -67,23 +78,32 @@
 #include "tests/utils.hpp"
 
 using mesos::internal::master::Master;
+using mesos::internal::master::Subscribers;
+using mesos::internal::master::TaskFragment;
 
 using mesos::internal::master::allocator::MesosAllocatorProcess;
 
 using mesos::internal::protobuf::createLabel;
 
+using mesos::internal::recordio::Reader;
+
 using mesos::internal::slave::GarbageCollectorProcess;
 using mesos::internal::slave::Slave;
 using mesos::internal::slave::Containerizer;
 using mesos::internal::slave::MesosContainerizerProcess;
 
 using process::Clock;
+using process::Failure;
 using process::Future;
+using process::Latch;
 using process::Owned;
 using process::PID;
+using process::ProcessBase;
 using process::Promise;
 
+using process::http::BadRequest;
 using process::http::OK;
+using process::http::Pipe;
 using process::http::Response;
 using process::http::Unauthorized;
 
@@ -91,6 +111,8 @@ using std::shared_ptr;
 using std::string;
 using std::vector;
 
+using recordio::Decoder;
+
 using testing::_;
 using testing::AtMost;
 using testing::DoAll;
@@ -98,6 +120,7 @@ using testing::Eq;
 using testing::Not;
 using testing::Return;
 using testing::SaveArg;
+using testing::WithParamInterface;
 
 namespace mesos {
 namespace internal {
@@ -3018,6 +3041,814 @@ TEST_F(MasterTest, StateEndpointFrameworkInfo)
 }
 
 
+// This test verifies that the master's state endpoint tags its
+// responses by the version of the state, so that requests for an
+// unchanged state are answered with 'Not Modified'.
+TEST_F(MasterTest, StateEndpointEntityTag)
+{
+  Try<Owned<cluster::Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  process::http::Headers headers = createBasicAuthHeaders(DEFAULT_CREDENTIAL);
+
+  Future<Response> response =
+    process::http::get(master.get()->pid, "state", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  ASSERT_EQ(1u, response->headers.count("ETag"));
+
+  const string etag = response->headers.at("ETag");
+
+  headers["If-None-Match"] = etag;
+
+  response = process::http::get(master.get()->pid, "state", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      process::http::Status::string(process::http::Status::NOT_MODIFIED),
+      response);
+  EXPECT_TRUE(response->body.empty());
+  EXPECT_EQ(etag, response->headers.at("ETag"));
+
+  // The state has not changed, so it is served with the same tag.
+  response = process::http::get(
+      master.get()->pid,
+      "state",
+      None(),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  ASSERT_EQ(1u, response->headers.count("ETag"));
+  EXPECT_EQ(etag, response->headers.at("ETag"));
+
+  // A slave registering changes the state.
+  Owned<MasterDetector> detector = master.get()->createDetector();
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get()->pid, _);
+
+  Try<Owned<cluster::Slave>> slave = StartSlave(detector.get());
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  response = process::http::get(master.get()->pid, "state", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  ASSERT_EQ(1u, response->headers.count("ETag"));
+  EXPECT_NE(etag, response->headers.at("ETag"));
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response->body);
+  ASSERT_SOME(parse);
+
+  Result<JSON::Array> slaves = parse->find<JSON::Array>("slaves");
+  ASSERT_SOME(slaves);
+  EXPECT_EQ(1u, slaves->values.size());
+}
+
+
+// This test verifies that the master serves its state endpoint from
+// the same snapshot until it is older than the maximum age.
+TEST_F(MasterTest, StateEndpointSnapshotAge)
+{
+  master::Flags flags = CreateMasterFlags();
+  flags.max_state_snapshot_age = Minutes(1);
+
+  Try<Owned<cluster::Master>> master = StartMaster(flags);
+  ASSERT_SOME(master);
+
+  Future<Response> response = process::http::get(
+      master.get()->pid,
+      "state",
+      None(),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response->body);
+  ASSERT_SOME(parse);
+  EXPECT_EQ(0, parse->values["activated_slaves"]);
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get()->pid, _);
+
+  Try<Owned<cluster::Slave>> slave = StartSlave(detector.get());
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  // The state is still served from the snapshot without the slave.
+  response = process::http::get(
+      master.get()->pid,
+      "state",
+      None(),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  parse = JSON::parse<JSON::Object>(response->body);
+  ASSERT_SOME(parse);
+  EXPECT_EQ(0, parse->values["activated_slaves"]);
+
+  Clock::pause();
+  Clock::advance(flags.max_state_snapshot_age);
+
+  response = process::http::get(
+      master.get()->pid,
+      "state",
+      None(),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  parse = JSON::parse<JSON::Object>(response->body);
+  ASSERT_SOME(parse);
+  EXPECT_EQ(1, parse->values["activated_slaves"]);
+
+  Clock::resume();
+}
+
+
+// This test verifies that the state and the frameworks endpoints do
+// not expose the cached JSON of a task once the task is updated.
+TEST_F(MasterTest, StateEndpointTaskUpdate)
+{
+  Try<Owned<cluster::Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  TestContainerizer containerizer(&exec);
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+  Try<Owned<cluster::Slave>> slave = StartSlave(detector.get(), &containerizer);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get()->pid, DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(LaunchTasks(DEFAULT_EXECUTOR_INFO, 1, 1, 64, "*"))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  ExecutorDriver* execDriver;
+  EXPECT_CALL(exec, registered(_, _, _, _))
+    .WillOnce(SaveArg<0>(&execDriver));
+
+  Future<TaskInfo> task;
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(FutureArg<1>(&task));
+
+  driver.start();
+
+  AWAIT_READY(task);
+
+  // Serialize the task while it is staging.
+  Future<Response> response = process::http::get(
+      master.get()->pid,
+      "state",
+      None(),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response->body);
+  ASSERT_SOME(parse);
+
+  EXPECT_SOME_EQ(
+      JSON::String("TASK_STAGING"),
+      parse->find<JSON::String>("frameworks[0].tasks[0].state"));
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  TaskStatus runningStatus;
+  runningStatus.mutable_task_id()->CopyFrom(task->task_id());
+  runningStatus.set_state(TASK_RUNNING);
+  execDriver->sendStatusUpdate(runningStatus);
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status->state());
+
+  response = process::http::get(
+      master.get()->pid,
+      "state",
+      None(),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  parse = JSON::parse<JSON::Object>(response->body);
+  ASSERT_SOME(parse);
+
+  EXPECT_SOME_EQ(
+      JSON::String("TASK_RUNNING"),
+      parse->find<JSON::String>("frameworks[0].tasks[0].state"));
+
+  response = process::http::get(
+      master.get()->pid,
+      "frameworks",
+      None(),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  parse = JSON::parse<JSON::Object>(response->body);
+  ASSERT_SOME(parse);
+
+  EXPECT_SOME_EQ(
+      JSON::String("TASK_RUNNING"),
+      parse->find<JSON::String>("frameworks[0].tasks[0].state"));
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+}
+
+
+// This test verifies that the tasks endpoint filters the tasks, and
+// lists them page by page with cursors.
+TEST_F(MasterTest, TasksEndpointFilters)
+{
+  Try<Owned<cluster::Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  TestContainerizer containerizer(&exec);
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+  Try<Owned<cluster::Slave>> slave = StartSlave(detector.get(), &containerizer);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get()->pid, DEFAULT_CREDENTIAL);
+
+  Future<FrameworkID> frameworkId;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureArg<1>(&frameworkId));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(frameworkId);
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  // Launch two tasks, one of them with a label.
+  Resources resources = Resources::parse("cpus:0.1;mem:32").get();
+
+  TaskInfo task1;
+  task1.set_name("");
+  task1.mutable_task_id()->set_value("1");
+  task1.mutable_slave_id()->MergeFrom(offers.get()[0].slave_id());
+  task1.mutable_resources()->MergeFrom(resources);
+  task1.mutable_executor()->MergeFrom(DEFAULT_EXECUTOR_INFO);
+  task1.mutable_labels()->add_labels()->CopyFrom(createLabel("foo", "bar"));
+
+  TaskInfo task2 = task1;
+  task2.mutable_task_id()->set_value("2");
+  task2.clear_labels();
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillRepeatedly(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status1;
+  Future<TaskStatus> status2;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status1))
+    .WillOnce(FutureArg<1>(&status2));
+
+  driver.launchTasks(offers.get()[0].id(), {task1, task2});
+
+  AWAIT_READY(status1);
+  EXPECT_EQ(TASK_RUNNING, status1->state());
+
+  AWAIT_READY(status2);
+  EXPECT_EQ(TASK_RUNNING, status2->state());
+
+  // Returns the IDs of the tasks listed for the query, along with the
+  // cursor to the next tasks, if any.
+  auto tasks = [&master](const string& query)
+      -> Future<std::pair<vector<string>, Option<string>>> {
+    return process::http::get(
+        master.get()->pid,
+        "tasks",
+        query,
+        createBasicAuthHeaders(DEFAULT_CREDENTIAL))
+      .then([](const Response& response)
+          -> Future<std::pair<vector<string>, Option<string>>> {
+        if (response.status != OK().status) {
+          return Failure("Unexpected response status " + response.status);
+        }
+
+        Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.body);
+        if (parse.isError()) {
+          return Failure(parse.error());
+        }
+
+        vector<string> ids;
+        foreach (const JSON::Value& task,
+                 parse->values["tasks"].as<JSON::Array>().values) {
+          ids.push_back(task.as<JSON::Object>()
+                          .values.at("id").as<JSON::String>().value);
+        }
+
+        Option<string> cursor;
+        Result<JSON::String> next = parse->find<JSON::String>("next_cursor");
+        if (next.isSome()) {
+          cursor = next->value;
+        }
+
+        return std::make_pair(ids, cursor);
+      });
+  };
+
+  Future<std::pair<vector<string>, Option<string>>> listed =
+    tasks("state=TASK_RUNNING");
+
+  AWAIT_READY(listed);
+  EXPECT_EQ(2u, listed->first.size());
+  EXPECT_NONE(listed->second);
+
+  listed = tasks("state=TASK_FINISHED");
+
+  AWAIT_READY(listed);
+  EXPECT_TRUE(listed->first.empty());
+
+  listed = tasks("framework_id=" + frameworkId->value());
+
+  AWAIT_READY(listed);
+  EXPECT_EQ(2u, listed->first.size());
+
+  listed = tasks("role=" + DEFAULT_FRAMEWORK_INFO.role());
+
+  AWAIT_READY(listed);
+  EXPECT_EQ(2u, listed->first.size());
+
+  listed = tasks("role=unknown");
+
+  AWAIT_READY(listed);
+  EXPECT_TRUE(listed->first.empty());
+
+  listed = tasks("label=foo:bar");
+
+  AWAIT_READY(listed);
+  EXPECT_EQ(vector<string>{"1"}, listed->first);
+
+  listed = tasks("label=foo:baz");
+
+  AWAIT_READY(listed);
+  EXPECT_TRUE(listed->first.empty());
+
+  // List the tasks one by one.
+  listed = tasks("limit=1");
+
+  AWAIT_READY(listed);
+  ASSERT_EQ(1u, listed->first.size());
+  ASSERT_SOME(listed->second);
+
+  const string first = listed->first[0];
+
+  listed = tasks("limit=1&cursor=" + listed->second.get());
+
+  AWAIT_READY(listed);
+  ASSERT_EQ(1u, listed->first.size());
+  EXPECT_NE(first, listed->first[0]);
+  EXPECT_NONE(listed->second);
+
+  Future<Response> response = process::http::get(
+      master.get()->pid,
+      "tasks",
+      "state=UNKNOWN",
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(BadRequest().status, response);
+
+  response = process::http::get(
+      master.get()->pid,
+      "tasks",
+      "cursor=unknown",
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(BadRequest().status, response);
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+}
+
+
+// Subscribers of the `/events` endpoint receive a snapshot of the
+// state, followed by the events of the master.
+TEST_F(MasterTest, EventsEndpoint)
+{
+  Try<Owned<cluster::Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Future<Response> response = process::http::streaming::get(
+      master.get()->pid,
+      "events",
+      None(),
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  ASSERT_EQ(Response::PIPE, response->type);
+  ASSERT_SOME(response->reader);
+
+  Reader<JSON::Object> events(
+      Decoder<JSON::Object>([](const string& record) {
+        return JSON::parse<JSON::Object>(record);
+      }),
+      response->reader.get());
+
+  Future<Result<JSON::Object>> event = events.read();
+  AWAIT_READY(event);
+  ASSERT_SOME(event.get());
+
+  EXPECT_SOME_EQ(
+      JSON::String("SNAPSHOT"),
+      event->get().find<JSON::String>("type"));
+
+  EXPECT_SOME_EQ(
+      JSON::Array(),
+      event->get().find<JSON::Array>("snapshot.slaves"));
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+  Try<Owned<cluster::Slave>> slave = StartSlave(detector.get());
+  ASSERT_SOME(slave);
+
+  event = events.read();
+  AWAIT_READY(event);
+  ASSERT_SOME(event.get());
+
+  EXPECT_SOME_EQ(
+      JSON::String("SLAVE_ADDED"),
+      event->get().find<JSON::String>("type"));
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get()->pid, DEFAULT_CREDENTIAL);
+
+  Future<FrameworkID> frameworkId;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureArg<1>(&frameworkId));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(frameworkId);
+  AWAIT_READY(offers);
+  ASSERT_EQ(1u, offers->size());
+
+  event = events.read();
+  AWAIT_READY(event);
+  ASSERT_SOME(event.get());
+
+  EXPECT_SOME_EQ(
+      JSON::String("FRAMEWORK_ADDED"),
+      event->get().find<JSON::String>("type"));
+
+  EXPECT_SOME_EQ(
+      JSON::String(frameworkId->value()),
+      event->get().find<JSON::String>("framework.id"));
+
+  event = events.read();
+  AWAIT_READY(event);
+  ASSERT_SOME(event.get());
+
+  EXPECT_SOME_EQ(
+      JSON::String("OFFER_ADDED"),
+      event->get().find<JSON::String>("type"));
+
+  EXPECT_SOME_EQ(
+      JSON::String(offers->front().id().value()),
+      event->get().find<JSON::String>("offer.id"));
+
+  driver.stop();
+  driver.join();
+
+  event = events.read();
+  AWAIT_READY(event);
+  ASSERT_SOME(event.get());
+
+  EXPECT_SOME_EQ(
+      JSON::String("OFFER_REMOVED"),
+      event->get().find<JSON::String>("type"));
+
+  event = events.read();
+  AWAIT_READY(event);
+  ASSERT_SOME(event.get());
+
+  EXPECT_SOME_EQ(
+      JSON::String("FRAMEWORK_REMOVED"),
+      event->get().find<JSON::String>("type"));
+}
+
+
+// A started subscriber with more events queued than it may have is
+// disconnected.
+TEST(SubscribersTest, Overflow)
+{
+  Subscribers subscribers(process::UPID(), 2, 4);
+
+  Pipe pipe;
+  Pipe::Reader reader = pipe.reader();
+
+  const UUID id = subscribers.add(pipe.writer());
+
+  // The events are held back until the subscriber is started, and
+  // count against its capacity for held back events instead.
+  subscribers.send("{}");
+  subscribers.send("{}");
+  subscribers.send("{}");
+  EXPECT_EQ(1u, subscribers.size());
+
+  // Starting the subscriber writes out the snapshot along with the
+  // held back events, which are not read off the pipe.
+  subscribers.start(id, string("{}"));
+
+  subscribers.send("{}");
+  subscribers.send("{}");
+  EXPECT_EQ(1u, subscribers.size());
+
+  subscribers.send("{}");
+  EXPECT_TRUE(subscribers.empty());
+
+  AWAIT_FAILED(reader.readAll());
+}
+
+
+// A subscriber that is held back more events than it may have before
+// it is started is disconnected.
+TEST(SubscribersTest, HeldBackOverflow)
+{
+  Subscribers subscribers(process::UPID(), 2, 4);
+
+  Pipe pipe;
+  Pipe::Reader reader = pipe.reader();
+
+  const UUID id = subscribers.add(pipe.writer());
+
+  for (int i = 0; i < 4; i++) {
+    subscribers.send("{}");
+  }
+
+  EXPECT_EQ(1u, subscribers.size());
+
+  subscribers.send("{}");
+  EXPECT_TRUE(subscribers.empty());
+
+  AWAIT_FAILED(reader.readAll());
+
+  // The snapshot of the disconnected subscriber is dropped.
+  subscribers.start(id, string("{}"));
+  EXPECT_TRUE(subscribers.empty());
+}
+
+
+// A subscriber that subscribes while events are being sent gets its
+// snapshot followed by all of the events sent in the meantime, even
+// if there are more of them than it may have queued once started.
+TEST(SubscribersTest, SubscribeWhileSending)
+{
+  Pipe pipe;
+
+  Reader<JSON::Object> events(
+      Decoder<JSON::Object>([](const string& record) {
+        return JSON::parse<JSON::Object>(record);
+      }),
+      pipe.reader());
+
+  {
+    Subscribers subscribers(process::UPID(), 2, 10);
+
+    subscribers.send("{\"index\":0}");
+
+    const UUID id = subscribers.add(pipe.writer());
+
+    for (int i = 1; i <= 10; i++) {
+      subscribers.send("{\"index\":" + stringify(i) + "}");
+    }
+
+    EXPECT_EQ(1u, subscribers.size());
+
+    subscribers.start(id, string("{}"));
+    EXPECT_EQ(1u, subscribers.size());
+
+    // Destroying the subscribers closes their pipes.
+  }
+
+  Future<Result<JSON::Object>> event = events.read();
+  AWAIT_READY(event);
+  ASSERT_SOME(event.get());
+
+  EXPECT_SOME_EQ(
+      JSON::String("SNAPSHOT"),
+      event->get().find<JSON::String>("type"));
+
+  for (int i = 1; i <= 10; i++) {
+    event = events.read();
+    AWAIT_READY(event);
+    ASSERT_SOME(event.get());
+
+    EXPECT_SOME_EQ(
+        JSON::Number(i),
+        event->get().find<JSON::Number>("index"));
+  }
+
+  event = events.read();
+  AWAIT_READY(event);
+  EXPECT_NONE(event.get());
+}
+
+
+// A subscriber whose reader has been closed is removed when an event
+// is sent to it, even before the callback on the closure has run, and
+// the other subscribers still get the event.
+TEST(SubscribersTest, ReaderClosedWhileSending)
+{
+  ProcessBase process;
+  process::spawn(process);
+
+  Subscribers subscribers(process.self(), 2, 4);
+
+  Pipe pipe1;
+  Pipe pipe2;
+  Pipe::Reader reader1 = pipe1.reader();
+  Pipe::Reader reader2 = pipe2.reader();
+
+  const UUID id1 = subscribers.add(pipe1.writer());
+  const UUID id2 = subscribers.add(pipe2.writer());
+
+  subscribers.start(id1, string("{}"));
+  subscribers.start(id2, string("{}"));
+
+  // Read the snapshots off the pipes so that the next events are
+  // written out as soon as they are sent.
+  AWAIT_READY(reader1.read());
+  AWAIT_READY(reader2.read());
+
+  AWAIT_READY(pipe1.writer().drained());
+  AWAIT_READY(pipe2.writer().drained());
+
+  // The callbacks on the drained pipes have been deferred to the
+  // process by now, hence they run before this dispatch.
+  Promise<Nothing> drained;
+  process::dispatch(process.self(), [&drained]() {
+    drained.set(Nothing());
+  });
+
+  AWAIT_READY(drained.future());
+
+  // Hold back the callbacks deferred to the process, including the
+  // one on the closure of the reader.
+  Latch latch;
+  process::dispatch(process.self(), [&latch]() { latch.await(); });
+
+  ASSERT_TRUE(reader1.close());
+
+  subscribers.send("{}");
+  EXPECT_EQ(1u, subscribers.size());
+
+  AWAIT_READY(reader2.read());
+
+  latch.trigger();
+
+  process::terminate(process);
+  process::wait(process);
+}
+
+
+// The master profiles the events that it processes, by handler.
+TEST_F(MasterTest, ProfileEndpoint)
+{
+  master::Flags flags = CreateMasterFlags();
+  flags.event_profiling_period = 1;
+
+  // Starting the master waits for the dispatch of `Master::_recover`,
+  // which the master profiles under the name of the method.
+  Try<Owned<cluster::Master>> master = StartMaster(flags);
+  ASSERT_SOME(master);
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get()->pid, _);
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+  Try<Owned<cluster::Slave>> slave = StartSlave(detector.get());
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  // The messages that the master does not handle are profiled
+  // together, whatever their names.
+  Future<process::Message> unknownMessage =
+    FUTURE_MESSAGE(Eq("mesos.internal.BogusMessage"), _, master.get()->pid);
+
+  process::post(master.get()->pid, "mesos.internal.BogusMessage");
+
+  AWAIT_READY(unknownMessage);
+
+  // The master processes the request after the events above, so they
+  // have all been profiled once it responds (and their metrics have
+  // been added before the metrics are requested below).
+  Future<Response> response = process::http::get(
+      master.get()->pid,
+      "profile",
+      "limit=100",
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response->body);
+  ASSERT_SOME(parse);
+
+  EXPECT_SOME_EQ(
+      JSON::Number(1),
+      parse->find<JSON::Number>("event_profiling_period"));
+
+  Result<JSON::Array> handlers = parse->find<JSON::Array>("handlers");
+  ASSERT_SOME(handlers);
+
+  const string handler = RegisterSlaveMessage().GetTypeName();
+
+  Option<JSON::Object> registration;
+  Option<JSON::Object> recovery;
+  foreach (const JSON::Value& value, handlers->values) {
+    const JSON::Object& object = value.as<JSON::Object>();
+
+    Result<JSON::String> name = object.find<JSON::String>("name");
+    ASSERT_SOME(name);
+
+    if (name->value == handler) {
+      registration = object;
+    } else if (name->value == "_recover") {
+      recovery = object;
+    }
+  }
+
+  ASSERT_SOME(registration);
+
+  EXPECT_SOME_EQ(
+      JSON::Number(1),
+      registration->find<JSON::Number>("events"));
+
+  ASSERT_SOME(recovery);
+
+  EXPECT_SOME_EQ(
+      JSON::Number(1),
+      recovery->find<JSON::Number>("events"));
+
+  // The handlers are listed by the time spent processing them.
+  double previous = std::numeric_limits<double>::max();
+  foreach (const JSON::Value& value, handlers->values) {
+    Result<JSON::Number> time =
+      value.as<JSON::Object>().find<JSON::Number>("processing_time_secs");
+
+    ASSERT_SOME(time);
+    EXPECT_LE(time->as<double>(), previous);
+    previous = time->as<double>();
+  }
+
+  JSON::Object metrics = Metrics();
+  EXPECT_EQ(
+      1u,
+      metrics.values.count(
+          "master/handlers/" + handler + "/processing_time_us"));
+
+  EXPECT_EQ(
+      1u,
+      metrics.values.count("master/handlers/_recover/processing_time_us"));
+
+  EXPECT_EQ(
+      1u,
+      metrics.values.count("master/handlers/unknown/processing_time_us"));
+
+  EXPECT_EQ(
+      0u,
+      metrics.values.count(
+          "master/handlers/mesos.internal.BogusMessage/processing_time_us"));
+}
+
+
 TEST_F(MasterTest, StateSummaryEndpoint)
 {
   master::Flags flags = CreateMasterFlags();
@@ -4307,6 +5138,114 @@ TEST_F(MasterTest, EndpointsBadAuthentication)
   }
 }
 
+
+class MasterTaskFragment_BENCHMARK_Test
+  : public ::testing::Test,
+    public WithParamInterface<size_t> {};
+
+
+// The task fragment benchmark tests are parameterized by the number of
+// tasks.
+INSTANTIATE_TEST_CASE_P(
+    TaskCount,
+    MasterTaskFragment_BENCHMARK_Test,
+    ::testing::Values(10000U, 100000U, 1000000U));
+
+
+// This benchmark measures how long it takes to write out the tasks of
+// the state endpoint by serializing them (as the endpoints used to),
+// through their fragments the first time (which serializes them) and
+// through their fragments again (which splices their cached JSON). It
+// also reports the memory the fragments keep.
+TEST_P(MasterTaskFragment_BENCHMARK_Test, Tasks)
+{
+  const size_t taskCount = GetParam();
+
+  FrameworkID frameworkId;
+  frameworkId.set_value("framework");
+
+  SlaveID slaveId;
+  slaveId.set_value("20160714-172424-16777343-5050-22545-S0");
+
+  TaskInfo taskInfo = createTask(
+      slaveId,
+      Resources::parse("cpus:0.1;mem:32;disk:32;ports:[31000-31001]").get(),
+      "sleep 1000");
+
+  taskInfo.mutable_labels()->add_labels()->CopyFrom(
+      createLabel("key", "value"));
+
+  Task task = protobuf::createTask(taskInfo, TASK_RUNNING, frameworkId);
+
+  TaskStatus* status = task.add_statuses();
+  status->mutable_task_id()->CopyFrom(task.task_id());
+  status->set_state(TASK_RUNNING);
+  status->set_timestamp(1468513464.0);
+
+  vector<Task> tasks;
+  vector<shared_ptr<const TaskFragment>> fragments;
+
+  tasks.reserve(taskCount);
+  fragments.reserve(taskCount);
+
+  for (size_t i = 0; i < taskCount; i++) {
+    task.mutable_task_id()->set_value("task-" + stringify(i));
+
+    tasks.push_back(task);
+    fragments.push_back(
+        shared_ptr<const TaskFragment>(new TaskFragment(task)));
+  }
+
+  Stopwatch watch;
+  watch.start();
+
+  string serialized = jsonify([&tasks](JSON::ArrayWriter* writer) {
+    foreach (const Task& task, tasks) {
+      writer->element(task);
+    }
+  });
+
+  LOG(INFO) << "Serialized " << taskCount << " tasks ("
+            << Bytes(serialized.size()) << ") in " << watch.elapsed();
+
+  auto splice = [&fragments](JSON::ArrayWriter* writer) {
+    foreach (const shared_ptr<const TaskFragment>& fragment, fragments) {
+      writer->element([&fragment](JSON::RawWriter* writer) {
+        writer->append(fragment->json());
+      });
+    }
+  };
+
+  watch.start();
+
+  string spliced = jsonify(splice);
+
+  LOG(INFO) << "Wrote out " << taskCount << " tasks through their"
+            << " fragments for the first time in " << watch.elapsed();
+
+  EXPECT_EQ(serialized, spliced);
+
+  watch.start();
+
+  spliced = jsonify(splice);
+
+  LOG(INFO) << "Wrote out " << taskCount << " tasks through their"
+            << " cached fragments in " << watch.elapsed();
+
+  EXPECT_EQ(serialized, spliced);
+
+  // A fragment keeps a copy of its task (which the master would keep
+  // anyway for a completed task) along with the task's JSON.
+  size_t json = 0;
+  foreach (const shared_ptr<const TaskFragment>& fragment, fragments) {
+    json += fragment->json().capacity();
+  }
+
+  LOG(INFO) << "The fragments of " << taskCount << " tasks keep "
+            << Bytes(task.SpaceUsed() * taskCount) << " of task copies and "
+            << Bytes(json) << " of JSON";
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
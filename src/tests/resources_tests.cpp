@@ -15,9 +15,13 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <atomic>
+#include <iostream>
 #include <set>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -25,6 +29,9 @@
 #include <stout/gtest.hpp>
 #include <stout/json.hpp>
 #include <stout/protobuf.hpp>
+#include <stout/stopwatch.hpp>
+
+#include "common/resource_quantities.hpp"
 
 #include "master/master.hpp"
 
@@ -32,16 +39,21 @@
 
 using namespace mesos::internal::master;
 
+using std::cout;
+using std::endl;
 using std::map;
 using std::ostringstream;
 using std::pair;
 using std::set;
 using std::string;
+using std::vector;
 
 using google::protobuf::RepeatedPtrField;
 
 using mesos::internal::protobuf::createLabel;
 
+using testing::WithParamInterface;
+
 namespace mesos {
 namespace internal {
 namespace tests {
@@ -1650,6 +1662,153 @@ TEST(ResourcesTest, PrecisionRounding)
 }
 
 
+// This test verifies that copies of resources share the Resource
+// objects only until either copy is mutated.
+TEST(ResourcesTest, CopyOnWrite)
+{
+  Resources r1 = Resources::parse("cpus:1;mem:512;ports:[1-10]").get();
+
+  Resources r2 = r1;
+  Resources r3 = r1;
+
+  r2 += Resources::parse("cpus:1").get();
+  r3 -= Resources::parse("ports:[1-5]").get();
+
+  EXPECT_EQ(Resources::parse("cpus:1;mem:512;ports:[1-10]").get(), r1);
+  EXPECT_EQ(Resources::parse("cpus:2;mem:512;ports:[1-10]").get(), r2);
+  EXPECT_EQ(Resources::parse("cpus:1;mem:512;ports:[6-10]").get(), r3);
+
+  // Adding to empty resources shares the Resource objects as well.
+  Resources r4;
+  r4 += r1;
+  r4 += Resources::parse("mem:512").get();
+
+  EXPECT_EQ(Resources::parse("cpus:1;mem:512;ports:[1-10]").get(), r1);
+  EXPECT_EQ(Resources::parse("cpus:1;mem:1024;ports:[1-10]").get(), r4);
+
+  Resources r5 = r1;
+  r5 -= r1;
+
+  EXPECT_TRUE(r5.empty());
+  EXPECT_FALSE(r1.empty());
+}
+
+
+// This test verifies that the cached aggregates of resources reflect
+// the mutations of the resources.
+TEST(ResourcesTest, CachedAggregates)
+{
+  Resource revocable = Resources::parse("cpus", "1", "*").get();
+  revocable.mutable_revocable();
+
+  Resources resources = Resources::parse("cpus:2;mem:512;ports:[1-10]").get();
+
+  EXPECT_TRUE(resources.revocable().empty());
+  EXPECT_EQ(Resources::parse("cpus:2;mem:512").get(), resources.scalars());
+
+  Resources copy = resources;
+
+  resources += revocable;
+
+  EXPECT_EQ(Resources(revocable), resources.revocable());
+  EXPECT_EQ(copy, resources.nonRevocable());
+  EXPECT_EQ(
+      Resources::parse("cpus:2;mem:512").get() + revocable,
+      resources.scalars());
+
+  // The aggregates of the copy are unaffected.
+  EXPECT_TRUE(copy.revocable().empty());
+  EXPECT_EQ(Resources::parse("cpus:2;mem:512").get(), copy.scalars());
+
+  Resources reserved = Resources::parse("disk:1024", "role").get();
+
+  EXPECT_TRUE(resources.reserved().empty());
+  EXPECT_EQ(
+      Resources::parse("disk:1024").get(),
+      (resources + reserved).flatten() - resources.flatten());
+
+  resources += reserved;
+
+  EXPECT_EQ(reserved, resources.reserved());
+  EXPECT_EQ(copy + revocable, resources.unreserved());
+
+  resources -= revocable;
+  resources -= reserved;
+
+  EXPECT_EQ(copy, resources);
+  EXPECT_TRUE(resources.revocable().empty());
+  EXPECT_TRUE(resources.reserved().empty());
+  EXPECT_EQ(copy.scalars(), resources.scalars());
+}
+
+
+// This test verifies that copies of resources can be read and mutated
+// by different threads, while they share the Resource objects and
+// fill the cached aggregates concurrently.
+TEST(ResourcesTest, ConcurrentCopyOnWrite)
+{
+  const string text =
+    "cpus:4;mem:4096;disk(role):1024;ports:[31000-32000]";
+
+  // Computed from separately parsed resources, so that the resources
+  // below start out without any cached aggregates.
+  const Resources parsed = Resources::parse(text).get();
+  const Resources scalars = parsed.scalars();
+  const Resources reserved = parsed.reserved();
+  const Resources unreserved = parsed.unreserved();
+  const Resources flattened = parsed.flatten();
+
+  const Resources cpus = Resources::parse("cpus:1").get();
+  const Resources ports = Resources::parse("ports:[31000-31500]").get();
+
+  const size_t threadCount = 8;
+
+  for (int round = 0; round < 50; round++) {
+    const Resources resources = Resources::parse(text).get();
+
+    std::atomic_bool start(false);
+    std::atomic_size_t failures(0);
+
+    vector<std::thread> threads;
+
+    for (size_t i = 0; i < threadCount; i++) {
+      threads.push_back(std::thread([&]() {
+        while (!start.load()) {}
+
+        Resources copy = resources;
+
+        if (copy.scalars() != scalars ||
+            copy.reserved() != reserved ||
+            copy.unreserved() != unreserved ||
+            copy.flatten() != flattened) {
+          failures++;
+        }
+
+        // Mutating the copy must leave the shared resources intact.
+        copy += cpus;
+        copy -= ports;
+
+        if (copy.scalars() == scalars ||
+            resources.scalars() != scalars ||
+            resources != parsed) {
+          failures++;
+        }
+      }));
+    }
+
+    start.store(true);
+
+    foreach (std::thread& thread, threads) {
+      thread.join();
+    }
+
+    EXPECT_EQ(0u, failures.load());
+    EXPECT_EQ(parsed, resources);
+    EXPECT_EQ(scalars, resources.scalars());
+  }
+}
+
+
 TEST(ReservedResourcesTest, Validation)
 {
   // Unreserved.
@@ -2405,6 +2564,230 @@ TEST(RevocableResourceTest, Filter)
   EXPECT_EQ(r2, (r1 + r2).nonRevocable());
 }
 
+TEST(ResourceQuantitiesTest, Construction)
+{
+  Resource revocable = Resources::parse("cpus", "2", "*").get();
+  revocable.mutable_revocable();
+
+  Resources resources = Resources::parse(
+      "cpus:1;cpus(role):0.5;mem:512;ports:[31000-32000];disks:{sda1}").get();
+
+  ResourceQuantities quantities(resources + revocable);
+
+  // Metadata is ignored and quantities are aggregated by name.
+  EXPECT_DOUBLE_EQ(3.5, quantities.get("cpus"));
+  EXPECT_DOUBLE_EQ(512, quantities.get("mem"));
+
+  // Non-scalar and absent resources have no quantity.
+  EXPECT_DOUBLE_EQ(0, quantities.get("ports"));
+  EXPECT_DOUBLE_EQ(0, quantities.get("disks"));
+  EXPECT_DOUBLE_EQ(0, quantities.get("gpus"));
+
+  EXPECT_FALSE(quantities.empty());
+  EXPECT_TRUE(ResourceQuantities().empty());
+  EXPECT_TRUE(ResourceQuantities(Resources::parse("ports:[1-2]").get())
+                .empty());
+
+  EXPECT_EQ(
+      quantities,
+      ResourceQuantities(Resources::parse("cpus:3.5;mem:512").get()));
+}
+
+
+TEST(ResourceQuantitiesTest, Arithmetic)
+{
+  ResourceQuantities left(Resources::parse("cpus:1;mem:512").get());
+  ResourceQuantities right(Resources::parse("cpus:0.1;disk:1024").get());
+
+  ResourceQuantities sum = left + right;
+  EXPECT_DOUBLE_EQ(1.1, sum.get("cpus"));
+  EXPECT_DOUBLE_EQ(512, sum.get("mem"));
+  EXPECT_DOUBLE_EQ(1024, sum.get("disk"));
+
+  EXPECT_TRUE(sum.contains(left));
+  EXPECT_TRUE(sum.contains(right));
+  EXPECT_FALSE(left.contains(right));
+  EXPECT_TRUE(left.contains(ResourceQuantities()));
+
+  EXPECT_EQ(left, sum - right);
+
+  // Like for `Resources`, subtraction does not go below zero.
+  ResourceQuantities difference = right - left;
+  EXPECT_DOUBLE_EQ(0, difference.get("cpus"));
+  EXPECT_DOUBLE_EQ(1024, difference.get("disk"));
+
+  // Arithmetic uses the fixed point representation of `Value::Scalar`,
+  // hence it agrees with that of `Resources`.
+  Resources resources;
+  ResourceQuantities quantities;
+
+  for (int i = 0; i < 10; i++) {
+    resources += Resources::parse("cpus:0.1").get();
+    quantities += ResourceQuantities(Resources::parse("cpus:0.1").get());
+  }
+
+  EXPECT_EQ(resources.cpus().get(), quantities.get("cpus"));
+  EXPECT_TRUE(quantities.contains(
+      ResourceQuantities(Resources::parse("cpus:1").get())));
+}
+
+
+class Resources_Ranges_BENCHMARK_Test
+  : public ::testing::Test,
+    public WithParamInterface<size_t> {};
+
+
+// The ranges benchmark tests are parameterized by the number of
+// fragments of the port ranges.
+INSTANTIATE_TEST_CASE_P(
+    FragmentCount,
+    Resources_Ranges_BENCHMARK_Test,
+    ::testing::Values(100U, 1000U, 10000U));
+
+
+// This benchmark simulates an agent with highly fragmented ports, of
+// which the allocator and the master check for and subtract single
+// ports as they are offered and used by tasks.
+TEST_P(Resources_Ranges_BENCHMARK_Test, FragmentedPorts)
+{
+  size_t fragmentCount = GetParam();
+
+  // Every other port is available, i.e., [0-0, 2-2, 4-4, ...].
+  Value::Ranges ranges;
+  for (size_t i = 0; i < fragmentCount; i++) {
+    Value::Range* range = ranges.add_range();
+    range->set_begin(i * 2);
+    range->set_end(i * 2);
+  }
+
+  Resource ports;
+  ports.set_name("ports");
+  ports.set_type(Value::RANGES);
+  ports.set_role("*");
+  ports.mutable_ranges()->CopyFrom(ranges);
+
+  Resources total = Resources::parse("cpus:24;mem:4096").get();
+  total += ports;
+
+  vector<Resources> singlePorts;
+  singlePorts.reserve(fragmentCount);
+
+  foreach (const Value::Range& range, ranges.range()) {
+    Resource port = ports;
+    port.mutable_ranges()->clear_range();
+    port.mutable_ranges()->add_range()->CopyFrom(range);
+
+    singlePorts.push_back(port);
+  }
+
+  cout << "Using " << fragmentCount << " port fragments" << endl;
+
+  Stopwatch watch;
+  watch.start();
+
+  foreach (const Resources& port, singlePorts) {
+    EXPECT_TRUE(total.contains(port));
+  }
+
+  cout << "Checked containment of " << fragmentCount << " ports"
+       << " in " << watch.elapsed() << endl;
+
+  Resources remaining = total;
+
+  watch.start();
+
+  foreach (const Resources& port, singlePorts) {
+    remaining -= port;
+  }
+
+  cout << "Subtracted " << fragmentCount << " ports"
+       << " in " << watch.elapsed() << endl;
+
+  EXPECT_NONE(remaining.ports());
+
+  watch.start();
+
+  foreach (const Resources& port, singlePorts) {
+    remaining += port;
+  }
+
+  cout << "Added " << fragmentCount << " ports"
+       << " in " << watch.elapsed() << endl;
+
+  EXPECT_EQ(total, remaining);
+}
+
+
+// This benchmark measures what the master and the allocator save when
+// they copy the resources of an agent and compute their aggregates:
+// copies share the Resource objects until they are mutated, and the
+// aggregates are cached until the resources are mutated.
+TEST(Resources_BENCHMARK_Test, CopyAndAggregate)
+{
+  const size_t count = 100000;
+
+  Resources total = Resources::parse(
+      "cpus:24;mem:4096;disk:409600;ports:[31000-32000]").get();
+
+  total += Resources::parse("cpus:8;mem:1024", "role").get();
+
+  Resource revocable = Resources::parse("cpus", "8", "*").get();
+  revocable.mutable_revocable();
+  total += revocable;
+
+  const Resources cpus = Resources::parse("cpus:1").get();
+
+  cout << "Using " << total.size() << " resources" << endl;
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t i = 0; i < count; i++) {
+    Resources copy = total;
+    EXPECT_FALSE(copy.empty());
+  }
+
+  cout << "Made " << count << " copies in " << watch.elapsed() << endl;
+
+  watch.start();
+
+  for (size_t i = 0; i < count; i++) {
+    Resources copy = total;
+    copy += cpus;
+  }
+
+  cout << "Made and mutated " << count << " copies"
+       << " in " << watch.elapsed() << endl;
+
+  watch.start();
+
+  for (size_t i = 0; i < count; i++) {
+    EXPECT_FALSE(total.scalars().empty());
+    EXPECT_FALSE(total.unreserved().empty());
+    EXPECT_FALSE(total.nonRevocable().empty());
+  }
+
+  cout << "Computed the cached aggregates " << count << " times"
+       << " in " << watch.elapsed() << endl;
+
+  // Mutating the resources discards the cached aggregates, so each
+  // iteration computes them again.
+  Resources mutated = total;
+
+  watch.start();
+
+  for (size_t i = 0; i < count; i++) {
+    mutated += cpus;
+
+    EXPECT_FALSE(mutated.scalars().empty());
+    EXPECT_FALSE(mutated.unreserved().empty());
+    EXPECT_FALSE(mutated.nonRevocable().empty());
+  }
+
+  cout << "Mutated and computed the aggregates " << count << " times"
+       << " in " << watch.elapsed() << endl;
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -17,23 +17,39 @@
 #include <stdarg.h>
 #include <stdint.h>
 
+#include <iostream>
 #include <list>
 #include <string>
+#include <vector>
 
 #include <gmock/gmock.h>
 
+#include <mesos/attributes.hpp>
 #include <mesos/resources.hpp>
 
 #include <stout/gtest.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
 
+#include "master/allocator/sorter/agent/sorter.hpp"
 #include "master/allocator/sorter/drf/sorter.hpp"
+#include "master/allocator/sorter/quota/sorter.hpp"
 
 #include "tests/mesos.hpp"
 
+using mesos::internal::master::allocator::AgentSorter;
 using mesos::internal::master::allocator::DRFSorter;
+using mesos::internal::master::allocator::QuotaSorter;
 
+using std::cout;
+using std::endl;
 using std::list;
 using std::string;
+using std::vector;
+
+using testing::WithParamInterface;
 
 namespace mesos {
 namespace internal {
@@ -447,6 +463,355 @@ TEST(SorterTest, RevocableResources)
   EXPECT_EQ("b", sorted.back());
 }
 
+// This test verifies that `sorted()` returns the same order as
+// `sort()`, and that the returned clients are not affected by
+// allocations until the sorter is asked to sort again.
+TEST(SorterTest, Sorted)
+{
+  DRFSorter sorter;
+
+  SlaveID slaveId;
+  slaveId.set_value("slaveId");
+
+  sorter.add(slaveId, Resources::parse("cpus:100;mem:100").get());
+
+  sorter.add("a");
+  sorter.add("b");
+  sorter.add("c");
+
+  sorter.allocated("a", slaveId, Resources::parse("cpus:5;mem:5").get());
+  sorter.allocated("b", slaveId, Resources::parse("cpus:1;mem:1").get());
+
+  const vector<string>& sorted = sorter.sorted();
+  EXPECT_EQ(vector<string>({"c", "b", "a"}), sorted);
+
+  list<string> expected(sorted.begin(), sorted.end());
+  EXPECT_EQ(expected, sorter.sort());
+
+  // Allocating to the clients while iterating over them does not
+  // change the iteration.
+  foreach (const string& name, sorted) {
+    sorter.allocated(name, slaveId, Resources::parse("cpus:10").get());
+  }
+
+  EXPECT_EQ(vector<string>({"c", "b", "a"}), sorted);
+
+  // Now the dominant share of "a" is 0.15, "b" is 0.11 and "c" is 0.1.
+  EXPECT_EQ(vector<string>({"c", "b", "a"}), sorter.sorted());
+
+  sorter.allocated("c", slaveId, Resources::parse("cpus:5").get());
+  EXPECT_EQ(vector<string>({"b", "a", "c"}), sorter.sorted());
+
+  sorter.deactivate("b");
+  EXPECT_EQ(vector<string>({"a", "c"}), sorter.sorted());
+
+  sorter.activate("b");
+  sorter.remove("a");
+  EXPECT_EQ(vector<string>({"b", "c"}), sorter.sorted());
+}
+
+
+// Verifies that the quota sorter only sorts the clients whose quota
+// guarantee is not satisfied.
+TEST(SorterTest, QuotaSorter)
+{
+  QuotaSorter sorter(new DRFSorter());
+
+  SlaveID slaveId;
+  slaveId.set_value("slaveId");
+
+  sorter.add(slaveId, Resources::parse("cpus:100;mem:100").get());
+
+  sorter.add("a");
+  sorter.guarantee("a", ResourceQuantities(Resources::parse("cpus:10").get()));
+
+  sorter.add("b");
+  sorter.guarantee(
+      "b", ResourceQuantities(Resources::parse("cpus:5;mem:5").get()));
+
+  // A client without a guarantee is always satisfied.
+  sorter.add("c");
+
+  EXPECT_EQ(3, sorter.count());
+  EXPECT_TRUE(sorter.satisfied("c"));
+  EXPECT_EQ(vector<string>({"a", "b"}), sorter.sorted());
+
+  sorter.allocated("a", slaveId, Resources::parse("cpus:4;mem:50").get());
+
+  EXPECT_EQ(ResourceQuantities(Resources::parse("cpus:6").get()),
+            sorter.remaining("a"));
+  EXPECT_EQ(vector<string>({"b", "a"}), sorter.sorted());
+
+  sorter.allocated("b", slaveId, Resources::parse("cpus:5;mem:5").get());
+
+  EXPECT_TRUE(sorter.satisfied("b"));
+  EXPECT_TRUE(sorter.remaining("b").empty());
+  EXPECT_EQ(vector<string>({"a"}), sorter.sorted());
+
+  // The client is sorted again once it is no longer satisfied.
+  sorter.unallocated("b", slaveId, Resources::parse("mem:1").get());
+
+  EXPECT_FALSE(sorter.satisfied("b"));
+  EXPECT_EQ(vector<string>({"b", "a"}), sorter.sorted());
+
+  // A deactivated client is not sorted, even if not satisfied.
+  sorter.deactivate("b");
+  EXPECT_EQ(vector<string>({"a"}), sorter.sorted());
+
+  sorter.allocated("a", slaveId, Resources::parse("cpus:6").get());
+  EXPECT_TRUE(sorter.sorted().empty());
+
+  sorter.activate("b");
+  EXPECT_EQ(vector<string>({"b"}), sorter.sorted());
+
+  // Satisfied clients are still accounted for.
+  EXPECT_EQ(ResourceQuantities(Resources::parse("cpus:10;mem:50").get()),
+            sorter.allocationScalarQuantities("a"));
+
+  sorter.remove("a");
+  EXPECT_FALSE(sorter.contains("a"));
+  EXPECT_EQ(2, sorter.count());
+}
+
+
+// Verifies that the agent sorters order the agents by their share of
+// free resources.
+TEST(SorterTest, AgentSorterFreeShare)
+{
+  Try<AgentSorter*> bestFit = AgentSorter::create("best_fit");
+  ASSERT_SOME(bestFit);
+
+  Try<AgentSorter*> spread = AgentSorter::create("spread");
+  ASSERT_SOME(spread);
+
+  const Resources total = Resources::parse("cpus:4;mem:1024").get();
+
+  vector<SlaveID> slaveIds;
+
+  for (int i = 0; i < 3; i++) {
+    SlaveInfo slaveInfo;
+    slaveInfo.set_hostname("host" + stringify(i));
+    slaveInfo.mutable_id()->set_value("agent" + stringify(i));
+
+    slaveIds.push_back(slaveInfo.id());
+
+    bestFit.get()->add(slaveInfo.id(), slaveInfo);
+    spread.get()->add(slaveInfo.id(), slaveInfo);
+  }
+
+  // The first agent is half allocated, the second is empty and the
+  // third is fully allocated.
+  const Resources half = Resources::parse("cpus:2;mem:512").get();
+
+  bestFit.get()->update(slaveIds[0], total, half);
+  bestFit.get()->update(slaveIds[1], total, Resources());
+  bestFit.get()->update(slaveIds[2], total, total);
+
+  spread.get()->update(slaveIds[0], total, half);
+  spread.get()->update(slaveIds[1], total, Resources());
+  spread.get()->update(slaveIds[2], total, total);
+
+  vector<SlaveID> sorted = slaveIds;
+
+  bestFit.get()->sort(&sorted);
+  EXPECT_EQ(vector<SlaveID>({slaveIds[2], slaveIds[0], slaveIds[1]}), sorted);
+
+  spread.get()->sort(&sorted);
+  EXPECT_EQ(vector<SlaveID>({slaveIds[1], slaveIds[0], slaveIds[2]}), sorted);
+
+  // Only the given agents are sorted.
+  sorted = {slaveIds[1], slaveIds[0]};
+
+  bestFit.get()->sort(&sorted);
+  EXPECT_EQ(vector<SlaveID>({slaveIds[0], slaveIds[1]}), sorted);
+
+  // Updates move the agents.
+  bestFit.get()->update(slaveIds[2], total, Resources());
+
+  sorted = slaveIds;
+
+  bestFit.get()->sort(&sorted);
+  EXPECT_EQ(slaveIds[0], sorted[0]);
+
+  bestFit.get()->remove(slaveIds[0]);
+
+  sorted = {slaveIds[1], slaveIds[2]};
+
+  bestFit.get()->sort(&sorted);
+  EXPECT_EQ(2u, sorted.size());
+
+  delete bestFit.get();
+  delete spread.get();
+}
+
+
+// Verifies that the agent sorter for an attribute keeps the agents
+// with the same value of the attribute together.
+TEST(SorterTest, AgentSorterAttribute)
+{
+  Try<AgentSorter*> sorter = AgentSorter::create("attribute:rack");
+  ASSERT_SOME(sorter);
+
+  hashmap<SlaveID, string> racks;
+  vector<SlaveID> slaveIds;
+
+  for (int i = 0; i < 9; i++) {
+    SlaveInfo slaveInfo;
+    slaveInfo.set_hostname("host" + stringify(i));
+    slaveInfo.mutable_id()->set_value("agent" + stringify(i));
+
+    // Every third agent has no rack.
+    string rack;
+    if (i % 3 != 0) {
+      rack = "rack" + stringify(i % 3);
+      *slaveInfo.mutable_attributes() = Attributes::parse("rack:" + rack);
+    }
+
+    racks[slaveInfo.id()] = rack;
+    slaveIds.push_back(slaveInfo.id());
+
+    sorter.get()->add(slaveInfo.id(), slaveInfo);
+  }
+
+  vector<SlaveID> sorted = slaveIds;
+  sorter.get()->sort(&sorted);
+
+  ASSERT_EQ(slaveIds.size(), sorted.size());
+
+  // Each rack occurs in a single run of agents.
+  hashset<string> seen;
+  for (size_t i = 0; i < sorted.size(); i++) {
+    const string& rack = racks.at(sorted[i]);
+
+    if (i == 0 || rack != racks.at(sorted[i - 1])) {
+      EXPECT_FALSE(seen.contains(rack));
+      seen.insert(rack);
+    }
+  }
+
+  EXPECT_EQ(3u, seen.size());
+
+  delete sorter.get();
+
+  EXPECT_ERROR(AgentSorter::create("attribute:"));
+  EXPECT_ERROR(AgentSorter::create("worst_fit"));
+}
+
+
+class Sorter_BENCHMARK_Test
+  : public ::testing::Test,
+    public WithParamInterface<std::tr1::tuple<size_t, size_t>> {};
+
+
+// The sorter benchmark tests are parameterized by
+// the number of agents and the number of clients.
+INSTANTIATE_TEST_CASE_P(
+    AgentAndClientCount,
+    Sorter_BENCHMARK_Test,
+    ::testing::Combine(
+      ::testing::Values(1000U, 5000U, 10000U, 50000U),
+      ::testing::Values(1U, 50U, 100U, 500U, 1000U, 5000U, 10000U))
+    );
+
+
+// This benchmark simulates the use of a framework sorter by the
+// allocator: every agent is allocated to the client that comes first
+// in the sort, which changes the order of the clients for the next
+// agent.
+TEST_P(Sorter_BENCHMARK_Test, FullSort)
+{
+  size_t agentCount = std::tr1::get<0>(GetParam());
+  size_t clientCount = std::tr1::get<1>(GetParam());
+
+  cout << "Using " << agentCount << " agents"
+       << " and " << clientCount << " clients" << endl;
+
+  vector<SlaveID> agents;
+  agents.reserve(agentCount);
+
+  for (size_t i = 0; i < agentCount; i++) {
+    SlaveID agent;
+    agent.set_value("agent" + stringify(i));
+    agents.push_back(agent);
+  }
+
+  const Resources agentResources =
+    Resources::parse("cpus:24;mem:4096;disk:4096").get();
+
+  DRFSorter sorter;
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t i = 0; i < clientCount; i++) {
+    sorter.add("framework" + stringify(i));
+  }
+
+  cout << "Added " << clientCount << " clients"
+       << " in " << watch.elapsed() << endl;
+
+  watch.start();
+
+  foreach (const SlaveID& agent, agents) {
+    sorter.add(agent, agentResources);
+  }
+
+  cout << "Added " << agentCount << " agents"
+       << " in " << watch.elapsed() << endl;
+
+  // Allocate a part of each agent to the first client in the sort.
+  // This recalculates all shares only once since the total does not
+  // change afterwards.
+  const Resources allocation = Resources::parse("cpus:2;mem:512").get();
+
+  watch.start();
+
+  foreach (const SlaveID& agent, agents) {
+    const vector<string>& sorted = sorter.sorted();
+    sorter.allocated(sorted.front(), agent, allocation);
+  }
+
+  cout << "Sorted and allocated to " << clientCount << " clients "
+       << agentCount << " times in " << watch.elapsed() << endl;
+
+  // Now change the total on every allocation, as the allocator does
+  // for its framework sorters, so that each sort recalculates all
+  // shares.
+  watch.start();
+
+  foreach (const SlaveID& agent, agents) {
+    const vector<string>& sorted = sorter.sorted();
+    sorter.add(agent, allocation);
+    sorter.allocated(sorted.front(), agent, allocation);
+  }
+
+  cout << "Sorted and allocated to " << clientCount << " clients "
+       << agentCount << " times with changing totals"
+       << " in " << watch.elapsed() << endl;
+
+  watch.start();
+
+  for (size_t i = 0; i < clientCount; i++) {
+    const string name = "framework" + stringify(i);
+
+    // Copy the allocation since unallocating modifies it.
+    const hashmap<SlaveID, Resources> allocation = sorter.allocation(name);
+
+    foreachpair (const SlaveID& agent,
+                 const Resources& resources,
+                 allocation) {
+      sorter.unallocated(name, agent, resources);
+    }
+  }
+
+  foreach (const SlaveID& agent, agents) {
+    sorter.remove(agent, sorter.total().at(agent));
+  }
+
+  cout << "Unallocated and removed " << agentCount << " agents"
+       << " in " << watch.elapsed() << endl;
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -0,0 +1,319 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <mesos/mesos.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/gtest.hpp>
+#include <stout/option.hpp>
+#include <stout/stringify.hpp>
+#include <stout/try.hpp>
+
+#include "master/task_index.hpp"
+
+#include "messages/messages.hpp"
+
+using mesos::internal::master::TaskIndex;
+
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace tests {
+
+// Returns a task with a status at the given time, if any.
+static Task createTask(
+    const string& id,
+    const string& frameworkId,
+    const string& slaveId,
+    TaskState state,
+    const Option<double>& time)
+{
+  Task task;
+  task.set_name(id);
+  task.mutable_task_id()->set_value(id);
+  task.mutable_framework_id()->set_value(frameworkId);
+  task.mutable_slave_id()->set_value(slaveId);
+  task.set_state(state);
+
+  if (time.isSome()) {
+    TaskStatus* status = task.add_statuses();
+    status->mutable_task_id()->set_value(id);
+    status->set_state(state);
+    status->set_timestamp(time.get());
+  }
+
+  return task;
+}
+
+
+// Returns the IDs of the tasks of a page.
+static vector<string> ids(const TaskIndex::Page& page)
+{
+  vector<string> ids;
+  foreach (const Task* task, page.tasks) {
+    ids.push_back(task->task_id().value());
+  }
+
+  return ids;
+}
+
+
+TEST(TaskIndexTest, Order)
+{
+  Task task1 = createTask("1", "f", "s", TASK_RUNNING, 2.0);
+  Task task2 = createTask("2", "f", "s", TASK_RUNNING, 1.0);
+  Task task3 = createTask("3", "f", "s", TASK_STAGING, None());
+  Task task4 = createTask("4", "f", "s", TASK_RUNNING, 3.0);
+
+  TaskIndex index;
+  index.add(&task1, "*");
+  index.add(&task2, "*");
+  index.add(&task3, "*");
+  index.add(&task4, "*");
+
+  EXPECT_EQ(4u, index.size());
+
+  TaskIndex::Query query;
+  query.limit = 10;
+
+  // Tasks without a status come last in the descending order.
+  EXPECT_EQ((vector<string>{"4", "1", "2", "3"}), ids(index.find(query)));
+
+  query.ascending = true;
+  EXPECT_EQ((vector<string>{"3", "2", "1", "4"}), ids(index.find(query)));
+
+  query.offset = 1;
+  query.limit = 2;
+  EXPECT_EQ((vector<string>{"2", "1"}), ids(index.find(query)));
+
+  // The first status of a task repositions it.
+  TaskStatus* status = task3.add_statuses();
+  status->set_state(TASK_RUNNING);
+  status->set_timestamp(2.5);
+  task3.set_state(TASK_RUNNING);
+  index.update(&task3);
+
+  query.offset = 0;
+  query.limit = 10;
+  EXPECT_EQ((vector<string>{"2", "1", "3", "4"}), ids(index.find(query)));
+
+  index.remove(&task1);
+  EXPECT_EQ(3u, index.size());
+  EXPECT_EQ((vector<string>{"2", "3", "4"}), ids(index.find(query)));
+}
+
+
+TEST(TaskIndexTest, Filters)
+{
+  Task task1 = createTask("1", "f1", "s1", TASK_RUNNING, 1.0);
+  Task task2 = createTask("2", "f1", "s2", TASK_FINISHED, 2.0);
+  Task task3 = createTask("3", "f2", "s1", TASK_RUNNING, 3.0);
+  Task task4 = createTask("4", "f3", "s2", TASK_RUNNING, 4.0);
+
+  Label* label = task3.mutable_labels()->add_labels();
+  label->set_key("key");
+  label->set_value("value");
+
+  TaskIndex index;
+  index.add(&task1, "role1");
+  index.add(&task2, "role1");
+  index.add(&task3, "role1");
+  index.add(&task4, "role2");
+
+  TaskIndex::Query query;
+  query.ascending = true;
+  query.limit = 10;
+
+  FrameworkID frameworkId;
+  frameworkId.set_value("f1");
+  query.frameworkId = frameworkId;
+  EXPECT_EQ((vector<string>{"1", "2"}), ids(index.find(query)));
+
+  query.frameworkId = None();
+  query.role = "role1";
+  EXPECT_EQ((vector<string>{"1", "2", "3"}), ids(index.find(query)));
+
+  SlaveID slaveId;
+  slaveId.set_value("s1");
+  query.slaveId = slaveId;
+  EXPECT_EQ((vector<string>{"1", "3"}), ids(index.find(query)));
+
+  query.role = None();
+  query.slaveId = None();
+  query.state = TASK_RUNNING;
+  EXPECT_EQ((vector<string>{"1", "3", "4"}), ids(index.find(query)));
+
+  // The state of a task is updated in place before the index.
+  task1.set_state(TASK_KILLED);
+  index.update(&task1);
+  EXPECT_EQ((vector<string>{"3", "4"}), ids(index.find(query)));
+
+  query.state = None();
+
+  Label filter;
+  filter.set_key("key");
+  query.label = filter;
+  EXPECT_EQ((vector<string>{"3"}), ids(index.find(query)));
+
+  filter.set_value("other");
+  query.label = filter;
+  EXPECT_TRUE(index.find(query).tasks.empty());
+
+  // No task of an unknown framework matches.
+  query.label = None();
+  frameworkId.set_value("unknown");
+  query.frameworkId = frameworkId;
+  EXPECT_TRUE(index.find(query).tasks.empty());
+}
+
+
+// This test verifies that the tasks are looked up by the keys and the
+// values of their labels, as long as they are indexed.
+TEST(TaskIndexTest, Labels)
+{
+  Task task1 = createTask("1", "f", "s", TASK_RUNNING, 1.0);
+  Task task2 = createTask("2", "f", "s", TASK_RUNNING, 2.0);
+  Task task3 = createTask("3", "f", "s", TASK_RUNNING, 3.0);
+
+  // The first task has the same key twice, with different values,
+  // and the same label twice.
+  const vector<string> values = {"a", "b", "b"};
+
+  foreach (const string& value, values) {
+    Label* label = task1.mutable_labels()->add_labels();
+    label->set_key("key");
+    label->set_value(value);
+  }
+
+  Label* label = task2.mutable_labels()->add_labels();
+  label->set_key("key");
+  label->set_value("a");
+
+  // A label without a value is indexed by its key.
+  label = task3.mutable_labels()->add_labels();
+  label->set_key("key");
+
+  TaskIndex index;
+  index.add(&task1, "*");
+  index.add(&task2, "*");
+  index.add(&task3, "*");
+
+  TaskIndex::Query query;
+  query.ascending = true;
+  query.limit = 10;
+
+  Label filter;
+  filter.set_key("key");
+  query.label = filter;
+  EXPECT_EQ((vector<string>{"1", "2", "3"}), ids(index.find(query)));
+
+  filter.set_value("a");
+  query.label = filter;
+  EXPECT_EQ((vector<string>{"1", "2"}), ids(index.find(query)));
+
+  filter.set_value("b");
+  query.label = filter;
+  EXPECT_EQ((vector<string>{"1"}), ids(index.find(query)));
+
+  filter.set_key("other");
+  query.label = filter;
+  EXPECT_TRUE(index.find(query).tasks.empty());
+
+  // Updating and removing the tasks keeps the label indexes in sync.
+  index.update(&task1);
+  index.remove(&task2);
+
+  filter.set_key("key");
+  filter.set_value("a");
+  query.label = filter;
+  EXPECT_EQ((vector<string>{"1"}), ids(index.find(query)));
+
+  index.remove(&task1);
+  EXPECT_TRUE(index.find(query).tasks.empty());
+
+  filter.clear_value();
+  query.label = filter;
+  EXPECT_EQ((vector<string>{"3"}), ids(index.find(query)));
+
+  index.remove(&task3);
+  EXPECT_TRUE(index.find(query).tasks.empty());
+  EXPECT_EQ(0u, index.size());
+}
+
+
+TEST(TaskIndexTest, Cursor)
+{
+  vector<Task> tasks;
+  for (int i = 0; i < 5; i++) {
+    tasks.push_back(createTask(
+        stringify(i), "f", "s", TASK_RUNNING, static_cast<double>(i)));
+  }
+
+  TaskIndex index;
+  foreach (const Task& task, tasks) {
+    index.add(&task, "*");
+  }
+
+  const vector<bool> orders = {true, false};
+
+  foreach (bool ascending, orders) {
+    TaskIndex::Query query;
+    query.ascending = ascending;
+    query.limit = 2;
+
+    vector<string> listed;
+
+    while (true) {
+      TaskIndex::Page page = index.find(query);
+      foreach (const string& id, ids(page)) {
+        listed.push_back(id);
+      }
+
+      if (page.next.isNone()) {
+        break;
+      }
+
+      EXPECT_EQ(2u, page.tasks.size());
+
+      Try<TaskIndex::Key> cursor =
+        TaskIndex::Key::parse(page.next->cursor());
+
+      ASSERT_SOME(cursor);
+      query.cursor = cursor.get();
+    }
+
+    vector<string> expected = {"0", "1", "2", "3", "4"};
+    if (!ascending) {
+      expected = {"4", "3", "2", "1", "0"};
+    }
+
+    EXPECT_EQ(expected, listed);
+  }
+
+  EXPECT_ERROR(TaskIndex::Key::parse("1"));
+  EXPECT_ERROR(TaskIndex::Key::parse("a:1"));
+}
+
+} // namespace tests {
+} // namespace internal {
+} // namespace mesos {
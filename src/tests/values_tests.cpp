@@ -407,6 +407,44 @@ TEST(ValuesTest, RangesSubtraction)
   EXPECT_EQ(parse("[3-8]").get().ranges(), ranges1 - ranges2);
 }
 
+
+// Test containment and subtraction of fragmented ranges, which are
+// not necessarily coalesced.
+TEST(ValuesTest, RangesFragmented)
+{
+  Value::Ranges ranges = parse("[1-1, 3-3, 5-10, 12-12]").get().ranges();
+
+  // Ranges that are not coalesced, e.g., not sorted or adjacent.
+  Value::Ranges unsorted;
+  Value::Range* range = unsorted.add_range();
+  range->set_begin(12);
+  range->set_end(12);
+  range = unsorted.add_range();
+  range->set_begin(5);
+  range->set_end(7);
+  range = unsorted.add_range();
+  range->set_begin(8);
+  range->set_end(8);
+
+  EXPECT_TRUE(unsorted <= ranges);
+  EXPECT_FALSE(ranges <= unsorted);
+  EXPECT_FALSE(parse("[2-3]").get().ranges() <= ranges);
+  EXPECT_FALSE(parse("[10-12]").get().ranges() <= ranges);
+  EXPECT_TRUE(parse("[]").get().ranges() <= ranges);
+
+  EXPECT_EQ(parse("[5-8, 12-12]").get().ranges(), unsorted);
+
+  EXPECT_EQ(parse("[1-1, 3-3, 9-10]").get().ranges(), ranges - unsorted);
+  EXPECT_EQ(parse("[]").get().ranges(), unsorted - ranges);
+
+  // Removals that span multiple ranges.
+  EXPECT_EQ(parse("[1-1, 11-12]").get().ranges(),
+            parse("[1-1, 3-3, 5-12]").get().ranges() -
+            parse("[2-6, 7-10]").get().ranges());
+
+  EXPECT_EQ(parse("[1-1, 3-3, 5-10, 12-12]").get().ranges(), unsorted + ranges);
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {